@@ -36,6 +36,7 @@
  * | conn/ssl.c          | @subpage conn_ssl        |
  * | conn/ssl_gnutls.c   | @subpage conn_ssl_gnutls |
  * | conn/tunnel.c       | @subpage conn_tunnel     |
+ * | conn/zstrm.c        | @subpage conn_zstrm      |
  */
 
 #ifndef MUTT_CONN_CONN_H
@@ -52,6 +53,9 @@
 #ifdef USE_SASL
 #include "sasl.h"
 #endif
+#ifdef HAVE_ZLIB
+#include "zstrm.h"
+#endif
 
 int getdnsdomainname(char *buf, size_t buflen);
 
@@ -31,6 +31,7 @@
 #include <stdio.h>
 
 short C_ConnectTimeout = 0; ///< Config: Timeout for making network connections (-1 to wait indefinitely)
+long C_SocketBufferSize = 0; ///< Config: Size of the receive buffer of a network connection
 
 #ifdef USE_SSL
 const char *C_CertificateFile = NULL; ///< Config: File containing trusted certificates
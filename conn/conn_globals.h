@@ -27,6 +27,7 @@
 
 /* These variables are backing for config items */
 extern short C_ConnectTimeout;
+extern long C_SocketBufferSize;
 
 #ifdef USE_SSL
 extern const char *C_CertificateFile;
@@ -36,11 +36,11 @@ struct Connection
   struct ConnAccount account;
   unsigned int ssf; /**< security strength factor, in bits */
 
-  char inbuf[1024];
   int bufpos;
 
   int fd;
   int available;
+  size_t inbuflen; ///< Size of the receive buffer, inbuf
 
   void *sockdata;
 
@@ -85,6 +85,8 @@ struct Connection
    * @retval -1 Error, see errno
    */
   int (*conn_close)(struct Connection *conn);
+
+  char inbuf[]; ///< Receive buffer, allocated with the Connection
 };
 
 #endif /* MUTT_CONN_CONNECTION_H */
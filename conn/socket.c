@@ -30,6 +30,7 @@
 
 #include "config.h"
 #include <errno.h>
+#include <stdbool.h>
 #include <string.h>
 #include <time.h>
 #include "mutt/mutt.h"
@@ -196,6 +197,40 @@ int mutt_socket_poll(struct Connection *conn, time_t wait_secs)
   return -1;
 }
 
+/**
+ * socket_fill - Read more data into a Connection's buffer
+ * @param conn Connection to a server
+ * @retval >0 Success, number of bytes read
+ * @retval -1 Error, the connection has been closed
+ *
+ * The data is appended to the buffer, which must have some free space.
+ */
+static int socket_fill(struct Connection *conn)
+{
+  if (conn->fd < 0)
+  {
+    mutt_debug(LL_DEBUG1, "attempt to read from closed connection\n");
+    return -1;
+  }
+
+  const int rc = conn->conn_read(conn, conn->inbuf + conn->available,
+                                 conn->inbuflen - conn->available);
+  if (rc == 0)
+  {
+    mutt_error(_("Connection to %s closed"), conn->account.host);
+  }
+  if (rc <= 0)
+  {
+    conn->bufpos = 0;
+    conn->available = 0;
+    mutt_socket_close(conn);
+    return -1;
+  }
+
+  conn->available += rc;
+  return rc;
+}
+
 /**
  * mutt_socket_readchar - simple read buffering to speed things up
  * @param[in]  conn Connection to a server
@@ -207,27 +242,77 @@ int mutt_socket_readchar(struct Connection *conn, char *c)
 {
   if (conn->bufpos >= conn->available)
   {
-    if (conn->fd >= 0)
-      conn->available = conn->conn_read(conn, conn->inbuf, sizeof(conn->inbuf));
-    else
-    {
-      mutt_debug(LL_DEBUG1, "attempt to read from closed connection\n");
+    conn->bufpos = 0;
+    conn->available = 0;
+    if (socket_fill(conn) < 0)
       return -1;
+  }
+  *c = conn->inbuf[conn->bufpos];
+  conn->bufpos++;
+  return 1;
+}
+
+/**
+ * mutt_socket_peekln - Look at the next line, without reading it
+ * @param[in]  conn Connection to a server
+ * @param[out] line Start of the line, in the Connection's buffer
+ * @retval >0 Success, length of the line, including the '\n'
+ * @retval -1 Error
+ *
+ * Make sure that the whole of the next line is in the Connection's buffer
+ * and return a pointer to it.  The line isn't '\0'-terminated.  If the line
+ * is longer than the buffer, only the start of it is returned, without a
+ * '\n'.
+ *
+ * The line stays in the buffer until it is consumed with
+ * mutt_socket_advance().  The pointer is only valid until the next read.
+ */
+int mutt_socket_peekln(struct Connection *conn, const char **line)
+{
+  size_t scanned = 0;
+
+  while (true)
+  {
+    const char *start = conn->inbuf + conn->bufpos;
+    const size_t avail = conn->available - conn->bufpos;
+
+    const char *nl = memchr(start + scanned, '\n', avail - scanned);
+    if (nl)
+    {
+      *line = start;
+      return nl - start + 1;
     }
-    conn->bufpos = 0;
-    if (conn->available == 0)
+
+    if (avail == conn->inbuflen)
     {
-      mutt_error(_("Connection to %s closed"), conn->account.host);
+      *line = start;
+      return avail;
     }
-    if (conn->available <= 0)
+    scanned = avail;
+
+    /* make room at the end of the buffer */
+    if (conn->bufpos > 0)
     {
-      mutt_socket_close(conn);
-      return -1;
+      memmove(conn->inbuf, start, avail);
+      conn->bufpos = 0;
+      conn->available = avail;
     }
+
+    if (socket_fill(conn) < 0)
+      return -1;
   }
-  *c = conn->inbuf[conn->bufpos];
-  conn->bufpos++;
-  return 1;
+}
+
+/**
+ * mutt_socket_advance - Consume data from a Connection's buffer
+ * @param conn Connection to a server
+ * @param len  Number of bytes to consume
+ *
+ * Use after mutt_socket_peekln().
+ */
+void mutt_socket_advance(struct Connection *conn, size_t len)
+{
+  conn->bufpos += MIN(len, (size_t) (conn->available - conn->bufpos));
 }
 
 /**
@@ -241,20 +326,34 @@ int mutt_socket_readchar(struct Connection *conn, char *c)
  */
 int mutt_socket_readln_d(char *buf, size_t buflen, struct Connection *conn, int dbg)
 {
-  char ch;
-  int i;
+  const char *line = NULL;
+  size_t i = 0;
 
-  for (i = 0; i < buflen - 1; i++)
+  /* a line may be longer than the connection's buffer */
+  while (i < (buflen - 1))
   {
-    if (mutt_socket_readchar(conn, &ch) != 1)
+    const int len = mutt_socket_peekln(conn, &line);
+    if (len < 0)
     {
       buf[i] = '\0';
       return -1;
     }
 
-    if (ch == '\n')
+    bool eol = (line[len - 1] == '\n');
+    size_t n = eol ? (len - 1) : len;
+    /* if buf is full, leave the '\n' to be read next time */
+    if (n >= (buflen - 1 - i))
+    {
+      n = buflen - 1 - i;
+      eol = false;
+    }
+
+    memcpy(buf + i, line, n);
+    mutt_socket_advance(conn, eol ? (n + 1) : n);
+    i += n;
+
+    if (eol)
       break;
-    buf[i] = ch;
   }
 
   /* strip \r from \r\n termination */
@@ -275,7 +374,10 @@ int mutt_socket_readln_d(char *buf, size_t buflen, struct Connection *conn, int
  */
 struct Connection *mutt_socket_new(enum ConnectionType type)
 {
-  struct Connection *conn = mutt_mem_calloc(1, sizeof(struct Connection));
+  /* the receive buffer is allocated with the Connection */
+  const size_t inbuflen = MAX(1024, MIN(C_SocketBufferSize, 1024 * 1024));
+  struct Connection *conn = mutt_mem_calloc(1, sizeof(struct Connection) + inbuflen);
+  conn->inbuflen = inbuflen;
   conn->fd = -1;
 
   if (type == MUTT_CONNECTION_TUNNEL)
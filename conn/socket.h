@@ -48,6 +48,8 @@ int mutt_socket_write(struct Connection *conn, const char *buf, size_t len);
 int mutt_socket_poll(struct Connection *conn, time_t wait_secs);
 int mutt_socket_readchar(struct Connection *conn, char *c);
 int mutt_socket_readln_d(char *buf, size_t buflen, struct Connection *conn, int dbg);
+int mutt_socket_peekln(struct Connection *conn, const char **line);
+void mutt_socket_advance(struct Connection *conn, size_t len);
 int mutt_socket_write_d(struct Connection *conn, const char *buf, int len, int dbg);
 
 int raw_socket_read(struct Connection *conn, char *buf, size_t len);
@@ -636,6 +636,20 @@ static void ssl_get_client_cert(struct SslSockData *ssldata, struct Connection *
     mutt_debug(LL_DEBUG1, "Couldn't get user info\n");
 }
 
+/**
+ * ssl_socket_poll - Check whether a socket read would block - Implements Connection::conn_poll()
+ */
+static int ssl_socket_poll(struct Connection *conn, time_t wait_secs)
+{
+  struct SslSockData *data = conn->sockdata;
+
+  /* Data OpenSSL has already decrypted won't show up on the socket */
+  if (data && data->ssl && (SSL_pending(data->ssl) > 0))
+    return 1;
+
+  return raw_socket_poll(conn, wait_secs);
+}
+
 /**
  * ssl_socket_close_and_restore - Close an SSL Connection and restore Connection callbacks - Implements Connection::conn_close()
  */
@@ -644,6 +658,7 @@ static int ssl_socket_close_and_restore(struct Connection *conn)
   int rc = ssl_socket_close(conn);
   conn->conn_read = raw_socket_read;
   conn->conn_write = raw_socket_write;
+  conn->conn_poll = raw_socket_poll;
   conn->conn_close = raw_socket_close;
 
   return rc;
@@ -1419,6 +1434,7 @@ int mutt_ssl_starttls(struct Connection *conn)
   /* hmm. watch out if we're starting TLS over any method other than raw. */
   conn->conn_read = ssl_socket_read;
   conn->conn_write = ssl_socket_write;
+  conn->conn_poll = ssl_socket_poll;
   conn->conn_close = ssl_socket_close_and_restore;
 
   return rc;
@@ -1441,7 +1457,7 @@ int mutt_ssl_socket_setup(struct Connection *conn)
   conn->conn_open = ssl_socket_open;
   conn->conn_read = ssl_socket_read;
   conn->conn_write = ssl_socket_write;
-  conn->conn_poll = raw_socket_poll;
+  conn->conn_poll = ssl_socket_poll;
   conn->conn_close = ssl_socket_close;
 
   return 0;
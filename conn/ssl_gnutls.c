@@ -100,6 +100,20 @@ static int tls_init(void)
   return 0;
 }
 
+/**
+ * tls_socket_poll - Check whether a socket read would block - Implements Connection::conn_poll()
+ */
+static int tls_socket_poll(struct Connection *conn, time_t wait_secs)
+{
+  struct TlsSockData *data = conn->sockdata;
+
+  /* Data GnuTLS has already decrypted won't show up on the socket */
+  if (data && (gnutls_record_check_pending(data->state) > 0))
+    return 1;
+
+  return raw_socket_poll(conn, wait_secs);
+}
+
 /**
  * tls_starttls_close - Close a TLS connection - Implements Connection::conn_close()
  */
@@ -110,6 +124,7 @@ static int tls_starttls_close(struct Connection *conn)
   rc = tls_socket_close(conn);
   conn->conn_read = raw_socket_read;
   conn->conn_write = raw_socket_write;
+  conn->conn_poll = raw_socket_poll;
   conn->conn_close = raw_socket_close;
 
   return rc;
@@ -1232,7 +1247,7 @@ int mutt_ssl_socket_setup(struct Connection *conn)
   conn->conn_read = tls_socket_read;
   conn->conn_write = tls_socket_write;
   conn->conn_close = tls_socket_close;
-  conn->conn_poll = raw_socket_poll;
+  conn->conn_poll = tls_socket_poll;
 
   return 0;
 }
@@ -1253,6 +1268,7 @@ int mutt_ssl_starttls(struct Connection *conn)
 
   conn->conn_read = tls_socket_read;
   conn->conn_write = tls_socket_write;
+  conn->conn_poll = tls_socket_poll;
   conn->conn_close = tls_starttls_close;
 
   return 0;
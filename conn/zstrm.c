@@ -0,0 +1,368 @@
+/**
+ * @file
+ * Zlib compression of network traffic
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page conn_zstrm Zlib compression of network traffic
+ *
+ * A raw-deflate stream (RFC1951) stacked on top of another Connection, e.g.
+ * a raw socket, SSL/TLS or a tunnel.  It is used by IMAP COMPRESS=DEFLATE
+ * (RFC4978).
+ *
+ * The original Connection's functions and data are kept in a ZstrmContext.
+ * When the Connection is closed, they are restored, so the Connection can be
+ * reopened in the usual way.
+ */
+
+#include "config.h"
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+#include "mutt/mutt.h"
+#include "zstrm.h"
+#include "connection.h"
+
+#define ZSTRM_BUFSIZE 8192 ///< Size of the buffers of compressed data
+
+/**
+ * struct ZstrmDirection - A stream of data going one way
+ */
+struct ZstrmDirection
+{
+  z_stream z;                 ///< zlib compression handle
+  char *buf;                  ///< Buffer for the compressed data
+  size_t len;                 ///< Size of buf
+  size_t pos;                 ///< Bytes of compressed data in buf
+  bool conn_eof;              ///< The underlying Connection has no more data
+  bool stream_eof;            ///< The compressed stream has ended
+  bool more;                  ///< inflate() may have more output, without more input
+  unsigned long long z_bytes; ///< Compressed bytes, read or written
+  unsigned long long bytes;   ///< Uncompressed bytes, read or written
+};
+
+/**
+ * struct ZstrmContext - Data compression layer
+ */
+struct ZstrmContext
+{
+  struct ZstrmDirection read;  ///< Data being read and decompressed
+  struct ZstrmDirection write; ///< Data being compressed and written
+
+  /* The wrapped Connection */
+  void *next_sockdata;
+  int (*next_open)(struct Connection *conn);
+  int (*next_read)(struct Connection *conn, char *buf, size_t count);
+  int (*next_write)(struct Connection *conn, const char *buf, size_t count);
+  int (*next_poll)(struct Connection *conn, time_t wait_secs);
+  int (*next_close)(struct Connection *conn);
+};
+
+/**
+ * zstrm_malloc - Redirector function for zlib's malloc()
+ * @param opaque Opaque zlib handle
+ * @param items  Number of items
+ * @param size   Size of each item
+ * @retval ptr New memory
+ */
+static void *zstrm_malloc(void *opaque, unsigned int items, unsigned int size)
+{
+  return mutt_mem_calloc(items, size);
+}
+
+/**
+ * zstrm_free - Redirector function for zlib's free()
+ * @param opaque  Opaque zlib handle
+ * @param address Memory to free
+ */
+static void zstrm_free(void *opaque, void *address)
+{
+  FREE(&address);
+}
+
+/**
+ * next_read - Read from the wrapped Connection
+ * @param conn  Connection to a server
+ * @param zctx  Compression layer
+ * @param buf   Buffer to store the data
+ * @param count Number of bytes to read
+ * @retval >0 Success, number of bytes read
+ * @retval  0 End of the stream
+ * @retval -1 Error
+ */
+static int next_read(struct Connection *conn, struct ZstrmContext *zctx,
+                     char *buf, size_t count)
+{
+  conn->sockdata = zctx->next_sockdata;
+  const int rc = zctx->next_read(conn, buf, count);
+  conn->sockdata = zctx;
+  return rc;
+}
+
+/**
+ * next_write - Write to the wrapped Connection
+ * @param conn  Connection to a server
+ * @param zctx  Compression layer
+ * @param buf   Data to write
+ * @param count Number of bytes to write
+ * @retval >0 Success, number of bytes written
+ * @retval -1 Error
+ */
+static int next_write(struct Connection *conn, struct ZstrmContext *zctx,
+                      const char *buf, size_t count)
+{
+  conn->sockdata = zctx->next_sockdata;
+  const int rc = zctx->next_write(conn, buf, count);
+  conn->sockdata = zctx;
+  return rc;
+}
+
+/**
+ * zstrm_open - Open a socket - Implements Connection::conn_open()
+ * @retval -1 Always
+ *
+ * A compressed Connection is never reopened.  Closing it removes the
+ * compression layer.
+ */
+static int zstrm_open(struct Connection *conn)
+{
+  return -1;
+}
+
+/**
+ * zstrm_close - Close a socket - Implements Connection::conn_close()
+ *
+ * Remove the compression layer and close the wrapped Connection.
+ */
+static int zstrm_close(struct Connection *conn)
+{
+  struct ZstrmContext *zctx = conn->sockdata;
+
+  mutt_debug(LL_DEBUG2, "read %llu bytes as %llu, wrote %llu bytes as %llu\n",
+             zctx->read.bytes, zctx->read.z_bytes, zctx->write.bytes,
+             zctx->write.z_bytes);
+
+  inflateEnd(&zctx->read.z);
+  deflateEnd(&zctx->write.z);
+  FREE(&zctx->read.buf);
+  FREE(&zctx->write.buf);
+
+  conn->sockdata = zctx->next_sockdata;
+  conn->conn_open = zctx->next_open;
+  conn->conn_read = zctx->next_read;
+  conn->conn_write = zctx->next_write;
+  conn->conn_poll = zctx->next_poll;
+  conn->conn_close = zctx->next_close;
+  FREE(&zctx);
+
+  return conn->conn_close(conn);
+}
+
+/**
+ * zstrm_read - Read compressed data from a socket - Implements Connection::conn_read()
+ */
+static int zstrm_read(struct Connection *conn, char *buf, size_t count)
+{
+  struct ZstrmContext *zctx = conn->sockdata;
+  struct ZstrmDirection *zr = &zctx->read;
+
+  while (!zr->stream_eof)
+  {
+    /* If inflate() filled the last output buffer, it may have more to give
+     * without more input.  Don't read then, as the read may block. */
+    if (!zr->more && !zr->conn_eof && (zr->pos < zr->len))
+    {
+      const int rc = next_read(conn, zctx, zr->buf + zr->pos, zr->len - zr->pos);
+      if (rc < 0)
+        return rc;
+      if (rc == 0)
+        zr->conn_eof = true;
+      zr->pos += rc;
+      zr->z_bytes += rc;
+    }
+
+    zr->z.next_in = (Bytef *) zr->buf;
+    zr->z.avail_in = (uInt) zr->pos;
+    zr->z.next_out = (Bytef *) buf;
+    zr->z.avail_out = (uInt) count;
+
+    const int zrc = inflate(&zr->z, Z_SYNC_FLUSH);
+    if ((zrc != Z_OK) && (zrc != Z_STREAM_END) && (zrc != Z_BUF_ERROR))
+    {
+      mutt_debug(LL_DEBUG1, "inflate failed: %d\n", zrc);
+      return -1;
+    }
+
+    /* keep any input that couldn't be used yet */
+    if (zr->z.avail_in > 0)
+      memmove(zr->buf, zr->z.next_in, zr->z.avail_in);
+    zr->pos = zr->z.avail_in;
+    zr->more = (zr->z.avail_out == 0);
+    if (zrc == Z_STREAM_END)
+      zr->stream_eof = true;
+
+    const size_t produced = count - zr->z.avail_out;
+    if (produced > 0)
+    {
+      zr->bytes += produced;
+      return produced;
+    }
+
+    if (zr->conn_eof)
+      break;
+
+    /* a full buffer that inflate() can't use is corrupt */
+    if (zr->pos == zr->len)
+      return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * zstrm_write - Write compressed data to a socket - Implements Connection::conn_write()
+ */
+static int zstrm_write(struct Connection *conn, const char *buf, size_t count)
+{
+  struct ZstrmContext *zctx = conn->sockdata;
+  struct ZstrmDirection *zw = &zctx->write;
+
+  zw->z.next_in = (Bytef *) buf;
+  zw->z.avail_in = (uInt) count;
+
+  /* Flush after every write.  Each one is a complete command, which the
+   * server has to be able to decompress straight away. */
+  do
+  {
+    zw->z.next_out = (Bytef *) zw->buf;
+    zw->z.avail_out = (uInt) zw->len;
+
+    const int zrc = deflate(&zw->z, Z_SYNC_FLUSH);
+    if ((zrc != Z_OK) && (zrc != Z_BUF_ERROR))
+    {
+      mutt_debug(LL_DEBUG1, "deflate failed: %d\n", zrc);
+      return -1;
+    }
+
+    const size_t len = zw->len - zw->z.avail_out;
+    for (size_t sent = 0; sent < len;)
+    {
+      const int rc = next_write(conn, zctx, zw->buf + sent, len - sent);
+      if (rc < 0)
+        return -1;
+      sent += rc;
+    }
+    zw->z_bytes += len;
+  } while ((zw->z.avail_in > 0) || (zw->z.avail_out == 0));
+
+  zw->bytes += count;
+  return count;
+}
+
+/**
+ * zstrm_poll - Check whether a socket read would block - Implements Connection::conn_poll()
+ */
+static int zstrm_poll(struct Connection *conn, time_t wait_secs)
+{
+  struct ZstrmContext *zctx = conn->sockdata;
+
+  if (zctx->read.more)
+    return 1;
+
+  conn->sockdata = zctx->next_sockdata;
+  const int rc = zctx->next_poll(conn, wait_secs);
+  conn->sockdata = zctx;
+  return rc;
+}
+
+/**
+ * mutt_zstrm_wrap_conn - Wrap a compression layer around a Connection
+ * @param conn Connection to wrap
+ * @retval  0 Success
+ * @retval -1 zlib couldn't be initialised, the Connection is unchanged
+ *
+ * Replace the read/write functions with ones that (de)compress the data.
+ * Everything sent or received afterwards is compressed.
+ *
+ * Anything already in the Connection's receive buffer arrived after the
+ * server switched on compression, so it's handed to the decompressor.
+ */
+int mutt_zstrm_wrap_conn(struct Connection *conn)
+{
+  if (!conn)
+    return -1;
+
+  struct ZstrmContext *zctx = mutt_mem_calloc(1, sizeof(struct ZstrmContext));
+
+  zctx->read.z.zalloc = zstrm_malloc;
+  zctx->read.z.zfree = zstrm_free;
+  zctx->write.z.zalloc = zstrm_malloc;
+  zctx->write.z.zfree = zstrm_free;
+
+  /* RFC4978 uses raw deflate data, without a zlib header */
+  int zrc = inflateInit2(&zctx->read.z, -15);
+  if (zrc != Z_OK)
+  {
+    mutt_debug(LL_DEBUG1, "inflateInit2 failed: %d\n", zrc);
+    FREE(&zctx);
+    return -1;
+  }
+
+  zrc = deflateInit2(&zctx->write.z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY);
+  if (zrc != Z_OK)
+  {
+    mutt_debug(LL_DEBUG1, "deflateInit2 failed: %d\n", zrc);
+    inflateEnd(&zctx->read.z);
+    FREE(&zctx);
+    return -1;
+  }
+
+  const size_t pending = (conn->available > conn->bufpos) ? conn->available - conn->bufpos : 0;
+  zctx->read.len = MAX(ZSTRM_BUFSIZE, pending);
+  zctx->read.buf = mutt_mem_malloc(zctx->read.len);
+  if (pending > 0)
+  {
+    mutt_debug(LL_DEBUG3, "%zu compressed bytes already buffered\n", pending);
+    memcpy(zctx->read.buf, conn->inbuf + conn->bufpos, pending);
+    zctx->read.pos = pending;
+    zctx->read.z_bytes = pending;
+    /* inflate them before reading any more */
+    zctx->read.more = true;
+  }
+  conn->bufpos = 0;
+  conn->available = 0;
+  zctx->write.len = ZSTRM_BUFSIZE;
+  zctx->write.buf = mutt_mem_malloc(zctx->write.len);
+
+  zctx->next_sockdata = conn->sockdata;
+  zctx->next_open = conn->conn_open;
+  zctx->next_read = conn->conn_read;
+  zctx->next_write = conn->conn_write;
+  zctx->next_poll = conn->conn_poll;
+  zctx->next_close = conn->conn_close;
+
+  conn->sockdata = zctx;
+  conn->conn_open = zstrm_open;
+  conn->conn_read = zstrm_read;
+  conn->conn_write = zstrm_write;
+  conn->conn_poll = zstrm_poll;
+  conn->conn_close = zstrm_close;
+
+  return 0;
+}
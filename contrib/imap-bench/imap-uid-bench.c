@@ -0,0 +1,324 @@
+/**
+ * @file
+ * Time the IMAP UID Hash against a struct Hash
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares imap_uid_hash_*(), linked from the tree, with the mutt_hash_int_*()
+ * table it replaced.  Each step is what an IMAP folder does to the table:
+ *
+ *   insert    Opening the folder: UIDs 1..N, in order
+ *   find      FETCH responses and SEARCH results: every UID, shuffled
+ *   expunge   EXPUNGE storm: half of the messages, at random
+ *   vanished  VANISHED (EARLIER) 1:N/4, a whole range, in order
+ *   oldest    Expunging the oldest half, in order
+ *   free      Closing the folder
+ *
+ * Each run is made in a new process, so every table starts with a fresh heap,
+ * as it would in a newly started NeoMutt.  Otherwise, what one table frees
+ * changes how quickly the next one can allocate.
+ *
+ * Build it from the top of a built source tree:
+ *
+ *   cc -O2 -I. -o imap-uid-bench contrib/imap-bench/imap-uid-bench.c \
+ *      imap/uid.o libmutt.a
+ *
+ * Usage: imap-uid-bench [SIZE...]
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "imap/imap_private.h"
+
+#define RUNS 5
+
+/**
+ * enum BenchStep - The steps that are timed
+ */
+enum BenchStep
+{
+  STEP_INSERT,
+  STEP_FIND,
+  STEP_EXPUNGE,
+  STEP_VANISHED,
+  STEP_OLDEST,
+  STEP_FREE,
+  STEP_MAX,
+};
+
+static const char *StepNames[STEP_MAX] = {
+  "insert", "find", "expunge", "vanished", "oldest", "free",
+};
+
+/**
+ * struct BenchTable - The operations of one table
+ */
+struct BenchTable
+{
+  const char *name;
+  void *(*new_table)(size_t num);
+  void (*insert)(void *table, unsigned int uid, struct Email *e);
+  struct Email *(*find)(void *table, unsigned int uid);
+  void (*delete)(void *table, unsigned int uid, struct Email *e);
+  void (*free_table)(void *table);
+};
+
+static void *hash_new(size_t num)
+{
+  return mutt_hash_int_new(num, MUTT_HASH_NO_FLAGS);
+}
+
+static void hash_insert(void *table, unsigned int uid, struct Email *e)
+{
+  mutt_hash_int_insert(table, uid, e);
+}
+
+static struct Email *hash_find(void *table, unsigned int uid)
+{
+  return mutt_hash_int_find(table, uid);
+}
+
+static void hash_delete(void *table, unsigned int uid, struct Email *e)
+{
+  mutt_hash_int_delete(table, uid, e);
+}
+
+static void hash_free(void *table)
+{
+  struct Hash *h = table;
+  mutt_hash_free(&h);
+}
+
+static void *uid_new(size_t num)
+{
+  return imap_uid_hash_new(num);
+}
+
+static void uid_insert(void *table, unsigned int uid, struct Email *e)
+{
+  imap_uid_hash_insert(table, uid, e);
+}
+
+static struct Email *uid_find(void *table, unsigned int uid)
+{
+  return imap_uid_hash_find(table, uid);
+}
+
+static void uid_delete(void *table, unsigned int uid, struct Email *e)
+{
+  imap_uid_hash_delete(table, uid, e);
+}
+
+static void uid_free(void *table)
+{
+  struct ImapUidHash *uh = table;
+  imap_uid_hash_free(&uh);
+}
+
+static const struct BenchTable Tables[] = {
+  { "mutt_hash", hash_new, hash_insert, hash_find, hash_delete, hash_free },
+  { "uid_hash", uid_new, uid_insert, uid_find, uid_delete, uid_free },
+};
+
+/**
+ * now_ms - Read the monotonic clock
+ */
+static double now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+/**
+ * shuffle - Put an array of UIDs in a random order
+ */
+static void shuffle(unsigned int *uids, size_t num, unsigned int seed)
+{
+  srand(seed);
+  for (size_t i = num - 1; i > 0; i--)
+  {
+    size_t j = (size_t) rand() % (i + 1);
+    unsigned int tmp = uids[i];
+    uids[i] = uids[j];
+    uids[j] = tmp;
+  }
+}
+
+/**
+ * run_once - Time each step once
+ * @param t      Table to test
+ * @param num    Number of messages
+ * @param emails Fake Emails, indexed by UID - 1
+ * @param order  Scratch array of num UIDs
+ * @param seed   Random seed
+ * @param ms     Time of each step, in milliseconds
+ *
+ * The table is sized for the messages, like imap_read_headers() does.
+ */
+static void run_once(const struct BenchTable *t, size_t num, struct Email *emails,
+                     unsigned int *order, unsigned int seed, double *ms)
+{
+  double start = now_ms();
+  void *table = t->new_table(num);
+  for (size_t i = 0; i < num; i++)
+    t->insert(table, i + 1, &emails[i]);
+  ms[STEP_INSERT] = now_ms() - start;
+
+  for (size_t i = 0; i < num; i++)
+    order[i] = i + 1;
+  shuffle(order, num, seed);
+  start = now_ms();
+  for (size_t i = 0; i < num; i++)
+  {
+    if (t->find(table, order[i]) != &emails[order[i] - 1])
+    {
+      fprintf(stderr, "%s: UID %u not found\n", t->name, order[i]);
+      exit(1);
+    }
+  }
+  ms[STEP_FIND] = now_ms() - start;
+
+  /* order is still shuffled: expunge the first half of it */
+  start = now_ms();
+  for (size_t i = 0; i < (num / 2); i++)
+    t->delete(table, order[i], &emails[order[i] - 1]);
+  ms[STEP_EXPUNGE] = now_ms() - start;
+
+  /* refill, then drop a range, as VANISHED does */
+  for (size_t i = 0; i < (num / 2); i++)
+    t->insert(table, order[i], &emails[order[i] - 1]);
+  start = now_ms();
+  for (size_t i = 1; i <= (num / 4); i++)
+    t->delete(table, i, &emails[i - 1]);
+  ms[STEP_VANISHED] = now_ms() - start;
+
+  /* then the oldest of the rest */
+  start = now_ms();
+  for (size_t i = (num / 4) + 1; i <= ((num / 4) + (num / 2)); i++)
+    t->delete(table, i, &emails[i - 1]);
+  ms[STEP_OLDEST] = now_ms() - start;
+
+  for (size_t i = (num / 4) + (num / 2) + 1; i <= num; i++)
+  {
+    if (t->find(table, i) != &emails[i - 1])
+    {
+      fprintf(stderr, "%s: UID %zu lost\n", t->name, i);
+      exit(1);
+    }
+  }
+
+  start = now_ms();
+  t->free_table(table);
+  ms[STEP_FREE] = now_ms() - start;
+}
+
+/**
+ * run_child - Time each step once, in a new process
+ * @param t    Table to test
+ * @param num  Number of messages
+ * @param seed Random seed
+ * @param ms   Time of each step, in milliseconds
+ */
+static void run_child(const struct BenchTable *t, size_t num, unsigned int seed, double *ms)
+{
+  int fd[2];
+  if (pipe(fd) < 0)
+  {
+    perror("pipe");
+    exit(1);
+  }
+
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    perror("fork");
+    exit(1);
+  }
+
+  if (pid == 0)
+  {
+    close(fd[0]);
+    struct Email *emails = mutt_mem_calloc(num, sizeof(struct Email));
+    unsigned int *order = mutt_mem_malloc(num * sizeof(unsigned int));
+    run_once(t, num, emails, order, seed, ms);
+    if (write(fd[1], ms, STEP_MAX * sizeof(double)) != (STEP_MAX * sizeof(double)))
+      _exit(1);
+    _exit(0);
+  }
+
+  close(fd[1]);
+  const ssize_t len = read(fd[0], ms, STEP_MAX * sizeof(double));
+  close(fd[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if ((len != (STEP_MAX * sizeof(double))) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+  {
+    fprintf(stderr, "%s: run failed\n", t->name);
+    exit(1);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  static const char *defaults[] = { "10000", "100000", "1000000" };
+  const char **sizes = defaults;
+  int num_sizes = mutt_array_size(defaults);
+  if (argc > 1)
+  {
+    sizes = (const char **) (argv + 1);
+    num_sizes = argc - 1;
+  }
+
+  printf("%10s %-10s", "messages", "table");
+  for (int s = 0; s < STEP_MAX; s++)
+    printf(" %9s", StepNames[s]);
+  printf("   (ms, best of %d)\n", RUNS);
+
+  for (int i = 0; i < num_sizes; i++)
+  {
+    size_t num = strtoul(sizes[i], NULL, 10);
+    if (num < 4)
+      continue;
+
+    for (size_t t = 0; t < mutt_array_size(Tables); t++)
+    {
+      double best[STEP_MAX];
+      for (int run = 0; run < RUNS; run++)
+      {
+        double ms[STEP_MAX];
+        run_child(&Tables[t], num, 42 + run, ms);
+        for (int s = 0; s < STEP_MAX; s++)
+          if ((run == 0) || (ms[s] < best[s]))
+            best[s] = ms[s];
+      }
+
+      printf("%10zu %-10s", num, Tables[t].name);
+      for (int s = 0; s < STEP_MAX; s++)
+        printf(" %9.2f", best[s]);
+      printf("\n");
+    }
+  }
+
+  return 0;
+}
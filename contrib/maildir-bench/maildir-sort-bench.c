@@ -0,0 +1,279 @@
+/**
+ * @file
+ * Time the Maildir message list sorts
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares maildir_sort_inode(), linked from the tree, with the linked-list
+ * merge sort it replaced, which is copied below.  Build it from the top of a
+ * built source tree:
+ *
+ *   cc -O2 -I. -o maildir-sort-bench contrib/maildir-bench/maildir-sort-bench.c \
+ *      maildir/sort.o libmutt.a
+ *
+ * Usage: maildir-sort-bench [SIZE...]
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mutt/mutt.h"
+#include "maildir/maildir_private.h"
+
+#define INS_SORT_THRESHOLD 6
+#define RUNS 5
+
+/**
+ * md_cmp_inode - Compare two Maildirs by inode number
+ */
+static int md_cmp_inode(struct Maildir *a, struct Maildir *b)
+{
+  return a->inode - b->inode;
+}
+
+/**
+ * maildir_merge_lists - Merge two maildir lists
+ */
+static struct Maildir *maildir_merge_lists(struct Maildir *left, struct Maildir *right,
+                                           int (*cmp)(struct Maildir *, struct Maildir *))
+{
+  struct Maildir *head = NULL;
+  struct Maildir *tail = NULL;
+
+  if (left && right)
+  {
+    if (cmp(left, right) < 0)
+    {
+      head = left;
+      left = left->next;
+    }
+    else
+    {
+      head = right;
+      right = right->next;
+    }
+  }
+  else
+  {
+    if (left)
+      return left;
+    else
+      return right;
+  }
+
+  tail = head;
+
+  while (left && right)
+  {
+    if (cmp(left, right) < 0)
+    {
+      tail->next = left;
+      left = left->next;
+    }
+    else
+    {
+      tail->next = right;
+      right = right->next;
+    }
+    tail = tail->next;
+  }
+
+  if (left)
+    tail->next = left;
+  else
+    tail->next = right;
+
+  return head;
+}
+
+/**
+ * maildir_ins_sort - Sort maildirs using an insertion sort
+ */
+static struct Maildir *maildir_ins_sort(struct Maildir *list,
+                                        int (*cmp)(struct Maildir *, struct Maildir *))
+{
+  struct Maildir *tmp = NULL, *last = NULL, *back = NULL;
+
+  struct Maildir *ret = list;
+  list = list->next;
+  ret->next = NULL;
+
+  while (list)
+  {
+    last = NULL;
+    back = list->next;
+    for (tmp = ret; tmp && cmp(tmp, list) <= 0; tmp = tmp->next)
+      last = tmp;
+
+    list->next = tmp;
+    if (last)
+      last->next = list;
+    else
+      ret = list;
+
+    list = back;
+  }
+
+  return ret;
+}
+
+/**
+ * maildir_sort - Sort Maildir list (the previous implementation)
+ */
+static struct Maildir *maildir_sort(struct Maildir *list, size_t len,
+                                    int (*cmp)(struct Maildir *, struct Maildir *))
+{
+  struct Maildir *left = list;
+  struct Maildir *right = list;
+  size_t c = 0;
+
+  if (!list || !list->next)
+    return list;
+
+  if ((len != (size_t)(-1)) && (len <= INS_SORT_THRESHOLD))
+    return maildir_ins_sort(list, cmp);
+
+  list = list->next;
+  while (list && list->next)
+  {
+    right = right->next;
+    list = list->next->next;
+    c++;
+  }
+
+  list = right;
+  right = right->next;
+  list->next = 0;
+
+  left = maildir_sort(left, c, cmp);
+  right = maildir_sort(right, c, cmp);
+  return maildir_merge_lists(left, right, cmp);
+}
+
+/**
+ * list_sort_inode - Sort with the previous implementation
+ */
+static struct Maildir *list_sort_inode(struct Maildir *list)
+{
+  return maildir_sort(list, (size_t) -1, md_cmp_inode);
+}
+
+/**
+ * now_ms - Read the monotonic clock
+ */
+static double now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+/**
+ * make_list - Create a list of Maildirs in random inode order
+ *
+ * The nodes are allocated in a different random order from the one they're
+ * linked in, so that following the list jumps about the heap, as it does after
+ * a real scan.
+ */
+static struct Maildir *make_list(struct Maildir **nodes, size_t num, unsigned int seed)
+{
+  srand(seed);
+  size_t *order = mutt_mem_malloc(num * sizeof(size_t));
+  for (size_t i = 0; i < num; i++)
+    order[i] = i;
+  for (size_t i = num - 1; i > 0; i--)
+  {
+    size_t j = (size_t) rand() % (i + 1);
+    size_t tmp = order[i];
+    order[i] = order[j];
+    order[j] = tmp;
+  }
+
+  for (size_t i = 0; i < num; i++)
+  {
+    nodes[i] = mutt_mem_calloc(1, sizeof(struct Maildir));
+    /* Positive and below 2^31, which the old comparison needs */
+    nodes[i]->inode = (ino_t)(rand() & 0x7fffffff);
+  }
+  for (size_t i = 0; i < (num - 1); i++)
+    nodes[order[i]]->next = nodes[order[i + 1]];
+  nodes[order[num - 1]]->next = NULL;
+
+  struct Maildir *list = nodes[order[0]];
+  FREE(&order);
+  return list;
+}
+
+/**
+ * time_sort - Time the best of several sorts of the same list
+ */
+static double time_sort(struct Maildir *(*sort)(struct Maildir *), size_t num)
+{
+  struct Maildir **nodes = mutt_mem_malloc(num * sizeof(struct Maildir *));
+  double best = -1;
+
+  for (int run = 0; run < RUNS; run++)
+  {
+    struct Maildir *list = make_list(nodes, num, 42 + run);
+    double start = now_ms();
+    list = sort(list);
+    double elapsed = now_ms() - start;
+    if ((best < 0) || (elapsed < best))
+      best = elapsed;
+
+    for (struct Maildir *p = list; p && p->next; p = p->next)
+    {
+      if (p->inode > p->next->inode)
+      {
+        fprintf(stderr, "list isn't sorted\n");
+        exit(1);
+      }
+    }
+
+    for (size_t i = 0; i < num; i++)
+      FREE(&nodes[i]);
+  }
+
+  FREE(&nodes);
+  return best;
+}
+
+int main(int argc, char *argv[])
+{
+  static const char *defaults[] = { "10000", "100000", "1000000" };
+  const char **sizes = defaults;
+  int num_sizes = mutt_array_size(defaults);
+  if (argc > 1)
+  {
+    sizes = (const char **) (argv + 1);
+    num_sizes = argc - 1;
+  }
+
+  printf("%10s %18s %18s\n", "entries", "list merge sort", "array radix sort");
+  for (int i = 0; i < num_sizes; i++)
+  {
+    size_t num = strtoul(sizes[i], NULL, 10);
+    if (num < 2)
+      continue;
+    double old = time_sort(list_sort_inode, num);
+    double new = time_sort(maildir_sort_inode, num);
+    printf("%10zu %15.2f ms %15.2f ms\n", num, old, new);
+  }
+
+  return 0;
+}
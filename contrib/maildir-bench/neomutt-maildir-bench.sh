@@ -0,0 +1,104 @@
+#!/usr/bin/env bash
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+# ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+usage()
+{
+    echo "Usage: $(basename "$0") -e <neomutt> [-e <neomutt>...] -n <sizes> -t <times>"
+    echo ""
+    echo "   -e Path to a neomutt executable (repeat to compare builds)"
+    echo "   -n List of maildir sizes, e.g. \"10000 100000 1000000\""
+    echo "   -t Number of times to repeat the test"
+    echo ""
+}
+
+while getopts e:n:t: OPT; do
+    case "$OPT" in
+        e)
+            NEOMUTTS="$NEOMUTTS $OPTARG"
+            ;;
+        n)
+            SIZES="$OPTARG"
+            ;;
+        t)
+            TIMES="$OPTARG"
+            ;;
+        *)
+            usage
+            exit 1
+    esac
+done
+
+if [ -z "$NEOMUTTS" ] || [ -z "$SIZES" ] || [ -z "$TIMES" ]; then
+    usage
+    exit 1
+fi
+
+CWD=$(dirname $(realpath $0))
+TMPDIR=$(mktemp -d)
+
+echo "Running in $TMPDIR"
+
+# Create a maildir of $2 small messages in $1.  The files are created in a
+# random order, so their inode numbers don't follow their names.
+generate()
+{
+    mkdir -p "$1/cur" "$1/new" "$1/tmp"
+    seq "$2" | shuf | while read -r i; do
+        printf "From: user%d@example.com\nSubject: message %d\nMessage-Id: <%d@example.com>\n\nbody\n" \
+            "$i" "$i" "$i" > "$1/cur/$i.bench:2,S"
+    done
+}
+
+exe()
+{
+    export my_maildir=$2
+    t=$({ time -p "$1" -n -F "$CWD"/neomuttrc > /dev/null 2>&1; } 2>&1)
+    echo "$t" | xargs
+}
+
+avg()
+{
+    echo "$*" | awk '{ s = 0; for (i = 1; i <= NF; i++) s += $i; printf "%.3f", s / NF }'
+}
+
+for n in $SIZES; do
+    printf "generating %d messages\n" "$n"
+    generate "$TMPDIR/maildir-$n" "$n"
+done
+
+for i in $(seq "$TIMES"); do
+    for n in $SIZES; do
+        for e in $NEOMUTTS; do
+            printf "%d - %d - %s\n" "$i" "$n" "$e"
+            echo "$n $e $(exe "$e" "$TMPDIR/maildir-$n")" >> "$TMPDIR"/result.txt
+        done
+    done
+done
+
+echo ""
+for n in $SIZES; do
+    for e in $NEOMUTTS; do
+        real=$(avg "$(grep "^$n $e " "$TMPDIR/result.txt" | awk '{print $4}' | xargs)")
+        printf "%8d %-30s %s real\n" "$n" "$e" "$real"
+    done
+done
@@ -1007,6 +1007,149 @@ char *mutt_rfc822_read_line(FILE *fp, char *line, size_t *linelen)
   /* not reached */
 }
 
+/**
+ * read_header_init - Prepare an Email for its headers to be read
+ * @param e Email (optional)
+ */
+static void read_header_init(struct Email *e)
+{
+  if (!e || e->content)
+    return;
+
+  e->content = mutt_body_new();
+
+  /* set the defaults from RFC1521 */
+  e->content->type = TYPE_TEXT;
+  e->content->subtype = mutt_str_strdup("plain");
+  e->content->encoding = ENC_7BIT;
+  e->content->length = -1;
+
+  /* RFC2183 says this is arbitrary */
+  e->content->disposition = DISP_INLINE;
+}
+
+/**
+ * read_header_field - Parse one unfolded header field
+ * @param env       Envelope of the email
+ * @param e         Email (optional)
+ * @param line      Header field, as read by mutt_rfc822_read_line()
+ * @param user_hdrs If set, store user headers
+ * @param weed      If set, honour the header weed list for user headers
+ * @retval true  Keep reading
+ * @retval false The line isn't a header field; the header has ended
+ */
+static bool read_header_field(struct Envelope *env, struct Email *e, char *line,
+                              bool user_hdrs, bool weed)
+{
+  char buf[1025];
+  char *p = strpbrk(line, ": \t");
+  if (!p || (*p != ':'))
+  {
+    char return_path[1024];
+    time_t t;
+
+    /* some bogus MTAs will quote the original "From " line */
+    if (mutt_str_startswith(line, ">From ", CASE_MATCH))
+      return true; /* just ignore */
+    else if (is_from(line, return_path, sizeof(return_path), &t))
+    {
+      /* MH sometimes has the From_ line in the middle of the header! */
+      if (e && !e->received)
+        e->received = t - mutt_date_local_tz(t);
+      return true;
+    }
+
+    return false; /* end of header */
+  }
+
+  *buf = '\0';
+
+  if (mutt_replacelist_match(&SpamList, buf, sizeof(buf), line))
+  {
+    if (!mutt_regexlist_match(&NoSpamList, line))
+    {
+      /* if spam tag already exists, figure out how to amend it */
+      if (env->spam && (*buf != '\0'))
+      {
+        /* If C_SpamSeparator defined, append with separator */
+        if (C_SpamSeparator)
+        {
+          mutt_buffer_addstr(env->spam, C_SpamSeparator);
+          mutt_buffer_addstr(env->spam, buf);
+        }
+        else /* overwrite */
+        {
+          mutt_buffer_reset(env->spam);
+          mutt_buffer_addstr(env->spam, buf);
+        }
+      }
+
+      /* spam tag is new, and match expr is non-empty; copy */
+      else if (!env->spam && (*buf != '\0'))
+      {
+        env->spam = mutt_buffer_from(buf);
+      }
+
+      /* match expr is empty; plug in null string if no existing tag */
+      else if (!env->spam)
+      {
+        env->spam = mutt_buffer_from("");
+      }
+
+      if (env->spam && env->spam->data)
+        mutt_debug(5, "spam = %s\n", env->spam->data);
+    }
+  }
+
+  *p = '\0';
+  p = mutt_str_skip_email_wsp(p + 1);
+  if (!*p)
+    return true; /* skip empty header fields */
+
+  mutt_rfc822_parse_line(env, e, line, p, user_hdrs, weed, true);
+  return true;
+}
+
+/**
+ * read_header_finish - Tidy up after reading an Email's headers
+ * @param env Envelope of the email
+ * @param e   Email (optional)
+ */
+static void read_header_finish(struct Envelope *env, struct Email *e)
+{
+  if (!e)
+    return;
+
+  rfc2047_decode_envelope(env);
+
+  if (env->subject)
+  {
+    regmatch_t pmatch[1];
+
+    if (C_ReplyRegex && C_ReplyRegex->regex &&
+        (regexec(C_ReplyRegex->regex, env->subject, 1, pmatch, 0) == 0))
+    {
+      env->real_subj = env->subject + pmatch[0].rm_eo;
+    }
+    else
+      env->real_subj = env->subject;
+  }
+
+  if (e->received < 0)
+  {
+    mutt_debug(LL_DEBUG1, "resetting invalid received time to 0\n");
+    e->received = 0;
+  }
+
+  /* check for missing or invalid date */
+  if (e->date_sent <= 0)
+  {
+    mutt_debug(LL_DEBUG1,
+               "no date found, using received time from msg separator\n");
+    e->date_sent = e->received;
+  }
+}
+
 /**
  * mutt_rfc822_read_header - parses an RFC822 header
  * @param fp        Stream to read from
@@ -1026,100 +1169,23 @@ struct Envelope *mutt_rfc822_read_header(FILE *fp, struct Email *e, bool user_hd
     return NULL;
 
   struct Envelope *env = mutt_env_new();
-  char *p = NULL;
   LOFF_T loc;
   size_t linelen = 1024;
   char *line = mutt_mem_malloc(linelen);
-  char buf[linelen + 1];
-
-  if (e)
-  {
-    if (!e->content)
-    {
-      e->content = mutt_body_new();
 
-      /* set the defaults from RFC1521 */
-      e->content->type = TYPE_TEXT;
-      e->content->subtype = mutt_str_strdup("plain");
-      e->content->encoding = ENC_7BIT;
-      e->content->length = -1;
-
-      /* RFC2183 says this is arbitrary */
-      e->content->disposition = DISP_INLINE;
-    }
-  }
+  read_header_init(e);
 
   while ((loc = ftello(fp)) != -1)
   {
     line = mutt_rfc822_read_line(fp, line, &linelen);
     if (*line == '\0')
       break;
-    p = strpbrk(line, ": \t");
-    if (!p || (*p != ':'))
-    {
-      char return_path[1024];
-      time_t t;
-
-      /* some bogus MTAs will quote the original "From " line */
-      if (mutt_str_startswith(line, ">From ", CASE_MATCH))
-        continue; /* just ignore */
-      else if (is_from(line, return_path, sizeof(return_path), &t))
-      {
-        /* MH sometimes has the From_ line in the middle of the header! */
-        if (e && !e->received)
-          e->received = t - mutt_date_local_tz(t);
-        continue;
-      }
 
+    if (!read_header_field(env, e, line, user_hdrs, weed))
+    {
       fseeko(fp, loc, SEEK_SET);
       break; /* end of header */
     }
-
-    *buf = '\0';
-
-    if (mutt_replacelist_match(&SpamList, buf, sizeof(buf), line))
-    {
-      if (!mutt_regexlist_match(&NoSpamList, line))
-      {
-        /* if spam tag already exists, figure out how to amend it */
-        if (env->spam && (*buf != '\0'))
-        {
-          /* If C_SpamSeparator defined, append with separator */
-          if (C_SpamSeparator)
-          {
-            mutt_buffer_addstr(env->spam, C_SpamSeparator);
-            mutt_buffer_addstr(env->spam, buf);
-          }
-          else /* overwrite */
-          {
-            mutt_buffer_reset(env->spam);
-            mutt_buffer_addstr(env->spam, buf);
-          }
-        }
-
-        /* spam tag is new, and match expr is non-empty; copy */
-        else if (!env->spam && (*buf != '\0'))
-        {
-          env->spam = mutt_buffer_from(buf);
-        }
-
-        /* match expr is empty; plug in null string if no existing tag */
-        else if (!env->spam)
-        {
-          env->spam = mutt_buffer_from("");
-        }
-
-        if (env->spam && env->spam->data)
-          mutt_debug(5, "spam = %s\n", env->spam->data);
-      }
-    }
-
-    *p = '\0';
-    p = mutt_str_skip_email_wsp(p + 1);
-    if (!*p)
-      continue; /* skip empty header fields */
-
-    mutt_rfc822_parse_line(env, e, line, p, user_hdrs, weed, true);
   }
 
   FREE(&line);
@@ -1128,37 +1194,137 @@ struct Envelope *mutt_rfc822_read_header(FILE *fp, struct Email *e, bool user_hd
   {
     e->content->hdr_offset = e->offset;
     e->content->offset = ftello(fp);
+  }
 
-    rfc2047_decode_envelope(env);
+  read_header_finish(env, e);
+  return env;
+}
+
+/**
+ * read_line_mem - Read a header line from memory
+ * @param[in,out] pos     Current position, updated
+ * @param[in]     end     End of the data
+ * @param[in]     line    Buffer to store the result
+ * @param[in,out] linelen Length of buffer
+ * @retval ptr Line read
+ *
+ * This behaves exactly like mutt_rfc822_read_line(): continuation lines are
+ * joined, trailing whitespace is removed and a blank line, or the end of the
+ * data, returns an empty string.  A final line without a newline is ignored.
+ */
+static char *read_line_mem(const char **pos, const char *end, char *line, size_t *linelen)
+{
+  const char *p = *pos;
+  size_t offset = 0;
 
-    if (env->subject)
+  if ((p == end) || IS_SPACE(*p))
+  {
+    /* end of headers: the blank line is consumed, like fgets() would */
+    const char *nl = memchr(p, '\n', end - p);
+    *pos = nl ? (nl + 1) : end;
+    *line = '\0';
+    return line;
+  }
+
+  while (true)
+  {
+    const char *nl = memchr(p, '\n', end - p);
+    if (!nl)
     {
-      regmatch_t pmatch[1];
+      *pos = end;
+      *line = '\0';
+      return line;
+    }
 
-      if (C_ReplyRegex && C_ReplyRegex->regex &&
-          (regexec(C_ReplyRegex->regex, env->subject, 1, pmatch, 0) == 0))
-      {
-        env->real_subj = env->subject + pmatch[0].rm_eo;
-      }
-      else
-        env->real_subj = env->subject;
+    size_t len = nl - p;
+    if (*linelen < (offset + len + 2))
+    {
+      *linelen = offset + len + 256;
+      mutt_mem_realloc(&line, *linelen);
     }
+    memcpy(line + offset, p, len);
+    offset += len;
+    line[offset] = '\0';
+
+    /* we got a full line. remove trailing space */
+    while ((offset > 0) && IS_SPACE(line[offset - 1]))
+      line[--offset] = '\0';
+
+    p = nl + 1;
 
-    if (e->received < 0)
+    /* check to see if the next line is a continuation line */
+    if ((p == end) || ((*p != ' ') && (*p != '\t')))
     {
-      mutt_debug(LL_DEBUG1, "resetting invalid received time to 0\n");
-      e->received = 0;
+      *pos = p;
+      return line; /* next line is a separate header field or EOH */
     }
 
-    /* check for missing or invalid date */
-    if (e->date_sent <= 0)
+    /* eat tabs and spaces from the beginning of the continuation line */
+    while ((p < end) && ((*p == ' ') || (*p == '\t')))
+      p++;
+    line[offset++] = ' ';
+    line[offset] = '\0';
+  }
+  /* not reached */
+}
+
+/**
+ * mutt_rfc822_read_header_mem - Parse an RFC822 header held in memory
+ * @param data      Header data
+ * @param len       Length of the data
+ * @param e         Current Email (optional)
+ * @param user_hdrs If set, store user headers
+ * @param weed      If set, honour the header weed list for user headers
+ * @retval ptr Newly allocated envelope structure
+ *
+ * This is the same as mutt_rfc822_read_header(), but works on a buffer rather
+ * than a stream.  The offsets stored in the Email's Body are relative to the
+ * start of data, i.e. as if it had been read from the start of a file.
+ * Empty data, even NULL, gives an empty Envelope.
+ *
+ * Caller should free the Envelope using mutt_env_free().
+ */
+struct Envelope *mutt_rfc822_read_header_mem(const char *data, size_t len,
+                                             struct Email *e, bool user_hdrs, bool weed)
+{
+  if (!data)
+  {
+    if (len != 0)
+      return NULL;
+    data = "";
+  }
+
+  struct Envelope *env = mutt_env_new();
+  const char *pos = data;
+  const char *end = data + len;
+  size_t linelen = 1024;
+  char *line = mutt_mem_malloc(linelen);
+
+  read_header_init(e);
+
+  while (true)
+  {
+    const char *loc = pos;
+    line = read_line_mem(&pos, end, line, &linelen);
+    if (*line == '\0')
+      break;
+
+    if (!read_header_field(env, e, line, user_hdrs, weed))
     {
-      mutt_debug(LL_DEBUG1,
-                 "no date found, using received time from msg separator\n");
-      e->date_sent = e->received;
+      pos = loc;
+      break; /* end of header */
     }
   }
 
+  FREE(&line);
+
+  if (e)
+  {
+    e->content->hdr_offset = e->offset;
+    e->content->offset = pos - data;
+  }
+
+  read_header_finish(env, e);
   return env;
 }
 
@@ -46,6 +46,7 @@ struct Body *    mutt_read_mime_header(FILE *fp, bool digest);
 int              mutt_rfc822_parse_line(struct Envelope *env, struct Email *e, char *line, char *p, bool user_hdrs, bool weed, bool do_2047);
 struct Body *    mutt_rfc822_parse_message(FILE *fp, struct Body *parent);
 struct Envelope *mutt_rfc822_read_header(FILE *fp, struct Email *e, bool user_hdrs, bool weed);
+struct Envelope *mutt_rfc822_read_header_mem(const char *data, size_t len, struct Email *e, bool user_hdrs, bool weed);
 char *           mutt_rfc822_read_line(FILE *fp, char *line, size_t *linelen);
 
 #endif /* MUTT_EMAIL_PARSE_H */
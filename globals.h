@@ -210,9 +210,9 @@ WHERE bool C_FlagSafe;                       ///< Config: Protect flagged messag
 WHERE bool C_ForwardDecode;                  ///< Config: Decode the message when forwarding it
 WHERE bool C_ForwardQuote;                   ///< Config: Automatically quote a forwarded message using #C_IndentString
 #ifdef USE_HCACHE
-#if defined(HAVE_QDBM) || defined(HAVE_TC) || defined(HAVE_KC)
-WHERE bool C_HeaderCacheCompress;            ///< Config: (hcache) Enable database compression (qdbm,tokyocabinet,kyotocabinet)
-#endif /* HAVE_QDBM | HAVE_TC | HAVE_KC */
+#if defined(HAVE_QDBM) || defined(HAVE_TC) || defined(HAVE_KC) || defined(HAVE_ZLIB)
+WHERE bool C_HeaderCacheCompress;            ///< Config: (hcache) Enable database compression (qdbm,tokyocabinet,kyotocabinet,zlib)
+#endif /* HAVE_QDBM | HAVE_TC | HAVE_KC | HAVE_ZLIB */
 #endif /* USE_HCACHE */
 WHERE bool C_Header;                         ///< Config: Include the message headers in the reply email (Weed applies)
 WHERE bool C_Help;                           ///< Config: Display a help line with common key bindings
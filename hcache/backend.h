@@ -55,10 +55,11 @@ struct HcacheOps
    * @param ctx    The backend-specific context retrieved via open()
    * @param key    A message identification string
    * @param keylen The length of the string pointed to by key
+   * @param dlen   Length of the data found
    * @retval ptr  Success, message's headers
    * @retval NULL Otherwise
    */
-  void *(*fetch)(void *ctx, const char *key, size_t keylen);
+  void *(*fetch)(void *ctx, const char *key, size_t keylen, size_t *dlen);
   /**
    * free - backend-specific routine to free fetched data
    * @param[in]  ctx The backend-specific context retrieved via open()
@@ -85,6 +86,26 @@ struct HcacheOps
    * @retval num Error, a backend-specific error code
    */
   int (*delete)(void *ctx, const char *key, size_t keylen);
+  /**
+   * begin - backend-specific routine to start a batch of writes
+   * @param ctx The backend-specific context retrieved via open()
+   * @retval 0   Success
+   * @retval num Error, a backend-specific error code
+   *
+   * All store() and delete() calls until the matching commit() may be grouped
+   * into a single transaction.  Backends without transactions may treat this
+   * as a no-op.
+   */
+  int (*begin)(void *ctx);
+  /**
+   * commit - backend-specific routine to finish a batch of writes
+   * @param ctx The backend-specific context retrieved via open()
+   * @retval 0   Success
+   * @retval num Error, a backend-specific error code
+   *
+   * Make all the writes since begin() durable.
+   */
+  int (*commit)(void *ctx);
   /**
    * close - backend-specific routine to close a context
    * @param[out] ctx The backend-specific context retrieved via open()
@@ -109,6 +130,8 @@ struct HcacheOps
     .free    = hcache_##_name##_free,                                          \
     .store   = hcache_##_name##_store,                                         \
     .delete  = hcache_##_name##_delete,                                        \
+    .begin   = hcache_##_name##_begin,                                         \
+    .commit  = hcache_##_name##_commit,                                        \
     .close   = hcache_##_name##_close,                                         \
     .backend = hcache_##_name##_backend,                                       \
   };
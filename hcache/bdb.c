@@ -153,7 +153,8 @@ fail_close:
 /**
  * hcache_bdb_fetch - Implements HcacheOps::fetch()
  */
-static void *hcache_bdb_fetch(void *vctx, const char *key, size_t keylen)
+static void *hcache_bdb_fetch(void *vctx, const char *key, size_t keylen,
+                              size_t *dlen)
 {
   if (!vctx)
     return NULL;
@@ -169,6 +170,7 @@ static void *hcache_bdb_fetch(void *vctx, const char *key, size_t keylen)
 
   ctx->db->get(ctx->db, NULL, &dkey, &data, 0);
 
+  *dlen = data.size;
   return data.data;
 }
 
@@ -219,6 +221,33 @@ static int hcache_bdb_delete(void *vctx, const char *key, size_t keylen)
   return ctx->db->del(ctx->db, NULL, &dkey, 0);
 }
 
+/**
+ * hcache_bdb_begin - Implements HcacheOps::begin()
+ *
+ * The environment isn't transactional, so writes are only buffered in the
+ * memory pool until hcache_bdb_commit() flushes them.
+ */
+static int hcache_bdb_begin(void *vctx)
+{
+  if (!vctx)
+    return -1;
+
+  return 0;
+}
+
+/**
+ * hcache_bdb_commit - Implements HcacheOps::commit()
+ */
+static int hcache_bdb_commit(void *vctx)
+{
+  if (!vctx)
+    return -1;
+
+  struct HcacheDbCtx *ctx = vctx;
+
+  return ctx->db->sync(ctx->db, 0);
+}
+
 /**
  * hcache_bdb_close - Implements HcacheOps::close()
  */
@@ -57,7 +57,8 @@ static void *hcache_gdbm_open(const char *path)
 /**
  * hcache_gdbm_fetch - Implements HcacheOps::fetch()
  */
-static void *hcache_gdbm_fetch(void *ctx, const char *key, size_t keylen)
+static void *hcache_gdbm_fetch(void *ctx, const char *key, size_t keylen,
+                               size_t *dlen)
 {
   if (!ctx)
     return NULL;
@@ -70,6 +71,7 @@ static void *hcache_gdbm_fetch(void *ctx, const char *key, size_t keylen)
   dkey.dptr = (char *) key;
   dkey.dsize = keylen;
   data = gdbm_fetch(db, dkey);
+  *dlen = data.dsize;
   return data.dptr;
 }
 
@@ -121,6 +123,33 @@ static int hcache_gdbm_delete(void *ctx, const char *key, size_t keylen)
   return gdbm_delete(db, dkey);
 }
 
+/**
+ * hcache_gdbm_begin - Implements HcacheOps::begin()
+ *
+ * GDBM has no transactions; the database is opened without GDBM_SYNC, so
+ * writes are only flushed to disk by hcache_gdbm_commit().
+ */
+static int hcache_gdbm_begin(void *ctx)
+{
+  if (!ctx)
+    return -1;
+
+  return 0;
+}
+
+/**
+ * hcache_gdbm_commit - Implements HcacheOps::commit()
+ */
+static int hcache_gdbm_commit(void *ctx)
+{
+  if (!ctx)
+    return -1;
+
+  GDBM_FILE db = ctx;
+  gdbm_sync(db);
+  return 0;
+}
+
 /**
  * hcache_gdbm_close - Implements HcacheOps::close()
  */
@@ -51,6 +51,7 @@
 #include "mutt/mutt.h"
 #include "email/lib.h"
 #include "backend.h"
+#include "globals.h"
 #include "hcache.h"
 #include "hcache/hcversion.h"
 
@@ -135,6 +136,37 @@ static bool crc_matches(const char *d, unsigned int crc)
   return crc == mycrc;
 }
 
+/**
+ * compress_records - Should records be compressed before storing them?
+ * @param ops Backend in use
+ * @retval true Records should be compressed
+ *
+ * qdbm, tokyocabinet and kyotocabinet compress the whole database themselves,
+ * so records are only compressed for the other backends.
+ */
+static bool compress_records(const struct HcacheOps *ops)
+{
+#ifdef HAVE_ZLIB
+  if (!C_HeaderCacheCompress)
+    return false;
+#ifdef HAVE_QDBM
+  if (ops == &hcache_qdbm_ops)
+    return false;
+#endif
+#ifdef HAVE_TC
+  if (ops == &hcache_tokyocabinet_ops)
+    return false;
+#endif
+#ifdef HAVE_KC
+  if (ops == &hcache_kyotocabinet_ops)
+    return false;
+#endif
+  return true;
+#else
+  return false;
+#endif
+}
+
 /**
  * create_hcache_dir - Create parent dirs for the hcache database
  * @param path Database filename
@@ -276,6 +308,10 @@ header_cache_t *mutt_hcache_open(const char *path, const char *folder, hcache_na
     /* Seed with the compiled-in header structure hash */
     mutt_md5_process_bytes(&hcachever, sizeof(hcachever), &md5ctx);
 
+    /* Mix in the record format, so other versions see our records as misses */
+    const unsigned int format = HCACHE_FORMAT_VERSION;
+    mutt_md5_process_bytes(&format, sizeof(format), &md5ctx);
+
     /* Mix in user's spam list */
     struct ReplaceListNode *sp = NULL;
     STAILQ_FOREACH(sp, &SpamList, entries)
@@ -346,13 +382,14 @@ void mutt_hcache_close(header_cache_t *hc)
  */
 void *mutt_hcache_fetch(header_cache_t *hc, const char *key, size_t keylen)
 {
-  void *data = mutt_hcache_fetch_raw(hc, key, keylen);
+  size_t dlen = 0;
+  void *data = mutt_hcache_fetch_raw(hc, key, keylen, &dlen);
   if (!data)
   {
     return NULL;
   }
 
-  if (!crc_matches(data, hc->crc))
+  if (!mutt_hcache_is_valid(hc, data, dlen))
   {
     mutt_hcache_free(hc, &data);
     return NULL;
@@ -361,20 +398,30 @@ void *mutt_hcache_fetch(header_cache_t *hc, const char *key, size_t keylen)
   return data;
 }
 
+/**
+ * mutt_hcache_is_valid - Check a record that wasn't read by mutt_hcache_fetch
+ */
+bool mutt_hcache_is_valid(header_cache_t *hc, const void *d, size_t dlen)
+{
+  return hc && d && (dlen >= (sizeof(union Validate) + sizeof(unsigned int))) &&
+         crc_matches(d, hc->crc) && mutt_hcache_is_supported(d, dlen);
+}
+
 /**
  * mutt_hcache_fetch_raw - Fetch a message's header from the cache
  * @param hc     Pointer to the header_cache_t structure got by mutt_hcache_open
  * @param key    Message identification string
  * @param keylen Length of the string pointed to by key
+ * @param dlen   Length of the data found, may be NULL
  * @retval ptr  Success, the data if found
  * @retval NULL Otherwise
  *
  * @note This function does not perform any check on the validity of the data
- *       found.
+ *       found.  Callers that walk the data must check it against @a dlen.
  * @note The returned pointer must be freed by calling mutt_hcache_free. This
  *       must be done before closing the header cache with mutt_hcache_close.
  */
-void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen)
+void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen, size_t *dlen)
 {
   char path[PATH_MAX];
   const struct HcacheOps *ops = hcache_get_ops();
@@ -384,7 +431,11 @@ void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen)
 
   keylen = snprintf(path, sizeof(path), "%s%s", hc->folder, key);
 
-  return ops->fetch(hc->ctx, path, keylen);
+  size_t len = 0;
+  void *data = ops->fetch(hc->ctx, path, keylen, &len);
+  if (dlen)
+    *dlen = data ? len : 0;
+  return data;
 }
 
 /**
@@ -411,7 +462,8 @@ int mutt_hcache_store(header_cache_t *hc, const char *key, size_t keylen,
 
   int dlen = 0;
 
-  char *data = mutt_hcache_dump(hc, e, &dlen, uidvalidity);
+  char *data = mutt_hcache_dump(hc, e, &dlen, uidvalidity,
+                                compress_records(hcache_get_ops()));
   int rc = mutt_hcache_store_raw(hc, key, keylen, data, dlen);
 
   FREE(&data);
@@ -459,6 +511,32 @@ int mutt_hcache_delete(header_cache_t *hc, const char *key, size_t keylen)
   return ops->delete (hc->ctx, path, keylen);
 }
 
+/**
+ * mutt_hcache_begin - Multiplexor for HcacheOps::begin
+ */
+int mutt_hcache_begin(header_cache_t *hc)
+{
+  const struct HcacheOps *ops = hcache_get_ops();
+
+  if (!hc || !ops)
+    return -1;
+
+  return ops->begin(hc->ctx);
+}
+
+/**
+ * mutt_hcache_commit - Multiplexor for HcacheOps::commit
+ */
+int mutt_hcache_commit(header_cache_t *hc)
+{
+  const struct HcacheOps *ops = hcache_get_ops();
+
+  if (!hc || !ops)
+    return -1;
+
+  return ops->commit(hc->ctx);
+}
+
 /**
  * mutt_hcache_backend_list - Get a list of backend names
  * @retval ptr Comma-space-separated list of names
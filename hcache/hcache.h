@@ -126,7 +126,19 @@ void mutt_hcache_close(header_cache_t *hc);
  */
 void *mutt_hcache_fetch(header_cache_t *hc, const char *key, size_t keylen);
 
-void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen);
+void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen, size_t *dlen);
+
+/**
+ * mutt_hcache_is_valid - Check a record that wasn't read by mutt_hcache_fetch
+ * @param hc Pointer to the header_cache_t structure got by mutt_hcache_open
+ * @param d    Record, as stored by mutt_hcache_store
+ * @param dlen Length of the record
+ * @retval true The record can be passed to mutt_hcache_restore()
+ *
+ * This performs the same checks as mutt_hcache_fetch, e.g. for records that
+ * were copied into a larger blob by the caller.
+ */
+bool mutt_hcache_is_valid(header_cache_t *hc, const void *d, size_t dlen);
 
 /**
  * mutt_hcache_free - free previously fetched data
@@ -136,6 +148,7 @@ void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen);
 void mutt_hcache_free(header_cache_t *hc, void **data);
 
 struct Email *mutt_hcache_restore(const unsigned char *d);
+void mutt_hcache_restore_flags(const unsigned char *d, struct Email *e);
 
 /**
  * mutt_hcache_store - store a Header along with a validity datum
@@ -163,6 +176,28 @@ int mutt_hcache_store_raw(header_cache_t *hc, const char *key, size_t keylen,
  */
 int mutt_hcache_delete(header_cache_t *hc, const char *key, size_t keylen);
 
+/**
+ * mutt_hcache_begin - start a batch of writes
+ * @param hc Pointer to the header_cache_t structure got by mutt_hcache_open
+ * @retval 0   Success
+ * @retval num Generic or backend-specific error code otherwise
+ *
+ * Stores and deletes until the matching mutt_hcache_commit() are grouped into
+ * a single backend transaction, where the backend supports it.  Use this when
+ * populating the cache for a whole mailbox.
+ */
+int mutt_hcache_begin(header_cache_t *hc);
+
+/**
+ * mutt_hcache_commit - finish a batch of writes
+ * @param hc Pointer to the header_cache_t structure got by mutt_hcache_open
+ * @retval 0   Success
+ * @retval num Generic or backend-specific error code otherwise
+ *
+ * @note Data returned by mutt_hcache_fetch() must be freed before committing.
+ */
+int mutt_hcache_commit(header_cache_t *hc);
+
 /**
  * mutt_hcache_backend_list - get a list of backend identification strings
  * @retval ptr Comma separated string describing the compiled-in backends
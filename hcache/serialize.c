@@ -27,650 +27,996 @@
  * @page hc_serial Email-object serialiser
  *
  * Email-object serialiser
+ *
+ * Emails are written as compact version 2 records.  Version 1 records, which
+ * stored raw structs, are no longer read: #HCACHE_FORMAT_VERSION is part of
+ * the cache's crc, so they are treated as cache misses and rewritten.
  */
 
 #include "config.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 #include "mutt/mutt.h"
 #include "address/lib.h"
 #include "email/lib.h"
 #include "hcache.h"
+#include "serialize.h"
 
-/**
- * lazy_malloc - Allocate some memory
- * @param size Minimum size to allocate
- * @retval ptr Allocated memory
+/* Version 2 records
+ *
+ * After the validity data and the crc, a version 2 record starts with two
+ * 0xff bytes.
  *
- * This block is likely to be lazy_realloc()'d repeatedly.
- * It starts off with a minimum size of 4KiB.
+ * | Field       | Encoding                                  |
+ * | :---------- | :---------------------------------------- |
+ * | magic       | 0xff 0xff                                 |
+ * | version     | 1 byte, #HCACHE_FORMAT_VERSION            |
+ * | flags       | 1 byte, e.g. #HCACHE_FORMAT_ZLIB          |
+ * | stored size | varint, size of the payload as stored     |
+ * | raw size    | varint, only if the payload is compressed |
+ * | payload     | the Email                                 |
+ *
+ * Integers in the payload are LEB128 varints; signed ones are zigzag encoded.
+ * Strings are stored once per record and repeats are replaced by a reference
+ * into the record's string table.  A string is encoded as a varint tag:
+ * - 0: NULL
+ * - even: literal of length (tag / 2 - 1), followed by the bytes
+ * - odd: reference to string number (tag / 2) of the table
  */
-static void *lazy_malloc(size_t size)
+
+#define HCACHE_FORMAT_MAGIC 0xff   ///< First two bytes of a version 2 record
+#define HCACHE_FORMAT_ZLIB (1 << 0) ///< Payload is compressed with zlib
+
+/* Only compress payloads larger than this */
+#define HCACHE_COMPRESS_MIN 256
+
+/**
+ * struct SerialString - A string stored in a record
+ */
+struct SerialString
 {
-  if (size < 4096)
-    size = 4096;
+  size_t off; ///< Offset of the string in the payload
+  size_t len; ///< Length of the string
+};
 
-  return mutt_mem_malloc(size);
-}
+/**
+ * struct SerialTable - Strings already seen in a record
+ */
+struct SerialTable
+{
+  struct SerialString *strings; ///< Array of strings
+  size_t num;                   ///< Number of strings in use
+  size_t max;                   ///< Number of strings allocated
+};
 
 /**
- * lazy_realloc - Reallocate some memory
- * @param ptr Pointer to resize
- * @param size Minimum size
- *
- * The minimum size is 4KiB to avoid repeated resizing.
+ * struct SerialWriter - Build a version 2 payload
  */
-static void lazy_realloc(void *ptr, size_t size)
+struct SerialWriter
 {
-  void **p = (void **) ptr;
+  unsigned char *data;      ///< Payload
+  size_t len;               ///< Length of the payload
+  size_t size;              ///< Allocated size of data
+  struct SerialTable table; ///< Strings written so far
+  size_t *slots;            ///< Hash of the strings, index+1 into table (0 is empty)
+  size_t num_slots;         ///< Number of hash slots (a power of 2)
+  bool convert;             ///< Convert strings to utf-8
+};
 
-  if (p && (size < 4096))
-    return;
+/**
+ * struct SerialReader - Parse a version 2 payload
+ */
+struct SerialReader
+{
+  const unsigned char *data; ///< Payload
+  size_t len;                ///< Length of the payload
+  size_t off;                ///< Current read position
+  struct SerialTable table;  ///< Strings read so far
+  bool convert;              ///< Convert strings from utf-8
+  bool error;                ///< Payload was truncated or corrupt
+};
 
-  mutt_mem_realloc(ptr, size);
+/**
+ * table_add - Remember a string in a record's string table
+ * @param t   String table
+ * @param off Offset of the string in the payload
+ * @param len Length of the string
+ */
+static void table_add(struct SerialTable *t, size_t off, size_t len)
+{
+  if (t->num == t->max)
+  {
+    t->max += 16;
+    mutt_mem_realloc(&t->strings, t->max * sizeof(struct SerialString));
+  }
+  t->strings[t->num].off = off;
+  t->strings[t->num].len = len;
+  t->num++;
 }
 
 /**
- * serial_dump_int - Pack an integer into a binary blob
- * @param i   Integer to save
- * @param d   Binary blob to add to
- * @param off Offset into the blob
- * @retval ptr End of the newly packed binary
+ * pack_bytes - Append some bytes to a payload
+ * @param sw  Payload writer
+ * @param src Bytes to append
+ * @param len Number of bytes
  */
-unsigned char *serial_dump_int(unsigned int i, unsigned char *d, int *off)
+static void pack_bytes(struct SerialWriter *sw, const void *src, size_t len)
 {
-  lazy_realloc(&d, *off + sizeof(int));
-  memcpy(d + *off, &i, sizeof(int));
-  (*off) += sizeof(int);
+  if ((sw->len + len) > sw->size)
+  {
+    sw->size = MAX(sw->size * 2, sw->len + len + 4096);
+    mutt_mem_realloc(&sw->data, sw->size);
+  }
+  memcpy(sw->data + sw->len, src, len);
+  sw->len += len;
+}
 
-  return d;
+/**
+ * pack_varint - Append an unsigned integer to a payload
+ * @param sw Payload writer
+ * @param v  Number to append
+ */
+static void pack_varint(struct SerialWriter *sw, uint64_t v)
+{
+  unsigned char buf[10];
+  size_t i = 0;
+
+  while (v >= 0x80)
+  {
+    buf[i++] = (v & 0x7f) | 0x80;
+    v >>= 7;
+  }
+  buf[i++] = v;
+
+  pack_bytes(sw, buf, i);
 }
 
 /**
- * serial_restore_int - Unpack an integer from a binary blob
- * @param i   Integer to write to
- * @param d   Binary blob to read from
- * @param off Offset into the blob
+ * pack_int - Append a signed integer to a payload
+ * @param sw Payload writer
+ * @param v  Number to append
  */
-void serial_restore_int(unsigned int *i, const unsigned char *d, int *off)
+static void pack_int(struct SerialWriter *sw, int64_t v)
 {
-  memcpy(i, d + *off, sizeof(int));
-  (*off) += sizeof(int);
+  pack_varint(sw, ((uint64_t) v << 1) ^ (uint64_t)(v >> 63));
 }
 
 /**
- * serial_dump_char_size - Pack a fixed-length string into a binary blob
- * @param c       String to pack
- * @param d       Binary blob to add to
- * @param off     Offset into the blob
- * @param size    Size of the string
- * @param convert If true, the strings will be converted to utf-8
- * @retval ptr End of the newly packed binary
+ * str_hash - Hash a string for the writer's string table
+ * @param str String
+ * @param len Length of the string
+ * @retval num Hash (FNV-1a)
+ */
+static size_t str_hash(const char *str, size_t len)
+{
+  size_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++)
+  {
+    h ^= (unsigned char) str[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/**
+ * slots_grow - Double the size of the writer's string hash
+ * @param sw Payload writer
  */
-unsigned char *serial_dump_char_size(char *c, unsigned char *d, int *off,
-                                     ssize_t size, bool convert)
+static void slots_grow(struct SerialWriter *sw)
 {
-  char *p = c;
+  FREE(&sw->slots);
+  sw->num_slots = sw->num_slots ? (sw->num_slots * 2) : 64;
+  sw->slots = mutt_mem_calloc(sw->num_slots, sizeof(size_t));
+
+  const size_t mask = sw->num_slots - 1;
+  for (size_t i = 0; i < sw->table.num; i++)
+  {
+    const struct SerialString *ss = &sw->table.strings[i];
+    size_t slot = str_hash((const char *) sw->data + ss->off, ss->len) & mask;
+    while (sw->slots[slot] != 0)
+      slot = (slot + 1) & mask;
+    sw->slots[slot] = i + 1;
+  }
+}
 
-  if (!c)
+/**
+ * pack_str - Append a string to a payload
+ * @param sw      Payload writer
+ * @param str     String to append (may be NULL)
+ * @param convert If true, the string will be converted to utf-8
+ */
+static void pack_str(struct SerialWriter *sw, const char *str, bool convert)
+{
+  if (!str)
   {
-    size = 0;
-    d = serial_dump_int(size, d, off);
-    return d;
+    pack_varint(sw, 0);
+    return;
   }
 
-  if (convert && !mutt_str_is_ascii(c, size))
+  char *conv = NULL;
+  size_t len = strlen(str);
+  if (convert && sw->convert && !mutt_str_is_ascii(str, len))
   {
-    p = mutt_str_substr_dup(c, c + size);
-    if (mutt_ch_convert_string(&p, C_Charset, "utf-8", 0) == 0)
+    conv = mutt_str_strdup(str);
+    if (mutt_ch_convert_string(&conv, C_Charset, "utf-8", 0) == 0)
     {
-      size = mutt_str_strlen(p) + 1;
+      str = conv;
+      len = strlen(str);
     }
   }
 
-  d = serial_dump_int(size, d, off);
-  lazy_realloc(&d, *off + size);
-  memcpy(d + *off, p, size);
-  *off += size;
+  if (len == 0)
+  {
+    pack_varint(sw, 1 << 1);
+    FREE(&conv);
+    return;
+  }
 
-  if (p != c)
-    FREE(&p);
+  /* Keep the hash at most half full */
+  if ((sw->table.num * 2) >= sw->num_slots)
+    slots_grow(sw);
 
-  return d;
+  const size_t mask = sw->num_slots - 1;
+  size_t slot = str_hash(str, len) & mask;
+  for (; sw->slots[slot] != 0; slot = (slot + 1) & mask)
+  {
+    const size_t i = sw->slots[slot] - 1;
+    const struct SerialString *ss = &sw->table.strings[i];
+    if ((ss->len == len) && (memcmp(sw->data + ss->off, str, len) == 0))
+    {
+      pack_varint(sw, (i << 1) | 1);
+      FREE(&conv);
+      return;
+    }
+  }
+
+  pack_varint(sw, (len + 1) << 1);
+  table_add(&sw->table, sw->len, len);
+  sw->slots[slot] = sw->table.num;
+  pack_bytes(sw, str, len);
+  FREE(&conv);
 }
 
 /**
- * serial_dump_char - Pack a variable-length string into a binary blob
- * @param c       String to pack
- * @param d       Binary blob to add to
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted to utf-8
- * @retval ptr End of the newly packed binary
+ * unpack_varint - Read an unsigned integer from a payload
+ * @param sr Payload reader
+ * @retval num Number read (0 on error)
  */
-unsigned char *serial_dump_char(char *c, unsigned char *d, int *off, bool convert)
+static uint64_t unpack_varint(struct SerialReader *sr)
 {
-  return serial_dump_char_size(c, d, off, mutt_str_strlen(c) + 1, convert);
+  uint64_t v = 0;
+
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    if (sr->off >= sr->len)
+      break;
+
+    unsigned char c = sr->data[sr->off++];
+    v |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return v;
+  }
+
+  sr->error = true;
+  return 0;
 }
 
 /**
- * serial_restore_char - Unpack a variable-length string from a binary blob
- * @param[out] c       Store the unpacked string here
- * @param[in]  d       Binary blob to read from
- * @param[out] off     Offset into the blob
- * @param[in]  convert If true, the strings will be converted to utf-8
+ * unpack_int - Read a signed integer from a payload
+ * @param sr Payload reader
+ * @retval num Number read (0 on error)
  */
-void serial_restore_char(char **c, const unsigned char *d, int *off, bool convert)
+static int64_t unpack_int(struct SerialReader *sr)
 {
-  unsigned int size;
-  serial_restore_int(&size, d, off);
+  uint64_t v = unpack_varint(sr);
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
 
-  if (size == 0)
-  {
-    *c = NULL;
-    return;
-  }
+/**
+ * unpack_str - Read a string from a payload
+ * @param sr      Payload reader
+ * @param convert If true, the string will be converted from utf-8
+ * @retval ptr  Newly allocated string
+ * @retval NULL The string was NULL, or the payload is corrupt
+ *
+ * Repeated strings are found through the record's string table, which only
+ * holds offsets into the payload.  Each string the Email gets is still copied
+ * once into its own allocation.
+ *
+ * @note The strings can't point into the payload: it belongs to the backend,
+ *       or is freed by v2_close(), and Email strings are freed and replaced
+ *       individually.
+ */
+static char *unpack_str(struct SerialReader *sr, bool convert)
+{
+  uint64_t tag = unpack_varint(sr);
+  if (tag == 0)
+    return NULL;
 
-  *c = mutt_mem_malloc(size);
-  memcpy(*c, d + *off, size);
-  if (convert && !mutt_str_is_ascii(*c, size))
+  size_t off;
+  size_t len;
+  if (tag & 1)
   {
-    char *tmp = mutt_str_strdup(*c);
-    if (mutt_ch_convert_string(&tmp, "utf-8", C_Charset, 0) == 0)
+    tag >>= 1;
+    if (tag >= sr->table.num)
     {
-      FREE(c);
-      *c = tmp;
+      sr->error = true;
+      return NULL;
     }
-    else
+    off = sr->table.strings[tag].off;
+    len = sr->table.strings[tag].len;
+  }
+  else
+  {
+    len = (tag >> 1) - 1;
+    if (len > (sr->len - sr->off))
     {
-      FREE(&tmp);
+      sr->error = true;
+      return NULL;
     }
+    off = sr->off;
+    sr->off += len;
+    if (len > 0)
+      table_add(&sr->table, off, len);
+  }
+
+  const char *src = (const char *) sr->data + off;
+  char *str = mutt_str_substr_dup(src, src + len);
+  if (convert && sr->convert && !mutt_str_is_ascii(src, len) &&
+      (mutt_ch_convert_string(&str, "utf-8", C_Charset, 0) != 0))
+  {
+    /* A failed conversion may have replaced str: keep the stored string */
+    FREE(&str);
+    str = mutt_str_substr_dup(src, src + len);
   }
-  *off += size;
+
+  return str;
 }
 
 /**
- * serial_dump_address - Pack an Address into a binary blob
- * @param al      AddressList to pack
- * @param d       Binary blob to add to
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted to utf-8
- * @retval ptr End of the newly packed binary
+ * pack_address - Append an AddressList to a payload
+ * @param sw Payload writer
+ * @param al AddressList to append
  */
-unsigned char *serial_dump_address(struct AddressList *al, unsigned char *d,
-                                   int *off, bool convert)
+static void pack_address(struct SerialWriter *sw, const struct AddressList *al)
 {
-  unsigned int counter = 0;
-  unsigned int start_off = *off;
-
-  d = serial_dump_int(0xdeadbeef, d, off);
-
+  size_t count = 0;
   struct Address *a = NULL;
   TAILQ_FOREACH(a, al, entries)
   {
-    d = serial_dump_char(a->personal, d, off, convert);
-    d = serial_dump_char(a->mailbox, d, off, false);
-    d = serial_dump_int(a->group, d, off);
-    counter++;
+    count++;
   }
 
-  memcpy(d + start_off, &counter, sizeof(int));
-
-  return d;
+  pack_varint(sw, count);
+  TAILQ_FOREACH(a, al, entries)
+  {
+    pack_str(sw, a->personal, true);
+    pack_str(sw, a->mailbox, false);
+    pack_varint(sw, a->group);
+  }
 }
 
 /**
- * serial_restore_address - Unpack an Address from a binary blob
- * @param[out] al      Store the unpacked AddressList here
- * @param[in]  d       Binary blob to read from
- * @param[out] off     Offset into the blob
- * @param[in]  convert If true, the strings will be converted from utf-8
+ * unpack_address - Read an AddressList from a payload
+ * @param sr Payload reader
+ * @param al AddressList to add to
  */
-void serial_restore_address(struct AddressList *al, const unsigned char *d,
-                            int *off, bool convert)
+static void unpack_address(struct SerialReader *sr, struct AddressList *al)
 {
-  unsigned int counter = 0;
-  unsigned int g = 0;
-
-  serial_restore_int(&counter, d, off);
-
-  while (counter)
+  for (uint64_t count = unpack_varint(sr); (count > 0) && !sr->error; count--)
   {
     struct Address *a = mutt_addr_new();
-    serial_restore_char(&a->personal, d, off, convert);
-    serial_restore_char(&a->mailbox, d, off, false);
-    serial_restore_int(&g, d, off);
-    a->group = !!g;
+    a->personal = unpack_str(sr, true);
+    a->mailbox = unpack_str(sr, false);
+    a->group = !!unpack_varint(sr);
     mutt_addrlist_append(al, a);
-    counter--;
   }
 }
 
 /**
- * serial_dump_stailq - Pack a STAILQ into a binary blob
- * @param l       List to read from
- * @param d       Binary blob to add to
- * @param off     Offset into the blob
+ * pack_stailq - Append a List to a payload
+ * @param sw      Payload writer
+ * @param l       List to append
  * @param convert If true, the strings will be converted to utf-8
- * @retval ptr End of the newly packed binary
  */
-unsigned char *serial_dump_stailq(struct ListHead *l, unsigned char *d, int *off, bool convert)
+static void pack_stailq(struct SerialWriter *sw, const struct ListHead *l, bool convert)
 {
-  unsigned int counter = 0;
-  unsigned int start_off = *off;
-
-  d = serial_dump_int(0xdeadbeef, d, off);
-
+  size_t count = 0;
   struct ListNode *np = NULL;
   STAILQ_FOREACH(np, l, entries)
   {
-    d = serial_dump_char(np->data, d, off, convert);
-    counter++;
+    count++;
   }
 
-  memcpy(d + start_off, &counter, sizeof(int));
-
-  return d;
+  pack_varint(sw, count);
+  STAILQ_FOREACH(np, l, entries)
+  {
+    pack_str(sw, np->data, convert);
+  }
 }
 
 /**
- * serial_restore_stailq - Unpack a STAILQ from a binary blob
+ * unpack_stailq - Read a List from a payload
+ * @param sr      Payload reader
  * @param l       List to add to
- * @param d       Binary blob to read from
- * @param off     Offset into the blob
  * @param convert If true, the strings will be converted from utf-8
  */
-void serial_restore_stailq(struct ListHead *l, const unsigned char *d, int *off, bool convert)
+static void unpack_stailq(struct SerialReader *sr, struct ListHead *l, bool convert)
 {
-  unsigned int counter;
-
-  serial_restore_int(&counter, d, off);
-
-  struct ListNode *np = NULL;
-  while (counter)
+  for (uint64_t count = unpack_varint(sr); (count > 0) && !sr->error; count--)
   {
-    np = mutt_list_insert_tail(l, NULL);
-    serial_restore_char(&np->data, d, off, convert);
-    counter--;
+    mutt_list_insert_tail(l, unpack_str(sr, convert));
   }
 }
 
 /**
- * serial_dump_buffer - Pack a Buffer into a binary blob
- * @param b       Buffer to pack
- * @param d       Binary blob to add to
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted to utf-8
- * @retval ptr End of the newly packed binary
+ * pack_parameter - Append a ParameterList to a payload
+ * @param sw Payload writer
+ * @param pl ParameterList to append
  */
-unsigned char *serial_dump_buffer(struct Buffer *b, unsigned char *d, int *off, bool convert)
+static void pack_parameter(struct SerialWriter *sw, const struct ParameterList *pl)
 {
-  if (!b)
+  size_t count = 0;
+  struct Parameter *np = NULL;
+  TAILQ_FOREACH(np, pl, entries)
   {
-    d = serial_dump_int(0, d, off);
-    return d;
+    count++;
   }
-  else
-    d = serial_dump_int(1, d, off);
-
-  d = serial_dump_char_size(b->data, d, off, b->dsize + 1, convert);
-  d = serial_dump_int(b->dptr - b->data, d, off);
-  d = serial_dump_int(b->dsize, d, off);
-  d = serial_dump_int(b->destroy, d, off);
 
-  return d;
+  pack_varint(sw, count);
+  TAILQ_FOREACH(np, pl, entries)
+  {
+    pack_str(sw, np->attribute, false);
+    pack_str(sw, np->value, true);
+  }
 }
 
 /**
- * serial_restore_buffer - Unpack a Buffer from a binary blob
- * @param[out] b       Store the unpacked Buffer here
- * @param[in]  d       Binary blob to read from
- * @param[out] off     Offset into the blob
- * @param[in]  convert If true, the strings will be converted from utf-8
+ * unpack_parameter - Read a ParameterList from a payload
+ * @param sr Payload reader
+ * @param pl ParameterList to add to
  */
-void serial_restore_buffer(struct Buffer **b, const unsigned char *d, int *off, bool convert)
+static void unpack_parameter(struct SerialReader *sr, struct ParameterList *pl)
 {
-  unsigned int used;
-  unsigned int offset;
-  serial_restore_int(&used, d, off);
-  if (!used)
+  for (uint64_t count = unpack_varint(sr); (count > 0) && !sr->error; count--)
   {
-    return;
+    struct Parameter *np = mutt_param_new();
+    np->attribute = unpack_str(sr, false);
+    np->value = unpack_str(sr, true);
+    TAILQ_INSERT_TAIL(pl, np, entries);
   }
+}
 
-  *b = mutt_mem_malloc(sizeof(struct Buffer));
-
-  serial_restore_char(&(*b)->data, d, off, convert);
-  serial_restore_int(&offset, d, off);
-  (*b)->dptr = (*b)->data + offset;
-  serial_restore_int(&used, d, off);
-  (*b)->dsize = used;
-  serial_restore_int(&used, d, off);
-  (*b)->destroy = used;
+/**
+ * pack_body - Append a Body to a payload
+ * @param sw Payload writer
+ * @param b  Body to append
+ *
+ * Only the fields that are safe to cache are stored.
+ */
+static void pack_body(struct SerialWriter *sw, const struct Body *b)
+{
+  pack_varint(sw, b->type);
+  pack_varint(sw, b->encoding);
+  pack_varint(sw, b->disposition);
+
+  unsigned int flags = 0;
+  flags |= b->use_disp ? (1 << 0) : 0;
+  flags |= b->unlink ? (1 << 1) : 0;
+  flags |= b->tagged ? (1 << 2) : 0;
+  flags |= b->deleted ? (1 << 3) : 0;
+  flags |= b->noconv ? (1 << 4) : 0;
+  flags |= b->force_charset ? (1 << 5) : 0;
+  flags |= b->is_signed_data ? (1 << 6) : 0;
+  flags |= b->goodsig ? (1 << 7) : 0;
+  flags |= b->warnsig ? (1 << 8) : 0;
+  flags |= b->badsig ? (1 << 9) : 0;
+  flags |= b->collapsed ? (1 << 10) : 0;
+  flags |= b->attach_qualifies ? (1 << 11) : 0;
+  pack_varint(sw, flags);
+
+  pack_int(sw, b->hdr_offset);
+  pack_int(sw, b->offset);
+  pack_int(sw, b->length);
+  pack_int(sw, b->attach_count);
+  pack_int(sw, b->stamp);
+
+  pack_str(sw, b->xtype, false);
+  pack_str(sw, b->subtype, false);
+  pack_parameter(sw, &b->parameter);
+  pack_str(sw, b->description, true);
+  pack_str(sw, b->form_name, true);
+  pack_str(sw, b->filename, true);
+  pack_str(sw, b->d_filename, true);
 }
 
 /**
- * serial_dump_parameter - Pack a Parameter into a binary blob
- * @param p       Parameter to pack
- * @param d       Binary blob to add to
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted to utf-8
- * @retval ptr End of the newly packed binary
+ * unpack_body - Read a Body from a payload
+ * @param sr Payload reader
+ * @param b  Body to fill in
  */
-unsigned char *serial_dump_parameter(struct ParameterList *p, unsigned char *d,
-                                     int *off, bool convert)
+static void unpack_body(struct SerialReader *sr, struct Body *b)
 {
-  unsigned int counter = 0;
-  unsigned int start_off = *off;
+  b->type = unpack_varint(sr);
+  b->encoding = unpack_varint(sr);
+  b->disposition = unpack_varint(sr);
+
+  uint64_t flags = unpack_varint(sr);
+  b->use_disp = flags & (1 << 0);
+  b->unlink = flags & (1 << 1);
+  b->tagged = flags & (1 << 2);
+  b->deleted = flags & (1 << 3);
+  b->noconv = flags & (1 << 4);
+  b->force_charset = flags & (1 << 5);
+  b->is_signed_data = flags & (1 << 6);
+  b->goodsig = flags & (1 << 7);
+  b->warnsig = flags & (1 << 8);
+  b->badsig = flags & (1 << 9);
+  b->collapsed = flags & (1 << 10);
+  b->attach_qualifies = flags & (1 << 11);
+
+  b->hdr_offset = unpack_int(sr);
+  b->offset = unpack_int(sr);
+  b->length = unpack_int(sr);
+  b->attach_count = unpack_int(sr);
+  b->stamp = unpack_int(sr);
+
+  b->xtype = unpack_str(sr, false);
+  b->subtype = unpack_str(sr, false);
+  unpack_parameter(sr, &b->parameter);
+  b->description = unpack_str(sr, true);
+  b->form_name = unpack_str(sr, true);
+  b->filename = unpack_str(sr, true);
+  b->d_filename = unpack_str(sr, true);
+}
 
-  d = serial_dump_int(0xdeadbeef, d, off);
+/**
+ * pack_envelope - Append an Envelope to a payload
+ * @param sw  Payload writer
+ * @param env Envelope to append
+ */
+static void pack_envelope(struct SerialWriter *sw, const struct Envelope *env)
+{
+  pack_address(sw, &env->return_path);
+  pack_address(sw, &env->from);
+  pack_address(sw, &env->to);
+  pack_address(sw, &env->cc);
+  pack_address(sw, &env->bcc);
+  pack_address(sw, &env->sender);
+  pack_address(sw, &env->reply_to);
+  pack_address(sw, &env->mail_followup_to);
+
+  pack_str(sw, env->list_post, true);
+  pack_str(sw, env->subject, true);
+  if (env->subject && env->real_subj)
+    pack_varint(sw, env->real_subj - env->subject + 1);
+  else
+    pack_varint(sw, 0);
 
-  struct Parameter *np = NULL;
-  TAILQ_FOREACH(np, p, entries)
-  {
-    d = serial_dump_char(np->attribute, d, off, false);
-    d = serial_dump_char(np->value, d, off, convert);
-    counter++;
-  }
+  pack_str(sw, env->message_id, false);
+  pack_str(sw, env->supersedes, false);
+  pack_str(sw, env->date, false);
+  pack_str(sw, env->x_label, true);
+  pack_str(sw, env->spam ? mutt_b2s(env->spam) : NULL, true);
 
-  memcpy(d + start_off, &counter, sizeof(int));
+  pack_stailq(sw, &env->references, false);
+  pack_stailq(sw, &env->in_reply_to, false);
+  pack_stailq(sw, &env->userhdrs, true);
 
-  return d;
+#ifdef USE_NNTP
+  pack_str(sw, env->xref, false);
+  pack_str(sw, env->followup_to, false);
+  pack_str(sw, env->x_comment_to, true);
+#endif
 }
 
 /**
- * serial_restore_parameter - Unpack a Parameter from a binary blob
- * @param p       Store the unpacked Parameter here
- * @param d       Binary blob to read from
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted from utf-8
+ * unpack_envelope - Read an Envelope from a payload
+ * @param sr  Payload reader
+ * @param env Envelope to fill in
  */
-void serial_restore_parameter(struct ParameterList *p, const unsigned char *d,
-                              int *off, bool convert)
+static void unpack_envelope(struct SerialReader *sr, struct Envelope *env)
 {
-  unsigned int counter;
+  unpack_address(sr, &env->return_path);
+  unpack_address(sr, &env->from);
+  unpack_address(sr, &env->to);
+  unpack_address(sr, &env->cc);
+  unpack_address(sr, &env->bcc);
+  unpack_address(sr, &env->sender);
+  unpack_address(sr, &env->reply_to);
+  unpack_address(sr, &env->mail_followup_to);
+
+  env->list_post = unpack_str(sr, true);
+  if (C_AutoSubscribe)
+    mutt_auto_subscribe(env->list_post);
 
-  serial_restore_int(&counter, d, off);
+  env->subject = unpack_str(sr, true);
+  uint64_t real_subj_off = unpack_varint(sr);
+  if (env->subject && (real_subj_off > 0) && (real_subj_off <= (strlen(env->subject) + 1)))
+    env->real_subj = env->subject + real_subj_off - 1;
+  else
+    env->real_subj = NULL;
 
-  struct Parameter *np = NULL;
-  while (counter)
+  env->message_id = unpack_str(sr, false);
+  env->supersedes = unpack_str(sr, false);
+  env->date = unpack_str(sr, false);
+  env->x_label = unpack_str(sr, true);
+
+  char *spam = unpack_str(sr, true);
+  if (spam)
   {
-    np = mutt_param_new();
-    serial_restore_char(&np->attribute, d, off, false);
-    serial_restore_char(&np->value, d, off, convert);
-    TAILQ_INSERT_TAIL(p, np, entries);
-    counter--;
+    env->spam = mutt_buffer_from(spam);
+    FREE(&spam);
   }
+
+  unpack_stailq(sr, &env->references, false);
+  unpack_stailq(sr, &env->in_reply_to, false);
+  unpack_stailq(sr, &env->userhdrs, true);
+
+#ifdef USE_NNTP
+  env->xref = unpack_str(sr, false);
+  env->followup_to = unpack_str(sr, false);
+  env->x_comment_to = unpack_str(sr, true);
+#endif
 }
 
 /**
- * serial_dump_body - Pack an Body into a binary blob
- * @param c       Body to pack
- * @param d       Binary blob to add to
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted to utf-8
- * @retval ptr End of the newly packed binary
+ * pack_email - Append an Email to a payload
+ * @param sw Payload writer
+ * @param e  Email to append
+ *
+ * Only the fields that are safe to cache are stored.
  */
-unsigned char *serial_dump_body(struct Body *c, unsigned char *d, int *off, bool convert)
+static void pack_email(struct SerialWriter *sw, const struct Email *e)
 {
-  struct Body nb;
-
-  memcpy(&nb, c, sizeof(struct Body));
-
-  /* some fields are not safe to cache */
-  nb.content = NULL;
-  nb.charset = NULL;
-  nb.next = NULL;
-  nb.parts = NULL;
-  nb.email = NULL;
-  nb.aptr = NULL;
-  nb.mime_headers = NULL;
-  nb.language = NULL;
-
-  lazy_realloc(&d, *off + sizeof(struct Body));
-  memcpy(d + *off, &nb, sizeof(struct Body));
-  *off += sizeof(struct Body);
-
-  d = serial_dump_char(nb.xtype, d, off, false);
-  d = serial_dump_char(nb.subtype, d, off, false);
-
-  d = serial_dump_parameter(&nb.parameter, d, off, convert);
+  pack_varint(sw, e->security);
+
+  unsigned int flags = 0;
+  flags |= e->mime ? (1 << 0) : 0;
+  flags |= e->flagged ? (1 << 1) : 0;
+  flags |= e->deleted ? (1 << 2) : 0;
+  flags |= e->purge ? (1 << 3) : 0;
+  flags |= e->quasi_deleted ? (1 << 4) : 0;
+  flags |= e->attach_del ? (1 << 5) : 0;
+  flags |= e->old ? (1 << 6) : 0;
+  flags |= e->read ? (1 << 7) : 0;
+  flags |= e->expired ? (1 << 8) : 0;
+  flags |= e->superseded ? (1 << 9) : 0;
+  flags |= e->replied ? (1 << 10) : 0;
+  flags |= e->subject_changed ? (1 << 11) : 0;
+  flags |= e->display_subject ? (1 << 12) : 0;
+  flags |= e->active ? (1 << 13) : 0;
+  flags |= e->trash ? (1 << 14) : 0;
+  flags |= e->zoccident ? (1 << 15) : 0;
+  pack_varint(sw, flags);
+
+  pack_varint(sw, e->zhours);
+  pack_varint(sw, e->zminutes);
+  pack_int(sw, e->date_sent);
+  pack_int(sw, e->received);
+  pack_int(sw, e->offset);
+  pack_int(sw, e->lines);
+  pack_int(sw, e->index);
+  pack_int(sw, e->msgno);
+  pack_int(sw, e->virtual);
+  pack_int(sw, e->score);
+  pack_int(sw, e->attach_total);
+#ifdef USE_POP
+  pack_int(sw, e->refno);
+#endif
 
-  d = serial_dump_char(nb.description, d, off, convert);
-  d = serial_dump_char(nb.form_name, d, off, convert);
-  d = serial_dump_char(nb.filename, d, off, convert);
-  d = serial_dump_char(nb.d_filename, d, off, convert);
+  pack_envelope(sw, e->env);
+  pack_body(sw, e->content);
+  pack_str(sw, e->maildir_flags, true);
+}
 
-  return d;
+/**
+ * unpack_email_fields - Read an Email's own fields from a payload
+ * @param sr Payload reader
+ * @param e  Email to fill in
+ *
+ * These are the first thing in the payload.  The Envelope and Body follow.
+ */
+static void unpack_email_fields(struct SerialReader *sr, struct Email *e)
+{
+  e->security = unpack_varint(sr);
+
+  uint64_t flags = unpack_varint(sr);
+  e->mime = flags & (1 << 0);
+  e->flagged = flags & (1 << 1);
+  e->deleted = flags & (1 << 2);
+  e->purge = flags & (1 << 3);
+  e->quasi_deleted = flags & (1 << 4);
+  e->attach_del = flags & (1 << 5);
+  e->old = flags & (1 << 6);
+  e->read = flags & (1 << 7);
+  e->expired = flags & (1 << 8);
+  e->superseded = flags & (1 << 9);
+  e->replied = flags & (1 << 10);
+  e->subject_changed = flags & (1 << 11);
+  e->display_subject = flags & (1 << 12);
+  e->active = flags & (1 << 13);
+  e->trash = flags & (1 << 14);
+  e->zoccident = flags & (1 << 15);
+
+  e->zhours = unpack_varint(sr);
+  e->zminutes = unpack_varint(sr);
+  e->date_sent = unpack_int(sr);
+  e->received = unpack_int(sr);
+  e->offset = unpack_int(sr);
+  e->lines = unpack_int(sr);
+  e->index = unpack_int(sr);
+  e->msgno = unpack_int(sr);
+  e->virtual = unpack_int(sr);
+  e->score = unpack_int(sr);
+  e->attach_total = unpack_int(sr);
+#ifdef USE_POP
+  e->refno = unpack_int(sr);
+#endif
 }
 
 /**
- * serial_restore_body - Unpack a Body from a binary blob
- * @param c       Store the unpacked Body here
- * @param d       Binary blob to read from
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted from utf-8
+ * unpack_email - Read an Email from a payload
+ * @param sr Payload reader
+ * @param e  Email to fill in
  */
-void serial_restore_body(struct Body *c, const unsigned char *d, int *off, bool convert)
+static void unpack_email(struct SerialReader *sr, struct Email *e)
 {
-  memcpy(c, d + *off, sizeof(struct Body));
-  *off += sizeof(struct Body);
-  c->language = NULL;
+  unpack_email_fields(sr, e);
 
-  serial_restore_char(&c->xtype, d, off, false);
-  serial_restore_char(&c->subtype, d, off, false);
+  e->env = mutt_env_new();
+  unpack_envelope(sr, e->env);
 
-  TAILQ_INIT(&c->parameter);
-  serial_restore_parameter(&c->parameter, d, off, convert);
+  e->content = mutt_body_new();
+  unpack_body(sr, e->content);
 
-  serial_restore_char(&c->description, d, off, convert);
-  serial_restore_char(&c->form_name, d, off, convert);
-  serial_restore_char(&c->filename, d, off, convert);
-  serial_restore_char(&c->d_filename, d, off, convert);
+  e->maildir_flags = unpack_str(sr, true);
 }
 
 /**
- * serial_dump_envelope - Pack an Envelope into a binary blob
- * @param env     Envelope to pack
- * @param d       Binary blob to add to
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted to utf-8
- * @retval ptr End of the newly packed binary
+ * mutt_hcache_dump - Serialise an Email object
+ * @param hc          Header cache handle
+ * @param e           Email to serialise
+ * @param off         Size of the binary blob
+ * @param uidvalidity IMAP server identifier
+ * @param compress    If true, try to compress the record
+ * @retval ptr Binary blob representing the Email
+ *
+ * This function transforms an Email into a version 2 record so that it is
+ * usable by db_store.  Compression is only used if NeoMutt was built with
+ * zlib, and only if it makes the record smaller.
  */
-unsigned char *serial_dump_envelope(struct Envelope *env, unsigned char *d,
-                                    int *off, bool convert)
+void *mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off,
+                       unsigned int uidvalidity, bool compress)
 {
-  d = serial_dump_address(&env->return_path, d, off, convert);
-  d = serial_dump_address(&env->from, d, off, convert);
-  d = serial_dump_address(&env->to, d, off, convert);
-  d = serial_dump_address(&env->cc, d, off, convert);
-  d = serial_dump_address(&env->bcc, d, off, convert);
-  d = serial_dump_address(&env->sender, d, off, convert);
-  d = serial_dump_address(&env->reply_to, d, off, convert);
-  d = serial_dump_address(&env->mail_followup_to, d, off, convert);
-
-  d = serial_dump_char(env->list_post, d, off, convert);
-  d = serial_dump_char(env->subject, d, off, convert);
-
-  if (env->real_subj)
-    d = serial_dump_int(env->real_subj - env->subject, d, off);
-  else
-    d = serial_dump_int(-1, d, off);
+  struct SerialWriter payload = { 0 };
+  payload.convert = !CharsetIsUtf8;
+  pack_email(&payload, e);
 
-  d = serial_dump_char(env->message_id, d, off, false);
-  d = serial_dump_char(env->supersedes, d, off, false);
-  d = serial_dump_char(env->date, d, off, false);
-  d = serial_dump_char(env->x_label, d, off, convert);
+  const unsigned char *stored = payload.data;
+  size_t stored_len = payload.len;
+  unsigned char flags = 0;
 
-  d = serial_dump_buffer(env->spam, d, off, convert);
-
-  d = serial_dump_stailq(&env->references, d, off, false);
-  d = serial_dump_stailq(&env->in_reply_to, d, off, false);
-  d = serial_dump_stailq(&env->userhdrs, d, off, convert);
+#ifdef HAVE_ZLIB
+  unsigned char *zdata = NULL;
+  if (compress && (payload.len > HCACHE_COMPRESS_MIN))
+  {
+    uLongf zlen = compressBound(payload.len);
+    zdata = mutt_mem_malloc(zlen);
+    if ((compress2(zdata, &zlen, payload.data, payload.len, Z_DEFAULT_COMPRESSION) == Z_OK) &&
+        (zlen < payload.len))
+    {
+      stored = zdata;
+      stored_len = zlen;
+      flags |= HCACHE_FORMAT_ZLIB;
+    }
+  }
+#endif
 
-#ifdef USE_NNTP
-  d = serial_dump_char(env->xref, d, off, false);
-  d = serial_dump_char(env->followup_to, d, off, false);
-  d = serial_dump_char(env->x_comment_to, d, off, convert);
+  struct SerialWriter rec = { 0 };
+  union Validate validate;
+  memset(&validate, 0, sizeof(validate));
+  if (uidvalidity == 0)
+    gettimeofday(&validate.timeval, NULL);
+  else
+    validate.uidvalidity = uidvalidity;
+  pack_bytes(&rec, &validate, sizeof(validate));
+  pack_bytes(&rec, &hc->crc, sizeof(hc->crc));
+
+  const unsigned char header[] = { HCACHE_FORMAT_MAGIC, HCACHE_FORMAT_MAGIC,
+                                   HCACHE_FORMAT_VERSION, flags };
+  pack_bytes(&rec, header, sizeof(header));
+  pack_varint(&rec, stored_len);
+  if (flags & HCACHE_FORMAT_ZLIB)
+    pack_varint(&rec, payload.len);
+  pack_bytes(&rec, stored, stored_len);
+
+#ifdef HAVE_ZLIB
+  FREE(&zdata);
 #endif
+  FREE(&payload.data);
+  FREE(&payload.table.strings);
+  FREE(&payload.slots);
 
-  return d;
+  *off = rec.len;
+  return rec.data;
 }
 
 /**
- * serial_restore_envelope - Unpack an Envelope from a binary blob
- * @param env     Store the unpacked Envelope here
- * @param d       Binary blob to read from
- * @param off     Offset into the blob
- * @param convert If true, the strings will be converted from utf-8
+ * mutt_hcache_is_supported - Can a record be restored?
+ * @param d    Data retrieved using mutt_hcache_fetch_raw
+ * @param dlen Length of the data
+ * @retval true The record can be passed to mutt_hcache_restore()
+ *
+ * Records in an unknown format, compressed when NeoMutt was built without
+ * zlib, or whose payload doesn't fit in @a dlen bytes, can't be restored.
  */
-void serial_restore_envelope(struct Envelope *env, const unsigned char *d, int *off, bool convert)
+bool mutt_hcache_is_supported(const unsigned char *d, size_t dlen)
 {
-  int real_subj_off;
-
-  serial_restore_address(&env->return_path, d, off, convert);
-  serial_restore_address(&env->from, d, off, convert);
-  serial_restore_address(&env->to, d, off, convert);
-  serial_restore_address(&env->cc, d, off, convert);
-  serial_restore_address(&env->bcc, d, off, convert);
-  serial_restore_address(&env->sender, d, off, convert);
-  serial_restore_address(&env->reply_to, d, off, convert);
-  serial_restore_address(&env->mail_followup_to, d, off, convert);
-
-  serial_restore_char(&env->list_post, d, off, convert);
-
-  if (C_AutoSubscribe)
-    mutt_auto_subscribe(env->list_post);
-
-  serial_restore_char(&env->subject, d, off, convert);
-  serial_restore_int((unsigned int *) (&real_subj_off), d, off);
+  const size_t prefix = sizeof(union Validate) + sizeof(unsigned int);
+  if (!d || (dlen < (prefix + 4)))
+    return false;
+
+  d += prefix;
+  dlen -= prefix;
+  if ((d[0] != HCACHE_FORMAT_MAGIC) || (d[1] != HCACHE_FORMAT_MAGIC) ||
+      (d[2] != HCACHE_FORMAT_VERSION))
+  {
+    return false;
+  }
 
-  if (real_subj_off >= 0)
-    env->real_subj = env->subject + real_subj_off;
-  else
-    env->real_subj = NULL;
+#ifdef HAVE_ZLIB
+  if ((d[3] & ~HCACHE_FORMAT_ZLIB) != 0)
+    return false;
+#else
+  if (d[3] != 0)
+    return false;
+#endif
 
-  serial_restore_char(&env->message_id, d, off, false);
-  serial_restore_char(&env->supersedes, d, off, false);
-  serial_restore_char(&env->date, d, off, false);
-  serial_restore_char(&env->x_label, d, off, convert);
+  /* The same header that v2_open() reads, bounded by the data */
+  struct SerialReader hdr = { 0 };
+  hdr.data = d;
+  hdr.len = MIN(dlen, 4 + 10 + 10);
+  hdr.off = 4;
 
-  serial_restore_buffer(&env->spam, d, off, convert);
+  const size_t stored_len = unpack_varint(&hdr);
+  if (d[3] & HCACHE_FORMAT_ZLIB)
+    unpack_varint(&hdr);
 
-  serial_restore_stailq(&env->references, d, off, false);
-  serial_restore_stailq(&env->in_reply_to, d, off, false);
-  serial_restore_stailq(&env->userhdrs, d, off, convert);
+  return !hdr.error && (stored_len <= (dlen - hdr.off));
+}
 
-#ifdef USE_NNTP
-  serial_restore_char(&env->xref, d, off, false);
-  serial_restore_char(&env->followup_to, d, off, false);
-  serial_restore_char(&env->x_comment_to, d, off, convert);
+/**
+ * v2_open - Prepare to read the payload of a version 2 record
+ * @param[in]  d     Data retrieved using mutt_hcache_fetch or mutt_hcache_fetch_raw
+ * @param[out] sr    Payload reader
+ * @param[out] zdata Decompressed payload, to be freed by v2_close()
+ * @retval true The payload can be read
+ */
+static bool v2_open(const unsigned char *d, struct SerialReader *sr, unsigned char **zdata)
+{
+  d += sizeof(union Validate) + sizeof(unsigned int);
+
+  /* The header can't be longer than this */
+  struct SerialReader hdr = { 0 };
+  hdr.data = d;
+  hdr.len = 4 + 10 + 10;
+  hdr.off = 4;
+
+  const bool compressed = (d[3] & HCACHE_FORMAT_ZLIB);
+  const size_t stored_len = unpack_varint(&hdr);
+  const size_t raw_len = compressed ? unpack_varint(&hdr) : stored_len;
+
+  memset(sr, 0, sizeof(*sr));
+  sr->convert = !CharsetIsUtf8;
+  sr->data = d + hdr.off;
+  sr->len = stored_len;
+  *zdata = NULL;
+
+#ifdef HAVE_ZLIB
+  /* zlib can't do better than about 1:1032 */
+  if (compressed && (raw_len <= (stored_len * 1032)))
+  {
+    uLongf zlen = raw_len;
+    *zdata = mutt_mem_malloc(raw_len);
+    if (uncompress(*zdata, &zlen, sr->data, stored_len) == Z_OK)
+    {
+      sr->data = *zdata;
+      sr->len = zlen;
+    }
+    else
+      sr->error = true;
+  }
+  else if (compressed)
+    sr->error = true;
+#else
+  if (compressed || (raw_len != stored_len))
+    sr->error = true;
 #endif
+
+  return !sr->error;
 }
 
 /**
- * mutt_hcache_dump - Serialise a Header object
- * @param hc          Header cache handle
- * @param e           Email to serialise
- * @param off         Size of the binary blob
- * @param uidvalidity IMAP server identifier
- * @retval ptr Binary blob representing the Header
- *
- * This function transforms a e into a char so that it is usable by
- * db_store.
+ * v2_close - Finish reading the payload of a version 2 record
+ * @param sr    Payload reader
+ * @param zdata Decompressed payload
  */
-void *mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsigned int uidvalidity)
+static void v2_close(struct SerialReader *sr, unsigned char **zdata)
 {
-  struct Email nh;
-  bool convert = !CharsetIsUtf8;
+  if (sr->error)
+    mutt_debug(LL_DEBUG1, "corrupt header cache record\n");
 
-  *off = 0;
-  unsigned char *d = lazy_malloc(sizeof(union Validate));
+  FREE(zdata);
+  FREE(&sr->table.strings);
+}
 
-  if (uidvalidity == 0)
-  {
-    struct timeval now;
-    gettimeofday(&now, NULL);
-    memcpy(d, &now, sizeof(struct timeval));
-  }
-  else
-    memcpy(d, &uidvalidity, sizeof(uidvalidity));
-  *off += sizeof(union Validate);
-
-  d = serial_dump_int(hc->crc, d, off);
-
-  lazy_realloc(&d, *off + sizeof(struct Email));
-  memcpy(&nh, e, sizeof(struct Email));
-
-  /* some fields are not safe to cache */
-  nh.tagged = false;
-  nh.changed = false;
-  nh.threaded = false;
-  nh.recip_valid = false;
-  nh.searched = false;
-  nh.matched = false;
-  nh.collapsed = false;
-  nh.limited = false;
-  nh.num_hidden = 0;
-  nh.recipient = 0;
-  nh.pair = 0;
-  nh.attach_valid = false;
-  nh.path = NULL;
-  nh.tree = NULL;
-  nh.thread = NULL;
-  STAILQ_INIT(&nh.tags);
-#ifdef MIXMASTER
-  STAILQ_INIT(&nh.chain);
-#endif
-  nh.edata = NULL;
+/**
+ * restore_v2 - Restore an Email from a version 2 record
+ * @param d Data retrieved using mutt_hcache_fetch or mutt_hcache_fetch_raw
+ * @retval ptr  The restored Email
+ * @retval NULL The record is corrupt
+ */
+static struct Email *restore_v2(const unsigned char *d)
+{
+  struct SerialReader sr;
+  unsigned char *zdata = NULL;
 
-  memcpy(d + *off, &nh, sizeof(struct Email));
-  *off += sizeof(struct Email);
+  struct Email *e = mutt_email_new();
+  if (v2_open(d, &sr, &zdata))
+    unpack_email(&sr, e);
 
-  d = serial_dump_envelope(nh.env, d, off, convert);
-  d = serial_dump_body(nh.content, d, off, convert);
-  d = serial_dump_char(nh.maildir_flags, d, off, convert);
+  if (sr.error)
+    mutt_email_free(&e);
 
-  return d;
+  v2_close(&sr, &zdata);
+  return e;
 }
 
 /**
  * mutt_hcache_restore - restore a Header from data retrieved from the cache
  * @param d Data retrieved using mutt_hcache_fetch or mutt_hcache_fetch_raw
- * @retval ptr Success, the restored header (can't be NULL)
+ * @retval ptr  Success, the restored header
+ * @retval NULL The record is corrupt, treat it as a cache miss
+ *
+ * The Envelope and Body are always restored in full.  The rest of the code
+ * reads e->env and e->content directly, e.g. replying, sorting by "to" and
+ * rewriting headers on sync, so a partly restored Envelope would silently
+ * lose recipients.  Callers that only need the flags should use
+ * mutt_hcache_restore_flags() instead.
  *
  * @note The returned Header must be free'd by caller code with
  *       mutt_email_free().
  */
 struct Email *mutt_hcache_restore(const unsigned char *d)
 {
-  int off = 0;
-  struct Email *e = mutt_email_new();
-  bool convert = !CharsetIsUtf8;
-
-  /* skip validate */
-  off += sizeof(union Validate);
-
-  /* skip crc */
-  off += sizeof(unsigned int);
-
-  memcpy(e, d + off, sizeof(struct Email));
-  off += sizeof(struct Email);
-
-  STAILQ_INIT(&e->tags);
-#ifdef MIXMASTER
-  STAILQ_INIT(&e->chain);
-#endif
-
-  e->env = mutt_env_new();
-  serial_restore_envelope(e->env, d, &off, convert);
+  return restore_v2(d);
+}
 
-  e->content = mutt_body_new();
-  serial_restore_body(e->content, d, &off, convert);
+/**
+ * mutt_hcache_restore_flags - Restore only the flags of a cached Email
+ * @param[in]  d Data retrieved using mutt_hcache_fetch or mutt_hcache_fetch_raw
+ * @param[out] e Email to fill in
+ *
+ * Only the Email's own fields are restored, e.g. flags, dates and line count.
+ * The Envelope and Body are neither read nor allocated, so this is much
+ * cheaper than mutt_hcache_restore().  @a e->env and @a e->content are left
+ * untouched, so @a e may be a zeroed Email on the stack.
+ */
+void mutt_hcache_restore_flags(const unsigned char *d, struct Email *e)
+{
+  struct SerialReader sr;
+  unsigned char *zdata = NULL;
 
-  serial_restore_char(&e->maildir_flags, d, &off, convert);
+  if (v2_open(d, &sr, &zdata))
+    unpack_email_fields(&sr, e);
 
-  return e;
+  v2_close(&sr, &zdata);
 }
@@ -30,34 +30,13 @@
 #include <sys/types.h>
 #include "hcache.h"
 
-struct Address;
-struct Body;
-struct Buffer;
-struct Envelope;
 struct Email;
-struct ListHead;
-struct ParameterList;
 
-unsigned char *serial_dump_address(struct Address *a, unsigned char *d, int *off, bool convert);
-unsigned char *serial_dump_body(struct Body *c, unsigned char *d, int *off, bool convert);
-unsigned char *serial_dump_buffer(struct Buffer *b, unsigned char *d, int *off, bool convert);
-unsigned char *serial_dump_char(char *c, unsigned char *d, int *off, bool convert);
-unsigned char *serial_dump_char_size(char *c, unsigned char *d, int *off, ssize_t size, bool convert);
-unsigned char *serial_dump_envelope(struct Envelope *e, unsigned char *d, int *off, bool convert);
-unsigned char *serial_dump_int(unsigned int i, unsigned char *d, int *off);
-unsigned char *serial_dump_parameter(struct ParameterList *p, unsigned char *d, int *off, bool convert);
-unsigned char *serial_dump_stailq(struct ListHead *l, unsigned char *d, int *off, bool convert);
+#define HCACHE_FORMAT_VERSION 2 ///< Current record format, see hcache/serialize.c
 
-void           serial_restore_address(struct Address **a, const unsigned char *d, int *off, bool convert);
-void           serial_restore_body(struct Body *c, const unsigned char *d, int *off, bool convert);
-void           serial_restore_buffer(struct Buffer **b, const unsigned char *d, int *off, bool convert);
-void           serial_restore_char(char **c, const unsigned char *d, int *off, bool convert);
-void           serial_restore_envelope(struct Envelope *e, const unsigned char *d, int *off, bool convert);
-void           serial_restore_int(unsigned int *i, const unsigned char *d, int *off);
-void           serial_restore_parameter(struct ParameterList *p, const unsigned char *d, int *off, bool convert);
-void           serial_restore_stailq(struct ListHead *l, const unsigned char *d, int *off, bool convert);
-
-void *        mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsigned int uidvalidity);
+void *        mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsigned int uidvalidity, bool compress);
+bool          mutt_hcache_is_supported(const unsigned char *d, size_t dlen);
 struct Email *mutt_hcache_restore(const unsigned char *d);
+void          mutt_hcache_restore_flags(const unsigned char *d, struct Email *e);
 
 #endif /* MUTT_HCACHE_SERIALIZE_H */
@@ -37,6 +37,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <time.h>
 #include "imap_private.h"
 #include "mutt/mutt.h"
@@ -53,9 +54,11 @@
 #include "mx.h"
 
 /* These Config Variables are only used in imap/command.c */
+short C_ImapPollBackoff; ///< Config: (imap) Maximum time between STATUS polls of a quiet mailbox
 bool C_ImapServernoise; ///< Config: (imap) Display server warnings as error messages
 
 #define IMAP_CMD_BUFSIZE 512
+#define IMAP_PIPELINE_BYTES 16384 ///< Maximum size of the outstanding commands
 
 /**
  * Capabilities - Server capabilities strings that we understand
@@ -69,22 +72,116 @@ static const char *const Capabilities[] = {
   "STARTTLS",    "LOGINDISABLED",  "IDLE",
   "SASL-IR",     "ENABLE",         "CONDSTORE",
   "QRESYNC",     "LIST-EXTENDED",  "X-GM-EXT-1",
+  "COMPRESS=DEFLATE", "NOTIFY",
   NULL,
 };
 
+/**
+ * cmd_now_us - Get the current time
+ * @retval num Microseconds since the Epoch
+ */
+static long long cmd_now_us(void)
+{
+  struct timeval tv = { 0 };
+  gettimeofday(&tv, NULL);
+  return ((long long) tv.tv_sec * 1000000) + tv.tv_usec;
+}
+
+/**
+ * cmd_outstanding - Count the commands in the IMAP command queue
+ * @param adata Imap Account data
+ * @retval num Number of commands queued, or waiting for a response
+ */
+static int cmd_outstanding(struct ImapAccountData *adata)
+{
+  return (adata->nextcmd - adata->lastcmd + adata->cmdslots) % adata->cmdslots;
+}
+
 /**
  * cmd_queue_full - Is the IMAP command queue full?
  * @param adata Imap Account data
  * @retval true Queue is full
+ *
+ * The queue is full when its ring is full, or when the pipeline window,
+ * which may be narrower, is.
  */
 static bool cmd_queue_full(struct ImapAccountData *adata)
 {
   if ((adata->nextcmd + 1) % adata->cmdslots == adata->lastcmd)
     return true;
 
+  if (cmd_outstanding(adata) >= adata->cmdwindow)
+    return true;
+
   return false;
 }
 
+/**
+ * cmd_completed - Account for a completed command
+ * @param adata Imap Account data
+ * @param cmd   Command that has received its tagged response
+ *
+ * Update the latency statistics and adapt the pipeline window.
+ *
+ * While the pipeline is busy, commands complete one "gap" apart, which is how
+ * long the server spends on each one.  To keep the server busy for a whole
+ * round trip, the window needs about 1 + RTT / gap commands.  The shortest
+ * round trip seen is used, because the latency of a pipelined command also
+ * includes its wait behind the others.  The window moves one step at a time
+ * towards that size, between 1 and the size of the ring.
+ *
+ * A congested link or a busy server makes the gap grow, which narrows the
+ * window.  A tagged BAD is a rejected command, not a sign of congestion, so
+ * it doesn't affect the window.
+ */
+static void cmd_completed(struct ImapAccountData *adata, struct ImapCommand *cmd)
+{
+  adata->inflight -= MIN(adata->inflight, cmd->len);
+
+  if (cmd->sent > 0)
+  {
+    const long long now = cmd_now_us();
+    const long long us = now - cmd->sent;
+    const unsigned int rtt = (us > 0) ? MIN(us, UINT_MAX) : 0;
+
+    if (adata->cmd_count == 0)
+      adata->srtt = rtt;
+    else
+      adata->srtt = ((7ULL * adata->srtt) + rtt) / 8;
+
+    if ((adata->min_rtt == 0) || (rtt < adata->min_rtt))
+      adata->min_rtt = MAX(rtt, 1);
+
+    /* The previous command completed while this one was in flight */
+    if ((adata->last_done > 0) && (adata->last_done >= cmd->sent))
+    {
+      const unsigned int gap = MIN(now - adata->last_done, UINT_MAX);
+      if (adata->sgap == 0)
+        adata->sgap = MAX(gap, 1);
+      else
+        adata->sgap = MAX(((7ULL * adata->sgap) + gap) / 8, 1);
+    }
+    adata->last_done = now;
+
+    adata->cmd_count++;
+    adata->cmd_us += rtt;
+    adata->cmd_max_us = MAX(adata->cmd_max_us, rtt);
+    mutt_debug(LL_DEBUG3, "%s completed in %u us, srtt %u us, gap %u us\n",
+               cmd->seq, rtt, adata->srtt, adata->sgap);
+  }
+
+  if (adata->sgap > 0)
+  {
+    int want = 1 + MIN(adata->min_rtt / adata->sgap, adata->cmdslots);
+    want = MIN(want, adata->cmdslots - 1);
+
+    if (adata->cmdwindow < want)
+      adata->cmdwindow++;
+    else if (adata->cmdwindow > want)
+      adata->cmdwindow--;
+  }
+}
+
 /**
  * cmd_new - Create and queue a new command control block
  * @param adata Imap Account data
@@ -109,10 +206,98 @@ static struct ImapCommand *cmd_new(struct ImapAccountData *adata)
     adata->seqno = 0;
 
   cmd->state = IMAP_CMD_NEW;
+  cmd->len = 0;
+  cmd->sent = 0;
 
   return cmd;
 }
 
+/**
+ * cmd_send - Send the queued commands to the server
+ * @param adata Imap Account data
+ * @param flags Command flags, see #ImapCmdFlags
+ * @retval  0 Success
+ * @retval <0 Failure, e.g. #IMAP_CMD_BAD
+ */
+static int cmd_send(struct ImapAccountData *adata, ImapCmdFlags flags)
+{
+  if (mutt_buffer_len(adata->cmdbuf) == 0)
+    return 0;
+
+  const int rc = mutt_socket_send_d(adata->conn, adata->cmdbuf->data,
+                                    (flags & IMAP_CMD_PASS) ? IMAP_LOG_PASS : IMAP_LOG_CMD);
+  mutt_buffer_reset(adata->cmdbuf);
+
+  /* start the clock on the commands that have just been sent */
+  const long long now = cmd_now_us();
+  for (int c = adata->lastcmd; c != adata->nextcmd; c = (c + 1) % adata->cmdslots)
+  {
+    if ((adata->cmds[c].state == IMAP_CMD_NEW) && (adata->cmds[c].sent == 0))
+      adata->cmds[c].sent = now;
+  }
+
+  /* unidle when command queue is flushed */
+  if (adata->state == IMAP_IDLE)
+    adata->state = IMAP_SELECTED;
+
+  return (rc < 0) ? IMAP_CMD_BAD : 0;
+}
+
+/**
+ * cmd_has_room - Can another command be queued?
+ * @param adata Imap Account data
+ * @param len   Length of the new command
+ * @retval true The window, and the byte limit, have room for it
+ */
+static bool cmd_has_room(struct ImapAccountData *adata, size_t len)
+{
+  if (cmd_queue_full(adata))
+    return false;
+
+  return (cmd_outstanding(adata) == 0) || (adata->inflight + len <= IMAP_PIPELINE_BYTES);
+}
+
+/**
+ * cmd_wait_room - Wait for the pipeline to have room for another command
+ * @param adata Imap Account data
+ * @param len   Length of the new command
+ * @param flags Command flags, see #ImapCmdFlags
+ * @retval  0 Success
+ * @retval <0 Failure, e.g. #IMAP_CMD_BAD
+ *
+ * Send anything still queued, then read the responses only until enough
+ * commands have completed, leaving the rest in flight.
+ */
+static int cmd_wait_room(struct ImapAccountData *adata, size_t len, ImapCmdFlags flags)
+{
+  int rc = cmd_send(adata, flags);
+  if (rc < 0)
+    return rc;
+
+  if ((flags & IMAP_CMD_POLL) && (C_ImapPollTimeout > 0) &&
+      ((mutt_socket_poll(adata->conn, C_ImapPollTimeout)) == 0))
+  {
+    mutt_error(_("Connection to %s timed out"), adata->conn->account.host);
+    return IMAP_CMD_BAD;
+  }
+
+  mutt_sig_allow_interrupt(1);
+  do
+    rc = imap_cmd_step(adata);
+  while ((rc == IMAP_CMD_CONTINUE) && !cmd_has_room(adata, len));
+  mutt_sig_allow_interrupt(0);
+
+  /* Nobody is waiting for the answers to the queued commands, so only a
+   * broken connection stops the new command being queued */
+  if ((adata->status == IMAP_FATAL) || (rc == IMAP_CMD_RESPOND))
+    return IMAP_CMD_BAD;
+
+  if (rc < 0)
+    mutt_debug(LL_DEBUG1, "queued command failed: %s\n", adata->buf);
+
+  return 0;
+}
+
 /**
  * cmd_queue - Add a IMAP command to the queue
  * @param adata Imap Account data
@@ -121,18 +306,20 @@ static struct ImapCommand *cmd_new(struct ImapAccountData *adata)
  * @retval  0 Success
  * @retval <0 Failure, e.g. #IMAP_CMD_BAD
  *
- * If the queue is full, attempts to drain it.
+ * If the window is full, or the outstanding commands are too big, waits for
+ * enough of them to complete.
  */
 static int cmd_queue(struct ImapAccountData *adata, const char *cmdstr, ImapCmdFlags flags)
 {
-  if (cmd_queue_full(adata))
-  {
-    mutt_debug(LL_DEBUG3, "Draining IMAP command pipeline\n");
+  const size_t len = mutt_str_strlen(cmdstr);
 
-    const int rc = imap_exec(adata, NULL, flags & IMAP_CMD_POLL);
+  if (!cmd_has_room(adata, len))
+  {
+    mutt_debug(LL_DEBUG3, "Waiting for room in the IMAP command pipeline\n");
 
-    if (rc == IMAP_EXEC_ERROR)
-      return IMAP_CMD_BAD;
+    const int rc = cmd_wait_room(adata, len, flags);
+    if (rc < 0)
+      return rc;
   }
 
   struct ImapCommand *cmd = cmd_new(adata);
@@ -142,6 +329,9 @@ static int cmd_queue(struct ImapAccountData *adata, const char *cmdstr, ImapCmdF
   if (mutt_buffer_add_printf(adata->cmdbuf, "%s %s\r\n", cmd->seq, cmdstr) < 0)
     return IMAP_CMD_BAD;
 
+  cmd->len = len;
+  adata->inflight += len;
+
   return 0;
 }
 
@@ -202,17 +392,15 @@ static int cmd_start(struct ImapAccountData *adata, const char *cmdstr, ImapCmdF
     return 0;
 
   if (mutt_buffer_len(adata->cmdbuf) == 0)
+  {
+    /* Everything has been sent, e.g. by imap_status_flush(), but the replies
+     * may still be outstanding */
+    if (!cmdstr && (cmd_outstanding(adata) > 0))
+      return 0;
     return IMAP_CMD_BAD;
+  }
 
-  rc = mutt_socket_send_d(adata->conn, adata->cmdbuf->data,
-                          (flags & IMAP_CMD_PASS) ? IMAP_LOG_PASS : IMAP_LOG_CMD);
-  mutt_buffer_reset(adata->cmdbuf);
-
-  /* unidle when command queue is flushed */
-  if (adata->state == IMAP_IDLE)
-    adata->state = IMAP_SELECTED;
-
-  return (rc < 0) ? IMAP_CMD_BAD : 0;
+  return cmd_send(adata, flags);
 }
 
 /**
@@ -322,7 +510,7 @@ static void cmd_parse_vanished(struct ImapAccountData *adata, char *s)
 
   while ((rc = mutt_seqset_iterator_next(iter, &uid)) == 0)
   {
-    struct Email *e = mutt_hash_int_find(mdata->uid_hash, uid);
+    struct Email *e = imap_uid_hash_find(mdata->uid_hash, uid);
     if (!e)
       continue;
 
@@ -775,7 +963,7 @@ static void cmd_parse_search(struct ImapAccountData *adata, const char *s)
   {
     if (mutt_str_atoui(s, &uid) < 0)
       continue;
-    e = mutt_hash_int_find(mdata->uid_hash, uid);
+    e = imap_uid_hash_find(mdata->uid_hash, uid);
     if (e)
       e->matched = true;
   }
@@ -841,6 +1029,8 @@ static void cmd_parse_status(struct ImapAccountData *adata, char *s)
   }
   olduv = mdata->uid_validity;
   oldun = mdata->uid_next;
+  const unsigned int oldmessages = mdata->messages;
+  const unsigned int oldunseen = mdata->unseen;
 
   if (*s++ != '(')
   {
@@ -908,6 +1098,20 @@ static void cmd_parse_status(struct ImapAccountData *adata, char *s)
     mutt_menu_set_current_redraw(REDRAW_SIDEBAR);
 #endif
 
+  /* Poll quiet mailboxes less often.  While a mailbox has new mail, its
+   * UIDNEXT is held back (see below), so that can't be compared. */
+  const bool changed = (olduv != mdata->uid_validity) || (oldmessages != mdata->messages) ||
+                       (oldunseen != mdata->unseen) ||
+                       (!m->has_new && (oldun != mdata->uid_next));
+  if (changed || (C_ImapPollBackoff == 0))
+    mdata->status_backoff = 0;
+  else
+  {
+    mdata->status_backoff = MAX(2 * mdata->status_backoff, (unsigned int) C_MailCheck);
+    mdata->status_backoff = MIN(mdata->status_backoff, (unsigned int) C_ImapPollBackoff);
+  }
+  mdata->status_due = time(NULL) + mdata->status_backoff;
+
   m->has_new = new;
   m->msg_count = mdata->messages;
   m->msg_unread = mdata->unseen;
@@ -1035,6 +1239,12 @@ static int cmd_handle_untagged(struct ImapAccountData *adata)
 
     return -1;
   }
+  else if (mutt_str_startswith(s, "OK [NOTIFICATIONOVERFLOW]", CASE_IGNORE))
+  {
+    /* The server has stopped sending notifications, RFC5465 */
+    mutt_debug(LL_DEBUG2, "Handling NOTIFICATIONOVERFLOW\n");
+    adata->notify = false;
+  }
   else if (C_ImapServernoise && mutt_str_startswith(s, "NO", CASE_IGNORE))
   {
     mutt_debug(LL_DEBUG2, "Handling untagged NO\n");
@@ -1162,6 +1372,7 @@ int imap_cmd_step(struct ImapAccountData *adata)
           adata->lastcmd = (adata->lastcmd + 1) % adata->cmdslots;
         }
         cmd->state = cmd_status(adata->buf);
+        cmd_completed(adata, cmd);
         /* bogus - we don't know which command result to return here. Caller
          * should provide a tag. */
         rc = cmd->state;
@@ -1173,11 +1384,19 @@ int imap_cmd_step(struct ImapAccountData *adata)
     c = (c + 1) % adata->cmdslots;
   } while (c != adata->nextcmd);
 
+  /* skip over commands that completed out of order */
+  while ((adata->lastcmd != adata->nextcmd) &&
+         (adata->cmds[adata->lastcmd].state != IMAP_CMD_NEW))
+  {
+    adata->lastcmd = (adata->lastcmd + 1) % adata->cmdslots;
+  }
+
   if (stillrunning)
     rc = IMAP_CMD_CONTINUE;
   else
   {
     mutt_debug(LL_DEBUG3, "IMAP queue drained\n");
+    adata->inflight = 0;
     imap_cmd_finish(adata);
   }
 
@@ -1349,6 +1568,22 @@ void imap_cmd_finish(struct ImapAccountData *adata)
   adata->status = 0;
 }
 
+/**
+ * imap_cmd_queued - Are there commands waiting to be sent?
+ * @param adata Imap Account data
+ * @retval true Commands have been queued, but not sent
+ */
+bool imap_cmd_queued(struct ImapAccountData *adata)
+{
+  for (int c = adata->lastcmd; c != adata->nextcmd; c = (c + 1) % adata->cmdslots)
+  {
+    if ((adata->cmds[c].state == IMAP_CMD_NEW) && (adata->cmds[c].sent == 0))
+      return true;
+  }
+
+  return false;
+}
+
 /**
  * imap_cmd_idle - Enter the IDLE state
  * @param adata Imap Account data
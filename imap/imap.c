@@ -68,6 +68,8 @@ struct stat;
 /* These Config Variables are only used in imap/imap.c */
 bool C_ImapIdle; ///< Config: (imap) Use the IMAP IDLE extension to check for new mail
 bool C_ImapRfc5161; ///< Config: (imap) Use the IMAP ENABLE extension to select capabilities
+bool C_ImapDeflate; ///< Config: (imap) Compress network traffic
+bool C_ImapNotify; ///< Config: (imap) Ask the server to report changes to the mailboxes
 
 /**
  * check_capabilities - Make sure we can log in to this server
@@ -331,38 +333,208 @@ static int sync_helper(struct Mailbox *m, AclFlags right, int flag, const char *
 }
 
 /**
- * do_search - Perform a search of messages
- * @param search  List of pattern to match
- * @param allpats Must all patterns match?
- * @retval num Number of patterns search that should be done server-side
+ * search_whole_days - Does a date pattern cover whole days?
+ * @param pat Date pattern to check
+ * @retval true The range starts at midnight and ends just before midnight
  *
- * Count the number of patterns that can be done by the server (are full-text).
+ * The server only compares dates, not times.
  */
-static int do_search(const struct PatternHead *search, bool allpats)
+static bool search_whole_days(const struct Pattern *pat)
 {
-  int rc = 0;
-  const struct Pattern *pat = NULL;
+  struct tm tm = mutt_date_localtime(pat->min);
+  if ((tm.tm_hour != 0) || (tm.tm_min != 0) || (tm.tm_sec != 0))
+    return false;
 
-  SLIST_FOREACH(pat, search, entries)
+  tm = mutt_date_localtime(pat->max);
+  return (tm.tm_hour == 23) && (tm.tm_min == 59) && (tm.tm_sec == 59);
+}
+
+/**
+ * search_string - Get the text of a pattern, for the server to search for
+ * @param pat Pattern
+ * @retval ptr  String to search for
+ * @retval NULL The pattern is a real regex
+ *
+ * A lower-case regex without special characters matches like the server's
+ * case-insensitive substring search.
+ */
+static const char *search_string(const struct Pattern *pat)
+{
+  return pat->stringmatch ? pat->p.str : pat->plain;
+}
+
+/**
+ * search_header_name - Does a header search name a valid header?
+ * @param str Header search, e.g. "X-Label: foo"
+ * @retval true The text before the ':' can be a header name
+ */
+static bool search_header_name(const char *str)
+{
+  const char *delim = strchr(str, ':');
+  if (!delim || (delim == str))
+    return false;
+
+  /* RFC5322: printable ASCII, except ':' */
+  for (const char *p = str; p < delim; p++)
+  {
+    if ((*p < 33) || (*p > 126))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * search_translatable - Can the server evaluate a pattern?
+ * @param m   Mailbox
+ * @param pat Pattern to check
+ * @retval true The pattern can be converted into an IMAP SEARCH
+ *
+ * Only patterns that the server will evaluate in the same way as NeoMutt
+ * qualify.  The server's string matches ignore case.
+ *
+ * A ~h regex, e.g. `~h "re: hello"`, matches anywhere in a header line, so it
+ * can't be turned into the server's HEADER name/value search.  Only =h is
+ * sent, and only if it starts with a header name.
+ */
+static bool search_translatable(struct Mailbox *m, const struct Pattern *pat)
+{
+  const struct Pattern *child = NULL;
+
+  switch (pat->op)
+  {
+    case MUTT_PAT_AND:
+    case MUTT_PAT_OR:
+      SLIST_FOREACH(child, pat->child, entries)
+      {
+        if (!search_translatable(m, child))
+          return false;
+      }
+      return true;
+    case MUTT_PAT_HEADER:
+      /* IMAP needs the name of the header */
+      return pat->stringmatch && search_header_name(pat->p.str);
+    case MUTT_PAT_BODY:
+    case MUTT_PAT_WHOLE_MSG:
+      return search_string(pat);
+    case MUTT_PAT_SERVERSEARCH:
+      return pat->stringmatch;
+    case MUTT_PAT_FROM:
+    case MUTT_PAT_TO:
+    case MUTT_PAT_CC:
+    case MUTT_PAT_SUBJECT:
+      if (pat->alladdr || pat->isalias)
+        return false;
+      return pat->plain || (pat->stringmatch && pat->ign_case);
+    case MUTT_PAT_DATE:
+    case MUTT_PAT_DATE_RECEIVED:
+      return !pat->dynamic && search_whole_days(pat);
+    case MUTT_FLAG:
+    case MUTT_READ:
+    case MUTT_UNREAD:
+    case MUTT_REPLIED:
+    case MUTT_DELETED:
+      /* unless the server is up to date */
+      return !m->changed;
+    case MUTT_ALL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * search_costly - Does a pattern need the text of the messages?
+ * @param pat Pattern to check
+ * @retval true The pattern matches the headers or body of the messages
+ */
+static bool search_costly(const struct Pattern *pat)
+{
+  const struct Pattern *child = NULL;
+
+  switch (pat->op)
+  {
+    case MUTT_PAT_BODY:
+    case MUTT_PAT_HEADER:
+    case MUTT_PAT_WHOLE_MSG:
+    case MUTT_PAT_SERVERSEARCH:
+      return true;
+    default:
+      if (!pat->child)
+        return false;
+      SLIST_FOREACH(child, pat->child, entries)
+      {
+        if (search_costly(child))
+          return true;
+      }
+      return false;
+  }
+}
+
+/**
+ * needs_message - Does a pattern need to read the message?
+ * @param pat Pattern to check
+ * @retval true The message's text must be matched locally
+ *
+ * Body and header matches that weren't done by the server must be done by
+ * reading the message.  So must matches of its MIME structure.
+ */
+static bool needs_message(const struct Pattern *pat)
+{
+  if (pat->server)
+    return false;
+
+  switch (pat->op)
+  {
+    case MUTT_PAT_BODY:
+    case MUTT_PAT_HEADER:
+    case MUTT_PAT_WHOLE_MSG:
+    case MUTT_PAT_MIMEATTACH:
+    case MUTT_PAT_MIMETYPE:
+      return true;
+  }
+
+  const struct Pattern *child = NULL;
+  if (pat->child)
   {
-    switch (pat->op)
+    SLIST_FOREACH(child, pat->child, entries)
     {
-      case MUTT_PAT_BODY:
-      case MUTT_PAT_HEADER:
-      case MUTT_PAT_WHOLE_MSG:
-        if (pat->stringmatch)
-          rc++;
-        break;
-      case MUTT_PAT_SERVERSEARCH:
-        rc++;
-        break;
-      default:
-        if (pat->child && do_search(pat->child, true))
-          rc++;
+      if (needs_message(child))
+        return true;
     }
+  }
 
-    if (!allpats)
-      break;
+  return false;
+}
+
+/**
+ * must_read - Must a message be read to find out if it matches?
+ * @param m   Mailbox
+ * @param pat Pattern to check
+ * @param e   Email to check
+ * @retval true The message has to be downloaded
+ *
+ * The terms of an AND or OR that don't need the message are matched first.
+ * A term that fails an AND, or matches an OR, decides the result without
+ * reading the message.
+ */
+static bool must_read(struct Mailbox *m, struct Pattern *pat, struct Email *e)
+{
+  if (!needs_message(pat))
+    return false;
+
+  if (pat->not || ((pat->op != MUTT_PAT_AND) && (pat->op != MUTT_PAT_OR)))
+    return true;
+
+  const bool and = (pat->op == MUTT_PAT_AND);
+  bool rc = false;
+  struct Pattern *child = NULL;
+  SLIST_FOREACH(child, pat->child, entries)
+  {
+    if (needs_message(child))
+      rc |= must_read(m, child, e);
+    else if ((mutt_pattern_exec(child, MUTT_MATCH_FULL_ADDRESS, m, e, NULL) > 0) != and)
+      return false;
   }
 
   return rc;
@@ -376,106 +548,296 @@ static int do_search(const struct PatternHead *search, bool allpats)
  * @retval  0 Success
  * @retval -1 Failure
  *
- * Convert neomutt Pattern to IMAP SEARCH command containing only elements
- * that require full-text search (neomutt already has what it needs for most
- * match types, and does a better job (eg server doesn't support regexes).
+ * The pattern must have passed search_translatable().
  */
-static int compile_search(struct Mailbox *m, const struct PatternHead *pat, struct Buffer *buf)
+static int compile_search(struct Mailbox *m, const struct Pattern *pat, struct Buffer *buf)
 {
-  struct Pattern *firstpat = SLIST_FIRST(pat);
-
-  if (do_search(pat, false) == 0)
-    return 0;
+  char term[256];
+  char name[256];
+  const char *delim = NULL;
+  const struct Pattern *child = NULL;
 
-  if (firstpat->not)
+  if (pat->not)
     mutt_buffer_addstr(buf, "NOT ");
 
-  if (firstpat->child)
+  switch (pat->op)
   {
-    int clauses;
-
-    clauses = do_search(firstpat->child, true);
-    if (clauses > 0)
-    {
+    case MUTT_PAT_AND:
+    case MUTT_PAT_OR:
       mutt_buffer_addch(buf, '(');
-
-      while (clauses)
+      SLIST_FOREACH(child, pat->child, entries)
       {
-        if (do_search(firstpat->child, false))
-        {
-          if ((firstpat->op == MUTT_PAT_OR) && (clauses > 1))
-            mutt_buffer_addstr(buf, "OR ");
-          clauses--;
-
-          if (compile_search(m, firstpat->child, buf) < 0)
-            return -1;
-
-          if (clauses)
-            mutt_buffer_addch(buf, ' ');
-        }
-
-        SLIST_REMOVE_HEAD(firstpat->child, entries);
+        if (child != SLIST_FIRST(pat->child))
+          mutt_buffer_addch(buf, ' ');
+        /* IMAP's OR takes two keys: "OR a OR b c" */
+        if ((pat->op == MUTT_PAT_OR) && SLIST_NEXT(child, entries))
+          mutt_buffer_addstr(buf, "OR ");
+        if (compile_search(m, child, buf) < 0)
+          return -1;
       }
-
       mutt_buffer_addch(buf, ')');
+      break;
+    case MUTT_PAT_HEADER:
+      mutt_buffer_addstr(buf, "HEADER ");
+
+      /* extract header name */
+      delim = strchr(pat->p.str, ':');
+      mutt_str_strfcpy(name, pat->p.str, MIN(sizeof(name), delim - pat->p.str + 1));
+      imap_quote_string(term, sizeof(term), name, false);
+      mutt_buffer_addstr(buf, term);
+      mutt_buffer_addch(buf, ' ');
+
+      /* and field */
+      delim++;
+      SKIPWS(delim);
+      imap_quote_string(term, sizeof(term), delim, false);
+      mutt_buffer_addstr(buf, term);
+      break;
+    case MUTT_PAT_BODY:
+      mutt_buffer_addstr(buf, "BODY ");
+      imap_quote_string(term, sizeof(term), search_string(pat), false);
+      mutt_buffer_addstr(buf, term);
+      break;
+    case MUTT_PAT_WHOLE_MSG:
+      mutt_buffer_addstr(buf, "TEXT ");
+      imap_quote_string(term, sizeof(term), search_string(pat), false);
+      mutt_buffer_addstr(buf, term);
+      break;
+    case MUTT_PAT_SERVERSEARCH:
+    {
+      struct ImapAccountData *adata = imap_adata_get(m);
+      if (!(adata->capabilities & IMAP_CAP_X_GM_EXT_1))
+      {
+        mutt_error(_("Server-side custom search not supported: %s"), pat->p.str);
+        return -1;
+      }
+    }
+      mutt_buffer_addstr(buf, "X-GM-RAW ");
+      imap_quote_string(term, sizeof(term), pat->p.str, false);
+      mutt_buffer_addstr(buf, term);
+      break;
+    case MUTT_PAT_FROM:
+    case MUTT_PAT_TO:
+    case MUTT_PAT_CC:
+    case MUTT_PAT_SUBJECT:
+      if (pat->op == MUTT_PAT_FROM)
+        mutt_buffer_addstr(buf, "FROM ");
+      else if (pat->op == MUTT_PAT_TO)
+        mutt_buffer_addstr(buf, "TO ");
+      else if (pat->op == MUTT_PAT_CC)
+        mutt_buffer_addstr(buf, "CC ");
+      else
+        mutt_buffer_addstr(buf, "SUBJECT ");
+      imap_quote_string(term, sizeof(term), search_string(pat), false);
+      mutt_buffer_addstr(buf, term);
+      break;
+    case MUTT_PAT_DATE:
+    case MUTT_PAT_DATE_RECEIVED:
+    {
+      /* SENT* compare the Date: header, the others the INTERNALDATE */
+      const char *sent = (pat->op == MUTT_PAT_DATE) ? "SENT" : "";
+      char since[IMAP_DATELEN];
+      char before[IMAP_DATELEN];
+      mutt_date_make_imap(since, sizeof(since), pat->min);
+      mutt_date_make_imap(before, sizeof(before), (time_t) pat->max + 1);
+      mutt_buffer_add_printf(buf, "(%sSINCE %.11s %sBEFORE %.11s)", sent, since,
+                             sent, before);
+      break;
     }
+    case MUTT_FLAG:
+      mutt_buffer_addstr(buf, "FLAGGED");
+      break;
+    case MUTT_READ:
+      mutt_buffer_addstr(buf, "SEEN");
+      break;
+    case MUTT_UNREAD:
+      mutt_buffer_addstr(buf, "UNSEEN");
+      break;
+    case MUTT_REPLIED:
+      mutt_buffer_addstr(buf, "ANSWERED");
+      break;
+    case MUTT_DELETED:
+      mutt_buffer_addstr(buf, "DELETED");
+      break;
+    case MUTT_ALL:
+      mutt_buffer_addstr(buf, "ALL");
+      break;
   }
-  else
+
+  return 0;
+}
+
+/**
+ * compare_uint - Compare two UIDs - Implements ::sort_t
+ */
+static int compare_uint(const void *a, const void *b)
+{
+  const unsigned int ua = *(const unsigned int *) a;
+  const unsigned int ub = *(const unsigned int *) b;
+  return (ua > ub) - (ua < ub);
+}
+
+/**
+ * search_server - Have the server evaluate part of a pattern
+ * @param m   Mailbox
+ * @param pat Pattern to evaluate
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * The UIDs of the matching messages are stored in the Pattern, for
+ * mutt_pattern_exec().  They stay valid when messages are renumbered by an
+ * expunge, e.g. when the limit is applied again.
+ */
+static int search_server(struct Mailbox *m, struct Pattern *pat)
+{
+  struct ImapAccountData *adata = imap_adata_get(m);
+  struct Buffer buf;
+  int rc = -1;
+
+  mutt_buffer_init(&buf);
+  mutt_buffer_addstr(&buf, "UID SEARCH ");
+  if (compile_search(m, pat, &buf) < 0)
+    goto out;
+
+  for (int i = 0; i < m->msg_count; i++)
+    m->emails[i]->matched = false;
+
+  if (imap_exec(adata, buf.data, IMAP_CMD_NO_FLAGS) != IMAP_EXEC_SUCCESS)
+    goto out;
+
+  pat->server_uids = mutt_mem_calloc(MAX(m->msg_count, 1), sizeof(unsigned int));
+  pat->server_num = 0;
+  pat->server_uid_max = 0;
+  for (int i = 0; i < m->msg_count; i++)
   {
-    char term[256];
-    char *delim = NULL;
+    struct Email *e = m->emails[i];
+    const unsigned int uid = e->edata ? imap_edata_get(e)->uid : 0;
+    pat->server_uid_max = MAX(pat->server_uid_max, uid);
+    if (e->matched && (uid != 0))
+      pat->server_uids[pat->server_num++] = uid;
+    e->matched = false;
+  }
+  qsort(pat->server_uids, pat->server_num, sizeof(unsigned int), compare_uint);
+  pat->server = true;
+  rc = 0;
+
+out:
+  FREE(&buf.data);
+  return rc;
+}
+
+/**
+ * search_regroup - Gather the server's parts of an AND or OR
+ * @param m   Mailbox
+ * @param pat Pattern to rearrange
+ *
+ * e.g. `~b foo ~F ~x bar` becomes `(~b foo ~F) ~x bar`, so that the server can
+ * evaluate the first part with one search.  The new group comes first, so it
+ * can short-circuit the rest.
+ */
+static void search_regroup(struct Mailbox *m, struct Pattern *pat)
+{
+  struct Pattern *child = NULL;
+  int count = 0;
+  bool costly = false;
 
-    switch (firstpat->op)
+  SLIST_FOREACH(child, pat->child, entries)
+  {
+    if (search_translatable(m, child))
     {
-      case MUTT_PAT_HEADER:
-        mutt_buffer_addstr(buf, "HEADER ");
+      count++;
+      costly |= search_costly(child);
+    }
+  }
 
-        /* extract header name */
-        delim = strchr(firstpat->p.str, ':');
-        if (!delim)
-        {
-          mutt_error(_("Header search without header name: %s"), firstpat->p.str);
-          return -1;
-        }
-        *delim = '\0';
-        imap_quote_string(term, sizeof(term), firstpat->p.str, false);
-        mutt_buffer_addstr(buf, term);
-        mutt_buffer_addch(buf, ' ');
-
-        /* and field */
-        *delim = ':';
-        delim++;
-        SKIPWS(delim);
-        imap_quote_string(term, sizeof(term), delim, false);
-        mutt_buffer_addstr(buf, term);
-        break;
-      case MUTT_PAT_BODY:
-        mutt_buffer_addstr(buf, "BODY ");
-        imap_quote_string(term, sizeof(term), firstpat->p.str, false);
-        mutt_buffer_addstr(buf, term);
-        break;
-      case MUTT_PAT_WHOLE_MSG:
-        mutt_buffer_addstr(buf, "TEXT ");
-        imap_quote_string(term, sizeof(term), firstpat->p.str, false);
-        mutt_buffer_addstr(buf, term);
-        break;
-      case MUTT_PAT_SERVERSEARCH:
-      {
-        struct ImapAccountData *adata = imap_adata_get(m);
-        if (!(adata->capabilities & IMAP_CAP_X_GM_EXT_1))
-        {
-          mutt_error(_("Server-side custom search not supported: %s"),
-                     firstpat->p.str);
-          return -1;
-        }
-      }
-        mutt_buffer_addstr(buf, "X-GM-RAW ");
-        imap_quote_string(term, sizeof(term), firstpat->p.str, false);
-        mutt_buffer_addstr(buf, term);
-        break;
+  if ((count < 2) || !costly)
+    return;
+
+  struct Pattern *group = mutt_mem_calloc(1, sizeof(struct Pattern));
+  group->op = pat->op;
+  group->child = mutt_mem_calloc(1, sizeof(struct PatternHead));
+  SLIST_INIT(group->child);
+
+  struct PatternHead rest = SLIST_HEAD_INITIALIZER(rest);
+  struct Pattern *group_tail = NULL;
+  struct Pattern *rest_tail = NULL;
+
+  while ((child = SLIST_FIRST(pat->child)))
+  {
+    SLIST_REMOVE_HEAD(pat->child, entries);
+    if (search_translatable(m, child))
+    {
+      if (group_tail)
+        SLIST_INSERT_AFTER(group_tail, child, entries);
+      else
+        SLIST_INSERT_HEAD(group->child, child, entries);
+      group_tail = child;
+    }
+    else
+    {
+      if (rest_tail)
+        SLIST_INSERT_AFTER(rest_tail, child, entries);
+      else
+        SLIST_INSERT_HEAD(&rest, child, entries);
+      rest_tail = child;
     }
   }
 
+  SLIST_FIRST(pat->child) = SLIST_FIRST(&rest);
+  SLIST_INSERT_HEAD(pat->child, group, entries);
+}
+
+/**
+ * search_reset - Forget the results of previous server-side searches
+ * @param search List of patterns to reset
+ */
+static void search_reset(struct PatternHead *search)
+{
+  struct Pattern *pat = NULL;
+
+  SLIST_FOREACH(pat, search, entries)
+  {
+    pat->server = false;
+    FREE(&pat->server_uids);
+    pat->server_num = 0;
+    pat->server_uid_max = 0;
+    if (pat->child)
+      search_reset(pat->child);
+  }
+}
+
+/**
+ * search_offload - Have the server evaluate as much of a pattern as it can
+ * @param m   Mailbox
+ * @param pat Pattern to evaluate
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * Each largest part of the pattern that the server understands, and which
+ * would otherwise mean reading the messages, is sent as one search.
+ */
+static int search_offload(struct Mailbox *m, struct Pattern *pat)
+{
+  if (search_translatable(m, pat))
+  {
+    if (!search_costly(pat))
+      return 0;
+    return search_server(m, pat);
+  }
+
+  if (!pat->child)
+    return 0;
+
+  if ((pat->op == MUTT_PAT_AND) || (pat->op == MUTT_PAT_OR))
+    search_regroup(m, pat);
+
+  struct Pattern *child = NULL;
+  SLIST_FOREACH(child, pat->child, entries)
+  {
+    if (search_offload(m, child) < 0)
+      return -1;
+  }
+
   return 0;
 }
 
@@ -654,11 +1016,33 @@ int imap_delete_mailbox(struct Mailbox *m, char *path)
   return 0;
 }
 
+/**
+ * log_cmd_stats - Log the latency of a connection's commands
+ * @param adata Imap Account data
+ *
+ * The statistics are reset afterwards.
+ */
+static void log_cmd_stats(struct ImapAccountData *adata)
+{
+  if (adata->cmd_count == 0)
+    return;
+
+  mutt_debug(LL_DEBUG2, "%lu commands: average %llu us, worst %u us, srtt %u us, min %u us, gap %u us, window %d\n",
+             adata->cmd_count, adata->cmd_us / adata->cmd_count, adata->cmd_max_us,
+             adata->srtt, adata->min_rtt, adata->sgap, adata->cmdwindow);
+  adata->cmd_count = 0;
+  adata->cmd_us = 0;
+  adata->cmd_max_us = 0;
+  adata->min_rtt = 0;
+  adata->sgap = 0;
+  adata->last_done = 0;
+}
+
 /**
  * imap_logout - Gracefully log out of server
  * @param adata Imap Account data
  */
-static void imap_logout(struct ImapAccountData *adata)
+void imap_logout(struct ImapAccountData *adata)
 {
   /* we set status here to let imap_handle_untagged know we _expect_ to
    * receive a bye response (so it doesn't freak out and close the conn) */
@@ -676,6 +1060,7 @@ static void imap_logout(struct ImapAccountData *adata)
   }
   mutt_socket_close(adata->conn);
   adata->state = IMAP_DISCONNECTED;
+  log_cmd_stats(adata);
 }
 
 /**
@@ -705,6 +1090,52 @@ void imap_logout_all(void)
   }
 }
 
+/**
+ * read_literal_span - Read part of a literal from the server
+ * @param[in]     adata Imap Account data
+ * @param[in]     left  Number of bytes of the literal still to read
+ * @param[in]     out   Buffer to append the data to
+ * @param[in,out] cr    true if a '\r' was held back from the previous span
+ * @retval >0 Number of bytes read from the server
+ * @retval -1 Error
+ *
+ * Read up to the end of the next line, or of the literal, whichever is first.
+ * A `\r\n` is stored as `\n`.  A `\r` at the end of the span is held back
+ * until we know what follows it.
+ */
+static int read_literal_span(struct ImapAccountData *adata, unsigned long left,
+                             struct Buffer *out, bool *cr)
+{
+  const char *line = NULL;
+  const int rc = mutt_socket_peekln(adata->conn, &line);
+  if (rc < 0)
+    return -1;
+
+  const size_t n = MIN((unsigned long) rc, left);
+  mutt_socket_advance(adata->conn, n);
+
+  if (*cr && (line[0] != '\n'))
+    mutt_buffer_addch(out, '\r');
+  *cr = false;
+
+  if ((n >= 2) && (line[n - 2] == '\r') && (line[n - 1] == '\n'))
+  {
+    mutt_buffer_addstr_n(out, line, n - 2);
+    mutt_buffer_addch(out, '\n');
+  }
+  else if (line[n - 1] == '\r')
+  {
+    mutt_buffer_addstr_n(out, line, n - 1);
+    *cr = true;
+  }
+  else
+  {
+    mutt_buffer_addstr_n(out, line, n);
+  }
+
+  return n;
+}
+
 /**
  * imap_read_literal - Read bytes bytes from server into file
  * @param fp    File handle for email file
@@ -714,53 +1145,49 @@ void imap_logout_all(void)
  * @retval  0 Success
  * @retval -1 Failure
  *
- * Not explicitly buffered, relies on FILE buffering.
- *
  * @note Strips `\r` from `\r\n`.
  *       Apparently even literals use `\r\n`-terminated strings ?!
  */
 int imap_read_literal(FILE *fp, struct ImapAccountData *adata,
                       unsigned long bytes, struct Progress *pbar)
 {
-  char c;
-  bool r = false;
+  bool cr = false;
   struct Buffer *buf = NULL;
+  struct Buffer *span = mutt_buffer_pool_get();
 
   if (C_DebugLevel >= IMAP_LOG_LTRL)
     buf = mutt_buffer_alloc(bytes + 10);
 
   mutt_debug(LL_DEBUG2, "reading %ld bytes\n", bytes);
 
-  for (unsigned long pos = 0; pos < bytes; pos++)
+  if (pbar)
+    mutt_progress_update(pbar, 0, -1);
+
+  for (unsigned long pos = 0; pos < bytes;)
   {
-    if (mutt_socket_readchar(adata->conn, &c) != 1)
+    mutt_buffer_reset(span);
+    const int rc = read_literal_span(adata, bytes - pos, span, &cr);
+    if (rc < 0)
     {
       mutt_debug(LL_DEBUG1, "error during read, %ld bytes read\n", pos);
       adata->status = IMAP_FATAL;
 
+      mutt_buffer_pool_release(&span);
       mutt_buffer_free(&buf);
       return -1;
     }
 
-    if (r && (c != '\n'))
-      fputc('\r', fp);
+    fwrite(span->data, 1, mutt_buffer_len(span), fp);
 
-    if (c == '\r')
-    {
-      r = true;
-      continue;
-    }
-    else
-      r = false;
-
-    fputc(c, fp);
-
-    if (pbar && !(pos % 1024))
+    pos += rc;
+    if (pbar)
       mutt_progress_update(pbar, pos, -1);
     if (C_DebugLevel >= IMAP_LOG_LTRL)
-      mutt_buffer_addch(buf, c);
+      mutt_buffer_addstr_n(buf, span->data, mutt_buffer_len(span));
   }
 
+  mutt_buffer_pool_release(&span);
+
   if (C_DebugLevel >= IMAP_LOG_LTRL)
   {
     mutt_debug(IMAP_LOG_LTRL, "\n%s", buf->data);
@@ -769,6 +1196,46 @@ int imap_read_literal(FILE *fp, struct ImapAccountData *adata,
   return 0;
 }
 
+/**
+ * imap_read_literal_buf - Read bytes bytes from server into a Buffer
+ * @param buf   Buffer to append the data to
+ * @param adata Imap Account data
+ * @param bytes Number of bytes to read
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * Like imap_read_literal(), but keeps the data in memory.
+ *
+ * @note Strips `\r` from `\r\n`.
+ */
+int imap_read_literal_buf(struct Buffer *buf, struct ImapAccountData *adata,
+                          unsigned long bytes)
+{
+  bool cr = false;
+  const size_t start = mutt_buffer_len(buf);
+
+  mutt_debug(LL_DEBUG2, "reading %ld bytes\n", bytes);
+
+  mutt_buffer_increase_size(buf, start + bytes + 1);
+
+  for (unsigned long pos = 0; pos < bytes;)
+  {
+    const int rc = read_literal_span(adata, bytes - pos, buf, &cr);
+    if (rc < 0)
+    {
+      mutt_debug(LL_DEBUG1, "error during read, %ld bytes read\n", pos);
+      adata->status = IMAP_FATAL;
+      return -1;
+    }
+    pos += rc;
+  }
+
+  if (C_DebugLevel >= IMAP_LOG_LTRL)
+    mutt_debug(IMAP_LOG_LTRL, "\n%s", buf->data + start);
+
+  return 0;
+}
+
 /**
  * imap_expunge_mailbox - Purge messages from the server
  * @param m Mailbox
@@ -805,7 +1272,7 @@ void imap_expunge_mailbox(struct Mailbox *m)
       imap_hcache_del(mdata, imap_edata_get(e)->uid);
 #endif
 
-      mutt_hash_int_delete(mdata->uid_hash, imap_edata_get(e)->uid, e);
+      imap_uid_hash_delete(mdata->uid_hash, imap_edata_get(e)->uid, e);
 
       imap_edata_free((void **) &e->edata);
     }
@@ -950,6 +1417,9 @@ void imap_close_connection(struct ImapAccountData *adata)
   adata->lastcmd = false;
   adata->status = 0;
   memset(adata->cmds, 0, sizeof(struct ImapCommand) * adata->cmdslots);
+  adata->inflight = 0;
+
+  log_cmd_stats(adata);
 }
 
 /**
@@ -1288,17 +1758,145 @@ static int imap_status(struct ImapAccountData *adata, struct ImapMboxData *mdata
   return mdata->messages;
 }
 
+/**
+ * imap_notify_set - Ask the server to report changes to our mailboxes
+ * @param adata Imap Account data
+ *
+ * RFC5465: the server reports changes to the Account's mailboxes, so they
+ * needn't be polled.  Until the list is sent again, mailboxes added later
+ * aren't covered and are still polled.  The auxiliary connections aren't
+ * part of any Account, so they don't ask for notifications.  The selected
+ * mailbox's EXPUNGEs must wait until we can handle them.
+ */
+static void imap_notify_set(struct ImapAccountData *adata)
+{
+  adata->notify = false;
+  adata->notify_update = false;
+  if (!C_ImapNotify || !(adata->capabilities & IMAP_CAP_NOTIFY))
+    return;
+
+  struct Account *a = NULL;
+  TAILQ_FOREACH(a, &AllAccounts, entries)
+  {
+    if (a->adata == adata)
+      break;
+  }
+  if (!a)
+    return;
+
+  struct Buffer *cmd = mutt_buffer_pool_get();
+  mutt_buffer_strcpy(cmd, "NOTIFY SET (selected-delayed (MessageNew MessageExpunge FlagChange)) "
+                          "(mailboxes (");
+
+  size_t count = 0;
+  struct MailboxNode *np = NULL;
+  STAILQ_FOREACH(np, &a->mailboxes, entries)
+  {
+    struct ImapMboxData *mdata = imap_mdata_get(np->mailbox);
+    if (!mdata)
+      continue;
+    mdata->notify = false;
+    if (count++ != 0)
+      mutt_buffer_addch(cmd, ' ');
+    mutt_buffer_addstr(cmd, mdata->munge_name);
+  }
+  mutt_buffer_addstr(cmd, ") (MessageNew MessageExpunge FlagChange))");
+
+  if ((count != 0) && (imap_exec(adata, mutt_b2s(cmd), IMAP_CMD_NO_FLAGS) == IMAP_EXEC_SUCCESS))
+  {
+    mutt_debug(LL_DEBUG2, "IMAP notifications are enabled for %zu mailboxes on %s\n",
+               count, adata->conn->account.host);
+    STAILQ_FOREACH(np, &a->mailboxes, entries)
+    {
+      struct ImapMboxData *mdata = imap_mdata_get(np->mailbox);
+      if (mdata)
+        mdata->notify = true;
+    }
+    adata->notify = true;
+  }
+
+  mutt_buffer_pool_release(&cmd);
+}
+
+/**
+ * imap_notify_read - Read any notifications the server has sent
+ * @param adata Imap Account data
+ *
+ * This doesn't wait for the server.
+ */
+static void imap_notify_read(struct ImapAccountData *adata)
+{
+  while (mutt_socket_poll(adata->conn, 0) > 0)
+  {
+    if (imap_cmd_step(adata) < 0)
+    {
+      mutt_debug(LL_DEBUG1, "Error reading notifications\n");
+      break;
+    }
+  }
+}
+
 /**
  * imap_mbox_check_stats - Implements MxOps::mbox_check_stats()
+ *
+ * Unless the check is forced, mailboxes whose state the server reports to us
+ * (RFC5465) aren't polled, nor are those that have backed off, see
+ * $imap_poll_backoff.
  */
 int imap_mbox_check_stats(struct Mailbox *m, int flags)
 {
+  struct ImapAccountData *adata = imap_adata_get(m);
+  struct ImapMboxData *mdata = imap_mdata_get(m);
+  if (!adata || !mdata)
+    return -1;
+
+  if (adata->notify_update && (adata->state >= IMAP_AUTHENTICATED))
+    imap_notify_set(adata);
+
+  if (!(flags & MUTT_MAILBOX_CHECK_FORCE) && (mdata->status_due != 0))
+  {
+    if (adata->notify && mdata->notify && (adata->state >= IMAP_AUTHENTICATED))
+    {
+      imap_notify_read(adata);
+      return 0;
+    }
+
+    if (time(NULL) < mdata->status_due)
+      return 0;
+  }
+
   int rc = imap_mailbox_status(m, true);
   if (rc > 0)
     rc = 0;
   return rc;
 }
 
+/**
+ * imap_status_flush - Send the queued STATUS commands
+ *
+ * While checking for new mail, the STATUS commands for each account are
+ * queued, then sent in a single burst.  This doesn't wait for the server: any
+ * replies that have already arrived are read now, the rest whenever the
+ * connection is next used.
+ */
+void imap_status_flush(void)
+{
+  struct Account *np = NULL;
+  TAILQ_FOREACH(np, &AllAccounts, entries)
+  {
+    if (np->magic != MUTT_IMAP)
+      continue;
+
+    struct ImapAccountData *adata = np->adata;
+    if (!adata || (adata->state < IMAP_AUTHENTICATED) || !imap_cmd_queued(adata))
+      continue;
+
+    if (imap_cmd_start(adata, NULL) < 0)
+      continue;
+    imap_notify_read(adata);
+  }
+}
+
 /**
  * imap_path_status - Refresh the number of total and new messages
  * @param path   Mailbox path
@@ -1345,34 +1943,69 @@ int imap_mailbox_status(struct Mailbox *m, bool queue)
  * @param pat Pattern to match
  * @retval  0 Success
  * @retval -1 Failure
+ *
+ * The parts of the pattern that the server can evaluate are searched for on
+ * the server.  The pattern may be rearranged to make this possible.
  */
-int imap_search(struct Mailbox *m, const struct PatternHead *pat)
+int imap_search(struct Mailbox *m, struct PatternHead *pat)
 {
-  struct Buffer buf;
-  struct ImapAccountData *adata = imap_adata_get(m);
   for (int i = 0; i < m->msg_count; i++)
     m->emails[i]->matched = false;
 
-  if (do_search(pat, true) == 0)
-    return 0;
+  search_reset(pat);
 
-  mutt_buffer_init(&buf);
-  mutt_buffer_addstr(&buf, "UID SEARCH ");
-  if (compile_search(m, pat, &buf) < 0)
+  struct Pattern *np = NULL;
+  SLIST_FOREACH(np, pat, entries)
   {
-    FREE(&buf.data);
-    return -1;
+    if (search_offload(m, np) < 0)
+      return -1;
   }
-  if (imap_exec(adata, buf.data, IMAP_CMD_NO_FLAGS) != IMAP_EXEC_SUCCESS)
+
+  /* download the messages in batches, rather than one at a time */
+  struct Email **emails = mutt_mem_calloc(m->msg_count, sizeof(struct Email *));
+  int num = 0;
+  for (int i = 0; i < m->msg_count; i++)
   {
-    FREE(&buf.data);
-    return -1;
+    bool read = false;
+    SLIST_FOREACH(np, pat, entries)
+    {
+      if (must_read(m, np, m->emails[i]))
+      {
+        read = true;
+        break;
+      }
+    }
+    if (read)
+      emails[num++] = m->emails[i];
   }
 
-  FREE(&buf.data);
+  imap_msg_prefetch(m, emails, num, num);
+  FREE(&emails);
+
   return 0;
 }
 
+/**
+ * imap_search_match - Look up the server's verdict on an Email
+ * @param pat Pattern that imap_search() sent to the server
+ * @param e   Email to check
+ * @retval  1 The server matched the Email
+ * @retval  0 The server didn't match it
+ * @retval -1 The Email arrived after the search, match it locally
+ */
+int imap_search_match(const struct Pattern *pat, struct Email *e)
+{
+  if (!pat || !pat->server || !e || !e->edata)
+    return -1;
+
+  const unsigned int uid = imap_edata_get(e)->uid;
+  if ((uid == 0) || (uid > pat->server_uid_max))
+    return -1;
+
+  return bsearch(&uid, pat->server_uids, pat->server_num, sizeof(unsigned int),
+                 compare_uint) != NULL;
+}
+
 /**
  * imap_subscribe - Subscribe to a mailbox
  * @param path      Mailbox path
@@ -1880,6 +2513,9 @@ int imap_ac_add(struct Account *a, struct Mailbox *m)
     m->free_mdata = imap_mdata_free;
     url_free(&url);
   }
+
+  /* The server must be told about the new mailbox, see imap_notify_set() */
+  adata->notify_update = true;
   return 0;
 }
 
@@ -1935,6 +2571,27 @@ int imap_login(struct ImapAccountData *adata)
 
     /* we may need the root delimiter before we open a mailbox */
     imap_exec(adata, NULL, IMAP_CMD_NO_FLAGS);
+
+#ifdef HAVE_ZLIB
+    /* RFC4978 */
+    if (C_ImapDeflate && (adata->capabilities & IMAP_CAP_COMPRESS) &&
+        (adata->state == IMAP_AUTHENTICATED) &&
+        (imap_exec(adata, "COMPRESS DEFLATE", IMAP_CMD_NO_FLAGS) == IMAP_EXEC_SUCCESS))
+    {
+      /* The server now expects compressed data, so there's no way back */
+      if (mutt_zstrm_wrap_conn(adata->conn) != 0)
+      {
+        mutt_error(_("Can't start compression on connection to %s"),
+                   adata->conn->account.host);
+        imap_close_connection(adata);
+        return -1;
+      }
+      mutt_debug(LL_DEBUG2, "IMAP compression is enabled on connection to %s\n",
+                 adata->conn->account.host);
+    }
+#endif
+
+    imap_notify_set(adata);
   }
 
   if (adata->state < IMAP_AUTHENTICATED)
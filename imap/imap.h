@@ -41,6 +41,7 @@
  * | imap/browse.c     | @subpage imap_browse     |
  * | imap/command.c    | @subpage imap_command    |
  * | imap/message.c    | @subpage imap_message    |
+ * | imap/uid.c        | @subpage imap_uid        |
  * | imap/utf7.c       | @subpage imap_utf7       |
  * | imap/util.c       | @subpage imap_util       |
  */
@@ -56,8 +57,10 @@
 struct BrowserState;
 struct Buffer;
 struct ConnAccount;
+struct Email;
 struct EmailList;
 struct Mailbox;
+struct Pattern;
 struct PatternHead;
 struct stat;
 
@@ -67,12 +70,18 @@ extern struct Slist *C_ImapAuthenticators;
 /* These Config Variables are only used in imap/imap.c */
 extern bool C_ImapIdle;
 extern bool C_ImapRfc5161;
+extern bool C_ImapDeflate;
+extern bool C_ImapNotify;
 
 /* These Config Variables are only used in imap/message.c */
 extern char *C_ImapHeaders;
 extern long C_ImapFetchChunkSize;
+extern short C_ImapFetchConnections;
+extern short C_ImapPrefetch;
+extern long C_ImapPrefetchSize;
 
 /* These Config Variables are only used in imap/command.c */
+extern short C_ImapPollBackoff;
 extern bool C_ImapServernoise;
 
 /* These Config Variables are only used in imap/util.c */
@@ -86,7 +95,9 @@ int imap_delete_mailbox(struct Mailbox *m, char *path);
 int imap_sync_mailbox(struct Mailbox *m, bool expunge, bool close);
 int imap_path_status(const char *path, bool queue);
 int imap_mailbox_status(struct Mailbox *m, bool queue);
-int imap_search(struct Mailbox *m, const struct PatternHead *pat);
+void imap_status_flush(void);
+int imap_search(struct Mailbox *m, struct PatternHead *pat);
+int imap_search_match(const struct Pattern *pat, struct Email *e);
 int imap_subscribe(char *path, bool subscribe);
 int imap_complete(char *buf, size_t buflen, char *path);
 int imap_fast_trash(struct Mailbox *m, char *dest);
@@ -113,6 +124,8 @@ void imap_pretty_mailbox(char *path, size_t pathlen, const char *folder);
 
 int imap_wait_keepalive(pid_t pid);
 void imap_keepalive(void);
+bool imap_prefetch_pending(void);
+void imap_prefetch(void);
 
 void imap_get_parent_path(const char *path, char *buf, size_t buflen);
 void imap_clean_path(char *path, size_t plen);
@@ -58,6 +58,7 @@ struct Progress;
 
 #define SEQ_LEN 16
 #define IMAP_MAX_CMDLEN 1024 ///< Maximum length of command lines before they must be split (for lazy servers)
+#define IMAP_PIPELINE_MAX 64 ///< Deepest the pipeline window may grow, if $imap_pipeline_depth is smaller
 
 typedef uint8_t ImapOpenFlags;         ///< Flags, e.g. #MUTT_THREAD_COLLAPSE
 #define IMAP_OPEN_NO_FLAGS          0  ///< No flags are set
@@ -86,6 +87,10 @@ enum ImapExecResult
 /* length of "DD-MMM-YYYY HH:MM:SS +ZZzz" (null-terminated) */
 #define IMAP_DATELEN 27
 
+#define IMAP_SNAPSHOT_MAX (64 * 1024 * 1024) ///< Don't snapshot mailboxes larger than this
+#define IMAP_SNAPSHOT_PAD(len) (((len) + 7) & ~(size_t) 7) ///< Keep ImapSnapshotEntry aligned
+#define IMAP_SNAPSHOT_MIN_RECORD 16 ///< A header cache record is never shorter than this
+
 /**
  * enum ImapFlags - IMAP server responses
  */
@@ -135,8 +140,10 @@ typedef uint32_t ImapCapFlags;              ///< Flags, e.g. #IMAP_CAP_IMAP4
 #define IMAP_CAP_QRESYNC          (1 << 15) ///< RFC7162
 #define IMAP_CAP_LIST_EXTENDED    (1 << 16) ///< RFC5258: IMAP4 LIST Command Extensions
 #define IMAP_CAP_X_GM_EXT_1       (1 << 17) ///< https://developers.google.com/gmail/imap/imap-extensions
+#define IMAP_CAP_COMPRESS         (1 << 18) ///< RFC4978: COMPRESS=DEFLATE
+#define IMAP_CAP_NOTIFY           (1 << 19) ///< RFC5465: NOTIFY
 
-#define IMAP_CAP_ALL             ((1 << 18) - 1)
+#define IMAP_CAP_ALL             ((1 << 20) - 1)
 
 /**
  * struct ImapList - Items in an IMAP browser
@@ -156,6 +163,8 @@ struct ImapCommand
 {
   char seq[SEQ_LEN + 1]; ///< Command tag, e.g. 'a0001'
   int state;            ///< Command state, e.g. #IMAP_CMD_NEW
+  size_t len;           ///< Length of the command, sent or queued
+  long long sent;       ///< Time the command was sent, in us, or 0 if queued
 };
 
 /**
@@ -189,6 +198,8 @@ struct ImapAccountData
 
   bool unicode; /* If true, we can send UTF-8, and the server will use UTF8 rather than mUTF7 */
   bool qresync; /* true, if QRESYNC is successfully ENABLE'd */
+  bool notify;  ///< true, if the server reports changes to some of our mailboxes (RFC5465)
+  bool notify_update; ///< true, if the list of mailboxes has changed since the last NOTIFY SET
 
   /* if set, the response parser will store results for complicated commands
    * here. */
@@ -200,6 +211,17 @@ struct ImapAccountData
   int nextcmd;
   int lastcmd;
   struct Buffer *cmdbuf;
+  int cmdwindow;            ///< Number of commands that may be outstanding
+  size_t inflight;          ///< Bytes of the outstanding commands
+
+  /* command latency statistics */
+  unsigned int srtt;        ///< Smoothed round-trip time of a command, in us
+  unsigned int min_rtt;     ///< Shortest round-trip time of a command, in us
+  unsigned int sgap;        ///< Smoothed time between two completions, in us
+  long long last_done;      ///< When the last command completed, in us
+  unsigned long cmd_count;  ///< Number of completed commands
+  unsigned long long cmd_us; ///< Total latency of the completed commands, in us
+  unsigned int cmd_max_us;  ///< Worst latency of a completed command, in us
 
   char delim;
   struct Mailbox *mailbox;     /* Current selected mailbox */
@@ -228,17 +250,70 @@ struct ImapMboxData
   unsigned int messages;
   unsigned int recent;
   unsigned int unseen;
+  time_t status_due;           ///< Don't poll with STATUS before this time
+  unsigned int status_backoff; ///< Seconds between STATUS polls, see $imap_poll_backoff
+  bool notify;                 ///< true, if the server reports changes to this mailbox (RFC5465)
 
   // Cached data used only when the mailbox is opened
-  struct Hash *uid_hash;
+  struct ImapUidHash *uid_hash;
   struct Email **msn_index;   /**< look up headers by (MSN-1) */
   size_t msn_index_size;       /**< allocation size */
   unsigned int max_msn;        /**< the largest MSN fetched so far */
   struct BodyCache *bcache;
+  unsigned int prefetch_uid;   ///< Prefetch the messages after this one, when idle
+  bool reading_headers;        ///< imap_read_headers() is running
 
   header_cache_t *hcache;
 };
 
+/**
+ * struct ImapUidSlot - One entry of an ImapUidHash
+ */
+struct ImapUidSlot
+{
+  unsigned int uid;    ///< Message UID, 0 if the slot is empty
+  struct Email *email; ///< Email with this UID
+};
+
+/**
+ * struct ImapUidHash - Look up Emails by UID
+ *
+ * An open-addressed hash table with linear probing, kept at most 3/4 full.
+ * It needs no allocation per message, unlike a struct Hash.
+ */
+struct ImapUidHash
+{
+  struct ImapUidSlot *slots; ///< Array of (mask + 1) slots
+  unsigned int mask;         ///< Number of slots - 1, a power of two
+  unsigned int shift;        ///< Bits to drop from the hash, 32 - log2(slots)
+  unsigned int count;        ///< Number of UIDs stored
+};
+
+/**
+ * struct ImapSnapshot - Copy of a whole mailbox in the header cache
+ *
+ * It's followed by one ImapSnapshotEntry per message, in MSN order.
+ */
+struct ImapSnapshot
+{
+  unsigned long long modseq; ///< HIGHESTMODSEQ when the snapshot was taken
+  unsigned int uid_validity; ///< UIDVALIDITY of the mailbox
+  unsigned int uid_next;     ///< UIDNEXT of the mailbox
+  unsigned int count;        ///< Number of messages
+  unsigned int len;          ///< Length of the snapshot, including this header
+};
+
+/**
+ * struct ImapSnapshotEntry - One message of an ImapSnapshot
+ *
+ * It's followed by the message's header cache record, padded to 8 bytes.
+ */
+struct ImapSnapshotEntry
+{
+  unsigned int uid; ///< Message UID
+  unsigned int len; ///< Length of the record
+};
+
 /**
  * struct SeqsetIterator - UID Sequence Set Iterator
  */
@@ -254,6 +329,19 @@ struct SeqsetIterator
   char *substr_end;
 };
 
+/**
+ * struct SeqsetBuilder - Build a Sequence Set, one number at a time
+ *
+ * Runs of consecutive numbers are written as ranges, e.g. "1:5,7".
+ */
+struct SeqsetBuilder
+{
+  struct Buffer *buf;  ///< Buffer for the Sequence Set
+  unsigned int begin;  ///< First number of the current run
+  unsigned int end;    ///< Last number of the current run
+  bool started;        ///< A run has been started
+};
+
 /* -- private IMAP functions -- */
 /* imap.c */
 int imap_create_mailbox(struct ImapAccountData *adata, char *mailbox);
@@ -262,7 +350,9 @@ int imap_exec_msgset(struct Mailbox *m, const char *pre, const char *post,
                      int flag, bool changed, bool invert);
 int imap_open_connection(struct ImapAccountData *adata);
 void imap_close_connection(struct ImapAccountData *adata);
+void imap_logout(struct ImapAccountData *adata);
 int imap_read_literal(FILE *fp, struct ImapAccountData *adata, unsigned long bytes, struct Progress *pbar);
+int imap_read_literal_buf(struct Buffer *buf, struct ImapAccountData *adata, unsigned long bytes);
 void imap_expunge_mailbox(struct Mailbox *m);
 int imap_login(struct ImapAccountData *adata);
 int imap_sync_message_for_copy(struct Mailbox *m, struct Email *e, struct Buffer *cmd, enum QuadOption *err_continue);
@@ -280,6 +370,7 @@ bool imap_code(const char *s);
 const char *imap_cmd_trailer(struct ImapAccountData *adata);
 int imap_exec(struct ImapAccountData *adata, const char *cmdstr, ImapCmdFlags flags);
 int imap_cmd_idle(struct ImapAccountData *adata);
+bool imap_cmd_queued(struct ImapAccountData *adata);
 
 /* message.c */
 void imap_edata_free(void **ptr);
@@ -289,6 +380,8 @@ char *imap_set_flags(struct Mailbox *m, struct Email *e, char *s, bool *server_c
 int imap_cache_del(struct Mailbox *m, struct Email *e);
 int imap_cache_clean(struct Mailbox *m);
 int imap_append_message(struct Mailbox *m, struct Message *msg);
+int imap_msg_prefetch(struct Mailbox *m, struct Email **emails, int num, int max);
+void imap_msg_prefetch_next(struct Mailbox *m);
 
 int imap_msg_open(struct Mailbox *m, struct Message *msg, int msgno);
 int imap_msg_close(struct Mailbox *m, struct Message *msg);
@@ -307,6 +400,8 @@ int imap_hcache_del(struct ImapMboxData *mdata, unsigned int uid);
 int imap_hcache_store_uid_seqset(struct ImapMboxData *mdata);
 int imap_hcache_clear_uid_seqset(struct ImapMboxData *mdata);
 char *imap_hcache_get_uid_seqset(struct ImapMboxData *mdata);
+int imap_hcache_store_snapshot(struct ImapMboxData *mdata);
+int imap_hcache_clear_snapshot(struct ImapMboxData *mdata);
 #endif
 
 enum QuadOption imap_continue(const char *msg, const char *resp);
@@ -333,6 +428,15 @@ void mutt_seqset_iterator_free(struct SeqsetIterator **p_iter);
 bool imap_account_match(const struct ConnAccount *a1, const struct ConnAccount *a2);
 void imap_get_parent(const char *mbox, char delim, char *buf, size_t buflen);
 
+/* uid.c */
+void imap_seqset_add(struct SeqsetBuilder *sb, unsigned int num);
+void imap_seqset_finish(struct SeqsetBuilder *sb);
+struct ImapUidHash *imap_uid_hash_new(size_t count);
+void imap_uid_hash_free(struct ImapUidHash **ptr);
+struct Email *imap_uid_hash_find(const struct ImapUidHash *uh, unsigned int uid);
+bool imap_uid_hash_insert(struct ImapUidHash *uh, unsigned int uid, struct Email *e);
+void imap_uid_hash_delete(struct ImapUidHash *uh, unsigned int uid, const struct Email *e);
+
 /* utf7.c */
 void imap_utf_encode(bool unicode, char **s);
 void imap_utf_decode(bool unicode, char **s);
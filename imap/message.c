@@ -34,6 +34,8 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/select.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include "imap_private.h"
 #include "mutt/mutt.h"
@@ -65,6 +67,13 @@ struct BodyCache;
 /* These Config Variables are only used in imap/message.c */
 char *C_ImapHeaders; ///< Config: (imap) Additional email headers to download when getting index
 long C_ImapFetchChunkSize; ///< Config: (imap) Download headers in blocks of this size
+short C_ImapFetchConnections; ///< Config: (imap) Number of connections used to download headers
+short C_ImapPrefetch; ///< Config: (imap) Number of messages to download after the one being read
+long C_ImapPrefetchSize; ///< Config: (imap) Maximum size of the messages to prefetch at once
+
+#define IMAP_MAX_FETCH_CONNS 8  ///< Maximum number of connections downloading headers
+#define IMAP_FETCH_CONNS_MIN 64 ///< Don't open extra connections for fewer new messages
+#define IMAP_PREFETCH_BATCH 32  ///< Number of messages to prefetch per FETCH
 
 /**
  * imap_edata_free - free ImapHeader structure
@@ -204,7 +213,7 @@ static int msg_cache_clean_cb(const char *id, struct BodyCache *bcache, void *da
     return 0;
 
   /* bad UID */
-  if ((uv != mdata->uid_validity) || !mutt_hash_int_find(mdata->uid_hash, uid))
+  if ((uv != mdata->uid_validity) || !imap_uid_hash_find(mdata->uid_hash, uid))
     mutt_bcache_del(bcache, id);
 
   return 0;
@@ -421,22 +430,21 @@ static int msg_parse_fetch(struct ImapHeader *h, char *s)
 
 /**
  * msg_fetch_header - import IMAP FETCH response into an ImapHeader
- * @param m   Mailbox
- * @param ih  ImapHeader
- * @param buf Server string containing FETCH response
- * @param fp  Connection to server
+ * @param adata Imap Account data of the connection the response came from
+ * @param ih    ImapHeader
+ * @param buf   Server string containing FETCH response
+ * @param hdrs  Buffer for the message's headers (optional)
  * @retval  0 Success
  * @retval -1 String is not a fetch response
  * @retval -2 String is a corrupt fetch response
  *
  * Expects string beginning with * n FETCH.
  */
-static int msg_fetch_header(struct Mailbox *m, struct ImapHeader *ih, char *buf, FILE *fp)
+static int msg_fetch_header(struct ImapAccountData *adata, struct ImapHeader *ih,
+                            char *buf, struct Buffer *hdrs)
 {
   int rc = -1; /* default now is that string isn't FETCH response */
 
-  struct ImapAccountData *adata = imap_adata_get(m);
-
   if (buf[0] != '*')
     return rc;
 
@@ -461,13 +469,14 @@ static int msg_fetch_header(struct Mailbox *m, struct ImapHeader *ih, char *buf,
   int parse_rc = msg_parse_fetch(ih, buf);
   if (parse_rc == 0)
     return 0;
-  if ((parse_rc != -2) || !fp)
+  if ((parse_rc != -2) || !hdrs)
     return rc;
 
   unsigned int bytes = 0;
   if (imap_get_literal_count(buf, &bytes) == 0)
   {
-    imap_read_literal(fp, adata, bytes, NULL);
+    if (imap_read_literal_buf(hdrs, adata, bytes) < 0)
+      return rc;
 
     /* we may have other fields of the FETCH _after_ the literal
      * (eg Domino puts FLAGS here). Nothing wrong with that, either.
@@ -578,7 +587,7 @@ static void imap_alloc_uid_hash(struct ImapAccountData *adata, unsigned int msn_
 {
   struct ImapMboxData *mdata = adata->mailbox->mdata;
   if (!mdata->uid_hash)
-    mdata->uid_hash = mutt_hash_int_new(MAX(6 * msn_count / 5, 30), MUTT_HASH_NO_FLAGS);
+    mdata->uid_hash = imap_uid_hash_new(msn_count);
 }
 
 /**
@@ -763,7 +772,7 @@ static int read_headers_normal_eval_cache(struct ImapAccountData *adata,
       if (rc != IMAP_CMD_CONTINUE)
         break;
 
-      mfhrc = msg_fetch_header(m, &h, adata->buf, NULL);
+      mfhrc = msg_fetch_header(adata, &h, adata->buf, NULL);
       if (mfhrc < 0)
         continue;
 
@@ -793,7 +802,7 @@ static int read_headers_normal_eval_cache(struct ImapAccountData *adata,
       {
         mdata->max_msn = MAX(mdata->max_msn, h.edata->msn);
         mdata->msn_index[h.edata->msn - 1] = m->emails[idx];
-        mutt_hash_int_insert(mdata->uid_hash, h.edata->uid, m->emails[idx]);
+        imap_uid_hash_insert(mdata->uid_hash, h.edata->uid, m->emails[idx]);
 
         m->emails[idx]->index = idx;
         /* messages which have not been expunged are ACTIVE (borrowed from mh
@@ -849,6 +858,45 @@ static int read_headers_normal_eval_cache(struct ImapAccountData *adata,
   return 0;
 }
 
+/**
+ * add_cached_email - Add an Email from the header cache to the Mailbox
+ * @param m   Mailbox
+ * @param e   Email, restored from the header cache
+ * @param msn Message Sequence Number
+ * @param uid Message UID
+ */
+static void add_cached_email(struct Mailbox *m, struct Email *e, unsigned int msn,
+                             unsigned int uid)
+{
+  struct ImapMboxData *mdata = imap_mdata_get(m);
+
+  mdata->max_msn = MAX(mdata->max_msn, msn);
+  mdata->msn_index[msn - 1] = e;
+
+  if (m->msg_count >= m->email_max)
+    mx_alloc_memory(m);
+
+  struct ImapEmailData *edata = imap_edata_new();
+  e->edata = edata;
+  e->free_edata = imap_edata_free;
+
+  e->index = m->msg_count;
+  e->active = true;
+  e->changed = false;
+  edata->read = e->read;
+  edata->old = e->old;
+  edata->deleted = e->deleted;
+  edata->flagged = e->flagged;
+  edata->replied = e->replied;
+
+  edata->msn = msn;
+  edata->uid = uid;
+  imap_uid_hash_insert(mdata->uid_hash, uid, e);
+
+  mutt_mailbox_size_add(m, e);
+  m->emails[m->msg_count++] = e;
+}
+
 /**
  * read_headers_qresync_eval_cache - Retrieve data from the header cache
  * @param adata Imap Account data
@@ -885,38 +933,119 @@ static int read_headers_qresync_eval_cache(struct ImapAccountData *adata, char *
     struct Email *e = imap_hcache_get(mdata, uid);
     if (e)
     {
-      mdata->max_msn = MAX(mdata->max_msn, msn);
-      mdata->msn_index[msn - 1] = e;
+      add_cached_email(m, e, msn, uid);
+      msn++;
+    }
+  }
 
-      if (m->msg_count >= m->email_max)
-        mx_alloc_memory(m);
+  mutt_seqset_iterator_free(&iter);
+
+  return rc;
+}
+
+/**
+ * read_headers_snapshot_eval_cache - Retrieve a whole mailbox from the header cache
+ * @param adata   Imap Account data
+ * @param msn_end Last Message Sequence number
+ * @retval  0 Success
+ * @retval -1 No usable snapshot, nothing was read
+ *
+ * If the mailbox hasn't changed since the snapshot was taken, its records can
+ * be read in one lookup, rather than one per message.
+ */
+static int read_headers_snapshot_eval_cache(struct ImapAccountData *adata,
+                                            unsigned int msn_end)
+{
+  struct Mailbox *m = adata->mailbox;
+  struct ImapMboxData *mdata = adata->mailbox->mdata;
+  int rc = -1;
+
+  size_t blob_len = 0;
+  char *blob = mutt_hcache_fetch_raw(mdata->hcache, "/SNAPSHOT", 9, &blob_len);
+  if (!blob)
+    return -1;
 
-      struct ImapEmailData *edata = imap_edata_new();
-      e->edata = edata;
-      e->free_edata = imap_edata_free;
+  struct ImapSnapshot *snap = (struct ImapSnapshot *) blob;
+  if (blob_len < sizeof(*snap))
+  {
+    mutt_debug(LL_DEBUG2, "/SNAPSHOT is too short, %zu bytes\n", blob_len);
+    goto done;
+  }
 
-      e->index = m->msg_count;
-      e->active = true;
-      e->changed = false;
-      edata->read = e->read;
-      edata->old = e->old;
-      edata->deleted = e->deleted;
-      edata->flagged = e->flagged;
-      edata->replied = e->replied;
+  if ((snap->modseq != mdata->modseq) || (snap->uid_validity != mdata->uid_validity) ||
+      (snap->uid_next != mdata->uid_next) || (snap->count != msn_end))
+  {
+    mutt_debug(LL_DEBUG2, "/SNAPSHOT is out of date\n");
+    goto done;
+  }
 
-      edata->msn = msn;
-      edata->uid = uid;
-      mutt_hash_int_insert(mdata->uid_hash, uid, e);
+  if ((snap->len < sizeof(*snap)) || (snap->len > IMAP_SNAPSHOT_MAX) ||
+      (snap->len != blob_len))
+  {
+    mutt_debug(LL_DEBUG2, "/SNAPSHOT has a bad length, %u\n", snap->len);
+    goto done;
+  }
 
-      mutt_mailbox_size_add(m, e);
-      m->emails[m->msg_count++] = e;
+  /* Check every record before touching the Mailbox.  Each one, and the
+   * entry in front of it, has to fit in what's left of the snapshot. */
+  size_t off = sizeof(*snap);
+  for (unsigned int msn = 1; msn <= snap->count; msn++)
+  {
+    struct ImapSnapshotEntry *entry = (struct ImapSnapshotEntry *) (blob + off);
+    const size_t avail = snap->len - off;
+    if ((avail < sizeof(*entry)) || (entry->len < IMAP_SNAPSHOT_MIN_RECORD) ||
+        (IMAP_SNAPSHOT_PAD(entry->len) > (avail - sizeof(*entry))))
+    {
+      mutt_debug(LL_DEBUG2, "/SNAPSHOT is truncated at MSN %u\n", msn);
+      goto done;
+    }
 
-      msn++;
+    const char *data = blob + off + sizeof(*entry);
+    if (!mutt_hcache_is_valid(mdata->hcache, data, entry->len) ||
+        (*(unsigned int *) data != mdata->uid_validity))
+    {
+      mutt_debug(LL_DEBUG2, "/SNAPSHOT has a bad record for MSN %u\n", msn);
+      goto done;
     }
+    off += sizeof(*entry) + IMAP_SNAPSHOT_PAD(entry->len);
   }
 
-  mutt_seqset_iterator_free(&iter);
+  if (off != snap->len)
+  {
+    mutt_debug(LL_DEBUG2, "/SNAPSHOT has %zu bytes left over\n", snap->len - off);
+    goto done;
+  }
+
+  mutt_debug(LL_DEBUG2, "Reading %u headers from /SNAPSHOT\n", snap->count);
+  struct Email **emails = mutt_mem_calloc(MAX(snap->count, 1), sizeof(struct Email *));
+  off = sizeof(*snap);
+  for (unsigned int i = 0; i < snap->count; i++)
+  {
+    struct ImapSnapshotEntry *entry = (struct ImapSnapshotEntry *) (blob + off);
+    emails[i] = mutt_hcache_restore((unsigned char *) blob + off + sizeof(*entry));
+    if (!emails[i])
+    {
+      mutt_debug(LL_DEBUG2, "/SNAPSHOT has a corrupt record for MSN %u\n", i + 1);
+      for (unsigned int j = 0; j < i; j++)
+        mutt_email_free(&emails[j]);
+      FREE(&emails);
+      goto done;
+    }
+    off += sizeof(*entry) + IMAP_SNAPSHOT_PAD(entry->len);
+  }
+
+  off = sizeof(*snap);
+  for (unsigned int msn = 1; msn <= snap->count; msn++)
+  {
+    struct ImapSnapshotEntry *entry = (struct ImapSnapshotEntry *) (blob + off);
+    add_cached_email(m, emails[msn - 1], msn, entry->uid);
+    off += sizeof(*entry) + IMAP_SNAPSHOT_PAD(entry->len);
+  }
+  FREE(&emails);
+  rc = 0;
 
+done:
+  mutt_hcache_free(mdata->hcache, (void **) &blob);
   return rc;
 }
 
@@ -1014,6 +1143,578 @@ static int read_headers_condstore_qresync_updates(struct ImapAccountData *adata,
 }
 #endif /* USE_HCACHE */
 
+/**
+ * fetch_new_email - Create an Email from a FETCH response
+ * @param m             Imap Selected Mailbox
+ * @param h             Parsed FETCH response
+ * @param hdrs          The message's headers, from the response
+ * @param fetch_msn_end Last Message Sequence number requested
+ * @param maxuid        Highest UID seen, updated
+ *
+ * If an Email is created, it takes ownership of h->edata, which is set to NULL.
+ */
+static void fetch_new_email(struct Mailbox *m, struct ImapHeader *h, struct Buffer *hdrs,
+                            unsigned int fetch_msn_end, unsigned int *maxuid)
+{
+  struct ImapMboxData *mdata = imap_mdata_get(m);
+  int idx = m->msg_count;
+
+  if (mutt_buffer_len(hdrs) == 0)
+  {
+    mutt_debug(LL_DEBUG2, "ignoring fetch response with no body\n");
+    return;
+  }
+
+  /* make sure the last header is terminated */
+  mutt_buffer_addstr(hdrs, "\n\n");
+
+  if ((h->edata->msn < 1) || (h->edata->msn > fetch_msn_end))
+  {
+    mutt_debug(LL_DEBUG1, "skipping FETCH response for unknown message number %d\n",
+               h->edata->msn);
+    return;
+  }
+
+  /* May receive FLAGS updates in a separate untagged response (#2935) */
+  if (mdata->msn_index[h->edata->msn - 1])
+  {
+    mutt_debug(LL_DEBUG2, "skipping FETCH response for duplicate message %d\n",
+               h->edata->msn);
+    return;
+  }
+
+  m->emails[idx] = mutt_email_new();
+
+  mdata->max_msn = MAX(mdata->max_msn, h->edata->msn);
+  mdata->msn_index[h->edata->msn - 1] = m->emails[idx];
+  imap_uid_hash_insert(mdata->uid_hash, h->edata->uid, m->emails[idx]);
+
+  m->emails[idx]->index = idx;
+  /* messages which have not been expunged are ACTIVE (borrowed from mh
+   * folders) */
+  m->emails[idx]->active = true;
+  m->emails[idx]->changed = false;
+  m->emails[idx]->read = h->edata->read;
+  m->emails[idx]->old = h->edata->old;
+  m->emails[idx]->deleted = h->edata->deleted;
+  m->emails[idx]->flagged = h->edata->flagged;
+  m->emails[idx]->replied = h->edata->replied;
+  m->emails[idx]->received = h->received;
+  m->emails[idx]->edata = (void *) (h->edata);
+  m->emails[idx]->free_edata = imap_edata_free;
+  STAILQ_INIT(&m->emails[idx]->tags);
+
+  /* We take a copy of the tags so we can split the string */
+  char *tags_copy = mutt_str_strdup(h->edata->flags_remote);
+  driver_tags_replace(&m->emails[idx]->tags, tags_copy);
+  FREE(&tags_copy);
+
+  if (*maxuid < h->edata->uid)
+    *maxuid = h->edata->uid;
+
+  /* NOTE: if Date: header is missing, mutt_rfc822_read_header_mem
+   *   depends on h->received being set */
+  m->emails[idx]->env = mutt_rfc822_read_header_mem(
+      mutt_b2s(hdrs), mutt_buffer_len(hdrs), m->emails[idx], false, false);
+  /* content built as a side-effect of mutt_rfc822_read_header_mem */
+  m->emails[idx]->content->length = h->content_length;
+  mutt_mailbox_size_add(m, m->emails[idx]);
+
+  m->msg_count++;
+
+  h->edata = NULL;
+}
+
+/**
+ * store_new_emails - Save newly fetched Emails in the header cache
+ * @param m     Imap Selected Mailbox
+ * @param first Index of the first new Email
+ *
+ * The Emails are written in one batch once their FETCH has completed, so the
+ * cache's write transaction is never held open while waiting for the server.
+ */
+static void store_new_emails(struct Mailbox *m, int first)
+{
+#ifdef USE_HCACHE
+  struct ImapMboxData *mdata = imap_mdata_get(m);
+  if (!mdata->hcache || (first >= m->msg_count))
+    return;
+
+  mutt_hcache_begin(mdata->hcache);
+  for (int i = first; i < m->msg_count; i++)
+    imap_hcache_put(mdata, m->emails[i]);
+  mutt_hcache_commit(mdata->hcache);
+#endif /* USE_HCACHE */
+}
+
+/**
+ * compare_msn - Compare two Emails by MSN - Implements ::sort_t
+ */
+static int compare_msn(const void *a, const void *b)
+{
+  struct Email **ea = (struct Email **) a;
+  struct Email **eb = (struct Email **) b;
+  return imap_edata_get(*ea)->msn - imap_edata_get(*eb)->msn;
+}
+
+/**
+ * struct FetchConn - A connection downloading part of a mailbox's headers
+ */
+struct FetchConn
+{
+  struct ImapAccountData *adata; ///< Connection
+  unsigned int msn_begin;        ///< First MSN of the next FETCH
+  unsigned int msn_end;          ///< Last MSN of this connection's share
+  unsigned int fetch_msn_end;    ///< Last MSN of the current FETCH
+  unsigned int hint;             ///< Where to look up the next UID in the map
+  bool busy;                     ///< A FETCH is in progress
+  bool done;                     ///< Finished, or failed
+};
+
+/**
+ * fetch_conn_open - Open an extra connection to download headers
+ * @param adata Imap Account data of the selected Mailbox
+ * @param mdata Imap Mailbox data of the selected Mailbox
+ * @retval ptr  Logged in connection, with the Mailbox EXAMINEd
+ * @retval NULL Failure
+ *
+ * The connection is never marked as selected, so the untagged responses to
+ * its FETCHes don't touch the Mailbox, which belongs to the main connection.
+ */
+static struct ImapAccountData *fetch_conn_open(struct ImapAccountData *adata,
+                                               struct ImapMboxData *mdata)
+{
+  struct ImapAccountData *aux = imap_adata_new();
+  aux->conn_account = adata->conn_account;
+  aux->conn = mutt_conn_new(&adata->conn->account);
+  /* a failed connection must not try to log back in */
+  aux->recovering = true;
+
+  if (!aux->conn || (imap_login(aux) < 0) || (aux->state != IMAP_AUTHENTICATED))
+    goto fail;
+
+  char buf[PATH_MAX];
+  snprintf(buf, sizeof(buf), "EXAMINE %s", mdata->munge_name);
+  imap_cmd_start(aux, buf);
+
+  unsigned int uid_validity = 0;
+  int rc;
+  while ((rc = imap_cmd_step(aux)) == IMAP_CMD_CONTINUE)
+  {
+    char *pc = aux->buf + 2;
+    if (mutt_str_startswith(pc, "OK [UIDVALIDITY", CASE_IGNORE))
+    {
+      pc = imap_next_word(pc + 3);
+      mutt_str_atoui(pc, &uid_validity);
+    }
+  }
+
+  /* the UIDs must mean the same messages as on the main connection */
+  if ((rc != IMAP_CMD_OK) || (uid_validity != mdata->uid_validity))
+  {
+    mutt_debug(LL_DEBUG1, "mailbox differs: uidvalidity %u\n", uid_validity);
+    goto fail;
+  }
+
+  return aux;
+
+fail:
+  mutt_debug(LL_DEBUG1, "Can't open an extra connection to %s\n",
+             adata->conn->account.host);
+  imap_close_connection(aux);
+  imap_adata_free((void **) &aux);
+  return NULL;
+}
+
+/**
+ * fetch_conn_close - Close an extra connection
+ * @param ptr      Connection to close
+ * @param graceful If true, log out; otherwise just drop the connection
+ */
+static void fetch_conn_close(struct ImapAccountData **ptr, bool graceful)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  if (graceful && ((*ptr)->status != IMAP_FATAL))
+    imap_logout(*ptr);
+  imap_close_connection(*ptr);
+  imap_adata_free((void **) ptr);
+}
+
+/**
+ * fetch_conn_ready - Does a connection have data waiting?
+ * @param adata Imap Account data
+ * @retval true Data can be read without blocking
+ */
+static bool fetch_conn_ready(struct ImapAccountData *adata)
+{
+  return mutt_socket_poll(adata->conn, 0) != 0;
+}
+
+/**
+ * fetch_conn_wait - Wait for any busy connection to have data
+ * @param fc  Connections
+ * @param num Number of connections
+ */
+static void fetch_conn_wait(struct FetchConn *fc, int num)
+{
+  fd_set rfds;
+  int maxfd = -1;
+
+  FD_ZERO(&rfds);
+  for (int i = 0; i < num; i++)
+  {
+    if (!fc[i].busy || fc[i].done || (fc[i].adata->conn->fd < 0))
+      continue;
+    /* Data may already be buffered, or decrypted, where select() can't see it */
+    if (fetch_conn_ready(fc[i].adata))
+      return;
+    FD_SET(fc[i].adata->conn->fd, &rfds);
+    maxfd = MAX(maxfd, fc[i].adata->conn->fd);
+  }
+
+  if (maxfd < 0)
+    return;
+
+  struct timeval tv = { 1, 0 };
+  select(maxfd + 1, &rfds, NULL, NULL, &tv);
+}
+
+/**
+ * fetch_uid_map - Get the UIDs of the messages to be fetched
+ * @param[in]  adata     Imap Account data of the selected Mailbox
+ * @param[in]  evalhc    If true, skip messages we already have
+ * @param[in]  msn_begin First Message Sequence number
+ * @param[in]  msn_end   Last Message Sequence number
+ * @param[out] uids      UID of each MSN, from msn_begin; 0 if unknown
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * The extra connections fetch by UID, because messages may have been expunged
+ * or added since the main connection numbered them.
+ */
+static int fetch_uid_map(struct ImapAccountData *adata, bool evalhc, unsigned int msn_begin,
+                         unsigned int msn_end, unsigned int *uids)
+{
+  struct Buffer *b = mutt_buffer_pool_get();
+  struct ImapHeader h;
+  unsigned int fetch_msn_end = 0;
+  int rc = IMAP_CMD_OK;
+
+  while ((rc == IMAP_CMD_OK) && (fetch_msn_end < msn_end) &&
+         imap_fetch_msn_seqset(b, adata, evalhc, fetch_msn_end ? fetch_msn_end + 1 : msn_begin,
+                               msn_end, &fetch_msn_end))
+  {
+    char *cmd = NULL;
+    mutt_str_asprintf(&cmd, "FETCH %s (UID)", mutt_b2s(b));
+    imap_cmd_start(adata, cmd);
+    FREE(&cmd);
+
+    while ((rc = imap_cmd_step(adata)) == IMAP_CMD_CONTINUE)
+    {
+      memset(&h, 0, sizeof(h));
+      h.edata = imap_edata_new();
+      if ((msg_fetch_header(adata, &h, adata->buf, NULL) == 0) &&
+          (h.edata->msn >= msn_begin) && (h.edata->msn <= msn_end))
+      {
+        uids[h.edata->msn - msn_begin] = h.edata->uid;
+      }
+      imap_edata_free((void **) &h.edata);
+    }
+  }
+
+  mutt_buffer_pool_release(&b);
+  return (rc == IMAP_CMD_OK) ? 0 : -1;
+}
+
+/**
+ * fetch_uid_seqset - Generate a UID set for an extra connection
+ * @param[in]  b             Buffer for the result
+ * @param[in]  mdata         Imap Mailbox data
+ * @param[in]  uids          UID of each MSN, from msn_base
+ * @param[in]  msn_base      MSN of uids[0]
+ * @param[in]  msn_begin     First Message Sequence Number
+ * @param[in]  msn_end       Last Message Sequence Number
+ * @param[out] fetch_msn_end Highest Message Sequence Number fetched
+ * @retval num Number of messages in the set
+ *
+ * Like imap_fetch_msn_seqset(), but each run of MSNs is given as the range of
+ * their UIDs.  Messages we already have, or whose UID is unknown, are skipped.
+ */
+static unsigned int fetch_uid_seqset(struct Buffer *b, struct ImapMboxData *mdata,
+                                     const unsigned int *uids, unsigned int msn_base,
+                                     unsigned int msn_begin, unsigned int msn_end,
+                                     unsigned int *fetch_msn_end)
+{
+  unsigned int max_headers_per_fetch = UINT_MAX;
+  unsigned int range_begin = 0;
+  unsigned int range_end = 0;
+  unsigned int msn_count = 0;
+  unsigned int msn;
+
+  mutt_buffer_reset(b);
+  if (C_ImapFetchChunkSize > 0)
+    max_headers_per_fetch = C_ImapFetchChunkSize;
+
+  for (msn = msn_begin; msn <= (msn_end + 1); msn++)
+  {
+    if ((msn_count < max_headers_per_fetch) && (msn <= msn_end) &&
+        !mdata->msn_index[msn - 1] && (uids[msn - msn_base] != 0))
+    {
+      msn_count++;
+      if (range_begin == 0)
+        range_begin = uids[msn - msn_base];
+      range_end = uids[msn - msn_base];
+    }
+    else if (range_begin != 0)
+    {
+      if (mutt_buffer_len(b) > 0)
+        mutt_buffer_addch(b, ',');
+      if (range_begin == range_end)
+        mutt_buffer_add_printf(b, "%u", range_begin);
+      else
+        mutt_buffer_add_printf(b, "%u:%u", range_begin, range_end);
+      range_begin = 0;
+
+      if ((mutt_buffer_len(b) > 500) || (msn_count >= max_headers_per_fetch))
+        break;
+    }
+  }
+
+  *fetch_msn_end = msn - 1;
+  return msn_count;
+}
+
+/**
+ * fetch_uid_msn - Find the main connection's MSN of a UID
+ * @param[in]     uids     UID of each MSN, from msn_base
+ * @param[in]     num      Number of UIDs
+ * @param[in]     msn_base MSN of uids[0]
+ * @param[in,out] hint     Index to start looking from
+ * @param[in]     uid      UID to look for
+ * @retval num MSN
+ * @retval 0   The UID isn't one we asked for
+ *
+ * A connection's responses usually come in UID order, so the search starts
+ * where the previous one finished.
+ */
+static unsigned int fetch_uid_msn(const unsigned int *uids, unsigned int num,
+                                  unsigned int msn_base, unsigned int *hint, unsigned int uid)
+{
+  for (unsigned int n = 0; n < num; n++)
+  {
+    unsigned int i = (*hint + n) % num;
+    if (uids[i] == uid)
+    {
+      *hint = i + 1;
+      return msn_base + i;
+    }
+  }
+  return 0;
+}
+
+/**
+ * read_headers_fetch_parallel - Download new headers over several connections
+ * @param[in]  m                Imap Selected Mailbox
+ * @param[in]  msn_begin        First Message Sequence number
+ * @param[in]  msn_end          Last Message Sequence number
+ * @param[in]  evalhc           If true, check the Header Cache
+ * @param[out] maxuid           Highest UID seen
+ * @param[in]  initial_download true, if this is the first opening of the mailbox
+ * @param[in]  hdrreq           Header fields to request
+ * @param[in]  progress         Progress bar
+ * @retval  0 Success
+ * @retval -1 Error, the user aborted
+ *
+ * Open up to $imap_fetch_connections - 1 extra connections, EXAMINE the
+ * mailbox on each, and split the MSN range between them and the main
+ * connection.  The responses are read from whichever connection has data.
+ *
+ * The extra connections may number the messages differently, so they're given
+ * the UIDs of their share, and their responses are matched back by UID.
+ *
+ * The Emails are appended in MSN order, as if a single connection had
+ * fetched them.  Any messages that weren't fetched, e.g. because a
+ * connection failed, are left for the caller to fetch.
+ */
+static int read_headers_fetch_parallel(struct Mailbox *m, unsigned int msn_begin,
+                                       unsigned int msn_end, bool evalhc,
+                                       unsigned int *maxuid, bool initial_download,
+                                       const char *hdrreq, struct Progress *progress)
+{
+  struct ImapAccountData *adata = imap_adata_get(m);
+  struct ImapMboxData *mdata = imap_mdata_get(m);
+  struct FetchConn fc[IMAP_MAX_FETCH_CONNS] = { { 0 } };
+  const int first = m->msg_count;
+  int retval = 0;
+
+  int num = 1;
+  fc[0].adata = adata;
+  const int want = MIN(C_ImapFetchConnections, IMAP_MAX_FETCH_CONNS);
+  for (int i = 1; i < want; i++)
+  {
+    fc[num].adata = fetch_conn_open(adata, mdata);
+    if (!fc[num].adata)
+      break;
+    num++;
+  }
+
+  /* with no extra connections, the caller's serial fetch does it all */
+  if (num == 1)
+    return 0;
+
+  const unsigned int num_uids = msn_end - msn_begin + 1;
+  unsigned int *uids = mutt_mem_calloc(num_uids, sizeof(unsigned int));
+  if (fetch_uid_map(adata, evalhc, msn_begin, msn_end, uids) < 0)
+  {
+    for (int i = 1; i < num; i++)
+      fetch_conn_close(&fc[i].adata, false);
+    FREE(&uids);
+    return -1;
+  }
+
+  mutt_debug(LL_DEBUG2, "fetching %u-%u over %d connections\n", msn_begin, msn_end, num);
+
+  /* split the range into contiguous shares */
+  const unsigned int share = (msn_end - msn_begin) / num + 1;
+  for (int i = 0; i < num; i++)
+  {
+    fc[i].msn_begin = msn_begin + (i * share);
+    fc[i].msn_end = MIN(msn_end, fc[i].msn_begin + share - 1);
+    fc[i].done = (fc[i].msn_begin > msn_end);
+  }
+
+  int active = 0;
+  for (int i = 0; i < num; i++)
+    if (!fc[i].done)
+      active++;
+
+  struct Buffer *b = mutt_buffer_pool_get();
+  struct Buffer *hdrs = mutt_buffer_pool_get();
+  struct ImapHeader h;
+  int count = 0;
+
+  while (active > 0)
+  {
+    bool progressed = false;
+
+    if (initial_download && SigInt && query_abort_header_download(adata))
+    {
+      retval = -1;
+      break;
+    }
+
+    for (int i = 0; i < num; i++)
+    {
+      struct FetchConn *c = &fc[i];
+      if (c->done)
+        continue;
+
+      if (!c->busy)
+      {
+        unsigned int count_set = 0;
+        if (i == 0)
+        {
+          count_set = imap_fetch_msn_seqset(b, adata, evalhc, c->msn_begin,
+                                            c->msn_end, &c->fetch_msn_end);
+        }
+        else
+        {
+          count_set = fetch_uid_seqset(b, mdata, uids, msn_begin, c->msn_begin,
+                                       c->msn_end, &c->fetch_msn_end);
+        }
+        if (count_set == 0)
+        {
+          c->done = true;
+          active--;
+          continue;
+        }
+
+        char *cmd = NULL;
+        mutt_str_asprintf(&cmd, "%sFETCH %s (UID FLAGS INTERNALDATE RFC822.SIZE %s)",
+                          (i == 0) ? "" : "UID ", mutt_b2s(b), hdrreq);
+        int rc = imap_cmd_start(c->adata, cmd);
+        FREE(&cmd);
+        if (rc < 0)
+        {
+          c->done = true;
+          active--;
+          if (i == 0)
+          {
+            retval = -1;
+            break;
+          }
+          continue;
+        }
+        c->busy = true;
+        c->msn_begin = c->fetch_msn_end + 1;
+      }
+
+      if (!fetch_conn_ready(c->adata))
+        continue;
+
+      mutt_buffer_reset(hdrs);
+      memset(&h, 0, sizeof(h));
+      h.edata = imap_edata_new();
+
+      int rc = imap_cmd_step(c->adata);
+      if ((rc == IMAP_CMD_CONTINUE) &&
+          (msg_fetch_header(c->adata, &h, c->adata->buf, hdrs) == 0))
+      {
+        /* use our MSN; an unknown UID gets 0, and is skipped */
+        if (i > 0)
+          h.edata->msn = fetch_uid_msn(uids, num_uids, msn_begin, &c->hint, h.edata->uid);
+        fetch_new_email(m, &h, hdrs, (i == 0) ? c->fetch_msn_end : c->msn_end, maxuid);
+        if (!h.edata)
+          mutt_progress_update(progress, ++count, -1);
+      }
+      imap_edata_free((void **) &h.edata);
+      progressed = true;
+
+      if (rc == IMAP_CMD_OK)
+        c->busy = false;
+      else if (rc != IMAP_CMD_CONTINUE)
+      {
+        mutt_debug(LL_DEBUG1, "connection %d failed\n", i);
+        c->done = true;
+        active--;
+        /* the serial fetch can't carry on without the main connection */
+        if (i == 0)
+        {
+          retval = -1;
+          break;
+        }
+      }
+    }
+
+    if (retval < 0)
+      break;
+
+    if (!progressed && (active > 0))
+      fetch_conn_wait(fc, num);
+  }
+
+  mutt_buffer_pool_release(&b);
+  mutt_buffer_pool_release(&hdrs);
+  FREE(&uids);
+
+  for (int i = 1; i < num; i++)
+    fetch_conn_close(&fc[i].adata, (retval == 0));
+
+  store_new_emails(m, first);
+
+  /* put the new Emails in MSN order, as a single connection would */
+  if (retval == 0)
+  {
+    qsort(m->emails + first, m->msg_count - first, sizeof(struct Email *), compare_msn);
+    for (int i = first; i < m->msg_count; i++)
+      m->emails[i]->index = i;
+  }
+
+  return retval;
+}
+
 /**
  * read_headers_fetch_new - Retrieve new messages from the server
  * @param[in]  m                Imap Selected Mailbox
@@ -1030,13 +1731,13 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
                                   unsigned int *maxuid, bool initial_download)
 {
   int rc, mfhrc = 0, retval = -1;
+  int first = m->msg_count;
   unsigned int fetch_msn_end = 0;
   struct Progress progress;
   char *hdrreq = NULL;
-  char tempfile[_POSIX_PATH_MAX];
-  FILE *fp = NULL;
   struct ImapHeader h;
   struct Buffer *b = NULL;
+  struct Buffer *hdrs = NULL;
   static const char *const want_headers =
       "DATE FROM SENDER SUBJECT TO CC MESSAGE-ID REFERENCES CONTENT-TYPE "
       "CONTENT-DESCRIPTION IN-REPLY-TO REPLY-TO LINES LIST-POST X-LABEL "
@@ -1044,7 +1745,6 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
 
   struct ImapAccountData *adata = imap_adata_get(m);
   struct ImapMboxData *mdata = imap_mdata_get(m);
-  int idx = m->msg_count;
 
   if (!adata || (adata->mailbox != m))
     return -1;
@@ -1065,22 +1765,28 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
     goto bail;
   }
 
-  /* instead of downloading all headers and then parsing them, we parse them
-   * as they come in. */
-  mutt_mktemp(tempfile, sizeof(tempfile));
-  fp = mutt_file_fopen(tempfile, "w+");
-  if (!fp)
-  {
-    mutt_error(_("Could not create temporary file %s"), tempfile);
-    goto bail;
-  }
-  unlink(tempfile);
-
   mutt_progress_init(&progress, _("Fetching message headers..."),
                      MUTT_PROGRESS_MSG, C_ReadInc, msn_end);
 
+  /* a big download can be split between several connections.  Anything they
+   * miss is picked up by the loop below, which skips the messages we have. */
+  if ((C_ImapFetchConnections > 1) && !C_Tunnel &&
+      ((msn_end - msn_begin + 1) >= IMAP_FETCH_CONNS_MIN))
+  {
+    if (read_headers_fetch_parallel(m, msn_begin, msn_end, evalhc, maxuid,
+                                    initial_download, hdrreq, &progress) < 0)
+    {
+      goto bail;
+    }
+    evalhc = true;
+  }
+
   b = mutt_buffer_pool_get();
 
+  /* instead of downloading all headers and then parsing them, we parse them
+   * in memory as they come in. */
+  hdrs = mutt_buffer_pool_get();
+
   /* NOTE:
    *   The (fetch_msn_end < msn_end) used to be important to prevent
    *   an infinite loop, in the event the server did not return all
@@ -1100,6 +1806,7 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
     imap_cmd_start(adata, cmd);
     FREE(&cmd);
 
+    first = m->msg_count;
     rc = IMAP_CMD_CONTINUE;
     for (int msgno = msn_begin; rc == IMAP_CMD_CONTINUE; msgno++)
     {
@@ -1108,7 +1815,7 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
 
       mutt_progress_update(&progress, msgno, -1);
 
-      rewind(fp);
+      mutt_buffer_reset(hdrs);
       memset(&h, 0, sizeof(h));
       h.edata = imap_edata_new();
 
@@ -1121,79 +1828,11 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
         if (rc != IMAP_CMD_CONTINUE)
           break;
 
-        mfhrc = msg_fetch_header(m, &h, adata->buf, fp);
+        mfhrc = msg_fetch_header(adata, &h, adata->buf, hdrs);
         if (mfhrc < 0)
           continue;
 
-        if (!ftello(fp))
-        {
-          mutt_debug(LL_DEBUG2, "ignoring fetch response with no body\n");
-          continue;
-        }
-
-        /* make sure we don't get remnants from older larger message headers */
-        fputs("\n\n", fp);
-
-        if ((h.edata->msn < 1) || (h.edata->msn > fetch_msn_end))
-        {
-          mutt_debug(LL_DEBUG1, "skipping FETCH response for unknown message number %d\n",
-                     h.edata->msn);
-          continue;
-        }
-
-        /* May receive FLAGS updates in a separate untagged response (#2935) */
-        if (mdata->msn_index[h.edata->msn - 1])
-        {
-          mutt_debug(LL_DEBUG2, "skipping FETCH response for duplicate message %d\n",
-                     h.edata->msn);
-          continue;
-        }
-
-        m->emails[idx] = mutt_email_new();
-
-        mdata->max_msn = MAX(mdata->max_msn, h.edata->msn);
-        mdata->msn_index[h.edata->msn - 1] = m->emails[idx];
-        mutt_hash_int_insert(mdata->uid_hash, h.edata->uid, m->emails[idx]);
-
-        m->emails[idx]->index = idx;
-        /* messages which have not been expunged are ACTIVE (borrowed from mh
-         * folders) */
-        m->emails[idx]->active = true;
-        m->emails[idx]->changed = false;
-        m->emails[idx]->read = h.edata->read;
-        m->emails[idx]->old = h.edata->old;
-        m->emails[idx]->deleted = h.edata->deleted;
-        m->emails[idx]->flagged = h.edata->flagged;
-        m->emails[idx]->replied = h.edata->replied;
-        m->emails[idx]->received = h.received;
-        m->emails[idx]->edata = (void *) (h.edata);
-        m->emails[idx]->free_edata = imap_edata_free;
-        STAILQ_INIT(&m->emails[idx]->tags);
-
-        /* We take a copy of the tags so we can split the string */
-        char *tags_copy = mutt_str_strdup(h.edata->flags_remote);
-        driver_tags_replace(&m->emails[idx]->tags, tags_copy);
-        FREE(&tags_copy);
-
-        if (*maxuid < h.edata->uid)
-          *maxuid = h.edata->uid;
-
-        rewind(fp);
-        /* NOTE: if Date: header is missing, mutt_rfc822_read_header depends
-         *   on h.received being set */
-        m->emails[idx]->env = mutt_rfc822_read_header(fp, m->emails[idx], false, false);
-        /* content built as a side-effect of mutt_rfc822_read_header */
-        m->emails[idx]->content->length = h.content_length;
-        mutt_mailbox_size_add(m, m->emails[idx]);
-
-#ifdef USE_HCACHE
-        imap_hcache_put(mdata, m->emails[idx]);
-#endif /* USE_HCACHE */
-
-        m->msg_count++;
-
-        h.edata = NULL;
-        idx++;
+        fetch_new_email(m, &h, hdrs, fetch_msn_end, maxuid);
       } while (mfhrc == -1);
 
       imap_edata_free((void **) &h.edata);
@@ -1202,6 +1841,8 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
         goto bail;
     }
 
+    store_new_emails(m, first);
+
     /* In case we get new mail while fetching the headers. */
     if (mdata->reopen & IMAP_NEWMAIL_PENDING)
     {
@@ -1229,8 +1870,10 @@ static int read_headers_fetch_new(struct Mailbox *m, unsigned int msn_begin,
   retval = 0;
 
 bail:
+  /* keep whatever was fetched before an error */
+  store_new_emails(m, first);
   mutt_buffer_pool_release(&b);
-  mutt_file_fclose(&fp);
+  mutt_buffer_pool_release(&hdrs);
   FREE(&hdrreq);
 
   return retval;
@@ -1268,6 +1911,7 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
   unsigned long long *pmodseq = NULL;
   unsigned long long hc_modseq = 0;
   char *uid_seqset = NULL;
+  bool from_snapshot = false;
 #endif /* USE_HCACHE */
 
   struct ImapAccountData *adata = imap_adata_get(m);
@@ -1279,6 +1923,9 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
   while (msn_end > m->email_max)
     mx_alloc_memory(m);
   alloc_msn_index(adata, msn_end);
+
+  /* a key press may be awaited mid-FETCH; keep the idle prefetch out */
+  mdata->reading_headers = true;
   imap_alloc_uid_hash(adata, msn_end);
 
   oldmsgcount = m->msg_count;
@@ -1290,8 +1937,8 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
 
   if (mdata->hcache && initial_download)
   {
-    uid_validity = mutt_hcache_fetch_raw(mdata->hcache, "/UIDVALIDITY", 12);
-    puid_next = mutt_hcache_fetch_raw(mdata->hcache, "/UIDNEXT", 8);
+    uid_validity = mutt_hcache_fetch_raw(mdata->hcache, "/UIDVALIDITY", 12, NULL);
+    puid_next = mutt_hcache_fetch_raw(mdata->hcache, "/UIDNEXT", 8, NULL);
     if (puid_next)
     {
       uid_next = *(unsigned int *) puid_next;
@@ -1312,7 +1959,7 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
     if (uid_validity && uid_next && (*(unsigned int *) uid_validity == mdata->uid_validity))
     {
       evalhc = true;
-      pmodseq = mutt_hcache_fetch_raw(mdata->hcache, "/MODSEQ", 7);
+      pmodseq = mutt_hcache_fetch_raw(mdata->hcache, "/MODSEQ", 7, NULL);
       if (pmodseq)
       {
         hc_modseq = *pmodseq;
@@ -1335,7 +1982,12 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
   }
   if (evalhc)
   {
-    if (eval_qresync)
+    if ((eval_condstore || eval_qresync) && (hc_modseq == mdata->modseq) &&
+        (read_headers_snapshot_eval_cache(adata, msn_end) == 0))
+    {
+      from_snapshot = true;
+    }
+    else if (eval_qresync)
     {
       if (read_headers_qresync_eval_cache(adata, uid_seqset) < 0)
         goto bail;
@@ -1404,6 +2056,16 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
       imap_hcache_store_uid_seqset(mdata);
     else
       imap_hcache_clear_uid_seqset(mdata);
+
+    /* Only snapshot mailboxes that were unchanged since the last time they
+     * were opened.  Busy mailboxes wouldn't get to use it. */
+    if ((eval_condstore || eval_qresync) && (hc_modseq == mdata->modseq))
+    {
+      if (!from_snapshot)
+        imap_hcache_store_snapshot(mdata);
+    }
+    else
+      imap_hcache_clear_snapshot(mdata);
   }
 #endif /* USE_HCACHE */
 
@@ -1419,6 +2081,7 @@ int imap_read_headers(struct Mailbox *m, unsigned int msn_begin,
   retval = msn_end;
 
 bail:
+  mdata->reading_headers = false;
 #ifdef USE_HCACHE
   imap_hcache_close(mdata);
   FREE(&uid_seqset);
@@ -1840,6 +2503,243 @@ char *imap_set_flags(struct Mailbox *m, struct Email *e, char *s, bool *server_c
   return s;
 }
 
+/**
+ * prefetch_message - Save a message from a prefetch FETCH response
+ * @param m     Selected Imap Mailbox
+ * @param adata Imap Account data
+ * @retval  0 Success, or not a message
+ * @retval -1 Error
+ */
+static int prefetch_message(struct Mailbox *m, struct ImapAccountData *adata)
+{
+  struct ImapMboxData *mdata = imap_mdata_get(m);
+  unsigned int msn = 0;
+  unsigned int uid = 0;
+  unsigned int bytes = 0;
+
+  char *pc = adata->buf;
+  if (pc[0] != '*')
+    return 0;
+  pc = imap_next_word(pc);
+  if ((mutt_str_atoui(pc, &msn) < 0) || (msn < 1) || (msn > mdata->max_msn))
+    return 0;
+  pc = imap_next_word(pc);
+  if (!mutt_str_startswith(pc, "FETCH", CASE_IGNORE))
+    return 0;
+
+  struct Email *e = mdata->msn_index[msn - 1];
+
+  while (*pc)
+  {
+    pc = imap_next_word(pc);
+    if (pc[0] == '(')
+      pc++;
+    if (mutt_str_startswith(pc, "UID", CASE_IGNORE))
+    {
+      pc = imap_next_word(pc);
+      if ((mutt_str_atoui(pc, &uid) < 0) || !e || (uid != imap_edata_get(e)->uid))
+        e = NULL;
+    }
+    else if (mutt_str_startswith(pc, "BODY[]", CASE_IGNORE))
+      break;
+  }
+
+  /* e.g. an unsolicited FLAGS update */
+  if (!*pc)
+    return 0;
+
+  pc = imap_next_word(pc);
+  if (imap_get_literal_count(pc, &bytes) < 0)
+  {
+    imap_error("prefetch_message()", adata->buf);
+    return -1;
+  }
+
+  FILE *fp = e ? msg_cache_put(m, e) : NULL;
+  if (!fp)
+  {
+    /* we still have to read the message */
+    struct Buffer *buf = mutt_buffer_pool_get();
+    const int rc = imap_read_literal_buf(buf, adata, bytes);
+    mutt_buffer_pool_release(&buf);
+    if (rc < 0)
+      return -1;
+  }
+  else
+  {
+    int rc = imap_read_literal(fp, adata, bytes, NULL);
+    if ((fflush(fp) != 0) || ferror(fp))
+      rc = -1;
+    mutt_file_fclose(&fp);
+    if (rc == 0)
+      msg_cache_commit(m, e);
+    else
+      imap_cache_del(m, e);
+    if (adata->status == IMAP_FATAL)
+      return -1;
+  }
+
+  /* pick up trailing line */
+  if (imap_cmd_step(adata) != IMAP_CMD_CONTINUE)
+    return -1;
+
+  return 0;
+}
+
+/**
+ * imap_msg_prefetch - Download messages into the message cache
+ * @param m      Selected Imap Mailbox
+ * @param emails Emails to download, most wanted first
+ * @param num    Number of Emails
+ * @param max    Maximum number of messages to download
+ * @retval num Number of messages requested
+ * @retval -1  Error
+ *
+ * Download the messages that aren't cached yet, in batches, until
+ * $imap_prefetch_size bytes, or max messages, have been requested.  The user
+ * can stop the download with Ctrl-C, which takes effect at the end of the
+ * current batch.  SigInt is left set, for the caller to deal with.
+ *
+ * Nothing is downloaded unless $message_cachedir is set.  The messages are
+ * fetched with BODY.PEEK[], so their flags don't change.
+ */
+int imap_msg_prefetch(struct Mailbox *m, struct Email **emails, int num, int max)
+{
+  struct ImapAccountData *adata = imap_adata_get(m);
+  struct ImapMboxData *mdata = imap_mdata_get(m);
+
+  if (!emails || (num < 1) || (C_ImapPrefetchSize <= 0) || !adata ||
+      (adata->mailbox != m) || !(adata->capabilities & IMAP_CAP_IMAP4REV1))
+  {
+    return 0;
+  }
+
+  mdata->bcache = msg_cache_open(m);
+  if (!mdata->bcache)
+    return 0;
+
+  struct Email **want = mutt_mem_calloc(num, sizeof(struct Email *));
+  int count = 0;
+  long size = 0;
+  char id[64];
+
+  for (int i = 0; (i < num) && (count < max) && (size < C_ImapPrefetchSize); i++)
+  {
+    struct Email *e = emails[i];
+    if (!e || !e->active || !e->edata)
+      continue;
+
+    snprintf(id, sizeof(id), "%u-%u", mdata->uid_validity, imap_edata_get(e)->uid);
+    if (mutt_bcache_exists(mdata->bcache, id) == 0)
+      continue;
+
+    want[count++] = e;
+    size += e->content ? e->content->length : 0;
+  }
+
+  if (count == 0)
+  {
+    FREE(&want);
+    return 0;
+  }
+
+  mutt_debug(LL_DEBUG2, "prefetching %d messages, about %ld bytes\n", count, size);
+
+  /* a single batch finishes quickly, don't disturb the screen */
+  struct Progress progress;
+  const bool output_progress = !isendwin() && (count > IMAP_PREFETCH_BATCH);
+  if (output_progress)
+  {
+    mutt_progress_init(&progress, _("Prefetching messages..."),
+                       MUTT_PROGRESS_MSG, C_ReadInc, count);
+  }
+
+  struct Buffer *cmd = mutt_buffer_pool_get();
+  struct Buffer *set = mutt_buffer_pool_get();
+  int rc = IMAP_CMD_OK;
+  int done = 0;
+
+  while ((done < count) && (rc == IMAP_CMD_OK))
+  {
+    if (SigInt)
+    {
+      mutt_debug(LL_DEBUG2, "prefetch interrupted\n");
+      break;
+    }
+
+    struct SeqsetBuilder sb = { .buf = set };
+    mutt_buffer_reset(set);
+    for (int i = 0; (i < IMAP_PREFETCH_BATCH) && (done < count); i++, done++)
+      imap_seqset_add(&sb, imap_edata_get(want[done])->uid);
+    imap_seqset_finish(&sb);
+    mutt_buffer_printf(cmd, "UID FETCH %s (UID BODY.PEEK[])", mutt_b2s(set));
+
+    if (imap_cmd_start(adata, mutt_b2s(cmd)) < 0)
+    {
+      rc = IMAP_CMD_BAD;
+      break;
+    }
+
+    while ((rc = imap_cmd_step(adata)) == IMAP_CMD_CONTINUE)
+    {
+      if (prefetch_message(m, adata) < 0)
+      {
+        rc = IMAP_CMD_BAD;
+        break;
+      }
+    }
+
+    if (output_progress)
+      mutt_progress_update(&progress, done, -1);
+  }
+
+  mutt_buffer_pool_release(&cmd);
+  mutt_buffer_pool_release(&set);
+  FREE(&want);
+
+  if (output_progress)
+    mutt_clear_error();
+
+  return (rc == IMAP_CMD_OK) ? done : -1;
+}
+
+/**
+ * imap_msg_prefetch_next - Download the messages after the one being read
+ * @param m Selected Imap Mailbox
+ *
+ * Download one batch of the $imap_prefetch messages that follow the one
+ * imap_msg_open() last downloaded, in the order they're displayed.  This is
+ * called while the user is idle, see imap_prefetch().
+ */
+void imap_msg_prefetch_next(struct Mailbox *m)
+{
+  struct ImapAccountData *adata = imap_adata_get(m);
+  struct ImapMboxData *mdata = imap_mdata_get(m);
+  if (!adata || !mdata)
+    return;
+
+  const unsigned int uid = mdata->prefetch_uid;
+  mdata->prefetch_uid = 0;
+
+  struct Email *e = mdata->uid_hash ? imap_uid_hash_find(mdata->uid_hash, uid) : NULL;
+  if (!e || (C_ImapPrefetch <= 0) || !m->v2r || (e->virtual < 0) ||
+      (adata->state < IMAP_SELECTED))
+  {
+    return;
+  }
+
+  struct Email **emails = mutt_mem_calloc(C_ImapPrefetch, sizeof(struct Email *));
+  int num = 0;
+  for (int v = e->virtual + 1; (v < m->vcount) && (num < C_ImapPrefetch); v++)
+    emails[num++] = m->emails[m->v2r[v]];
+
+  /* a full batch means there may be more to come */
+  if (imap_msg_prefetch(m, emails, num, IMAP_PREFETCH_BATCH) == IMAP_PREFETCH_BATCH)
+    mdata->prefetch_uid = uid;
+
+  FREE(&emails);
+}
+
 /**
  * imap_msg_open - Implements MxOps::msg_open()
  */
@@ -1855,6 +2755,7 @@ int imap_msg_open(struct Mailbox *m, struct Message *msg, int msgno)
   struct Progress progress;
   unsigned int uid;
   bool retried = false;
+  bool downloaded = false;
   bool read;
   int rc;
 
@@ -1991,6 +2892,7 @@ int imap_msg_open(struct Mailbox *m, struct Message *msg, int msgno)
     goto bail;
 
   msg_cache_commit(m, e);
+  downloaded = true;
 
 parsemsg:
   /* Update the header information.  Previously, we only downloaded a
@@ -2035,6 +2937,10 @@ parsemsg:
     goto parsemsg;
   }
 
+  /* reading uncached messages; get the next ones ready when the user is idle */
+  if (downloaded && (C_ImapPrefetch > 0))
+    imap_mdata_get(m)->prefetch_uid = imap_edata_get(e)->uid;
+
   return 0;
 
 bail:
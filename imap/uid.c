@@ -0,0 +1,234 @@
+/**
+ * @file
+ * Look up messages by UID, and build UID sets
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page imap_uid Look up messages by UID, and build UID sets
+ *
+ * The UID Hash maps a mailbox's UIDs to its Emails.  The Sequence Set Builder
+ * turns a list of numbers into an IMAP Sequence Set, e.g. "1:5,7".
+ *
+ * These only depend on the mutt library, so they can be unit tested.
+ */
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include "imap_private.h"
+#include "mutt/mutt.h"
+
+/**
+ * imap_seqset_add - Add a number to a Sequence Set
+ * @param sb  Sequence Set Builder
+ * @param num Number to add
+ *
+ * A number that follows on from the previous one extends the current run.
+ */
+void imap_seqset_add(struct SeqsetBuilder *sb, unsigned int num)
+{
+  if (sb->started && (num != 0) && (num == sb->end + 1))
+  {
+    sb->end = num;
+    return;
+  }
+
+  imap_seqset_finish(sb);
+  sb->begin = num;
+  sb->end = num;
+  sb->started = true;
+}
+
+/**
+ * imap_seqset_finish - Write out the current run of a Sequence Set
+ * @param sb Sequence Set Builder
+ */
+void imap_seqset_finish(struct SeqsetBuilder *sb)
+{
+  if (!sb->started)
+    return;
+
+  if (mutt_buffer_len(sb->buf) != 0)
+    mutt_buffer_addch(sb->buf, ',');
+
+  if (sb->begin == sb->end)
+    mutt_buffer_add_printf(sb->buf, "%u", sb->begin);
+  else
+    mutt_buffer_add_printf(sb->buf, "%u:%u", sb->begin, sb->end);
+
+  sb->started = false;
+}
+
+/**
+ * uid_hash_home - Find the preferred slot for a UID
+ * @param uh  UID Hash
+ * @param uid UID
+ * @retval num Slot index
+ *
+ * Fibonacci hashing: the top bits of the product are the best mixed.
+ */
+static unsigned int uid_hash_home(const struct ImapUidHash *uh, unsigned int uid)
+{
+  return (unsigned int) ((uid * 2654435769U) >> uh->shift) & uh->mask;
+}
+
+/**
+ * uid_hash_resize - Allocate the slots of a UID Hash
+ * @param uh   UID Hash
+ * @param bits log2 of the number of slots
+ *
+ * Any existing entries are moved into the new slots.
+ */
+static void uid_hash_resize(struct ImapUidHash *uh, unsigned int bits)
+{
+  struct ImapUidSlot *old = uh->slots;
+  const unsigned int old_size = old ? uh->mask + 1 : 0;
+
+  uh->slots = mutt_mem_calloc((size_t) 1 << bits, sizeof(struct ImapUidSlot));
+  uh->mask = (1U << bits) - 1;
+  uh->shift = 32 - bits;
+  uh->count = 0;
+
+  for (unsigned int i = 0; i < old_size; i++)
+    if (old[i].uid != 0)
+      imap_uid_hash_insert(uh, old[i].uid, old[i].email);
+
+  FREE(&old);
+}
+
+/**
+ * imap_uid_hash_new - Create a UID Hash
+ * @param count Expected number of messages
+ * @retval ptr New UID Hash
+ */
+struct ImapUidHash *imap_uid_hash_new(size_t count)
+{
+  struct ImapUidHash *uh = mutt_mem_calloc(1, sizeof(struct ImapUidHash));
+
+  unsigned int bits = 5;
+  while ((bits < 31) && (((size_t) 3 << bits) < count * 4))
+    bits++;
+  uid_hash_resize(uh, bits);
+
+  return uh;
+}
+
+/**
+ * imap_uid_hash_free - Free a UID Hash
+ * @param[out] ptr UID Hash to free
+ *
+ * The Emails are not freed.
+ */
+void imap_uid_hash_free(struct ImapUidHash **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  FREE(&(*ptr)->slots);
+  FREE(ptr);
+}
+
+/**
+ * imap_uid_hash_find - Find the Email with a UID
+ * @param uh  UID Hash
+ * @param uid UID to look for
+ * @retval ptr  Matching Email
+ * @retval NULL No match
+ */
+struct Email *imap_uid_hash_find(const struct ImapUidHash *uh, unsigned int uid)
+{
+  if (!uh || (uid == 0))
+    return NULL;
+
+  for (unsigned int i = uid_hash_home(uh, uid); uh->slots[i].uid != 0;
+       i = (i + 1) & uh->mask)
+  {
+    if (uh->slots[i].uid == uid)
+      return uh->slots[i].email;
+  }
+
+  return NULL;
+}
+
+/**
+ * imap_uid_hash_insert - Add an Email to a UID Hash
+ * @param uh  UID Hash
+ * @param uid UID of the Email
+ * @param e   Email
+ * @retval true  Success
+ * @retval false The UID is already present, or invalid
+ */
+bool imap_uid_hash_insert(struct ImapUidHash *uh, unsigned int uid, struct Email *e)
+{
+  if (!uh || (uid == 0))
+    return false;
+
+  if (((uh->count + 1) * 4ULL) > ((uh->mask + 1) * 3ULL))
+    uid_hash_resize(uh, 33 - uh->shift);
+
+  unsigned int i = uid_hash_home(uh, uid);
+  for (; uh->slots[i].uid != 0; i = (i + 1) & uh->mask)
+  {
+    if (uh->slots[i].uid == uid)
+      return false;
+  }
+
+  uh->slots[i].uid = uid;
+  uh->slots[i].email = e;
+  uh->count++;
+  return true;
+}
+
+/**
+ * imap_uid_hash_delete - Remove an Email from a UID Hash
+ * @param uh  UID Hash
+ * @param uid UID of the Email
+ * @param e   Email, only remove the UID if it belongs to this Email
+ *
+ * The following entries are shifted back, so that lookups never stop at the
+ * gap (Knuth's Algorithm R).
+ */
+void imap_uid_hash_delete(struct ImapUidHash *uh, unsigned int uid, const struct Email *e)
+{
+  if (!uh || (uid == 0))
+    return;
+
+  unsigned int i = uid_hash_home(uh, uid);
+  for (; uh->slots[i].uid != uid; i = (i + 1) & uh->mask)
+  {
+    if (uh->slots[i].uid == 0)
+      return;
+  }
+
+  if (e && (uh->slots[i].email != e))
+    return;
+
+  for (unsigned int j = (i + 1) & uh->mask; uh->slots[j].uid != 0; j = (j + 1) & uh->mask)
+  {
+    /* move the entry back, unless its home lies cyclically in (i, j] */
+    const unsigned int home = uid_hash_home(uh, uh->slots[j].uid);
+    if (((j - home) & uh->mask) >= ((j - i) & uh->mask))
+    {
+      uh->slots[i] = uh->slots[j];
+      i = j;
+    }
+  }
+
+  uh->slots[i].uid = 0;
+  uh->slots[i].email = NULL;
+  uh->count--;
+}
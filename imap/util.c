@@ -52,6 +52,7 @@
 #include "curs_lib.h"
 #include "globals.h"
 #include "hcache/hcache.h"
+#include "hcache/serialize.h"
 #include "imap/imap.h"
 #include "mailbox.h"
 #include "message.h"
@@ -99,8 +100,11 @@ struct ImapAccountData *imap_adata_new(void)
 
   adata->seqid = new_seqid;
   adata->cmdbuf = mutt_buffer_new();
-  adata->cmdslots = C_ImapPipelineDepth + 2;
+  /* leave the window room to grow, unless pipelining is off */
+  adata->cmdslots = (C_ImapPipelineDepth > 0) ?
+                        MAX(C_ImapPipelineDepth, IMAP_PIPELINE_MAX) + 2 : 2;
   adata->cmds = mutt_mem_calloc(adata->cmdslots, sizeof(*adata->cmds));
+  adata->cmdwindow = MAX(C_ImapPipelineDepth, 1);
 
   if (++new_seqid > 'z')
     new_seqid = 'a';
@@ -185,9 +189,9 @@ struct ImapMboxData *imap_mdata_new(struct ImapAccountData *adata, const char *n
   header_cache_t *hc = imap_hcache_open(adata, mdata);
   if (hc)
   {
-    void *uidvalidity = mutt_hcache_fetch_raw(hc, "/UIDVALIDITY", 12);
-    void *uidnext = mutt_hcache_fetch_raw(hc, "/UIDNEXT", 8);
-    unsigned long long *modseq = mutt_hcache_fetch_raw(hc, "/MODSEQ", 7);
+    void *uidvalidity = mutt_hcache_fetch_raw(hc, "/UIDVALIDITY", 12, NULL);
+    void *uidnext = mutt_hcache_fetch_raw(hc, "/UIDNEXT", 8, NULL);
+    unsigned long long *modseq = mutt_hcache_fetch_raw(hc, "/MODSEQ", 7, NULL);
     if (uidvalidity)
     {
       mdata->uid_validity = *(unsigned int *) uidvalidity;
@@ -212,11 +216,12 @@ struct ImapMboxData *imap_mdata_new(struct ImapAccountData *adata, const char *n
  */
 void imap_mdata_cache_reset(struct ImapMboxData *mdata)
 {
-  mutt_hash_free(&mdata->uid_hash);
+  imap_uid_hash_free(&mdata->uid_hash);
   FREE(&mdata->msn_index);
   mdata->msn_index_size = 0;
   mdata->max_msn = 0;
   mutt_bcache_close(&mdata->bcache);
+  mdata->prefetch_uid = 0;
 }
 
 /**
@@ -349,54 +354,14 @@ void imap_clean_path(char *path, size_t plen)
  */
 static void imap_msn_index_to_uid_seqset(struct Buffer *b, struct ImapMboxData *mdata)
 {
-  int first = 1, state = 0;
-  unsigned int cur_uid = 0, last_uid = 0;
-  unsigned int range_begin = 0, range_end = 0;
+  struct SeqsetBuilder sb = { .buf = b };
 
-  for (unsigned int msn = 1; msn <= mdata->max_msn + 1; msn++)
+  for (unsigned int msn = 1; msn <= mdata->max_msn; msn++)
   {
-    bool match = false;
-    if (msn <= mdata->max_msn)
-    {
-      struct Email *cur_header = mdata->msn_index[msn - 1];
-      cur_uid = cur_header ? imap_edata_get(cur_header)->uid : 0;
-      if (!state || (cur_uid && ((cur_uid - 1) == last_uid)))
-        match = true;
-      last_uid = cur_uid;
-    }
-
-    if (match)
-    {
-      switch (state)
-      {
-        case 1: /* single: convert to a range */
-          state = 2;
-          /* fall through */
-        case 2: /* extend range ending */
-          range_end = cur_uid;
-          break;
-        default:
-          state = 1;
-          range_begin = cur_uid;
-          break;
-      }
-    }
-    else if (state)
-    {
-      if (first)
-        first = 0;
-      else
-        mutt_buffer_addch(b, ',');
-
-      if (state == 1)
-        mutt_buffer_add_printf(b, "%u", range_begin);
-      else if (state == 2)
-        mutt_buffer_add_printf(b, "%u:%u", range_begin, range_end);
-
-      state = 1;
-      range_begin = cur_uid;
-    }
+    struct Email *cur_header = mdata->msn_index[msn - 1];
+    imap_seqset_add(&sb, cur_header ? imap_edata_get(cur_header)->uid : 0);
   }
+  imap_seqset_finish(&sb);
 }
 
 /**
@@ -564,13 +529,94 @@ char *imap_hcache_get_uid_seqset(struct ImapMboxData *mdata)
   if (!mdata->hcache)
     return NULL;
 
-  char *hc_seqset = mutt_hcache_fetch_raw(mdata->hcache, "/UIDSEQSET", 10);
+  char *hc_seqset = mutt_hcache_fetch_raw(mdata->hcache, "/UIDSEQSET", 10, NULL);
   char *seqset = mutt_str_strdup(hc_seqset);
   mutt_hcache_free(mdata->hcache, (void **) &hc_seqset);
   mutt_debug(LL_DEBUG3, "Retrieved /UIDSEQSET %s\n", NONULL(seqset));
 
   return seqset;
 }
+
+/**
+ * imap_hcache_store_snapshot - Store a snapshot of the mailbox in the header cache
+ * @param mdata Imap Mailbox data
+ * @retval  0 Success
+ * @retval -1 Error
+ *
+ * The snapshot is a copy of every message's record, in MSN order, so that an
+ * unchanged mailbox can be read back in a single lookup.  It's only valid as
+ * long as the mailbox's HIGHESTMODSEQ doesn't change.
+ */
+int imap_hcache_store_snapshot(struct ImapMboxData *mdata)
+{
+  if (!mdata->hcache || (mdata->max_msn == 0))
+    return -1;
+
+  struct ImapSnapshot snap = { 0 };
+  snap.modseq = mdata->modseq;
+  snap.uid_validity = mdata->uid_validity;
+  snap.uid_next = mdata->uid_next;
+  snap.count = mdata->max_msn;
+
+  /* Records are typically a few hundred bytes */
+  size_t size = sizeof(snap);
+  size_t alloc = size + snap.count * 512;
+  char *blob = mutt_mem_malloc(alloc);
+
+  int rc = -1;
+  for (unsigned int msn = 1; msn <= snap.count; msn++)
+  {
+    struct Email *e = mdata->msn_index[msn - 1];
+    if (!e || !e->edata)
+      goto done;
+
+    int dlen = 0;
+    char *data = mutt_hcache_dump(mdata->hcache, e, &dlen, mdata->uid_validity, false);
+    struct ImapSnapshotEntry entry = { imap_edata_get(e)->uid, dlen };
+    size_t need = size + sizeof(entry) + IMAP_SNAPSHOT_PAD(dlen);
+    if (need > IMAP_SNAPSHOT_MAX)
+    {
+      FREE(&data);
+      goto done;
+    }
+    if (need > alloc)
+    {
+      alloc = MAX(need, alloc * 2);
+      mutt_mem_realloc(&blob, alloc);
+    }
+
+    memcpy(blob + size, &entry, sizeof(entry));
+    memcpy(blob + size + sizeof(entry), data, dlen);
+    memset(blob + size + sizeof(entry) + dlen, 0, IMAP_SNAPSHOT_PAD(dlen) - dlen);
+    size = need;
+    FREE(&data);
+  }
+
+  snap.len = size;
+  memcpy(blob, &snap, sizeof(snap));
+  rc = mutt_hcache_store_raw(mdata->hcache, "/SNAPSHOT", 9, blob, size);
+  mutt_debug(LL_DEBUG2, "Stored /SNAPSHOT of %u messages, %zu bytes\n", snap.count, size);
+
+done:
+  FREE(&blob);
+  if (rc != 0)
+    imap_hcache_clear_snapshot(mdata);
+  return rc;
+}
+
+/**
+ * imap_hcache_clear_snapshot - Delete a mailbox snapshot from the header cache
+ * @param mdata Imap Mailbox data
+ * @retval  0 Success
+ * @retval -1 Error
+ */
+int imap_hcache_clear_snapshot(struct ImapMboxData *mdata)
+{
+  if (!mdata->hcache)
+    return -1;
+
+  return mutt_hcache_delete(mdata->hcache, "/SNAPSHOT", 9);
+}
 #endif
 
 /**
@@ -1070,6 +1116,63 @@ void imap_keepalive(void)
   }
 }
 
+/**
+ * prefetch_ready - Can a folder be prefetched now?
+ * @param adata Imap Account data
+ * @retval true The folder has messages to prefetch, and the connection is free
+ *
+ * The idle loop also runs while a key is awaited in the middle of a command,
+ * e.g. the question of whether to stop a header download.  A prefetch then
+ * would mix its responses with the other command's.
+ */
+static bool prefetch_ready(struct ImapAccountData *adata)
+{
+  if (!adata || !adata->mailbox || SigInt)
+    return false;
+
+  struct ImapMboxData *mdata = imap_mdata_get(adata->mailbox);
+  if (!mdata || (mdata->prefetch_uid == 0) || mdata->reading_headers)
+    return false;
+
+  return (adata->lastcmd == adata->nextcmd);
+}
+
+/**
+ * imap_prefetch_pending - Are there messages waiting to be prefetched?
+ * @retval true imap_prefetch() has work to do
+ */
+bool imap_prefetch_pending(void)
+{
+  struct Account *np = NULL;
+  TAILQ_FOREACH(np, &AllAccounts, entries)
+  {
+    if ((np->magic == MUTT_IMAP) && prefetch_ready(np->adata))
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * imap_prefetch - Download the next messages while the user is idle
+ *
+ * Only one batch is downloaded for each folder, so that a key press isn't
+ * kept waiting for long.  Call this again while imap_prefetch_pending().
+ */
+void imap_prefetch(void)
+{
+  struct Account *np = NULL;
+  TAILQ_FOREACH(np, &AllAccounts, entries)
+  {
+    if (np->magic != MUTT_IMAP)
+      continue;
+
+    struct ImapAccountData *adata = np->adata;
+    if (prefetch_ready(adata))
+      imap_msg_prefetch_next(adata->mailbox);
+  }
+}
+
 /**
  * imap_wait_keepalive - Wait for a process to change state
  * @param pid Process ID to listen to
@@ -1030,6 +1030,9 @@ int mutt_index_menu(void)
   bool do_mailbox_notify = true;
   int close = 0; /* did we OP_QUIT or OP_EXIT out of this menu? */
   int attach_msg = OptAttachMsg;
+#ifdef USE_NOTMUCH
+  bool idle = false; /* no key was pressed while the query was being read */
+#endif
 
   struct Menu *menu = mutt_menu_new(MENU_MAIN);
   menu->menu_make_entry = index_make_entry;
@@ -1090,6 +1093,7 @@ int mutt_index_menu(void)
     if (Context && !attach_msg)
     {
       int check;
+      bool loading = false;
       /* check for new mail in the mailbox.  If nonzero, then something has
        * changed about the file (either we got new mail or the file was
        * modified underneath us.) */
@@ -1100,6 +1104,15 @@ int mutt_index_menu(void)
                        0;
 
       check = mx_mbox_check(Context->mailbox, &index_hint);
+#ifdef USE_NOTMUCH
+      /* read the next batch of a large query, that's not new mail */
+      if ((check == 0) && idle && nm_mbox_is_loading(Context->mailbox))
+      {
+        check = nm_mbox_read_batch(Context->mailbox);
+        loading = true;
+      }
+      idle = false;
+#endif
       if (check < 0)
       {
         if (!Context->mailbox || (mutt_buffer_is_empty(Context->mailbox->pathbuf)))
@@ -1119,7 +1132,7 @@ int mutt_index_menu(void)
           mutt_error(
               _("Mailbox was externally modified.  Flags may be wrong."));
         }
-        else if (check == MUTT_NEW_MAIL)
+        else if ((check == MUTT_NEW_MAIL) && !loading)
         {
           for (size_t i = oldcount; i < Context->mailbox->msg_count; i++)
           {
@@ -1226,6 +1239,26 @@ int mutt_index_menu(void)
         continue;
       }
 
+#ifdef USE_NOTMUCH
+      /* keep reading the query while the user is idle */
+      if (Context && nm_mbox_is_loading(Context->mailbox))
+      {
+        mutt_getch_timeout(0);
+        struct KeyEvent ch = mutt_getch();
+        mutt_getch_timeout(-1);
+        if (ch.ch == -2)
+        {
+          idle = true;
+          continue;
+        }
+
+        if (ch.op == OP_NULL)
+          mutt_unget_event(ch.ch, 0);
+        else
+          mutt_unget_event(0, ch.op);
+      }
+#endif
+
       op = km_dokey(MENU_MAIN);
 
       mutt_debug(LL_DEBUG3, "[%d]: Got op %d\n", __LINE__, op);
@@ -1372,15 +1372,15 @@ struct ConfigDef MuttVars[] = {
   ** all folders.
   ** By default it is \fIunset\fP so no header caching will be used.
   ** .pp
-  ** Header caching can greatly improve speed when opening POP, IMAP
-  ** MH or Maildir folders, see "$caching" for details.
+  ** Header caching can greatly improve speed when opening POP, IMAP,
+  ** MH, Maildir, mbox or MMDF folders, see "$caching" for details.
   */
   { "header_cache_backend", DT_STRING, &C_HeaderCacheBackend, 0, 0, hcache_validator },
   /*
   ** .pp
   ** This variable specifies the header cache backend.
   */
-#if defined(HAVE_QDBM) || defined(HAVE_TC) || defined(HAVE_KC)
+#if defined(HAVE_QDBM) || defined(HAVE_TC) || defined(HAVE_KC) || defined(HAVE_ZLIB)
   { "header_cache_compress", DT_BOOL, &C_HeaderCacheCompress, true },
   /*
   ** .pp
@@ -1391,8 +1391,11 @@ struct ConfigDef MuttVars[] = {
   ** decompression can result in a slower opening of cached folder(s)
   ** which in general is still much faster than opening non header
   ** cached folders.
+  ** .pp
+  ** When NeoMutt is compiled with zlib, the other backends (bdb, gdbm
+  ** and lmdb) compress each cached header individually instead.
   */
-#endif /* HAVE_QDBM */
+#endif /* HAVE_QDBM || HAVE_TC || HAVE_KC || HAVE_ZLIB */
 #if defined(HAVE_GDBM) || defined(HAVE_BDB)
   { "header_cache_pagesize", DT_STRING, &C_HeaderCachePagesize, IP "16384" },
   /*
@@ -1596,6 +1599,17 @@ struct ConfigDef MuttVars[] = {
   ** those, and displays worse performance when enabled.  Your
   ** mileage may vary.
   */
+#ifdef HAVE_ZLIB
+  { "imap_deflate", DT_BOOL, &C_ImapDeflate, true },
+  /*
+  ** .pp
+  ** When \fIset\fP, NeoMutt will use the COMPRESS=DEFLATE extension (RFC
+  ** 4978) if advertised by the server.
+  ** .pp
+  ** In general a good compression efficiency can be achieved, which
+  ** speeds up reading large mailboxes also on fairly good connections.
+  */
+#endif
   { "imap_delim_chars", DT_STRING, &C_ImapDelimChars, IP "/." },
   /*
   ** .pp
@@ -1612,6 +1626,20 @@ struct ConfigDef MuttVars[] = {
   ** a FETCH per set of this size instead of a single FETCH for all new
   ** headers.
   */
+  { "imap_fetch_connections", DT_NUMBER|DT_NOT_NEGATIVE, &C_ImapFetchConnections, 1 },
+  /*
+  ** .pp
+  ** The number of connections used to download the headers when a large
+  ** IMAP mailbox is opened.  When set to a value greater than 1, NeoMutt
+  ** opens extra connections to the server, each of which examines the
+  ** mailbox and downloads a share of the new headers.  The extra connections
+  ** are closed once the headers have been downloaded.  At most 8 connections
+  ** are used.
+  ** .pp
+  ** Each connection logs in separately, so this is not useful when logging
+  ** in is slow, nor with servers that limit the number of connections.  It
+  ** is ignored when $$tunnel is set.
+  */
   { "imap_headers", DT_STRING|R_INDEX, &C_ImapHeaders, 0 },
   /*
   ** .pp
@@ -1660,6 +1688,18 @@ struct ConfigDef MuttVars[] = {
   ** .pp
   ** This variable defaults to the value of $$imap_user.
   */
+  { "imap_notify", DT_BOOL, &C_ImapNotify, false },
+  /*
+  ** .pp
+  ** When \fIset\fP, NeoMutt will ask servers that support the IMAP NOTIFY
+  ** extension (RFC5465) to tell it when mail arrives in any of your
+  ** mailboxes.  Once NeoMutt knows the state of a mailbox, it stops
+  ** polling it with STATUS commands.  The list of mailboxes is sent when
+  ** NeoMutt logs in; mailboxes added after that are still polled.
+  ** .pp
+  ** The notifications are read whenever NeoMutt checks for new mail, see
+  ** $$mail_check.
+  */
   { "imap_oauth_refresh_command", DT_STRING|DT_SENSITIVE, &C_ImapOauthRefreshCommand, 0 },
   /*
   ** .pp
@@ -1705,8 +1745,25 @@ struct ConfigDef MuttVars[] = {
   ** more responsive. But not all servers correctly handle pipelined commands,
   ** so if you have problems you might want to try setting this variable to 0.
   ** .pp
+  ** This is the depth NeoMutt starts with.  It then measures how long the
+  ** server takes to answer, and deepens or narrows the pipeline, up to 64
+  ** commands, to keep the server busy without queueing more than is needed.
+  ** Setting this to 0 turns pipelining off.  Commands are also sent early if
+  ** the queue grows large.
+  ** .pp
   ** \fBNote:\fP Changes to this variable have no effect on open connections.
   */
+  { "imap_poll_backoff", DT_NUMBER|DT_NOT_NEGATIVE, &C_ImapPollBackoff, 0 },
+  /*
+  ** .pp
+  ** When checking IMAP mailboxes for new mail, NeoMutt can poll the quiet
+  ** ones less often.  Each time a mailbox is found unchanged, the time until
+  ** it's next polled is doubled, starting from $$mail_check, up to this
+  ** many seconds.  As soon as a mailbox changes, it's polled every
+  ** $$mail_check seconds again.
+  ** .pp
+  ** Forced checks always poll every mailbox.  Set to 0 to disable this.
+  */
   { "imap_poll_timeout", DT_NUMBER|DT_NOT_NEGATIVE, &C_ImapPollTimeout, 15 },
   /*
   ** .pp
@@ -1715,6 +1772,28 @@ struct ConfigDef MuttVars[] = {
   ** for new mail, before timing out and closing the connection.  Set
   ** to 0 to disable timing out.
   */
+  { "imap_prefetch", DT_NUMBER|DT_NOT_NEGATIVE, &C_ImapPrefetch, 0 },
+  /*
+  ** .pp
+  ** When a message that isn't in the message cache is opened, also download
+  ** this many of the messages that follow it in the index, so they can be
+  ** read without waiting.  They are downloaded in batches while NeoMutt waits
+  ** for a key, and pressing a key stops them.
+  ** .pp
+  ** This only works if $$message_cachedir is set.  See also
+  ** $$imap_prefetch_size.
+  */
+  { "imap_prefetch_size", DT_LONG|DT_NOT_NEGATIVE, &C_ImapPrefetchSize, 10485760 },
+  /*
+  ** .pp
+  ** The maximum size, in bytes, of the messages that NeoMutt downloads into
+  ** the message cache before they are needed.  This applies to
+  ** $$imap_prefetch and to searches of message bodies or headers using
+  ** regular expressions, which download the messages in batches.  Setting
+  ** this to 0 disables prefetching.
+  ** .pp
+  ** A prefetch can be interrupted with \fCCtrl-C\fP.
+  */
   { "imap_qresync", DT_BOOL, &C_ImapQresync, false },
   /*
   ** .pp
@@ -2015,6 +2094,29 @@ struct ConfigDef MuttVars[] = {
   ** files when the header cache is in use.  This incurs one \fCstat(2)\fP per
   ** message every time the folder is opened (which can be very slow for NFS
   ** folders).
+  ** .pp
+  ** The modification time and filenames of each directory are saved in the
+  ** header cache.  If a directory hasn't changed since it was last read, no
+  ** messages have been added, removed or renamed, so the per-message check is
+  ** skipped.
+  ** Note that a program that rewrites a message in place, without renaming
+  ** it, doesn't change the directory.
+  */
+#endif
+#ifdef USE_PTHREADS
+  { "maildir_read_threads", DT_NUMBER|DT_NOT_NEGATIVE, &C_MaildirReadThreads, 4 },
+  /*
+  ** .pp
+  ** The number of threads used to open and read Maildir and MH messages
+  ** whose headers aren't in the header cache.  Reading several messages at
+  ** once hides the latency of \fCopen(2)\fP and \fCread(2)\fP on large or
+  ** remote folders.  The headers are still parsed in inode order, so the
+  ** result is the same as reading the messages one at a time.
+  ** .pp
+  ** This is the number of reads kept in flight, so it isn't limited by the
+  ** number of CPUs.  Threads are only used on network filesystems, such as
+  ** NFS or SMB.  On a local filesystem, or if set to 0, the messages are read
+  ** one by one.
   */
 #endif
   { "maildir_trash", DT_BOOL, &C_MaildirTrash, false },
@@ -2321,6 +2423,10 @@ struct ConfigDef MuttVars[] = {
   ** .dt %S .dd Url schema        .dd \fCnews\fP
   ** .dt %u .dd Username          .dd \fCusername\fP
   ** .de
+  ** .pp
+  ** Changes to the read articles are appended to a journal, named after the
+  ** file with ``.journal'' added.  The journal is folded back into the file
+  ** when you leave the newsgroup, or once it grows bigger than the file.
   */
 #endif
 #ifdef USE_NOTMUCH
@@ -2348,6 +2454,18 @@ struct ConfigDef MuttVars[] = {
   ** variable is used to count flagged messages in DB and set the flagged flag when
   ** modifying tags. All other NeoMutt commands use standard (e.g. maildir) flags.
   */
+  { "nm_open_batch", DT_NUMBER|DT_NOT_NEGATIVE, &C_NmOpenBatch, 0 },
+  /*
+  ** .pp
+  ** When set to a non-zero value, opening a notmuch mailbox only reads this
+  ** many results (messages or threads, see $$nm_query_type) before the index
+  ** is shown.  The remaining results are read in batches of the same size
+  ** while the index is waiting for a key press, so large queries can be used
+  ** straight away.  The results are read newest first.  Reading pauses while
+  ** another menu, e.g. the pager, is shown.
+  ** .pp
+  ** When set to 0, all the results are read when the mailbox is opened.
+  */
   { "nm_open_timeout", DT_NUMBER|DT_NOT_NEGATIVE, &C_NmOpenTimeout, 5 },
   /*
   ** .pp
@@ -4134,6 +4252,17 @@ struct ConfigDef MuttVars[] = {
   ** variable.
   */
 #endif /* USE_SMTP */
+  { "socket_buffer_size", DT_LONG|DT_NOT_NEGATIVE, &C_SocketBufferSize, 16384 },
+  /*
+  ** .pp
+  ** The size, in bytes, of the buffer that NeoMutt reads network data into.
+  ** A larger buffer means fewer reads when downloading a lot of data, e.g.
+  ** the headers of a large IMAP mailbox or newsgroup.  Values smaller than
+  ** 1024 are treated as 1024 and values larger than 1048576 are treated as
+  ** 1048576.
+  ** .pp
+  ** \fBNote:\fP Changes to this variable have no effect on open connections.
+  */
   { "sort", DT_SORT|R_INDEX|R_RESORT, &C_Sort, SORT_DATE, 0, pager_validator },
   /*
   ** .pp
@@ -581,6 +581,17 @@ int km_dokey(int menu)
   {
     int i = (C_Timeout > 0) ? C_Timeout : 60;
 #ifdef USE_IMAP
+    /* download the next messages in the background, until a key is pressed */
+    while (imap_prefetch_pending())
+    {
+      mutt_getch_timeout(0);
+      tmp = mutt_getch();
+      mutt_getch_timeout(-1);
+      if ((tmp.ch != -2) || SigWinch)
+        goto gotkey;
+      imap_prefetch();
+    }
+
     /* keepalive may need to run more frequently than C_Timeout allows */
     if (C_ImapKeepalive)
     {
@@ -124,9 +124,10 @@ void mailbox_free(struct Mailbox **ptr)
  * @param m_check     Mailbox to check
  * @param ctx_sb      stat() info for the current Mailbox
  * @param check_stats If true, also count the total, new and flagged messages
+ * @param force       Force flags, see mutt_mailbox_check()
  */
 static void mailbox_check(struct Mailbox *m_cur, struct Mailbox *m_check,
-                          struct stat *ctx_sb, bool check_stats)
+                          struct stat *ctx_sb, bool check_stats, int force)
 {
   struct stat sb = { 0 };
 
@@ -182,7 +183,7 @@ static void mailbox_check(struct Mailbox *m_cur, struct Mailbox *m_check,
       case MUTT_MAILDIR:
       case MUTT_MH:
       case MUTT_NOTMUCH:
-        if (mx_mbox_check_stats(m_check, 0) == 0)
+        if (mx_mbox_check_stats(m_check, force) == 0)
           MailboxCount++;
         break;
       default:; /* do nothing */
@@ -198,11 +199,6 @@ static void mailbox_check(struct Mailbox *m_cur, struct Mailbox *m_check,
     mutt_menu_set_current_redraw(REDRAW_SIDEBAR);
   }
 #endif
-
-  if (!m_check->has_new)
-    m_check->notified = false;
-  else if (!m_check->notified)
-    MailboxNotify++;
 }
 
 /**
@@ -386,10 +382,24 @@ int mutt_mailbox_check(struct Mailbox *m_cur, int force)
   STAILQ_FOREACH(np, &AllMailboxes, entries)
   {
     mailbox_check(m_cur, np->mailbox, &contex_sb,
-                  check_stats || (!np->mailbox->first_check_stats_done && C_MailCheckStats));
+                  check_stats || (!np->mailbox->first_check_stats_done && C_MailCheckStats),
+                  force);
     np->mailbox->first_check_stats_done = true;
   }
 
+#ifdef USE_IMAP
+  /* collect the replies to the STATUS commands queued above */
+  imap_status_flush();
+#endif
+
+  STAILQ_FOREACH(np, &AllMailboxes, entries)
+  {
+    if (!np->mailbox->has_new)
+      np->mailbox->notified = false;
+    else if (!np->mailbox->notified)
+      MailboxNotify++;
+  }
+
   return MailboxCount;
 }
 
@@ -48,6 +48,7 @@ struct Email;
 /* These Config Variables are only used in maildir/mh.c */
 extern bool  C_CheckNew;
 extern bool  C_MaildirHeaderCacheVerify;
+extern short C_MaildirReadThreads;
 extern bool  C_MhPurge;
 extern char *C_MhSeqFlagged;
 extern char *C_MhSeqReplied;
@@ -283,11 +283,19 @@ cleanup:
 static int maildir_mbox_open(struct Mailbox *m)
 {
   /* maildir looks sort of like MH, except that there are two subdirectories
-   * of the main folder path from which to read messages */
-  if ((mh_read_dir(m, "new") == -1) || (mh_read_dir(m, "cur") == -1))
-    return -1;
+   * of the main folder path from which to read messages.  Both directories
+   * are read at once, then the messages are processed in order. */
+  const char *subdirs[] = { "new", "cur" };
+  struct MaildirScan scans[2];
+  int rc = 0;
 
-  return 0;
+  maildir_scan_dirs(m, subdirs, scans, mutt_array_size(scans), true);
+  if ((mh_read_dir(m, "new", &scans[0]) == -1) || (mh_read_dir(m, "cur", &scans[1]) == -1))
+    rc = -1;
+
+  maildir_scan_free(&scans[0]);
+  maildir_scan_free(&scans[1]);
+  return rc;
 }
 
 /**
@@ -343,6 +351,27 @@ static int maildir_mbox_open_append(struct Mailbox *m, OpenMailboxFlags flags)
   return 0;
 }
 
+#ifdef USE_INOTIFY
+/**
+ * stat_subdir_file - Look up a file in a Maildir subdirectory
+ * @param[in]  m      Mailbox
+ * @param[in]  subdir Subdirectory, e.g. 'new'
+ * @param[in]  name   Filename
+ * @param[in]  buf    Buffer for the path
+ * @param[out] st     File's details
+ * @retval  0 Success, the file is a regular file
+ * @retval -1 Error
+ */
+static int stat_subdir_file(struct Mailbox *m, const char *subdir,
+                            const char *name, struct Buffer *buf, struct stat *st)
+{
+  mutt_buffer_printf(buf, "%s/%s/%s", mutt_b2s(m->pathbuf), subdir, name);
+  if (stat(mutt_b2s(buf), st) != 0)
+    return -1;
+  return S_ISREG(st->st_mode) ? 0 : -1;
+}
+#endif
+
 /**
  * maildir_mbox_check - Implements MxOps::mbox_check()
  *
@@ -376,20 +405,22 @@ int maildir_mbox_check(struct Mailbox *m, int *index_hint)
   if (!C_CheckNew)
     return 0;
 
+#ifdef USE_INOTIFY
+  /* If inotify saw every change to the 'new' directory, we needn't read it */
+  struct ListHead added = STAILQ_HEAD_INITIALIZER(added);
+  bool use_events = MonitorContextChanged && !MonitorContextIncomplete;
+  STAILQ_SWAP(&added, &MonitorContextFiles, ListNode);
+  mutt_monitor_files_clear();
+#endif
+
   struct Buffer *buf = mutt_buffer_pool_get();
   mutt_buffer_printf(buf, "%s/new", mutt_b2s(m->pathbuf));
   if (stat(mutt_b2s(buf), &st_new) == -1)
-  {
-    mutt_buffer_pool_release(&buf);
-    return -1;
-  }
+    goto fail;
 
   mutt_buffer_printf(buf, "%s/cur", mutt_b2s(m->pathbuf));
   if (stat(mutt_b2s(buf), &st_cur) == -1)
-  {
-    mutt_buffer_pool_release(&buf);
-    return -1;
-  }
+    goto fail;
 
   /* determine which subdirectories need to be scanned */
   if (mutt_file_stat_timespec_compare(&st_new, MUTT_STAT_MTIME, &m->mtime) > 0)
@@ -399,6 +430,9 @@ int maildir_mbox_check(struct Mailbox *m, int *index_hint)
 
   if (changed == MMC_NO_DIRS)
   {
+#ifdef USE_INOTIFY
+    mutt_list_free(&added);
+#endif
     mutt_buffer_pool_release(&buf);
     return 0; /* nothing to do */
   }
@@ -423,10 +457,86 @@ int maildir_mbox_check(struct Mailbox *m, int *index_hint)
    * the subdirectories that have changed.  */
   md = NULL;
   last = &md;
-  if (changed & MMC_NEW_DIR)
-    maildir_parse_dir(m, &last, "new", &count, NULL);
-  if (changed & MMC_CUR_DIR)
-    maildir_parse_dir(m, &last, "cur", &count, NULL);
+  const char *subdirs[2];
+  struct MaildirScan scans[2];
+  int num_dirs = 0;
+  int scanned = changed; /* which subdirectories were read in full */
+#ifdef USE_INOTIFY
+  if (use_events && (changed == MMC_NEW_DIR))
+  {
+    /* Only look at the files inotify told us about */
+    subdirs[0] = "new";
+    memset(&scans[0], 0, sizeof(struct MaildirScan));
+    scans[0].magic = m->magic;
+    mutt_buffer_printf(buf, "%s/new", mutt_b2s(m->pathbuf));
+    scans[0].path = mutt_str_strdup(mutt_b2s(buf));
+
+    struct ListNode *np = NULL;
+    STAILQ_FOREACH(np, &added, entries)
+    {
+      struct stat st;
+      if ((*np->data == '.') || (stat_subdir_file(m, "new", np->data, buf, &st) != 0))
+        continue;
+
+      if (scans[0].num_entries >= scans[0].max_entries)
+      {
+        scans[0].max_entries += 16;
+        mutt_mem_realloc(&scans[0].entries,
+                         scans[0].max_entries * sizeof(struct MaildirScanEntry));
+      }
+      scans[0].entries[scans[0].num_entries].name = mutt_str_strdup(np->data);
+      scans[0].entries[scans[0].num_entries].inode = st.st_ino;
+      scans[0].num_entries++;
+    }
+    num_dirs = 1;
+    scanned = MMC_NO_DIRS;
+    mutt_debug(LL_DEBUG2, "inotify: %zu files added to %s\n", scans[0].num_entries,
+               scans[0].path);
+  }
+  else
+#endif
+  {
+    if (changed & MMC_NEW_DIR)
+      subdirs[num_dirs++] = "new";
+    if (changed & MMC_CUR_DIR)
+      subdirs[num_dirs++] = "cur";
+
+    maildir_scan_dirs(m, subdirs, scans, num_dirs, false);
+  }
+
+  /* Most of the files will be exactly the ones we already know about.  Only
+   * the rest (new, removed or renamed files) needs looking at in detail. */
+  struct Hash *known = mutt_hash_new(m->msg_count, MUTT_HASH_NO_FLAGS);
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    m->emails[i]->active = false;
+    mutt_hash_insert(known, m->emails[i]->path, m->emails[i]);
+  }
+
+  for (int i = 0; i < num_dirs; i++)
+  {
+    size_t kept = 0;
+    for (size_t j = 0; j < scans[i].num_entries; j++)
+    {
+      struct MaildirScanEntry *entry = &scans[i].entries[j];
+      mutt_buffer_printf(buf, "%s/%s", subdirs[i], entry->name);
+      struct Email *e = mutt_hash_find(known, mutt_b2s(buf));
+      if (e)
+      {
+        e->active = true;
+        FREE(&entry->name);
+      }
+      else
+        scans[i].entries[kept++] = *entry;
+    }
+    mutt_debug(LL_DEBUG2, "%s: %zu of %zu files changed\n", scans[i].path, kept,
+               scans[i].num_entries);
+    scans[i].num_entries = kept;
+
+    maildir_parse_scan(m, &last, subdirs[i], &scans[i], &count, NULL);
+    maildir_scan_free(&scans[i]);
+  }
+  mutt_hash_free(&known);
 
   /* we create a hash table keyed off the canonical (sans flags) filename
    * of each message we scanned.  This is used in the loop over the
@@ -445,7 +555,10 @@ int maildir_mbox_check(struct Mailbox *m, int *index_hint)
   {
     struct Email *e = m->emails[i];
 
-    e->active = false;
+    /* the file is still there, under the same name */
+    if (e->active)
+      continue;
+
     maildir_canon_filename(buf, e->path);
     p = mutt_hash_find(fnames, mutt_b2s(buf));
     if (p && p->email)
@@ -480,8 +593,8 @@ int maildir_mbox_check(struct Mailbox *m, int *index_hint)
     /* This message was not in the list of messages we just scanned.
      * Check to see if we have enough information to know if the
      * message has disappeared out from underneath us.  */
-    else if (((changed & MMC_NEW_DIR) && (strncmp(e->path, "new/", 4) == 0)) ||
-             ((changed & MMC_CUR_DIR) && (strncmp(e->path, "cur/", 4) == 0)))
+    else if (((scanned & MMC_NEW_DIR) && (strncmp(e->path, "new/", 4) == 0)) ||
+             ((scanned & MMC_CUR_DIR) && (strncmp(e->path, "cur/", 4) == 0)))
     {
       /* This message disappeared, so we need to simulate a "reopen"
        * event.  We know it disappeared because we just scanned the
@@ -505,7 +618,7 @@ int maildir_mbox_check(struct Mailbox *m, int *index_hint)
     mutt_mailbox_changed(m, MBN_RESORT);
 
   /* do any delayed parsing we need to do. */
-  maildir_delayed_parsing(m, &md, NULL);
+  maildir_delayed_parsing(m, &md, NULL, NULL);
 
   /* Incorporate new messages */
   num_new = maildir_move_to_mailbox(m, &md);
@@ -515,6 +628,9 @@ int maildir_mbox_check(struct Mailbox *m, int *index_hint)
     m->changed = true;
   }
 
+#ifdef USE_INOTIFY
+  mutt_list_free(&added);
+#endif
   mutt_buffer_pool_release(&buf);
 
   if (occult)
@@ -524,6 +640,13 @@ int maildir_mbox_check(struct Mailbox *m, int *index_hint)
   if (flags_changed)
     return MUTT_FLAGS;
   return 0;
+
+fail:
+#ifdef USE_INOTIFY
+  mutt_list_free(&added);
+#endif
+  mutt_buffer_pool_release(&buf);
+  return -1;
 }
 
 /**
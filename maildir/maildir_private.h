@@ -60,6 +60,32 @@ struct Maildir
   struct Maildir *next;
 };
 
+/**
+ * struct MaildirScanEntry - A message file found in a directory
+ */
+struct MaildirScanEntry
+{
+  char *name;  ///< Filename
+  ino_t inode; ///< Inode number, from readdir()
+};
+
+/**
+ * struct MaildirScan - The message files found in a Maildir/MH directory
+ */
+struct MaildirScan
+{
+  char *path;                       ///< Directory that was read
+  const char *subdir;               ///< Subdirectory, e.g. 'new', or NULL for MH
+  enum MailboxType magic;           ///< Mailbox type, e.g. #MUTT_MAILDIR
+  struct MaildirScanEntry *entries; ///< Message files
+  size_t num_entries;               ///< Number of message files
+  size_t max_entries;               ///< Size of the entries array
+  int skipped;                      ///< Subdirectories skipped without a stat()
+  int rc;                           ///< 0 on success, -1 if the directory couldn't be read
+  struct timespec mtime;            ///< Modification time of the directory before reading it
+  bool cached;                      ///< Filenames came from the header cache
+};
+
 typedef uint8_t MhSeqFlags;     ///< Flags, e.g. #MH_SEQ_UNSEEN
 #define MH_SEQ_NO_FLAGS         ///< No flags are set
 #define MH_SEQ_UNSEEN  (1 << 0) ///< Email hasn't been read
@@ -90,19 +116,24 @@ int             mh_msg_save_hcache (struct Mailbox *m, struct Email *e);
 
 /* Maildir/MH shared functions */
 void                    maildir_canon_filename (struct Buffer *dest, const char *src);
-void                    maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Progress *progress);
+void                    maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct MaildirScan *scan, struct Progress *progress);
 size_t                  maildir_hcache_keylen  (const char *fn);
 struct MaildirMboxData *maildir_mdata_get      (struct Mailbox *m);
 int                     maildir_mh_open_message(struct Mailbox *m, struct Message *msg, int msgno, bool is_maildir);
 int                     maildir_move_to_mailbox(struct Mailbox *m, struct Maildir **ptr);
 int                     maildir_parse_dir      (struct Mailbox *m, struct Maildir ***last, const char *subdir, int *count, struct Progress *progress);
+int                     maildir_parse_scan     (struct Mailbox *m, struct Maildir ***last, const char *subdir, struct MaildirScan *scan, int *count, struct Progress *progress);
 void                    maildir_parse_flags    (struct Email *e, const char *path);
 struct Email *          maildir_parse_message  (enum MailboxType magic, const char *fname, bool is_old, struct Email *e);
+void                    maildir_scan_dirs      (struct Mailbox *m, const char **subdirs, struct MaildirScan *scans, int num, bool use_hc);
+void                    maildir_scan_free      (struct MaildirScan *scan);
+struct Maildir *        maildir_sort_inode     (struct Maildir *list);
+struct Maildir *        maildir_sort_path      (struct Maildir *list);
 void                    maildir_update_tables  (struct Context *ctx, int *index_hint);
 int                     md_commit_message      (struct Mailbox *m, struct Message *msg, struct Email *e);
 int                     mh_commit_msg          (struct Mailbox *m, struct Message *msg, struct Email *e, bool updseq);
 int                     mh_mkstemp             (struct Mailbox *m, FILE **fp, char **tgt);
-int                     mh_read_dir            (struct Mailbox *m, const char *subdir);
+int                     mh_read_dir            (struct Mailbox *m, const char *subdir, struct MaildirScan *scan);
 int                     mh_read_sequences      (struct MhSequences *mhs, const char *path);
 MhSeqFlags              mhs_check              (struct MhSequences *mhs, int i);
 void                    mhs_free_sequences     (struct MhSequences *mhs);
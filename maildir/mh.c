@@ -543,7 +543,7 @@ int mh_sync_message(struct Mailbox *m, int msgno)
  */
 static int mh_mbox_open(struct Mailbox *m)
 {
-  return mh_read_dir(m, NULL);
+  return mh_read_dir(m, NULL, NULL);
 }
 
 /**
@@ -661,7 +661,7 @@ int mh_mbox_check(struct Mailbox *m, int *index_hint)
   last = &md;
 
   maildir_parse_dir(m, &last, NULL, &count, NULL);
-  maildir_delayed_parsing(m, &md, NULL);
+  maildir_delayed_parsing(m, &md, NULL, NULL);
 
   if (mh_read_sequences(&mhs, mutt_b2s(m->pathbuf)) < 0)
     return -1;
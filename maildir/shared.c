@@ -36,11 +36,17 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#ifdef HAVE_SYS_VFS_H
+#include <sys/vfs.h>
+#endif
 #include <time.h>
 #include <unistd.h>
 #include <utime.h>
@@ -70,12 +76,48 @@ struct Account;
 /* These Config Variables are only used in maildir/mh.c */
 bool C_CheckNew; ///< Config: (maildir,mh) Check for new mail while the mailbox is open
 bool C_MaildirHeaderCacheVerify; ///< Config: (hcache) Check for maildir changes when opening mailbox
+short C_MaildirReadThreads; ///< Config: Number of threads reading Maildir/MH messages
 bool C_MhPurge;       ///< Config: Really delete files in MH mailboxes
 char *C_MhSeqFlagged; ///< Config: MH sequence for flagged message
 char *C_MhSeqReplied; ///< Config: MH sequence to tag replied messages
 char *C_MhSeqUnseen;  ///< Config: MH sequence for unseen messages
 
-#define INS_SORT_THRESHOLD 6
+#define MD_MAX_READ_THREADS 64 ///< Upper limit for $maildir_read_threads
+#define MD_READ_AHEAD 4        ///< Messages each reader thread may open ahead
+
+/**
+ * struct MdParseJob - A Maildir/MH message whose header must be parsed
+ */
+struct MdParseJob
+{
+  struct Maildir *md; ///< Entry to fill in
+  char *path;         ///< Full path of the message file
+  int count;          ///< Position in the mailbox, for the progress bar
+  FILE *fp;           ///< Opened message file, NULL on error
+  bool ready;         ///< fp has been opened
+};
+
+/**
+ * struct MdReader - Open Maildir/MH messages ahead of the parser
+ *
+ * Reader threads open the messages, in order, and pull their headers into the
+ * page cache.  The parsing itself stays in the main thread, which consumes the
+ * messages in the same order as the serial code.
+ */
+struct MdReader
+{
+  struct MdParseJob *jobs; ///< Messages to read
+  size_t num_jobs;         ///< Number of messages
+#ifdef USE_PTHREADS
+  pthread_mutex_t lock;    ///< Protects the fields below
+  pthread_cond_t cond;     ///< Signalled when a job is opened or consumed
+  pthread_t *threads;      ///< Reader threads
+  size_t num_threads;      ///< Number of reader threads
+  size_t next;             ///< Next job to be opened
+  size_t done;             ///< Jobs consumed by the parser
+  size_t window;           ///< Maximum number of jobs opened ahead
+#endif
+};
 
 /**
  * maildir_mdata_free - Free data attached to the Mailbox
@@ -323,57 +365,351 @@ static void maildir_update_mtime(struct Mailbox *m)
 }
 
 /**
- * maildir_parse_dir - Read a Maildir mailbox
+ * scan_dir - Read the filenames of a Maildir/MH directory
+ * @param scan Scan to fill in; scan->path and scan->magic must be set
+ *
+ * This only reads the directory.  It doesn't touch any shared state, so it
+ * may be run in a separate thread.
+ */
+static void scan_dir(struct MaildirScan *scan)
+{
+  struct dirent *de = NULL;
+
+  DIR *dirp = opendir(scan->path);
+  if (!dirp)
+  {
+    scan->rc = -1;
+    return;
+  }
+
+  while (((de = readdir(dirp))) && (SigInt != 1))
+  {
+    if (((scan->magic == MUTT_MH) && !mh_valid_message(de->d_name)) ||
+        ((scan->magic == MUTT_MAILDIR) && (*de->d_name == '.')))
+    {
+      continue;
+    }
+
+#ifdef DT_DIR
+    /* readdir() tells most filesystems' file types for free */
+    if (de->d_type == DT_DIR)
+    {
+      scan->skipped++;
+      continue;
+    }
+#endif
+
+    if (scan->num_entries >= scan->max_entries)
+    {
+      scan->max_entries += 256;
+      mutt_mem_realloc(&scan->entries, scan->max_entries * sizeof(struct MaildirScanEntry));
+    }
+
+    struct MaildirScanEntry *entry = &scan->entries[scan->num_entries++];
+    entry->name = mutt_str_strdup(de->d_name);
+    entry->inode = de->d_ino;
+  }
+
+  closedir(dirp);
+}
+
+#ifdef USE_PTHREADS
+/**
+ * scan_dir_thread - Read a directory in a separate thread
+ * @param arg Scan to fill in
+ * @retval NULL Always
+ */
+static void *scan_dir_thread(void *arg)
+{
+  scan_dir(arg);
+  return NULL;
+}
+#endif
+
+#ifdef USE_HCACHE
+/**
+ * struct MdDirStamp - A Maildir/MH directory's record in the header cache
+ *
+ * It's followed by num entries, each an ino_t and a NUL-terminated filename.
+ * It's only saved once every message of the directory is in the header cache,
+ * so while the directory's mtime matches, the cached headers are still good.
+ */
+struct MdDirStamp
+{
+  struct timespec mtime; ///< Modification time of the directory
+  size_t num;            ///< Number of entries
+  size_t size;           ///< Size of the entries, in bytes
+};
+
+/**
+ * dir_stamp_key - Get the header cache key of a directory's record
+ * @param subdir Subdirectory, e.g. 'new', or NULL for MH
+ * @param buf    Buffer for the key
+ */
+static void dir_stamp_key(const char *subdir, struct Buffer *buf)
+{
+  /* Filenames can't contain '/', so this can't clash with a message */
+  if (subdir)
+    mutt_buffer_printf(buf, "/MTIME/%s", subdir);
+  else
+    mutt_buffer_strcpy(buf, "/MTIME");
+}
+
+/**
+ * dir_stamp_fetch - Read a directory's filenames from the header cache
+ * @param hc   Header cache handle
+ * @param scan Scan to fill in; scan->subdir and scan->mtime must be set
+ * @retval true The record matches the directory and was used
+ */
+static bool dir_stamp_fetch(header_cache_t *hc, struct MaildirScan *scan)
+{
+  struct Buffer *buf = mutt_buffer_pool_get();
+  dir_stamp_key(scan->subdir, buf);
+  size_t dlen = 0;
+  unsigned char *data = mutt_hcache_fetch_raw(hc, mutt_b2s(buf), mutt_buffer_len(buf), &dlen);
+  mutt_buffer_pool_release(&buf);
+  if (!data)
+    return false;
+
+  bool rc = false;
+  struct MdDirStamp hdr;
+  if (dlen < sizeof(hdr))
+    goto done;
+
+  /* The backend's data may not be aligned */
+  memcpy(&hdr, data, sizeof(hdr));
+
+  if ((hdr.mtime.tv_sec == 0) || (mutt_file_timespec_compare(&hdr.mtime, &scan->mtime) != 0))
+    goto done;
+
+  /* Each entry takes at least an inode and a NUL */
+  if ((hdr.size != (dlen - sizeof(hdr))) || (hdr.num > (hdr.size / (sizeof(ino_t) + 1))))
+    goto done;
+
+  const unsigned char *d = data + sizeof(hdr);
+  const unsigned char *end = d + hdr.size;
+  scan->entries = mutt_mem_calloc(MAX(hdr.num, 1), sizeof(struct MaildirScanEntry));
+  scan->max_entries = MAX(hdr.num, 1);
+  for (size_t i = 0; i < hdr.num; i++)
+  {
+    struct MaildirScanEntry *entry = &scan->entries[i];
+    if ((end - d) <= sizeof(ino_t))
+      goto done;
+    memcpy(&entry->inode, d, sizeof(ino_t));
+    d += sizeof(ino_t);
+
+    const unsigned char *nul = memchr(d, '\0', end - d);
+    if (!nul)
+      goto done;
+    entry->name = mutt_str_substr_dup((const char *) d, (const char *) nul);
+    scan->num_entries++;
+    d = nul + 1;
+  }
+  rc = true;
+
+done:
+  if (!rc)
+  {
+    for (size_t i = 0; i < scan->num_entries; i++)
+      FREE(&scan->entries[i].name);
+    FREE(&scan->entries);
+    scan->num_entries = 0;
+    scan->max_entries = 0;
+  }
+  mutt_hcache_free(hc, (void **) &data);
+  return rc;
+}
+
+/**
+ * dir_stamp_store - Save a directory's filenames in the header cache
+ * @param hc   Header cache handle
+ * @param scan Filenames read from the directory
+ *
+ * This is called once every message of the directory is in the header cache.
+ */
+static void dir_stamp_store(header_cache_t *hc, struct MaildirScan *scan)
+{
+  /* If the directory changed within the last couple of seconds, a
+   * coarse-grained mtime might not tell it apart from a later change. */
+  if ((scan->rc != 0) || (scan->mtime.tv_sec == 0) ||
+      (scan->mtime.tv_sec >= (time(NULL) - 1)))
+  {
+    return;
+  }
+
+  struct MdDirStamp hdr = { 0 };
+  hdr.mtime = scan->mtime;
+  hdr.num = scan->num_entries;
+  for (size_t i = 0; i < scan->num_entries; i++)
+    hdr.size += sizeof(ino_t) + strlen(scan->entries[i].name) + 1;
+
+  unsigned char *data = mutt_mem_malloc(sizeof(hdr) + hdr.size);
+  unsigned char *d = data;
+  memcpy(d, &hdr, sizeof(hdr));
+  d += sizeof(hdr);
+  for (size_t i = 0; i < scan->num_entries; i++)
+  {
+    memcpy(d, &scan->entries[i].inode, sizeof(ino_t));
+    d += sizeof(ino_t);
+    size_t len = strlen(scan->entries[i].name) + 1;
+    memcpy(d, scan->entries[i].name, len);
+    d += len;
+  }
+
+  struct Buffer *buf = mutt_buffer_pool_get();
+  dir_stamp_key(scan->subdir, buf);
+  mutt_hcache_store_raw(hc, mutt_b2s(buf), mutt_buffer_len(buf), data, sizeof(hdr) + hdr.size);
+  mutt_buffer_pool_release(&buf);
+  FREE(&data);
+}
+#endif
+
+/**
+ * maildir_scan_dirs - Read the filenames of several Maildir/MH directories
+ * @param[in]  m       Mailbox
+ * @param[in]  subdirs Subdirectories, e.g. 'new', or NULL entries for the mailbox itself
+ * @param[out] scans   Results, one for each subdir
+ * @param[in]  num     Number of subdirs
+ * @param[in]  use_hc  Take an unchanged directory's filenames from the header cache
+ *
+ * The directories are read concurrently, if threads are available.
+ * The results must be freed with maildir_scan_free().
+ */
+void maildir_scan_dirs(struct Mailbox *m, const char **subdirs,
+                       struct MaildirScan *scans, int num, bool use_hc)
+{
+  struct Buffer *buf = mutt_buffer_pool_get();
+
+  for (int i = 0; i < num; i++)
+  {
+    memset(&scans[i], 0, sizeof(struct MaildirScan));
+    if (subdirs[i])
+      mutt_buffer_printf(buf, "%s/%s", mutt_b2s(m->pathbuf), subdirs[i]);
+    else
+      mutt_buffer_strcpy(buf, mutt_b2s(m->pathbuf));
+    scans[i].path = mutt_str_strdup(mutt_b2s(buf));
+    scans[i].subdir = subdirs[i];
+    scans[i].magic = m->magic;
+
+    struct stat st;
+    if (stat(scans[i].path, &st) == 0)
+      mutt_file_get_stat_timespec(&scans[i].mtime, &st, MUTT_STAT_MTIME);
+  }
+  mutt_buffer_pool_release(&buf);
+
+#ifdef USE_HCACHE
+  /* An unchanged directory needn't be read again */
+  header_cache_t *hc = NULL;
+  for (int i = 0; use_hc && (i < num); i++)
+  {
+    if (scans[i].mtime.tv_sec == 0)
+      continue;
+    if (!hc)
+      hc = mutt_hcache_open(C_HeaderCache, mutt_b2s(m->pathbuf), NULL);
+    scans[i].cached = dir_stamp_fetch(hc, &scans[i]);
+    if (scans[i].cached)
+      mutt_debug(LL_DEBUG2, "%s: unchanged, using %zu cached filenames\n",
+                 scans[i].path, scans[i].num_entries);
+  }
+  mutt_hcache_close(hc);
+#endif
+
+#ifdef USE_PTHREADS
+  /* Read the first directory in this thread and the others alongside it */
+  pthread_t *threads = mutt_mem_calloc(num, sizeof(pthread_t));
+  bool *started = mutt_mem_calloc(num, sizeof(bool));
+  int first = -1;
+  for (int i = 0; i < num; i++)
+  {
+    if (scans[i].cached)
+      continue;
+    if (first < 0)
+      first = i;
+    else
+      started[i] = (pthread_create(&threads[i], NULL, scan_dir_thread, &scans[i]) == 0);
+  }
+
+  if (first >= 0)
+    scan_dir(&scans[first]);
+
+  for (int i = 0; i < num; i++)
+  {
+    if (started[i])
+      pthread_join(threads[i], NULL);
+    else if (!scans[i].cached && (i != first))
+      scan_dir(&scans[i]);
+  }
+
+  FREE(&threads);
+  FREE(&started);
+#else
+  for (int i = 0; i < num; i++)
+  {
+    if (!scans[i].cached)
+      scan_dir(&scans[i]);
+  }
+#endif
+
+}
+
+/**
+ * maildir_scan_free - Free the results of a directory scan
+ * @param scan Scan to free
+ */
+void maildir_scan_free(struct MaildirScan *scan)
+{
+  if (!scan)
+    return;
+
+  for (size_t i = 0; i < scan->num_entries; i++)
+    FREE(&scan->entries[i].name);
+  FREE(&scan->entries);
+  FREE(&scan->path);
+  scan->num_entries = 0;
+  scan->max_entries = 0;
+}
+
+/**
+ * maildir_parse_scan - Create Maildir entries for the files of a directory
  * @param[in]  m        Mailbox
  * @param[out] last     Last Maildir
  * @param[in]  subdir   Subdirectory, e.g. 'new'
+ * @param[in]  scan     Filenames read by maildir_scan_dirs()
  * @param[out] count    Counter for the progress bar
  * @param[in]  progress Progress bar
  * @retval  0 Success
  * @retval -1 Error
  * @retval -2 Aborted
  */
-int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
-                      const char *subdir, int *count, struct Progress *progress)
+int maildir_parse_scan(struct Mailbox *m, struct Maildir ***last, const char *subdir,
+                       struct MaildirScan *scan, int *count, struct Progress *progress)
 {
-  struct dirent *de = NULL;
-  int rc = 0;
+  if (scan->rc < 0)
+    return -1;
+
   bool is_old = false;
   struct Maildir *entry = NULL;
   struct Email *e = NULL;
 
-  struct Buffer *buf = mutt_buffer_pool_get();
-
   if (subdir)
-  {
-    mutt_buffer_printf(buf, "%s/%s", mutt_b2s(m->pathbuf), subdir);
     is_old = C_MarkOld ? (mutt_str_strcmp("cur", subdir) == 0) : false;
-  }
-  else
-    mutt_buffer_strcpy(buf, mutt_b2s(m->pathbuf));
 
-  DIR *dirp = opendir(mutt_b2s(buf));
-  if (!dirp)
-  {
-    rc = -1;
-    goto cleanup;
-  }
+  if (scan->skipped > 0)
+    mutt_debug(LL_DEBUG2, "%s: skipped %d directories\n", scan->path, scan->skipped);
 
-  while (((de = readdir(dirp))) && (SigInt != 1))
+  struct Buffer *buf = mutt_buffer_pool_get();
+
+  for (size_t i = 0; (i < scan->num_entries) && (SigInt != 1); i++)
   {
-    if (((m->magic == MUTT_MH) && !mh_valid_message(de->d_name)) ||
-        ((m->magic == MUTT_MAILDIR) && (*de->d_name == '.')))
-    {
-      continue;
-    }
+    const char *name = scan->entries[i].name;
 
     /* FOO - really ignore the return value? */
-    mutt_debug(LL_DEBUG2, "queueing %s\n", de->d_name);
+    mutt_debug(LL_DEBUG2, "queueing %s\n", name);
 
     e = mutt_email_new();
     e->old = is_old;
     if (m->magic == MUTT_MAILDIR)
-      maildir_parse_flags(e, de->d_name);
+      maildir_parse_flags(e, name);
 
     if (count)
     {
@@ -384,20 +720,20 @@ int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
 
     if (subdir)
     {
-      mutt_buffer_printf(buf, "%s/%s", subdir, de->d_name);
+      mutt_buffer_printf(buf, "%s/%s", subdir, name);
       e->path = mutt_str_strdup(mutt_b2s(buf));
     }
     else
-      e->path = mutt_str_strdup(de->d_name);
+      e->path = mutt_str_strdup(name);
 
     entry = mutt_mem_calloc(1, sizeof(struct Maildir));
     entry->email = e;
-    entry->inode = de->d_ino;
+    entry->inode = scan->entries[i].inode;
     **last = entry;
     *last = &entry->next;
   }
 
-  closedir(dirp);
+  mutt_buffer_pool_release(&buf);
 
   if (SigInt == 1)
   {
@@ -405,8 +741,28 @@ int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
     return -2; /* action aborted */
   }
 
-cleanup:
-  mutt_buffer_pool_release(&buf);
+  return 0;
+}
+
+/**
+ * maildir_parse_dir - Read a Maildir mailbox
+ * @param[in]  m        Mailbox
+ * @param[out] last     Last Maildir
+ * @param[in]  subdir   Subdirectory, e.g. 'new'
+ * @param[out] count    Counter for the progress bar
+ * @param[in]  progress Progress bar
+ * @retval  0 Success
+ * @retval -1 Error
+ * @retval -2 Aborted
+ */
+int maildir_parse_dir(struct Mailbox *m, struct Maildir ***last,
+                      const char *subdir, int *count, struct Progress *progress)
+{
+  struct MaildirScan scan;
+
+  maildir_scan_dirs(m, &subdir, &scan, 1, false);
+  int rc = maildir_parse_scan(m, last, subdir, &scan, count, progress);
+  maildir_scan_free(&scan);
 
   return rc;
 }
@@ -478,222 +834,269 @@ size_t maildir_hcache_keylen(const char *fn)
 }
 
 /**
- * md_cmp_inode - Compare two Maildirs by inode number
- * @param a First  Maildir
- * @param b Second Maildir
- * @retval -1 a precedes b
- * @retval  0 a and b are identical
- * @retval  1 b precedes a
+ * mh_sort_natural - Sort a Maildir list into its natural order
+ * @param[in]  m  Mailbox
+ * @param[out] md Maildir list to sort
+ *
+ * Currently only defined for MH where files are numbered.
  */
-static int md_cmp_inode(struct Maildir *a, struct Maildir *b)
+static void mh_sort_natural(struct Mailbox *m, struct Maildir **md)
 {
-  return a->inode - b->inode;
+  if (!m || !md || !*md || (m->magic != MUTT_MH) || (C_Sort != SORT_ORDER))
+    return;
+  mutt_debug(LL_DEBUG3, "maildir: sorting %s into natural order\n", mutt_b2s(m->pathbuf));
+  *md = maildir_sort_path(*md);
 }
 
 /**
- * md_cmp_path - Compare two Maildirs by path
- * @param a First  Maildir
- * @param b Second Maildir
- * @retval -1 a precedes b
- * @retval  0 a and b are identical
- * @retval  1 b precedes a
+ * skip_duplicates - Find the first non-duplicate message
+ * @param[in]  p    Maildir to start
+ * @param[out] last Previous Maildir
+ * @retval ptr Next Maildir
  */
-static int md_cmp_path(struct Maildir *a, struct Maildir *b)
+static struct Maildir *skip_duplicates(struct Maildir *p, struct Maildir **last)
 {
-  return strcmp(a->email->path, b->email->path);
+  /* Skip ahead to the next non-duplicate message.
+   *
+   * p should never reach NULL, because we couldn't have reached this point
+   * unless there was a message that needed to be parsed.
+   *
+   * The check for p->header_parsed is likely unnecessary since the dupes will
+   * most likely be at the head of the list.  but it is present for consistency
+   * with the check at the top of the for() loop in maildir_delayed_parsing().
+   */
+  while (!p->email || p->header_parsed)
+  {
+    *last = p;
+    p = p->next;
+  }
+  return p;
 }
 
+#ifdef USE_PTHREADS
 /**
- * maildir_merge_lists - Merge two maildir lists
- * @param left    First  Maildir to merge
- * @param right   Second Maildir to merge
- * @param cmp     Comparison function for sorting
- * @retval ptr Merged Maildir
+ * md_read_ahead - Open a message and read its header into the page cache
+ * @param path Path of the message file
+ * @retval ptr  File handle, rewound to the start
+ * @retval NULL Error
  */
-static struct Maildir *maildir_merge_lists(struct Maildir *left, struct Maildir *right,
-                                           int (*cmp)(struct Maildir *, struct Maildir *))
+static FILE *md_read_ahead(const char *path)
 {
-  struct Maildir *head = NULL;
-  struct Maildir *tail = NULL;
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return NULL;
 
-  if (left && right)
+  char buf[1024];
+  while (fgets(buf, sizeof(buf), fp))
   {
-    if (cmp(left, right) < 0)
-    {
-      head = left;
-      left = left->next;
-    }
-    else
-    {
-      head = right;
-      right = right->next;
-    }
-  }
-  else
-  {
-    if (left)
-      return left;
-    else
-      return right;
+    if ((buf[0] == '\n') || ((buf[0] == '\r') && (buf[1] == '\n')))
+      break;
   }
+  rewind(fp);
+  return fp;
+}
 
-  tail = head;
+/**
+ * md_reader_thread - Open messages until there are none left
+ * @param arg Reader
+ * @retval NULL Always
+ */
+static void *md_reader_thread(void *arg)
+{
+  struct MdReader *r = arg;
 
-  while (left && right)
+  pthread_mutex_lock(&r->lock);
+  while (true)
   {
-    if (cmp(left, right) < 0)
-    {
-      tail->next = left;
-      left = left->next;
-    }
-    else
-    {
-      tail->next = right;
-      right = right->next;
-    }
-    tail = tail->next;
-  }
+    while ((r->next < r->num_jobs) && ((r->next - r->done) >= r->window))
+      pthread_cond_wait(&r->cond, &r->lock);
+    if (r->next >= r->num_jobs)
+      break;
 
-  if (left)
-  {
-    tail->next = left;
-  }
-  else
-  {
-    tail->next = right;
-  }
+    struct MdParseJob *job = &r->jobs[r->next++];
+    pthread_mutex_unlock(&r->lock);
+    FILE *fp = md_read_ahead(job->path);
+    pthread_mutex_lock(&r->lock);
 
-  return head;
+    job->fp = fp;
+    job->ready = true;
+    pthread_cond_broadcast(&r->cond);
+  }
+  pthread_mutex_unlock(&r->lock);
+  return NULL;
 }
 
 /**
- * maildir_ins_sort - Sort maildirs using an insertion sort
- * @param list    Maildir list to sort
- * @param cmp     Comparison function for sorting
- * @retval ptr Sort Maildir list
+ * md_is_remote - Is a directory on a network filesystem?
+ * @param path Directory
+ * @retval true The filesystem is remote, or its type can't be told
+ *
+ * On a local filesystem, opening a message costs far less than the locking
+ * and context switches of handing it to another thread.
  */
-static struct Maildir *maildir_ins_sort(struct Maildir *list,
-                                        int (*cmp)(struct Maildir *, struct Maildir *))
+static bool md_is_remote(const char *path)
 {
-  struct Maildir *tmp = NULL, *last = NULL, *back = NULL;
-
-  struct Maildir *ret = list;
-  list = list->next;
-  ret->next = NULL;
+#ifdef HAVE_SYS_VFS_H
+  struct statfs sfs;
+  if (statfs(path, &sfs) != 0)
+    return true;
 
-  while (list)
+  switch ((unsigned long) sfs.f_type)
   {
-    last = NULL;
-    back = list->next;
-    for (tmp = ret; tmp && cmp(tmp, list) <= 0; tmp = tmp->next)
-      last = tmp;
-
-    list->next = tmp;
-    if (last)
-      last->next = list;
-    else
-      ret = list;
-
-    list = back;
+    case 0x6969:     /* NFS */
+    case 0x517b:     /* SMB */
+    case 0xfe534d42: /* SMB2 */
+    case 0xff534d42: /* CIFS */
+    case 0x65735546: /* FUSE, e.g. sshfs */
+    case 0x00c36400: /* Ceph */
+    case 0x01021997: /* 9P */
+    case 0x0bd00bd0: /* Lustre */
+    case 0x01161970: /* GFS2 */
+    case 0x5346414f: /* AFS */
+    case 0x6b414653: /* kAFS */
+    case 0x73757245: /* Coda */
+    case 0x7461636f: /* OCFS2 */
+      return true;
+    default:
+      return false;
   }
-
-  return ret;
+#else
+  return true;
+#endif
 }
+#endif
 
 /**
- * maildir_sort - Sort Maildir list
- * @param list    Maildirs to sort
- * @param len     Number of Maildirs in the list
- * @param cmp     Comparison function for sorting
- * @retval ptr Sort Maildir list
+ * md_reader_start - Start reading messages in the background
+ * @param r    Reader
+ * @param path Mailbox directory
+ *
+ * If $maildir_read_threads is 0, the Mailbox is on a local filesystem, or
+ * threads aren't available, the messages will be opened by md_reader_get()
+ * instead.
  */
-static struct Maildir *maildir_sort(struct Maildir *list, size_t len,
-                                    int (*cmp)(struct Maildir *, struct Maildir *))
+static void md_reader_start(struct MdReader *r, const char *path)
 {
-  struct Maildir *left = list;
-  struct Maildir *right = list;
-  size_t c = 0;
+#ifdef USE_PTHREADS
+  r->num_threads = 0;
+  r->next = 0;
+  r->done = 0;
+
+  size_t num = MIN((size_t) C_MaildirReadThreads, MD_MAX_READ_THREADS);
+  num = MIN(num, r->num_jobs);
+  if (num < 2)
+    return;
 
-  if (!list || !list->next)
+  /* The threads hide I/O latency; there's none to hide on a local disk */
+  if (!md_is_remote(path))
   {
-    return list;
+    mutt_debug(LL_DEBUG2, "%s is local, reading messages one by one\n", path);
+    return;
   }
 
-  if ((len != (size_t)(-1)) && (len <= INS_SORT_THRESHOLD))
-    return maildir_ins_sort(list, cmp);
-
-  list = list->next;
-  while (list && list->next)
+  pthread_mutex_init(&r->lock, NULL);
+  pthread_cond_init(&r->cond, NULL);
+  r->window = num * MD_READ_AHEAD;
+  r->threads = mutt_mem_calloc(num, sizeof(pthread_t));
+  for (; r->num_threads < num; r->num_threads++)
   {
-    right = right->next;
-    list = list->next->next;
-    c++;
+    if (pthread_create(&r->threads[r->num_threads], NULL, md_reader_thread, r) != 0)
+      break;
   }
 
-  list = right;
-  right = right->next;
-  list->next = 0;
-
-  left = maildir_sort(left, c, cmp);
-  right = maildir_sort(right, c, cmp);
-  return maildir_merge_lists(left, right, cmp);
+  mutt_debug(LL_DEBUG2, "started %zu of %zu reader threads\n", r->num_threads, num);
+  if (r->num_threads == 0)
+  {
+    FREE(&r->threads);
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+  }
+#endif
 }
 
 /**
- * mh_sort_natural - Sort a Maildir list into its natural order
- * @param[in]  m  Mailbox
- * @param[out] md Maildir list to sort
+ * md_reader_get - Get the file handle of a message
+ * @param r Reader
+ * @param i Index of the job
+ * @retval ptr  Opened message, owned by the caller
+ * @retval NULL Error
  *
- * Currently only defined for MH where files are numbered.
+ * Jobs must be collected in order.
  */
-static void mh_sort_natural(struct Mailbox *m, struct Maildir **md)
+static FILE *md_reader_get(struct MdReader *r, size_t i)
 {
-  if (!m || !md || !*md || (m->magic != MUTT_MH) || (C_Sort != SORT_ORDER))
-    return;
-  mutt_debug(LL_DEBUG3, "maildir: sorting %s into natural order\n", mutt_b2s(m->pathbuf));
-  *md = maildir_sort(*md, (size_t) -1, md_cmp_path);
+  struct MdParseJob *job = &r->jobs[i];
+
+#ifdef USE_PTHREADS
+  if (r->num_threads > 0)
+  {
+    pthread_mutex_lock(&r->lock);
+    while (!job->ready)
+      pthread_cond_wait(&r->cond, &r->lock);
+    r->done = i + 1;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+
+    FILE *fp = job->fp;
+    job->fp = NULL;
+    return fp;
+  }
+#endif
+
+  return fopen(job->path, "r");
 }
 
 /**
- * skip_duplicates - Find the first non-duplicate message
- * @param[in]  p    Maildir to start
- * @param[out] last Previous Maildir
- * @retval ptr Next Maildir
+ * md_reader_stop - Wait for the reader threads to finish
+ * @param r Reader
  */
-static struct Maildir *skip_duplicates(struct Maildir *p, struct Maildir **last)
+static void md_reader_stop(struct MdReader *r)
 {
-  /* Skip ahead to the next non-duplicate message.
-   *
-   * p should never reach NULL, because we couldn't have reached this point
-   * unless there was a message that needed to be parsed.
-   *
-   * The check for p->header_parsed is likely unnecessary since the dupes will
-   * most likely be at the head of the list.  but it is present for consistency
-   * with the check at the top of the for() loop in maildir_delayed_parsing().
-   */
-  while (!p->email || p->header_parsed)
-  {
-    *last = p;
-    p = p->next;
-  }
-  return p;
+#ifdef USE_PTHREADS
+  if (r->num_threads == 0)
+    return;
+
+  for (size_t i = 0; i < r->num_threads; i++)
+    pthread_join(r->threads[i], NULL);
+
+  FREE(&r->threads);
+  pthread_cond_destroy(&r->cond);
+  pthread_mutex_destroy(&r->lock);
+  r->num_threads = 0;
+#endif
 }
 
 /**
  * maildir_delayed_parsing - This function does the second parsing pass
- * @param[in]  m  Mailbox
- * @param[out] md Maildir to parse
+ * @param[in]  m        Mailbox
+ * @param[out] md       Maildir to parse
+ * @param[in]  scan     Directory the messages were read from (OPTIONAL)
  * @param[in]  progress Progress bar
+ *
+ * If the whole of a directory is being read, its scan is saved in the header
+ * cache, once all of its messages are there.
  */
-void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Progress *progress)
+void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md,
+                             struct MaildirScan *scan, struct Progress *progress)
 {
   struct Maildir *p = NULL, *last = NULL;
   char fn[PATH_MAX];
   int count;
   bool sort = false;
+  struct MdReader r = { 0 };
+  size_t jobs_max = 0;
 
 #ifdef USE_HCACHE
-  header_cache_t *hc = mutt_hcache_open(C_HeaderCache, mutt_b2s(m->pathbuf), NULL);
+  header_cache_t *hc = NULL;
+  if (*md || scan)
+  {
+    hc = mutt_hcache_open(C_HeaderCache, mutt_b2s(m->pathbuf), NULL);
+    mutt_hcache_begin(hc);
+  }
+
+  /* If the directory hasn't changed, the cached headers are still good */
+  bool unchanged = scan && scan->cached;
+  int stats_saved = 0;
 #endif
 
   for (p = *md, count = 0; p; p = p->next, count++)
@@ -710,7 +1113,7 @@ void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Prog
     if (!sort)
     {
       mutt_debug(LL_DEBUG3, "maildir: need to sort %s by inode\n", mutt_b2s(m->pathbuf));
-      p = maildir_sort(p, (size_t) -1, md_cmp_inode);
+      p = maildir_sort_inode(p);
       if (!last)
         *md = p;
       else
@@ -727,7 +1130,10 @@ void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Prog
     int ret = 0;
     if (C_MaildirHeaderCacheVerify)
     {
-      ret = stat(fn, &lastchanged);
+      if (unchanged)
+        stats_saved++;
+      else
+        ret = stat(fn, &lastchanged);
     }
 
     const char *key = NULL;
@@ -744,12 +1150,17 @@ void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Prog
     }
     void *data = mutt_hcache_fetch(hc, key, keylen);
     struct timeval *when = data;
+    struct Email *e = NULL;
 
     if (data && !ret && (lastchanged.st_mtime <= when->tv_sec))
+      e = mutt_hcache_restore((unsigned char *) data);
+
+    if (e)
     {
-      struct Email *e = mutt_hcache_restore((unsigned char *) data);
       e->old = p->email->old;
-      e->path = mutt_str_strdup(p->email->path);
+      /* Take over the path rather than copying it */
+      e->path = p->email->path;
+      p->email->path = NULL;
       mutt_email_free(&p->email);
       p->email = e;
       if (m->magic == MUTT_MAILDIR)
@@ -758,33 +1169,71 @@ void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Prog
     else
     {
 #endif
-
-      if (maildir_parse_message(m->magic, fn, p->email->old, p->email))
+      /* Queue the message; they're all parsed, in this order, below */
+      if (r.num_jobs >= jobs_max)
       {
-        p->header_parsed = 1;
-#ifdef USE_HCACHE
-        if (m->magic == MUTT_MH)
-        {
-          key = p->email->path;
-          keylen = strlen(key);
-        }
-        else
-        {
-          key = p->email->path + 3;
-          keylen = maildir_hcache_keylen(key);
-        }
-        mutt_hcache_store(hc, key, keylen, p->email, 0);
-#endif
+        jobs_max += 256;
+        mutt_mem_realloc(&r.jobs, jobs_max * sizeof(struct MdParseJob));
       }
-      else
-        mutt_email_free(&p->email);
+      struct MdParseJob *job = &r.jobs[r.num_jobs++];
+      memset(job, 0, sizeof(*job));
+      job->md = p;
+      job->path = mutt_str_strdup(fn);
+      job->count = count;
 #ifdef USE_HCACHE
     }
     mutt_hcache_free(hc, &data);
 #endif
     last = p;
   }
+
+  md_reader_start(&r, mutt_b2s(m->pathbuf));
+  for (size_t i = 0; i < r.num_jobs; i++)
+  {
+    struct MdParseJob *job = &r.jobs[i];
+    p = job->md;
+
+    if (!m->quiet && progress)
+      mutt_progress_update(progress, job->count, -1);
+
+    FILE *fp = md_reader_get(&r, i);
+    if (fp && maildir_parse_stream(m->magic, fp, job->path, p->email->old, p->email))
+    {
+      p->header_parsed = 1;
 #ifdef USE_HCACHE
+      const char *key = NULL;
+      size_t keylen = 0;
+      if (m->magic == MUTT_MH)
+      {
+        key = p->email->path;
+        keylen = strlen(key);
+      }
+      else
+      {
+        key = p->email->path + 3;
+        keylen = maildir_hcache_keylen(key);
+      }
+      mutt_hcache_store(hc, key, keylen, p->email, 0);
+#endif
+    }
+    else
+      mutt_email_free(&p->email);
+
+    mutt_file_fclose(&fp);
+  }
+  md_reader_stop(&r);
+
+  for (size_t i = 0; i < r.num_jobs; i++)
+    FREE(&r.jobs[i].path);
+  FREE(&r.jobs);
+
+#ifdef USE_HCACHE
+  if (C_MaildirHeaderCacheVerify)
+    mutt_debug(LL_DEBUG2, "%s: %d stat() calls avoided\n", mutt_b2s(m->pathbuf), stats_saved);
+  if (scan && !scan->cached && (SigInt != 1))
+    dir_stamp_store(hc, scan);
+
+  mutt_hcache_commit(hc);
   mutt_hcache_close(hc);
 #endif
 
@@ -796,10 +1245,11 @@ void maildir_delayed_parsing(struct Mailbox *m, struct Maildir **md, struct Prog
  * @param m      Mailbox
  * @param subdir NULL for MH mailboxes,
  *               otherwise the subdir of the maildir mailbox to read from
+ * @param scan   Filenames already read by maildir_scan_dirs() (OPTIONAL)
  * @retval  0 Success
  * @retval -1 Failure
  */
-int mh_read_dir(struct Mailbox *m, const char *subdir)
+int mh_read_dir(struct Mailbox *m, const char *subdir, struct MaildirScan *scan)
 {
   if (!m)
     return -1;
@@ -826,18 +1276,31 @@ int mh_read_dir(struct Mailbox *m, const char *subdir)
 
   maildir_update_mtime(m);
 
+  struct MaildirScan local_scan;
+  if (!scan)
+  {
+    maildir_scan_dirs(m, &subdir, &local_scan, 1, true);
+    scan = &local_scan;
+  }
+
   md = NULL;
   last = &md;
   int count = 0;
-  if (maildir_parse_dir(m, &last, subdir, &count, &progress) < 0)
+  if (maildir_parse_scan(m, &last, subdir, scan, &count, &progress) < 0)
+  {
+    if (scan == &local_scan)
+      maildir_scan_free(&local_scan);
     return -1;
+  }
 
   if (!m->quiet)
   {
     snprintf(msgbuf, sizeof(msgbuf), _("Reading %s..."), mutt_b2s(m->pathbuf));
     mutt_progress_init(&progress, msgbuf, MUTT_PROGRESS_MSG, C_ReadInc, count);
   }
-  maildir_delayed_parsing(m, &md, &progress);
+  maildir_delayed_parsing(m, &md, scan, &progress);
+  if (scan == &local_scan)
+    maildir_scan_free(&local_scan);
 
   if (m->magic == MUTT_MH)
   {
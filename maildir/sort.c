@@ -0,0 +1,147 @@
+/**
+ * @file
+ * Sort Maildir/MH message lists
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page maildir_sort Sort Maildir/MH message lists
+ *
+ * Sort Maildir/MH message lists
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "maildir_private.h"
+#include "mutt/mutt.h"
+#include "email/lib.h"
+
+/**
+ * struct MdSortEntry - A Maildir and its sort key
+ *
+ * Keeping the key next to the pointer means sorting never has to follow the
+ * pointers into the list.
+ */
+struct MdSortEntry
+{
+  ino_t inode;        ///< Sort key
+  struct Maildir *md; ///< Maildir entry
+};
+
+/**
+ * md_cmp_path - Compare two Maildirs by path - Implements ::sort_t
+ */
+static int md_cmp_path(const void *a, const void *b)
+{
+  const struct Maildir *ma = *(struct Maildir const *const *) a;
+  const struct Maildir *mb = *(struct Maildir const *const *) b;
+
+  return strcmp(ma->email->path, mb->email->path);
+}
+
+/**
+ * maildir_sort_inode - Sort a Maildir list by inode number
+ * @param list Maildirs to sort
+ * @retval ptr Sorted Maildir list
+ *
+ * The list is copied into an array and sorted with an LSD radix sort, one byte
+ * at a time.  Only as many passes are made as the largest inode needs.
+ */
+struct Maildir *maildir_sort_inode(struct Maildir *list)
+{
+  if (!list || !list->next)
+    return list;
+
+  size_t num = 0;
+  for (struct Maildir *p = list; p; p = p->next)
+    num++;
+
+  struct MdSortEntry *src = mutt_mem_malloc(num * sizeof(struct MdSortEntry));
+  struct MdSortEntry *dst = mutt_mem_malloc(num * sizeof(struct MdSortEntry));
+
+  ino_t max = 0;
+  size_t i = 0;
+  for (struct Maildir *p = list; p; p = p->next, i++)
+  {
+    src[i].inode = p->inode;
+    src[i].md = p;
+    if (p->inode > max)
+      max = p->inode;
+  }
+
+  for (size_t shift = 0; (shift < (sizeof(ino_t) * 8)) && ((max >> shift) != 0); shift += 8)
+  {
+    size_t counts[256] = { 0 };
+    for (i = 0; i < num; i++)
+      counts[(src[i].inode >> shift) & 0xff]++;
+
+    size_t pos = 0;
+    for (int b = 0; b < 256; b++)
+    {
+      size_t c = counts[b];
+      counts[b] = pos;
+      pos += c;
+    }
+
+    for (i = 0; i < num; i++)
+      dst[counts[(src[i].inode >> shift) & 0xff]++] = src[i];
+
+    struct MdSortEntry *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  for (i = 0; i < (num - 1); i++)
+    src[i].md->next = src[i + 1].md;
+  src[num - 1].md->next = NULL;
+  list = src[0].md;
+
+  FREE(&src);
+  FREE(&dst);
+  return list;
+}
+
+/**
+ * maildir_sort_path - Sort a Maildir list by path
+ * @param list Maildirs to sort
+ * @retval ptr Sorted Maildir list
+ */
+struct Maildir *maildir_sort_path(struct Maildir *list)
+{
+  if (!list || !list->next)
+    return list;
+
+  size_t num = 0;
+  for (struct Maildir *p = list; p; p = p->next)
+    num++;
+
+  struct Maildir **array = mutt_mem_malloc(num * sizeof(struct Maildir *));
+  size_t i = 0;
+  for (struct Maildir *p = list; p; p = p->next)
+    array[i++] = p;
+
+  qsort(array, num, sizeof(struct Maildir *), md_cmp_path);
+
+  for (i = 0; i < (num - 1); i++)
+    array[i]->next = array[i + 1];
+  array[num - 1]->next = NULL;
+  list = array[0];
+
+  FREE(&array);
+  return list;
+}
@@ -31,12 +31,14 @@
  */
 
 #include "config.h"
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
@@ -50,6 +52,7 @@
 #include "context.h"
 #include "copy.h"
 #include "globals.h"
+#include "hcache/hcache.h"
 #include "mailbox.h"
 #include "mutt_header.h"
 #include "muttlib.h"
@@ -101,7 +104,7 @@ static struct MboxAccountData *mbox_adata_new(void)
  */
 static struct MboxAccountData *mbox_adata_get(struct Mailbox *m)
 {
-  if (!m || (m->magic != MUTT_MBOX))
+  if (!m || ((m->magic != MUTT_MBOX) && (m->magic != MUTT_MMDF)))
     return NULL;
   struct Account *a = m->account;
   if (!a)
@@ -117,7 +120,7 @@ static struct MboxAccountData *mbox_adata_get(struct Mailbox *m)
  */
 static int init_mailbox(struct Mailbox *m)
 {
-  if (!m || (m->magic != MUTT_MBOX) || !m->account)
+  if (!m || ((m->magic != MUTT_MBOX) && (m->magic != MUTT_MMDF)) || !m->account)
     return -1;
 
   if (m->account->adata)
@@ -173,6 +176,632 @@ static void mbox_unlock_mailbox(struct Mailbox *m)
   }
 }
 
+/**
+ * map_find_line - Find the next line starting with a string
+ * @param map   Mapped mailbox
+ * @param start Offset to search from; must be the start of a line
+ * @param end   Size of the mapped mailbox
+ * @param str   String to find, e.g. "From "
+ * @param len   Length of str
+ * @retval num Offset of the line
+ * @retval end Not found
+ *
+ * memchr() is used to skip to the first character of str.  Picking a
+ * character that's rare in the text ('F', '\001') lets it cover most of the
+ * file in large vectorised steps, rather than stopping on every line.
+ */
+static LOFF_T map_find_line(const char *map, LOFF_T start, LOFF_T end,
+                            const char *str, size_t len)
+{
+  const char *p = map + start;
+  const char *stop = map + end;
+
+  while (p < stop)
+  {
+    p = memchr(p, str[0], stop - p);
+    if (!p)
+      break;
+    if (((p == (map + start)) || (p[-1] == '\n')) &&
+        ((size_t)(stop - p) >= len) && (memcmp(p, str, len) == 0))
+    {
+      return p - map;
+    }
+    p++;
+  }
+
+  return end;
+}
+
+/**
+ * map_line_is - Does a line of the mailbox start with a string?
+ * @param map  Mapped mailbox
+ * @param pos  Offset of the line
+ * @param end  Size of the mapped mailbox
+ * @param str  String to match, e.g. "From "
+ * @param len  Length of str
+ * @retval true The line matches
+ */
+static bool map_line_is(const char *map, LOFF_T pos, LOFF_T end, const char *str, size_t len)
+{
+  return ((end - pos) >= (LOFF_T) len) && (memcmp(map + pos, str, len) == 0);
+}
+
+/**
+ * map_copy_line - Copy a line of the mailbox, like fgets()
+ * @param map    Mapped mailbox
+ * @param pos    Offset of the line
+ * @param end    Size of the mapped mailbox
+ * @param buf    Buffer for the line
+ * @param buflen Length of the buffer
+ * @retval num Offset of the next line
+ */
+static LOFF_T map_copy_line(const char *map, LOFF_T pos, LOFF_T end, char *buf, size_t buflen)
+{
+  size_t len = MIN((size_t)(end - pos), buflen - 1);
+  const char *nl = memchr(map + pos, '\n', len);
+  if (nl)
+    len = nl - (map + pos) + 1;
+
+  memcpy(buf, map + pos, len);
+  buf[len] = '\0';
+  return pos + len;
+}
+
+/**
+ * map_count_lines - Count the newlines in part of the mailbox
+ * @param map   Mapped mailbox
+ * @param start Start offset
+ * @param end   End offset
+ * @retval num Number of newlines
+ *
+ * A simple loop, which the compiler can vectorise.
+ */
+static int map_count_lines(const char *map, LOFF_T start, LOFF_T end)
+{
+  int lines = 0;
+  for (LOFF_T i = start; i < end; i++)
+    lines += (map[i] == '\n');
+
+  return lines;
+}
+
+/**
+ * map_count_fgets - Count the lines in part of the mailbox, like fgets()
+ * @param map   Mapped mailbox
+ * @param start Start offset
+ * @param end   End offset
+ * @retval num Number of lines
+ *
+ * Unlike map_count_lines(), a final line without a newline counts, too.
+ */
+static int map_count_fgets(const char *map, LOFF_T start, LOFF_T end)
+{
+  if (end <= start)
+    return 0;
+
+  return map_count_lines(map, start, end) + (map[end - 1] != '\n');
+}
+
+/**
+ * map_next_from - Find the next valid "From " line
+ * @param[in]  map     Mapped mailbox
+ * @param[in]  pos     Offset to search from; must be the start of a line
+ * @param[in]  end     Size of the mapped mailbox
+ * @param[out] rp      Return path of the message
+ * @param[in]  rplen   Length of rp
+ * @param[out] t       Time the message was received
+ * @retval num Offset of the line
+ * @retval end Not found
+ */
+static LOFF_T map_next_from(const char *map, LOFF_T pos, LOFF_T end, char *rp,
+                            size_t rplen, time_t *t)
+{
+  char buf[8192];
+
+  while ((pos = map_find_line(map, pos, end, "From ", 5)) < end)
+  {
+    LOFF_T next = map_copy_line(map, pos, end, buf, sizeof(buf));
+    if (is_from(buf, rp, rplen, t))
+      return pos;
+    pos = next;
+  }
+
+  return end;
+}
+
+/**
+ * map_mailbox - Map a mailbox file into memory
+ * @param m Mailbox
+ * @retval ptr  Mapped mailbox, m->size bytes long
+ * @retval NULL The mailbox couldn't be mapped; read it with stdio instead
+ *
+ * Reading a mapped page beyond the end of a file raises SIGBUS, so the
+ * mailbox is only mapped if nothing is likely to truncate it: we hold the
+ * lock, and the file hasn't changed since it was last stat()ed, nor in the
+ * last couple of seconds.  Otherwise, stdio copes with a shrinking file.
+ */
+static char *map_mailbox(struct Mailbox *m)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  if (!adata || !adata->locked || (m->size <= 0) || ((size_t) m->size != m->size))
+    return NULL;
+
+  struct stat st;
+  if ((fstat(fileno(adata->fp), &st) != 0) || (st.st_size != m->size) ||
+      (mutt_file_stat_timespec_compare(&st, MUTT_STAT_MTIME, &m->mtime) != 0) ||
+      (st.st_mtime >= (time(NULL) - 1)))
+  {
+    mutt_debug(LL_DEBUG2, "%s is being written to, not mapping it\n",
+               mutt_b2s(m->pathbuf));
+    return NULL;
+  }
+
+  char *map = mmap(NULL, m->size, PROT_READ, MAP_PRIVATE, fileno(adata->fp), 0);
+  if (map == MAP_FAILED)
+  {
+    mutt_debug(LL_DEBUG1, "mmap() failed: %s (errno %d)\n", strerror(errno), errno);
+    return NULL;
+  }
+
+#ifdef POSIX_MADV_SEQUENTIAL
+  posix_madvise(map, m->size, POSIX_MADV_SEQUENTIAL);
+#endif
+  return map;
+}
+
+#ifdef USE_HCACHE
+/**
+ * map_hcache_key - Create a header cache key for a message
+ * @param st     Mailbox file's stat info
+ * @param offset Offset of the message
+ * @param buf    Buffer for the key
+ * @param buflen Length of the buffer
+ * @retval num Length of the key
+ *
+ * The key identifies the file (device and inode) and the message's position
+ * in it, so one cache file can be shared by many mailboxes.
+ */
+static size_t map_hcache_key(const struct stat *st, LOFF_T offset, char *buf, size_t buflen)
+{
+  return snprintf(buf, buflen, "%llu.%llu/" OFF_T_FMT, (unsigned long long) st->st_dev,
+                  (unsigned long long) st->st_ino, offset);
+}
+
+/**
+ * map_hash - Hash the headers of a message
+ * @param map   Mapped mailbox
+ * @param start Start of the message
+ * @param end   Start of the body
+ * @retval num Hash (never 0)
+ *
+ * The hash (32-bit FNV-1a) is stored as the record's "uidvalidity", so a
+ * cached Email is only used if its headers are byte-for-byte unchanged.
+ */
+static unsigned int map_hash(const char *map, LOFF_T start, LOFF_T end)
+{
+  unsigned int h = 2166136261U;
+  for (LOFF_T i = start; i < end; i++)
+  {
+    h ^= (unsigned char) map[i];
+    h *= 16777619U;
+  }
+
+  return h ? h : 1;
+}
+
+/**
+ * map_hcache_open - Open the header cache of a mailbox
+ * @param m Mailbox
+ * @retval ptr  Header cache handle
+ * @retval NULL The mailbox mustn't be cached
+ *
+ * A compressed mailbox is uncompressed into a new temporary file every time
+ * it's opened, so its records could never be found again.
+ */
+static header_cache_t *map_hcache_open(struct Mailbox *m)
+{
+#ifdef USE_COMPRESSED
+  if (m->compress_info)
+    return NULL;
+#endif
+  return mutt_hcache_open(C_HeaderCache, mutt_b2s(m->pathbuf), NULL);
+}
+
+/**
+ * map_hcache_delete - Forget messages that have moved
+ * @param m          Mailbox
+ * @param old_offset Previous positions of the messages
+ * @param num        Number of positions
+ *
+ * After a sync, the records of the rewritten messages are keyed by offsets
+ * that no longer start a message, or start a different one.
+ */
+static void map_hcache_delete(struct Mailbox *m, const struct MUpdate *old_offset, int num)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  struct stat st;
+  if (!adata || !adata->fp || (fstat(fileno(adata->fp), &st) != 0))
+    return;
+
+  header_cache_t *hc = map_hcache_open(m);
+  if (!hc)
+    return;
+
+  char key[128];
+  mutt_hcache_begin(hc);
+  for (int i = 0; (i < num) && old_offset[i].valid; i++)
+  {
+    size_t keylen = map_hcache_key(&st, old_offset[i].hdr, key, sizeof(key));
+    mutt_hcache_delete(hc, key, keylen);
+  }
+  mutt_hcache_commit(hc);
+  mutt_hcache_close(hc);
+}
+
+/**
+ * map_hcache_fetch - Restore a message from the header cache
+ * @param hc     Header cache handle
+ * @param st     Mailbox file's stat info
+ * @param map    Mapped mailbox
+ * @param size   Size of the mapped mailbox
+ * @param offset Offset of the message
+ * @retval ptr  Cached Email, whose headers match the mailbox
+ * @retval NULL Not cached, or the headers have changed
+ *
+ * The caller must still check that the message ends where the cache says.
+ */
+static struct Email *map_hcache_fetch(header_cache_t *hc, const struct stat *st,
+                                      const char *map, LOFF_T size, LOFF_T offset)
+{
+  if (!hc)
+    return NULL;
+
+  char key[128];
+  size_t keylen = map_hcache_key(st, offset, key, sizeof(key));
+  void *data = mutt_hcache_fetch(hc, key, keylen);
+  if (!data)
+    return NULL;
+
+  unsigned int hash = 0;
+  memcpy(&hash, data, sizeof(hash));
+  struct Email *e = mutt_hcache_restore(data);
+  mutt_hcache_free(hc, &data);
+
+  if (!e || !e->content || (e->offset != offset) || (e->content->offset <= offset) ||
+      (e->content->offset > size) || (e->content->length < 0) ||
+      (hash != map_hash(map, offset, e->content->offset)))
+  {
+    mutt_email_free(&e);
+  }
+
+  return e;
+}
+
+/**
+ * map_hcache_store - Save a message to the header cache
+ * @param hc  Header cache handle
+ * @param st  Mailbox file's stat info
+ * @param map Mapped mailbox
+ * @param e   Email, parsed from the mailbox
+ */
+static void map_hcache_store(header_cache_t *hc, const struct stat *st,
+                             const char *map, struct Email *e)
+{
+  if (!hc)
+    return;
+
+  char key[128];
+  size_t keylen = map_hcache_key(st, e->offset, key, sizeof(key));
+  mutt_hcache_store(hc, key, keylen, e, map_hash(map, e->offset, e->content->offset));
+}
+#endif
+
+/**
+ * mmdf_parse_map - Read a mapped mailbox in MMDF format
+ * @param m        Mailbox
+ * @param st       Mailbox file's stat info
+ * @param map      Mapped mailbox
+ * @param progress Progress bar
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * Only the headers are read through stdio.  The message boundaries and line
+ * counts come from scanning the mapped file.
+ */
+static int mmdf_parse_map(struct Mailbox *m, const struct stat *st,
+                          const char *map, struct Progress *progress)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  const LOFF_T size = m->size;
+  const size_t seplen = sizeof(MMDF_SEP) - 1;
+  char buf[8192];
+  char return_path[1024];
+  int count = 0;
+  time_t t;
+
+  LOFF_T pos = ftello(adata->fp);
+  if (pos < 0)
+    return -1;
+
+#ifdef USE_HCACHE
+  header_cache_t *hc = map_hcache_open(m);
+  mutt_hcache_begin(hc);
+  int cached = 0;
+#endif
+  int rc = 0;
+
+  while ((pos < size) && (SigInt != 1))
+  {
+    if (!map_line_is(map, pos, size, MMDF_SEP, seplen))
+    {
+      mutt_debug(LL_DEBUG1, "corrupt mailbox\n");
+      mutt_error(_("Mailbox is corrupt"));
+      rc = -1;
+      break;
+    }
+
+    LOFF_T loc = pos + seplen;
+
+    count++;
+    if (!m->quiet)
+      mutt_progress_update(progress, count, (int) (loc / (m->size / 100 + 1)));
+
+    if (loc >= size)
+    {
+      mutt_debug(LL_DEBUG1, "unexpected EOF\n");
+      break;
+    }
+
+    if (m->msg_count == m->email_max)
+      mx_alloc_memory(m);
+
+    struct Email *e = NULL;
+#ifdef USE_HCACHE
+    e = map_hcache_fetch(hc, st, map, size, loc);
+    if (e)
+    {
+      const LOFF_T end = e->content->offset + e->content->length;
+      if ((end == size) || map_line_is(map, end, size, MMDF_SEP, seplen))
+      {
+        e->index = m->msg_count;
+        m->emails[m->msg_count++] = e;
+        pos = (end < size) ? (end + seplen) : size;
+        cached++;
+        continue;
+      }
+      mutt_email_free(&e);
+    }
+#endif
+
+    e = mutt_email_new();
+    m->emails[m->msg_count] = e;
+    e->offset = loc;
+    e->index = m->msg_count;
+
+    return_path[0] = '\0';
+    LOFF_T hdr = map_copy_line(map, loc, size, buf, sizeof(buf));
+    if (is_from(buf, return_path, sizeof(return_path), &t))
+      e->received = t - mutt_date_local_tz(t);
+    else
+      hdr = loc;
+
+    if (fseeko(adata->fp, hdr, SEEK_SET) != 0)
+    {
+      mutt_debug(LL_DEBUG1, "#1 fseek() failed\n");
+      mutt_error(_("Mailbox is corrupt"));
+      rc = -1;
+      break;
+    }
+    e->env = mutt_rfc822_read_header(adata->fp, e, false, false);
+
+    const LOFF_T body = e->content->offset;
+    LOFF_T end = -1;
+    if ((e->content->length > 0) && (e->lines > 0))
+    {
+      LOFF_T tmploc = body + e->content->length;
+      if ((tmploc > 0) && (tmploc < size) && map_line_is(map, tmploc, size, MMDF_SEP, seplen))
+        end = tmploc;
+    }
+
+    if (end < 0)
+    {
+      end = map_find_line(map, body, size, MMDF_SEP, seplen);
+      /* Without a closing separator, the last line isn't counted */
+      if (end < size)
+        e->lines = map_count_lines(map, body, end);
+      else
+        e->lines = MAX(map_count_fgets(map, body, end) - 1, 0);
+      e->content->length = end - body;
+    }
+
+    pos = (end < size) ? (end + seplen) : size;
+
+    if (TAILQ_EMPTY(&e->env->return_path) && return_path[0])
+      mutt_addrlist_parse(&e->env->return_path, return_path);
+
+    if (TAILQ_EMPTY(&e->env->from))
+      mutt_addrlist_copy(&e->env->from, &e->env->return_path, false);
+
+#ifdef USE_HCACHE
+    map_hcache_store(hc, st, map, e);
+#endif
+    m->msg_count++;
+  }
+
+#ifdef USE_HCACHE
+  mutt_hcache_commit(hc);
+  mutt_hcache_close(hc);
+  mutt_debug(LL_DEBUG2, "%d of %d messages restored from the header cache\n",
+             cached, count);
+#endif
+
+  if (rc != 0)
+    return rc;
+
+  if (fseeko(adata->fp, pos, SEEK_SET) != 0)
+    mutt_debug(LL_DEBUG1, "#2 fseek() failed\n");
+
+  return 0;
+}
+
+/**
+ * mbox_parse_map - Read a mapped mailbox in mbox format
+ * @param m        Mailbox
+ * @param st       Mailbox file's stat info
+ * @param map      Mapped mailbox
+ * @param progress Progress bar
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * Only the headers are read through stdio.  The message boundaries and line
+ * counts come from scanning the mapped file.
+ */
+static int mbox_parse_map(struct Mailbox *m, const struct stat *st,
+                          const char *map, struct Progress *progress)
+{
+  struct MboxAccountData *adata = mbox_adata_get(m);
+  const LOFF_T size = m->size;
+  char return_path[256];
+  int count = 0;
+  time_t t;
+
+  LOFF_T loc = ftello(adata->fp);
+  if (loc < 0)
+    return -1;
+
+#ifdef USE_HCACHE
+  header_cache_t *hc = map_hcache_open(m);
+  mutt_hcache_begin(hc);
+  int cached = 0;
+#endif
+  int rc = 0;
+
+  loc = map_next_from(map, loc, size, return_path, sizeof(return_path), &t);
+  while ((loc < size) && (SigInt != 1))
+  {
+    count++;
+    if (!m->quiet)
+      mutt_progress_update(progress, count, (int) (loc / (m->size / 100 + 1)));
+
+    if (m->msg_count == m->email_max)
+      mx_alloc_memory(m);
+
+    struct Email *e = NULL;
+#ifdef USE_HCACHE
+    /* A cached message is only used if it still ends at a separator */
+    e = map_hcache_fetch(hc, st, map, size, loc);
+    if (e)
+    {
+      const LOFF_T next = e->content->offset + e->content->length + 1;
+      if ((next == size) || ((next < size) && map_line_is(map, next, size, "From ", 5)))
+      {
+        e->index = m->msg_count;
+        m->emails[m->msg_count++] = e;
+        loc = map_next_from(map, next, size, return_path, sizeof(return_path), &t);
+        cached++;
+        continue;
+      }
+      mutt_email_free(&e);
+    }
+#endif
+
+    e = mutt_email_new();
+    m->emails[m->msg_count] = e;
+    e->received = t - mutt_date_local_tz(t);
+    e->offset = loc;
+    e->index = m->msg_count;
+
+    const char *nl = memchr(map + loc, '\n', size - loc);
+    LOFF_T hdr = nl ? ((nl - map) + 1) : size;
+    if (fseeko(adata->fp, hdr, SEEK_SET) != 0)
+    {
+      mutt_debug(LL_DEBUG1, "#1 fseek() failed\n");
+      rc = -1;
+      break;
+    }
+    e->env = mutt_rfc822_read_header(adata->fp, e, false, false);
+
+    /* if we know how long this message is, skip over the body; but check the
+     * content-length looks valid first.  We expect to see a message separator
+     * just after it. */
+    const LOFF_T body = e->content->offset;
+    LOFF_T search = body;
+    if (e->content->length > 0)
+    {
+      /* The test below avoids a potential integer overflow if the
+       * content-length is huge (thus necessarily invalid).  */
+      LOFF_T tmploc = (e->content->length < size) ? (body + e->content->length + 1) : -1;
+
+      if ((tmploc > 0) && (tmploc < size))
+      {
+        if (map_line_is(map, tmploc, size, "From ", 5))
+          search = tmploc;
+        else
+        {
+          mutt_debug(LL_DEBUG1, "bad content-length in message %d (cl=" OFF_T_FMT ")\n",
+                     e->index, e->content->length);
+          e->content->length = -1;
+        }
+      }
+      else if (tmploc != size)
+      {
+        /* content-length would put us past the end of the file, so it
+         * must be wrong */
+        e->content->length = -1;
+      }
+      else
+        search = size;
+
+      /* good content-length.  check to see if we know how many lines
+       * are in this message.  */
+      if ((e->content->length != -1) && (e->lines == 0))
+        e->lines = map_count_lines(map, body, body + e->content->length);
+    }
+
+    m->msg_count++;
+
+    if (TAILQ_EMPTY(&e->env->return_path) && return_path[0])
+      mutt_addrlist_parse(&e->env->return_path, return_path);
+
+    if (TAILQ_EMPTY(&e->env->from))
+      mutt_addrlist_copy(&e->env->from, &e->env->return_path, false);
+
+    loc = map_next_from(map, search, size, return_path, sizeof(return_path), &t);
+
+    /* Save the Content-Length of this message */
+    if (e->content->length < 0)
+    {
+      e->content->length = loc - e->content->offset - 1;
+      if (e->content->length < 0)
+        e->content->length = 0;
+    }
+    if (!e->lines)
+    {
+      int lines = map_count_fgets(map, search, loc);
+      e->lines = lines ? lines - 1 : 0;
+    }
+
+#ifdef USE_HCACHE
+    map_hcache_store(hc, st, map, e);
+#endif
+  }
+
+#ifdef USE_HCACHE
+  mutt_hcache_commit(hc);
+  mutt_hcache_close(hc);
+  mutt_debug(LL_DEBUG2, "%d of %d messages restored from the header cache\n",
+             cached, count);
+#endif
+
+  if (rc != 0)
+    return rc;
+
+  if (fseeko(adata->fp, size, SEEK_SET) != 0)
+    mutt_debug(LL_DEBUG1, "#2 fseek() failed\n");
+
+  return 0;
+}
+
 /**
  * mmdf_parse_mailbox - Read a mailbox in MMDF format
  * @param m Mailbox
@@ -217,6 +846,19 @@ static int mmdf_parse_mailbox(struct Mailbox *m)
     mutt_progress_init(&progress, msgbuf, MUTT_PROGRESS_MSG, C_ReadInc, 0);
   }
 
+  char *map = map_mailbox(m);
+  if (map)
+  {
+    int rc = mmdf_parse_map(m, &sb, map, &progress);
+    munmap(map, m->size);
+    if ((rc == 0) && (SigInt == 1))
+    {
+      SigInt = 0;
+      return -2; /* action aborted */
+    }
+    return rc;
+  }
+
   while (true)
   {
     if (!fgets(buf, sizeof(buf) - 1, adata->fp))
@@ -393,6 +1035,19 @@ static int mbox_parse_mailbox(struct Mailbox *m)
     mx_alloc_memory(m);
   }
 
+  char *map = map_mailbox(m);
+  if (map)
+  {
+    int rc = mbox_parse_map(m, &sb, map, &progress);
+    munmap(map, m->size);
+    if ((rc == 0) && (SigInt == 1))
+    {
+      SigInt = 0;
+      return -2; /* action aborted */
+    }
+    return rc;
+  }
+
   loc = ftello(adata->fp);
   while ((fgets(buf, sizeof(buf), adata->fp)) && (SigInt != 1))
   {
@@ -876,7 +1531,7 @@ void mbox_reset_atime(struct Mailbox *m, struct stat *st)
  */
 struct Account *mbox_ac_find(struct Account *a, const char *path)
 {
-  if (!a || (a->magic != MUTT_MBOX) || !path)
+  if (!a || ((a->magic != MUTT_MBOX) && (a->magic != MUTT_MMDF)) || !path)
     return NULL;
 
   struct MailboxNode *np = STAILQ_FIRST(&a->mailboxes);
@@ -894,7 +1549,7 @@ struct Account *mbox_ac_find(struct Account *a, const char *path)
  */
 int mbox_ac_add(struct Account *a, struct Mailbox *m)
 {
-  if (!a || !m || (m->magic != MUTT_MBOX))
+  if (!a || !m || ((m->magic != MUTT_MBOX) && (m->magic != MUTT_MMDF)))
     return -1;
   return 0;
 }
@@ -1404,6 +2059,10 @@ static int mbox_mbox_sync(struct Mailbox *m, int *index_hint)
     return -1;
   }
 
+#ifdef USE_HCACHE
+  map_hcache_delete(m, old_offset, m->msg_count - first);
+#endif
+
   /* update the offsets of the rewritten messages */
   for (i = first, j = first; i < m->msg_count; i++)
   {
@@ -48,6 +48,8 @@
 
 int MonitorFilesChanged = 0;
 int MonitorContextChanged = 0;
+struct ListHead MonitorContextFiles = STAILQ_HEAD_INITIALIZER(MonitorContextFiles);
+bool MonitorContextIncomplete = false;
 
 static int INotifyFd = -1;
 static struct Monitor *Monitor = NULL;
@@ -59,9 +61,12 @@ static int MonitorContextDescriptor = -1;
 
 #define INOTIFY_MASK_DIR (IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE | IN_ISDIR)
 #define INOTIFY_MASK_FILE IN_CLOSE_WRITE
+#define INOTIFY_MASK_CONTEXT (IN_MOVED_FROM | IN_DELETE) ///< Also watched in the open Maildir
 
 #define EVENT_BUFLEN MAX(4096, sizeof(struct inotify_event) + NAME_MAX + 1)
 
+#define MONITOR_MAX_FILES 1000 ///< Most files remembered between mailbox checks
+
 #define RESOLVERES_FAIL_NOMAILBOX -3
 #define RESOLVERES_FAIL_NOMAGIC -2
 #define RESOLVERES_FAIL_STAT -1
@@ -363,6 +368,51 @@ static int monitor_resolve(struct MonitorInfo *info, struct Mailbox *m)
   return iter ? RESOLVERES_OK_EXISTING : RESOLVERES_OK_NOTEXISTING;
 }
 
+/**
+ * monitor_context_event - Remember which file of the current mailbox changed
+ * @param event inotify event
+ *
+ * Files added to the directory are listed in #MonitorContextFiles.  If a file
+ * is removed, or there are too many, the list is marked incomplete.
+ */
+static void monitor_context_event(const struct inotify_event *event)
+{
+  if (MonitorContextIncomplete || (event->mask & IN_ISDIR))
+    return;
+
+  if ((event->mask & (IN_MOVED_FROM | IN_DELETE)) || (event->len == 0))
+  {
+    MonitorContextIncomplete = true;
+    return;
+  }
+
+  if (!(event->mask & (IN_MOVED_TO | IN_CLOSE_WRITE)))
+    return;
+
+  int count = 0;
+  struct ListNode *np = NULL;
+  STAILQ_FOREACH(np, &MonitorContextFiles, entries)
+  {
+    if (mutt_str_strcmp(np->data, event->name) == 0)
+      return;
+    count++;
+  }
+
+  if (count >= MONITOR_MAX_FILES)
+    MonitorContextIncomplete = true;
+  else
+    mutt_list_insert_tail(&MonitorContextFiles, mutt_str_strdup(event->name));
+}
+
+/**
+ * mutt_monitor_files_clear - Forget the files added to the current mailbox
+ */
+void mutt_monitor_files_clear(void)
+{
+  mutt_list_free(&MonitorContextFiles);
+  MonitorContextIncomplete = false;
+}
+
 /**
  * mutt_monitor_poll - Check for filesystem changes
  * @retval -3 unknown/unexpected events: poll timeout / fds not handled by us
@@ -433,8 +483,13 @@ int mutt_monitor_poll(void)
                            event->wd, event->mask);
                 if (event->mask & IN_IGNORED)
                   monitor_handle_ignore(event->wd);
+                else if (event->mask & IN_Q_OVERFLOW)
+                  MonitorContextIncomplete = true;
                 else if (event->wd == MonitorContextDescriptor)
+                {
                   MonitorContextChanged = 1;
+                  monitor_context_event(event);
+                }
                 ptr += sizeof(struct inotify_event) + event->len;
               }
             }
@@ -463,16 +518,26 @@ int mutt_monitor_add(struct Mailbox *m)
   monitor_info_init(&info);
 
   int rc = 0;
+  if (!m)
+    mutt_monitor_files_clear();
+
   int desc = monitor_resolve(&info, m);
   if (desc != RESOLVERES_OK_NOTEXISTING)
   {
     if (!m && (desc == RESOLVERES_OK_EXISTING))
+    {
       MonitorContextDescriptor = info.monitor->desc;
+      /* Already watched as a mailbox; now removals matter too */
+      if (info.isdir)
+        inotify_add_watch(INotifyFd, info.path, INOTIFY_MASK_DIR | INOTIFY_MASK_CONTEXT);
+    }
     rc = (desc == RESOLVERES_OK_EXISTING) ? 0 : -1;
     goto cleanup;
   }
 
   uint32_t mask = info.isdir ? INOTIFY_MASK_DIR : INOTIFY_MASK_FILE;
+  if (!m && info.isdir)
+    mask |= INOTIFY_MASK_CONTEXT;
   if (((INotifyFd == -1) && (monitor_init() == -1)) ||
       ((desc = inotify_add_watch(INotifyFd, info.path, mask)) == -1))
   {
@@ -514,6 +579,7 @@ int mutt_monitor_remove(struct Mailbox *m)
   {
     MonitorContextDescriptor = -1;
     MonitorContextChanged = 0;
+    mutt_monitor_files_clear();
   }
 
   if (monitor_resolve(&info, m) != RESOLVERES_OK_EXISTING)
@@ -537,6 +603,9 @@ int mutt_monitor_remove(struct Mailbox *m)
     {
       if (mutt_mailbox_find(Context->mailbox->realpath))
       {
+        /* Still watched as a mailbox, which only needs to see arrivals */
+        if (info.isdir)
+          inotify_add_watch(INotifyFd, info.path, INOTIFY_MASK_DIR);
         rc = 1;
         goto cleanup;
       }
@@ -23,13 +23,18 @@
 #ifndef MUTT_MONITOR_H
 #define MUTT_MONITOR_H
 
+#include <stdbool.h>
+
 extern int MonitorFilesChanged;   ///< true after a monitored file has changed
 extern int MonitorContextChanged; ///< true after the current mailbox has changed
+extern struct ListHead MonitorContextFiles; ///< Files added to the current mailbox's directory
+extern bool MonitorContextIncomplete;       ///< MonitorContextFiles doesn't list every change
 
 struct Mailbox;
 
-int mutt_monitor_add(struct Mailbox *m);
-int mutt_monitor_remove(struct Mailbox *m);
-int mutt_monitor_poll(void);
+int  mutt_monitor_add(struct Mailbox *m);
+void mutt_monitor_files_clear(void);
+int  mutt_monitor_remove(struct Mailbox *m);
+int  mutt_monitor_poll(void);
 
 #endif /* MUTT_MONITOR_H */
@@ -35,6 +35,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
@@ -64,6 +65,37 @@ char *C_Newsrc; ///< Config: (nntp) File containing list of subscribed newsgroup
 
 struct BodyCache;
 
+#define ACTIVE_CACHE_MAGIC "NMACTIVE"
+#define ACTIVE_CACHE_VERSION 1
+
+/**
+ * struct ActiveCacheHeader - Header of the binary active list cache
+ *
+ * The header is followed by `count` ActiveCacheRecords and then a table of
+ * `strings` bytes of nul-terminated group names and descriptions.
+ */
+struct ActiveCacheHeader
+{
+  char magic[8];           ///< ACTIVE_CACHE_MAGIC
+  uint32_t version;        ///< ACTIVE_CACHE_VERSION
+  uint32_t count;          ///< Number of records
+  uint64_t newgroups_time; ///< Last time the server was asked for new groups
+  uint32_t strings;        ///< Size of the string table
+  uint32_t pad;            ///< Unused
+};
+
+/**
+ * struct ActiveCacheRecord - One newsgroup in the binary active list cache
+ */
+struct ActiveCacheRecord
+{
+  anum_t first;     ///< First article number
+  anum_t last;      ///< Last article number
+  uint32_t group;   ///< Offset of the group name in the string table
+  uint32_t desc;    ///< Offset of the description in the string table
+  uint32_t allowed; ///< Posting is allowed
+};
+
 /**
  * mdata_find - Find NntpMboxData for given newsgroup or add it
  * @param adata NNTP server
@@ -97,6 +129,41 @@ static struct NntpMboxData *mdata_find(struct NntpAccountData *adata, const char
   return mdata;
 }
 
+/**
+ * groups_hash_reserve - Make room for a number of newsgroups
+ * @param adata NNTP server
+ * @param num   Expected number of newsgroups
+ *
+ * The Hash never grows, so a full Usenet active list would leave long chains
+ * behind every bucket.  Rebuild the table with more buckets if necessary.
+ */
+static void groups_hash_reserve(struct NntpAccountData *adata, size_t num)
+{
+  if (num > adata->groups_max)
+  {
+    adata->groups_max = num;
+    mutt_mem_realloc(&adata->groups_list, adata->groups_max * sizeof(struct NntpMboxData *));
+  }
+
+  if (num <= adata->groups_hash->nelem)
+    return;
+
+  mutt_debug(LL_DEBUG2, "resizing groups hash to %zu\n", num);
+  struct Hash *hash = mutt_hash_new(num, MUTT_HASH_NO_FLAGS);
+  mutt_hash_set_destructor(hash, nntp_hashelem_free, 0);
+  for (unsigned int i = 0; i < adata->groups_num; i++)
+  {
+    struct NntpMboxData *mdata = adata->groups_list[i];
+    if (mdata)
+      mutt_hash_insert(hash, mdata->group, mdata);
+  }
+
+  /* The groups now belong to the new table */
+  mutt_hash_set_destructor(adata->groups_hash, NULL, 0);
+  mutt_hash_free(&adata->groups_hash);
+  adata->groups_hash = hash;
+}
+
 /**
  * nntp_acache_free - Remove all temporarily cache files
  * @param mdata NNTP Mailbox data
@@ -151,6 +218,236 @@ void nntp_group_unread_stat(struct NntpMboxData *mdata)
   }
 }
 
+/**
+ * newsrc_journal_path - Get the path of the .newsrc journal
+ * @param adata  NNTP server
+ * @param buf    Buffer for the path
+ * @param buflen Length of the buffer
+ *
+ * Lines that change between rewrites of .newsrc are appended to the journal.
+ * Its first line records which .newsrc it applies to.
+ */
+static void newsrc_journal_path(struct NntpAccountData *adata, char *buf, size_t buflen)
+{
+  snprintf(buf, buflen, "%s.journal", adata->newsrc_file);
+}
+
+/**
+ * newsrc_parse_line - Parse one line of .newsrc
+ * @param adata NNTP server
+ * @param line  Line to parse, will be modified
+ *
+ * The line replaces anything already known about the newsgroup.
+ */
+static void newsrc_parse_line(struct NntpAccountData *adata, char *line)
+{
+  char *b = NULL, *h = NULL;
+  unsigned int j = 1;
+  bool subs = false;
+
+  /* find end of newsgroup name */
+  char *p = strpbrk(line, ":!");
+  if (!p)
+    return;
+
+  /* ":" - subscribed, "!" - unsubscribed */
+  if (*p == ':')
+    subs = true;
+  *p++ = '\0';
+
+  /* get newsgroup data */
+  struct NntpMboxData *mdata = mdata_find(adata, line);
+  FREE(&mdata->newsrc_ent);
+
+  /* count number of entries */
+  b = p;
+  while (*b)
+    if (*b++ == ',')
+      j++;
+  mdata->newsrc_ent = mutt_mem_calloc(j, sizeof(struct NewsrcEntry));
+  mdata->subscribed = subs;
+
+  /* parse entries */
+  j = 0;
+  while (p)
+  {
+    b = p;
+
+    /* find end of entry */
+    p = strchr(p, ',');
+    if (p)
+      *p++ = '\0';
+
+    /* first-last or single number */
+    h = strchr(b, '-');
+    if (h)
+      *h++ = '\0';
+    else
+      h = b;
+
+    if ((sscanf(b, ANUM, &mdata->newsrc_ent[j].first) == 1) &&
+        (sscanf(h, ANUM, &mdata->newsrc_ent[j].last) == 1))
+    {
+      j++;
+    }
+  }
+  if (j == 0)
+  {
+    mdata->newsrc_ent[j].first = 1;
+    mdata->newsrc_ent[j].last = 0;
+    j++;
+  }
+  if (mdata->last_message == 0)
+    mdata->last_message = mdata->newsrc_ent[j - 1].last;
+  mdata->newsrc_len = j;
+  mutt_mem_realloc(&mdata->newsrc_ent, j * sizeof(struct NewsrcEntry));
+  nntp_group_unread_stat(mdata);
+  mutt_debug(LL_DEBUG2, "%s\n", mdata->group);
+}
+
+/**
+ * newsrc_parse_text - Parse the contents of .newsrc
+ * @param adata    NNTP server
+ * @param text     Contents of .newsrc, will be modified
+ * @param len      Length of the contents
+ * @param complete The contents are complete
+ * @retval num Length of the lines parsed
+ *
+ * A last line without a newline is only parsed if complete is true.
+ */
+static size_t newsrc_parse_text(struct NntpAccountData *adata, char *text,
+                                size_t len, bool complete)
+{
+  size_t done = 0;
+
+  while (done < len)
+  {
+    char *line = text + done;
+    char *eol = memchr(line, '\n', len - done);
+    if (!eol && !complete)
+      break;
+
+    size_t linelen = eol ? (eol - line + 1) : (len - done);
+    done += linelen;
+    if (eol)
+      *eol = '\0';
+    else
+      line[linelen] = '\0';
+
+    newsrc_parse_line(adata, line);
+  }
+
+  return done;
+}
+
+/**
+ * newsrc_journal_read - Replay the .newsrc journal
+ * @param adata NNTP server
+ * @param sb    Details of .newsrc
+ *
+ * If .newsrc has been rewritten since the journal was started, e.g. by another
+ * newsreader, the journal is out of date and is deleted.  A torn last line,
+ * left by a crash, is cut off so that new lines can be appended.
+ */
+static void newsrc_journal_read(struct NntpAccountData *adata, struct stat *sb)
+{
+  char path[PATH_MAX];
+  struct stat jsb;
+  unsigned long long ino = 0, size = 0;
+  long long mtime = 0;
+
+  adata->journal_size = 0;
+  newsrc_journal_path(adata, path, sizeof(path));
+  FILE *fp = mutt_file_fopen(path, "r");
+  if (!fp)
+    return;
+
+  if ((fstat(fileno(fp), &jsb) < 0) || (jsb.st_size == 0))
+  {
+    mutt_file_fclose(&fp);
+    return;
+  }
+
+  char *text = mutt_mem_malloc(jsb.st_size + 1);
+  size_t len = fread(text, 1, jsb.st_size, fp);
+  mutt_file_fclose(&fp);
+  text[len] = '\0';
+
+  char *eol = memchr(text, '\n', len);
+  if (!eol || (sscanf(text, "# neomutt newsrc journal %llu %llu %lld", &ino, &size, &mtime) != 3) ||
+      (ino != (unsigned long long) sb->st_ino) ||
+      (size != (unsigned long long) sb->st_size) || (mtime != (long long) sb->st_mtime))
+  {
+    mutt_debug(LL_DEBUG1, "Discarding out of date %s\n", path);
+    unlink(path);
+    FREE(&text);
+    return;
+  }
+
+  mutt_debug(LL_DEBUG1, "Replaying %s\n", path);
+  size_t hdrlen = eol - text + 1;
+  size_t done = hdrlen + newsrc_parse_text(adata, eol + 1, len - hdrlen, false);
+  if ((done < len) && (truncate(path, done) < 0))
+    mutt_perror(path);
+  adata->journal_size = done;
+  FREE(&text);
+}
+
+/**
+ * newsrc_gen - Generate the contents of .newsrc
+ * @param[in]  adata NNTP server
+ * @param[out] len   Length of the contents
+ * @retval ptr Contents of .newsrc, must be freed by the caller
+ */
+static char *newsrc_gen(struct NntpAccountData *adata, size_t *len)
+{
+  size_t buflen = 10240;
+  char *buf = mutt_mem_calloc(1, buflen);
+  size_t off = 0;
+
+  for (unsigned int i = 0; i < adata->groups_num; i++)
+  {
+    struct NntpMboxData *mdata = adata->groups_list[i];
+
+    if (!mdata || !mdata->newsrc_ent)
+      continue;
+
+    /* write newsgroup name */
+    if (off + strlen(mdata->group) + 3 > buflen)
+    {
+      buflen *= 2;
+      mutt_mem_realloc(&buf, buflen);
+    }
+    snprintf(buf + off, buflen - off, "%s%c ", mdata->group, mdata->subscribed ? ':' : '!');
+    off += strlen(buf + off);
+
+    /* write entries */
+    for (unsigned int j = 0; j < mdata->newsrc_len; j++)
+    {
+      if (off + 1024 > buflen)
+      {
+        buflen *= 2;
+        mutt_mem_realloc(&buf, buflen);
+      }
+      if (j)
+        buf[off++] = ',';
+      if (mdata->newsrc_ent[j].first == mdata->newsrc_ent[j].last)
+        snprintf(buf + off, buflen - off, "%u", mdata->newsrc_ent[j].first);
+      else if (mdata->newsrc_ent[j].first < mdata->newsrc_ent[j].last)
+      {
+        snprintf(buf + off, buflen - off, "%u-%u", mdata->newsrc_ent[j].first,
+                 mdata->newsrc_ent[j].last);
+      }
+      off += strlen(buf + off);
+    }
+    buf[off++] = '\n';
+  }
+  buf[off] = '\0';
+
+  *len = off;
+  return buf;
+}
+
 /**
  * nntp_newsrc_parse - Parse .newsrc file
  * @param adata NNTP server
@@ -160,8 +457,9 @@ void nntp_group_unread_stat(struct NntpMboxData *mdata)
  */
 int nntp_newsrc_parse(struct NntpAccountData *adata)
 {
-  char *line = NULL;
+  char path[PATH_MAX];
   struct stat sb;
+  struct stat jsb;
 
   if (adata->fp_newsrc)
   {
@@ -198,8 +496,16 @@ int nntp_newsrc_parse(struct NntpAccountData *adata)
     return -1;
   }
 
-  if ((adata->size == sb.st_size) && (adata->mtime == sb.st_mtime))
+  /* another NeoMutt may have appended to the journal */
+  newsrc_journal_path(adata, path, sizeof(path));
+  if (stat(path, &jsb) < 0)
+    jsb.st_size = 0;
+
+  if ((adata->size == sb.st_size) && (adata->mtime == sb.st_mtime) &&
+      (adata->journal_size == jsb.st_size))
+  {
     return 0;
+  }
 
   adata->size = sb.st_size;
   adata->mtime = sb.st_mtime;
@@ -218,73 +524,22 @@ int nntp_newsrc_parse(struct NntpAccountData *adata)
     FREE(&mdata->newsrc_ent);
   }
 
-  line = mutt_mem_malloc(sb.st_size + 1);
-  while (sb.st_size && fgets(line, sb.st_size + 1, adata->fp_newsrc))
-  {
-    char *b = NULL, *h = NULL;
-    unsigned int j = 1;
-    bool subs = false;
-
-    /* find end of newsgroup name */
-    char *p = strpbrk(line, ":!");
-    if (!p)
-      continue;
-
-    /* ":" - subscribed, "!" - unsubscribed */
-    if (*p == ':')
-      subs = true;
-    *p++ = '\0';
-
-    /* get newsgroup data */
-    struct NntpMboxData *mdata = mdata_find(adata, line);
-    FREE(&mdata->newsrc_ent);
-
-    /* count number of entries */
-    b = p;
-    while (*b)
-      if (*b++ == ',')
-        j++;
-    mdata->newsrc_ent = mutt_mem_calloc(j, sizeof(struct NewsrcEntry));
-    mdata->subscribed = subs;
-
-    /* parse entries */
-    j = 0;
-    while (p)
-    {
-      b = p;
+  char *text = mutt_mem_malloc(sb.st_size + 1);
+  size_t len = fread(text, 1, sb.st_size, adata->fp_newsrc);
+  text[len] = '\0';
 
-      /* find end of entry */
-      p = strchr(p, ',');
-      if (p)
-        *p++ = '\0';
+  size_t lines = 0;
+  for (char *s = text; (s = strchr(s, '\n')); s++)
+    lines++;
+  groups_hash_reserve(adata, lines);
 
-      /* first-last or single number */
-      h = strchr(b, '-');
-      if (h)
-        *h++ = '\0';
-      else
-        h = b;
+  newsrc_parse_text(adata, text, len, true);
+  FREE(&text);
+  newsrc_journal_read(adata, &sb);
 
-      if ((sscanf(b, ANUM, &mdata->newsrc_ent[j].first) == 1) &&
-          (sscanf(h, ANUM, &mdata->newsrc_ent[j].last) == 1))
-      {
-        j++;
-      }
-    }
-    if (j == 0)
-    {
-      mdata->newsrc_ent[j].first = 1;
-      mdata->newsrc_ent[j].last = 0;
-      j++;
-    }
-    if (mdata->last_message == 0)
-      mdata->last_message = mdata->newsrc_ent[j - 1].last;
-    mdata->newsrc_len = j;
-    mutt_mem_realloc(&mdata->newsrc_ent, j * sizeof(struct NewsrcEntry));
-    nntp_group_unread_stat(mdata);
-    mutt_debug(LL_DEBUG2, "%s\n", mdata->group);
-  }
-  FREE(&line);
+  /* Keep a copy of the contents, so nntp_newsrc_update() can tell what changed */
+  FREE(&adata->newsrc_text);
+  adata->newsrc_text = newsrc_gen(adata, &adata->newsrc_textlen);
   return 1;
 }
 
@@ -379,11 +634,12 @@ void nntp_newsrc_gen_entries(struct Mailbox *m)
 /**
  * update_file - Update file with new contents
  * @param filename File to update
- * @param buf      New context
+ * @param buf      New contents
+ * @param buflen   Length of new contents
  * @retval  0 Success
  * @retval -1 Failure
  */
-static int update_file(char *filename, char *buf)
+static int update_file(char *filename, const void *buf, size_t buflen)
 {
   FILE *fp = NULL;
   char tmpfile[PATH_MAX];
@@ -399,7 +655,7 @@ static int update_file(char *filename, char *buf)
       *tmpfile = '\0';
       break;
     }
-    if (fputs(buf, fp) == EOF)
+    if (fwrite(buf, 1, buflen, fp) != buflen)
     {
       mutt_perror(tmpfile);
       break;
@@ -428,83 +684,193 @@ static int update_file(char *filename, char *buf)
 }
 
 /**
- * nntp_newsrc_update - Update .newsrc file
- * @param adata NNTP server
+ * newsrc_compact - Rewrite .newsrc and delete the journal
+ * @param adata  NNTP server
+ * @param buf    New contents of .newsrc
+ * @param buflen Length of the new contents
  * @retval  0 Success
  * @retval -1 Failure
+ *
+ * .newsrc is replaced atomically before the journal is deleted.  If the
+ * journal is left behind, it no longer matches .newsrc, so it won't be
+ * replayed.
  */
-int nntp_newsrc_update(struct NntpAccountData *adata)
+static int newsrc_compact(struct NntpAccountData *adata, const char *buf, size_t buflen)
 {
-  if (!adata)
+  char path[PATH_MAX];
+  struct stat sb;
+
+  mutt_debug(LL_DEBUG1, "Updating %s\n", adata->newsrc_file);
+  if (update_file(adata->newsrc_file, buf, buflen) < 0)
     return -1;
 
-  int rc = -1;
+  newsrc_journal_path(adata, path, sizeof(path));
+  if ((unlink(path) < 0) && (errno != ENOENT))
+    mutt_perror(path);
+  adata->journal_size = 0;
 
-  size_t buflen = 10240;
-  char *buf = mutt_mem_calloc(1, buflen);
-  size_t off = 0;
-
-  /* we will generate full newsrc here */
-  for (unsigned int i = 0; i < adata->groups_num; i++)
+  if (stat(adata->newsrc_file, &sb) < 0)
   {
-    struct NntpMboxData *mdata = adata->groups_list[i];
+    mutt_perror(adata->newsrc_file);
+    return -1;
+  }
+  adata->size = sb.st_size;
+  adata->mtime = sb.st_mtime;
+  return 0;
+}
 
-    if (!mdata || !mdata->newsrc_ent)
-      continue;
+/**
+ * newsrc_journal_append - Append the changed lines of .newsrc to the journal
+ * @param adata  NNTP server
+ * @param buf    New contents of .newsrc
+ * @param buflen Length of the new contents
+ * @retval  0 Success
+ * @retval -1 .newsrc needs rewriting instead
+ *
+ * Only changes to the read articles, or to the subscriptions, of newsgroups
+ * already in .newsrc are journalled.  Once the journal is bigger than .newsrc,
+ * it's cheaper to rewrite .newsrc.
+ */
+static int newsrc_journal_append(struct NntpAccountData *adata, const char *buf, size_t buflen)
+{
+  char path[PATH_MAX];
+  struct stat sb;
 
-    /* write newsgroup name */
-    if (off + strlen(mdata->group) + 3 > buflen)
-    {
-      buflen *= 2;
-      mutt_mem_realloc(&buf, buflen);
-    }
-    snprintf(buf + off, buflen - off, "%s%c ", mdata->group, mdata->subscribed ? ':' : '!');
-    off += strlen(buf + off);
+  if (!adata->newsrc_text || (stat(adata->newsrc_file, &sb) < 0) ||
+      (sb.st_size != adata->size) || (sb.st_mtime != adata->mtime))
+  {
+    return -1;
+  }
 
-    /* write entries */
-    for (unsigned int j = 0; j < mdata->newsrc_len; j++)
-    {
-      if (off + 1024 > buflen)
-      {
-        buflen *= 2;
-        mutt_mem_realloc(&buf, buflen);
-      }
-      if (j)
-        buf[off++] = ',';
-      if (mdata->newsrc_ent[j].first == mdata->newsrc_ent[j].last)
-        snprintf(buf + off, buflen - off, "%u", mdata->newsrc_ent[j].first);
-      else if (mdata->newsrc_ent[j].first < mdata->newsrc_ent[j].last)
-      {
-        snprintf(buf + off, buflen - off, "%u-%u", mdata->newsrc_ent[j].first,
-                 mdata->newsrc_ent[j].last);
-      }
-      off += strlen(buf + off);
-    }
-    buf[off++] = '\n';
+  struct Buffer *changes = mutt_buffer_pool_get();
+  if (adata->journal_size == 0)
+  {
+    mutt_buffer_printf(changes, "# neomutt newsrc journal %llu %llu %lld\n",
+                       (unsigned long long) sb.st_ino,
+                       (unsigned long long) sb.st_size, (long long) sb.st_mtime);
   }
-  buf[off] = '\0';
 
-  /* newrc being fully rewritten */
-  mutt_debug(LL_DEBUG1, "Updating %s\n", adata->newsrc_file);
-  if (adata->newsrc_file && (update_file(adata->newsrc_file, buf) == 0))
+  /* the groups must be the same, in the same order */
+  const char *old = adata->newsrc_text;
+  const char *old_end = old + adata->newsrc_textlen;
+  const char *new = buf;
+  const char *new_end = buf + buflen;
+  while ((old < old_end) && (new < new_end))
   {
-    struct stat sb;
+    const char *old_eol = memchr(old, '\n', old_end - old);
+    const char *new_eol = memchr(new, '\n', new_end - new);
+    size_t old_len = old_eol - old + 1;
+    size_t new_len = new_eol - new + 1;
+    size_t name_len = strcspn(new, ":!");
 
-    rc = stat(adata->newsrc_file, &sb);
-    if (rc == 0)
-    {
-      adata->size = sb.st_size;
-      adata->mtime = sb.st_mtime;
-    }
-    else
-    {
-      mutt_perror(adata->newsrc_file);
-    }
+    if ((strcspn(old, ":!") != name_len) || (memcmp(old, new, name_len) != 0))
+      break;
+    if ((old_len != new_len) || (memcmp(old, new, new_len) != 0))
+      mutt_buffer_addstr_n(changes, new, new_len);
+
+    old += old_len;
+    new += new_len;
   }
-  FREE(&buf);
+
+  int rc = -1;
+  const size_t len = mutt_buffer_len(changes);
+  if ((old != old_end) || (new != new_end) || ((adata->journal_size + (off_t) len) > sb.st_size))
+    goto done;
+
+  newsrc_journal_path(adata, path, sizeof(path));
+  FILE *fp = mutt_file_fopen(path, "a");
+  if (!fp)
+  {
+    mutt_perror(path);
+    goto done;
+  }
+  if (fwrite(mutt_b2s(changes), 1, len, fp) != len)
+  {
+    mutt_perror(path);
+    mutt_file_fclose(&fp);
+    goto done;
+  }
+  if (mutt_file_fsync_close(&fp) != 0)
+  {
+    mutt_perror(path);
+    goto done;
+  }
+
+  mutt_debug(LL_DEBUG1, "Appended %zu bytes to %s\n", len, path);
+  adata->journal_size += len;
+  rc = 0;
+
+done:
+  mutt_buffer_pool_release(&changes);
   return rc;
 }
 
+/**
+ * nntp_newsrc_update - Update .newsrc file
+ * @param adata NNTP server
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * If only the read articles have changed, the changed lines are appended to
+ * the journal.  Otherwise, .newsrc is rewritten.
+ */
+int nntp_newsrc_update(struct NntpAccountData *adata)
+{
+  if (!adata || !adata->newsrc_file)
+    return -1;
+
+  size_t len = 0;
+  char *buf = newsrc_gen(adata, &len);
+
+  if (adata->newsrc_text && (len == adata->newsrc_textlen) &&
+      (memcmp(buf, adata->newsrc_text, len) == 0))
+  {
+    mutt_debug(LL_DEBUG2, "%s is unchanged\n", adata->newsrc_file);
+    FREE(&buf);
+    return 0;
+  }
+
+  if ((newsrc_journal_append(adata, buf, len) < 0) &&
+      (newsrc_compact(adata, buf, len) < 0))
+  {
+    FREE(&buf);
+    return -1;
+  }
+
+  FREE(&adata->newsrc_text);
+  adata->newsrc_text = buf;
+  adata->newsrc_textlen = len;
+  return 0;
+}
+
+/**
+ * nntp_newsrc_compact - Fold the journal back into .newsrc
+ * @param adata NNTP server
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * Other newsreaders don't know about the journal, so this is done when
+ * leaving a newsgroup.
+ */
+int nntp_newsrc_compact(struct NntpAccountData *adata)
+{
+  if (!adata || !adata->newsrc_file || (adata->journal_size == 0))
+    return 0;
+
+  size_t len = 0;
+  char *buf = newsrc_gen(adata, &len);
+  if (newsrc_compact(adata, buf, len) < 0)
+  {
+    FREE(&buf);
+    return -1;
+  }
+
+  FREE(&adata->newsrc_text);
+  adata->newsrc_text = buf;
+  adata->newsrc_textlen = len;
+  return 0;
+}
+
 /**
  * cache_expand - Make fully qualified cache file name
  * @param dst    Buffer for filename
@@ -556,6 +922,32 @@ void nntp_expand_path(char *buf, size_t buflen, struct ConnAccount *acct)
   FREE(&url.path);
 }
 
+/**
+ * active_set_group - Update a newsgroup from the active list
+ * @param adata   NNTP server
+ * @param group   Newsgroup
+ * @param first   First article number
+ * @param last    Last article number
+ * @param allowed Posting is allowed
+ * @param desc    Description
+ */
+static void active_set_group(struct NntpAccountData *adata, const char *group,
+                             anum_t first, anum_t last, bool allowed, const char *desc)
+{
+  struct NntpMboxData *mdata = mdata_find(adata, group);
+  mdata->deleted = false;
+  mdata->first_message = first;
+  mdata->last_message = last;
+  mdata->allowed = allowed;
+  mutt_str_replace(&mdata->desc, desc);
+  if (mdata->newsrc_ent || mdata->last_cached)
+    nntp_group_unread_stat(mdata);
+  else if (mdata->last_message && (mdata->first_message <= mdata->last_message))
+    mdata->unread = mdata->last_message - mdata->first_message + 1;
+  else
+    mdata->unread = 0;
+}
+
 /**
  * nntp_add_group - Parse newsgroup
  * @param line String to parse
@@ -565,7 +957,6 @@ void nntp_expand_path(char *buf, size_t buflen, struct ConnAccount *acct)
 int nntp_add_group(char *line, void *data)
 {
   struct NntpAccountData *adata = data;
-  struct NntpMboxData *mdata = NULL;
   char group[1024] = { 0 };
   char desc[8192] = { 0 };
   char mod;
@@ -582,31 +973,76 @@ int nntp_add_group(char *line, void *data)
     return 0;
   }
 
-  mdata = mdata_find(adata, group);
-  mdata->deleted = false;
-  mdata->first_message = first;
-  mdata->last_message = last;
-  mdata->allowed = (mod == 'y') || (mod == 'm');
-  mutt_str_replace(&mdata->desc, desc);
-  if (mdata->newsrc_ent || mdata->last_cached)
-    nntp_group_unread_stat(mdata);
-  else if (mdata->last_message && (mdata->first_message <= mdata->last_message))
-    mdata->unread = mdata->last_message - mdata->first_message + 1;
-  else
-    mdata->unread = 0;
+  active_set_group(adata, group, first, last, (mod == 'y') || (mod == 'm'), desc);
   return 0;
 }
 
+/**
+ * active_get_cache_binary - Load the binary list of newsgroups
+ * @param adata NNTP server
+ * @param fd    File descriptor of the cache
+ * @param size  Size of the cache
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * The cache is mapped into memory and the records are used directly, so even
+ * a full Usenet active list loads without parsing any text.
+ */
+static int active_get_cache_binary(struct NntpAccountData *adata, int fd, size_t size)
+{
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    return -1;
+
+  int rc = -1;
+  const struct ActiveCacheHeader *hdr = map;
+  const struct ActiveCacheRecord *rec = (const void *) (hdr + 1);
+  const char *strings = (const char *) (rec + hdr->count);
+
+  if ((hdr->version != ACTIVE_CACHE_VERSION) || (hdr->newgroups_time == 0) ||
+      (hdr->count > (size - sizeof(*hdr)) / sizeof(*rec)) || (hdr->strings == 0) ||
+      (size != sizeof(*hdr) + hdr->count * sizeof(*rec) + hdr->strings) ||
+      (strings[hdr->strings - 1] != '\0'))
+  {
+    mutt_debug(LL_DEBUG1, "invalid active cache\n");
+    goto done;
+  }
+
+  adata->newgroups_time = hdr->newgroups_time;
+  groups_hash_reserve(adata, adata->groups_num + hdr->count);
+
+  mutt_message(_("Loading list of groups from cache..."));
+  for (uint32_t i = 0; i < hdr->count; i++)
+  {
+    if ((rec[i].group >= hdr->strings) || (rec[i].desc >= hdr->strings) ||
+        (strings[rec[i].group] == '\0'))
+    {
+      continue;
+    }
+    active_set_group(adata, strings + rec[i].group, rec[i].first, rec[i].last,
+                     rec[i].allowed, strings + rec[i].desc);
+  }
+  mutt_clear_error();
+  rc = 0;
+
+done:
+  munmap(map, size);
+  return rc;
+}
+
 /**
  * active_get_cache - Load list of all newsgroups from cache
  * @param adata NNTP server
  * @retval  0 Success
  * @retval -1 Failure
+ *
+ * Older versions stored the list as text, which is still understood.
  */
 static int active_get_cache(struct NntpAccountData *adata)
 {
   char buf[8192];
   char file[4096];
+  struct stat sb;
   time_t t;
 
   cache_expand(file, sizeof(file), &adata->conn->account, ".active");
@@ -615,6 +1051,16 @@ static int active_get_cache(struct NntpAccountData *adata)
   if (!fp)
     return -1;
 
+  if ((fstat(fileno(fp), &sb) == 0) && ((size_t) sb.st_size > sizeof(struct ActiveCacheHeader)) &&
+      (fread(buf, 1, sizeof(ACTIVE_CACHE_MAGIC) - 1, fp) == sizeof(ACTIVE_CACHE_MAGIC) - 1) &&
+      (memcmp(buf, ACTIVE_CACHE_MAGIC, sizeof(ACTIVE_CACHE_MAGIC) - 1) == 0))
+  {
+    int rc = active_get_cache_binary(adata, fileno(fp), sb.st_size);
+    mutt_file_fclose(&fp);
+    return rc;
+  }
+  rewind(fp);
+
   if (!fgets(buf, sizeof(buf), fp) || (sscanf(buf, "%ld%4095s", &t, file) != 1) || (t == 0))
   {
     mutt_file_fclose(&fp);
@@ -642,11 +1088,13 @@ int nntp_active_save_cache(struct NntpAccountData *adata)
   if (!adata->cacheable)
     return 0;
 
-  size_t buflen = 10240;
-  char *buf = mutt_mem_calloc(1, buflen);
-  snprintf(buf, buflen, "%lu\n", (unsigned long) adata->newgroups_time);
-  size_t off = strlen(buf);
+  struct ActiveCacheHeader hdr = { ACTIVE_CACHE_MAGIC, ACTIVE_CACHE_VERSION };
+  struct ActiveCacheRecord *recs =
+      mutt_mem_calloc(adata->groups_num + 1, sizeof(struct ActiveCacheRecord));
+  struct Buffer strings = { 0 };
 
+  /* offset 0 is the empty string, used for missing descriptions */
+  mutt_buffer_addch(&strings, '\0');
   for (unsigned int i = 0; i < adata->groups_num; i++)
   {
     struct NntpMboxData *mdata = adata->groups_list[i];
@@ -654,21 +1102,36 @@ int nntp_active_save_cache(struct NntpAccountData *adata)
     if (!mdata || mdata->deleted)
       continue;
 
-    if ((off + strlen(mdata->group) + (mdata->desc ? strlen(mdata->desc) : 0) + 50) > buflen)
+    struct ActiveCacheRecord *rec = &recs[hdr.count++];
+    rec->first = mdata->first_message;
+    rec->last = mdata->last_message;
+    rec->allowed = mdata->allowed;
+    rec->group = mutt_buffer_len(&strings);
+    mutt_buffer_addstr(&strings, mdata->group);
+    mutt_buffer_addch(&strings, '\0');
+    if (mdata->desc)
     {
-      buflen *= 2;
-      mutt_mem_realloc(&buf, buflen);
+      rec->desc = mutt_buffer_len(&strings);
+      mutt_buffer_addstr(&strings, mdata->desc);
+      mutt_buffer_addch(&strings, '\0');
     }
-    snprintf(buf + off, buflen - off, "%s %u %u %c%s%s\n", mdata->group,
-             mdata->last_message, mdata->first_message, mdata->allowed ? 'y' : 'n',
-             mdata->desc ? " " : "", mdata->desc ? mdata->desc : "");
-    off += strlen(buf + off);
   }
+  hdr.newgroups_time = adata->newgroups_time;
+  hdr.strings = mutt_buffer_len(&strings);
+
+  size_t recslen = hdr.count * sizeof(struct ActiveCacheRecord);
+  size_t buflen = sizeof(hdr) + recslen + hdr.strings;
+  char *buf = mutt_mem_malloc(buflen);
+  memcpy(buf, &hdr, sizeof(hdr));
+  memcpy(buf + sizeof(hdr), recs, recslen);
+  memcpy(buf + sizeof(hdr) + recslen, strings.data, hdr.strings);
+  FREE(&recs);
+  FREE(&strings.data);
 
   char file[PATH_MAX];
   cache_expand(file, sizeof(file), &adata->conn->account, ".active");
   mutt_debug(LL_DEBUG1, "Updating %s\n", file);
-  int rc = update_file(file, buf);
+  int rc = update_file(file, buf, buflen);
   FREE(&buf);
   return rc;
 }
@@ -731,7 +1194,7 @@ void nntp_hcache_update(struct NntpMboxData *mdata, header_cache_t *hc)
   anum_t first = 0, last = 0;
 
   /* fetch previous values of first and last */
-  void *hdata = mutt_hcache_fetch_raw(hc, "index", 5);
+  void *hdata = mutt_hcache_fetch_raw(hc, "index", 5, NULL);
   if (hdata)
   {
     mutt_debug(LL_DEBUG2, "mutt_hcache_fetch index: %s\n", (char *) hdata);
@@ -1117,7 +1580,7 @@ struct NntpAccountData *nntp_select_server(struct Mailbox *m, char *server, bool
           continue;
 
         /* fetch previous values of first and last */
-        hdata = mutt_hcache_fetch_raw(hc, "index", 5);
+        hdata = mutt_hcache_fetch_raw(hc, "index", 5, NULL);
         if (hdata)
         {
           anum_t first, last;
@@ -1152,6 +1615,7 @@ struct NntpAccountData *nntp_select_server(struct Mailbox *m, char *server, bool
     mutt_hash_free(&adata->groups_hash);
     FREE(&adata->groups_list);
     FREE(&adata->newsrc_file);
+    FREE(&adata->newsrc_text);
     FREE(&adata->authenticators);
     FREE(&adata);
     mutt_socket_close(conn);
@@ -76,6 +76,8 @@ bool C_ShowNewNews; ///< Config: (nntp) Check for new newsgroups when entering t
 
 struct NntpAccountData *CurrentNewsSrv;
 
+#define NNTP_HEAD_WINDOW 32 ///< Maximum number of HEAD commands awaiting a reply
+
 const char *OverviewFmt = "Subject:\0"
                           "From:\0"
                           "Date:\0"
@@ -99,6 +101,15 @@ struct FetchCtx
   header_cache_t *hc;
 };
 
+/**
+ * struct HeadRequest - An article whose header will be fetched with HEAD
+ */
+struct HeadRequest
+{
+  anum_t anum; ///< Article number
+  int index;   ///< Index of the article's (empty) Email in the Mailbox
+};
+
 /**
  * struct ChildCtx - Keep track of the children of an article
  */
@@ -839,6 +850,78 @@ static int nntp_query(struct NntpMboxData *mdata, char *line, size_t linelen)
   return 0;
 }
 
+/**
+ * nntp_read_lines - Read the lines of a multi-line response
+ * @param adata    NNTP Account data
+ * @param progress Progress bar (OPTIONAL)
+ * @param func     Callback function
+ * @param data     Data for callback function
+ * @retval  0 Success
+ * @retval -1 Connection lost
+ * @retval -2 Error in func(*line, *data)
+ *
+ * The lines are taken straight from the connection's buffer, with the
+ * dot-stuffing removed.  The terminating "." is consumed.
+ */
+static int nntp_read_lines(struct NntpAccountData *adata, struct Progress *progress,
+                           int (*func)(char *, void *), void *data)
+{
+  struct Connection *conn = adata->conn;
+  struct Buffer *line = mutt_buffer_pool_get();
+  unsigned int lines = 0;
+  int rc = 0;
+
+  while (true)
+  {
+    const char *p = NULL;
+    const int len = mutt_socket_peekln(conn, &p);
+    if (len < 0)
+    {
+      adata->status = NNTP_NONE;
+      rc = -1;
+      break;
+    }
+
+    const bool eol = (p[len - 1] == '\n');
+    size_t n = eol ? (len - 1) : len;
+
+    if ((mutt_buffer_len(line) == 0) && (p[0] == '.'))
+    {
+      if (eol && ((n == 1) || ((n == 2) && (p[1] == '\r'))))
+      {
+        mutt_socket_advance(conn, len);
+        break;
+      }
+      if ((n > 1) && (p[1] == '.'))
+      {
+        p++;
+        n--;
+      }
+    }
+
+    mutt_buffer_addstr_n(line, p, n);
+    mutt_socket_advance(conn, len);
+    if (!eol)
+      continue;
+
+    /* strip \r from \r\n termination */
+    n = mutt_buffer_len(line);
+    if (n && (line->data[n - 1] == '\r'))
+      line->data[n - 1] = '\0';
+    mutt_debug(MUTT_SOCK_LOG_FULL, "%d< %s\n", conn->fd, line->data);
+
+    if (progress)
+      mutt_progress_update(progress, ++lines, -1);
+
+    if ((rc == 0) && (func(line->data, data) < 0))
+      rc = -2;
+    mutt_buffer_reset(line);
+  }
+
+  mutt_buffer_pool_release(&line);
+  return rc;
+}
+
 /**
  * nntp_fetch_lines - Read lines, calling a callback function for each
  * @param mdata NNTP Mailbox data
@@ -858,15 +941,11 @@ static int nntp_query(struct NntpMboxData *mdata, char *line, size_t linelen)
 static int nntp_fetch_lines(struct NntpMboxData *mdata, char *query, size_t qlen,
                             const char *msg, int (*func)(char *, void *), void *data)
 {
-  bool done = false;
   int rc;
 
-  while (!done)
+  while (true)
   {
     char buf[1024];
-    char *line = NULL;
-    unsigned int lines = 0;
-    size_t off = 0;
     struct Progress progress;
 
     if (msg)
@@ -881,49 +960,12 @@ static int nntp_fetch_lines(struct NntpMboxData *mdata, char *query, size_t qlen
       return 1;
     }
 
-    line = mutt_mem_malloc(sizeof(buf));
-    rc = 0;
-
-    while (true)
-    {
-      char *p = NULL;
-      int chunk = mutt_socket_readln_d(buf, sizeof(buf), mdata->adata->conn, MUTT_SOCK_LOG_FULL);
-      if (chunk < 0)
-      {
-        mdata->adata->status = NNTP_NONE;
-        break;
-      }
-
-      p = buf;
-      if (!off && (buf[0] == '.'))
-      {
-        if (buf[1] == '\0')
-        {
-          done = true;
-          break;
-        }
-        if (buf[1] == '.')
-          p++;
-      }
-
-      mutt_str_strfcpy(line + off, p, sizeof(buf));
-
-      if (chunk >= sizeof(buf))
-        off += strlen(p);
-      else
-      {
-        if (msg)
-          mutt_progress_update(&progress, ++lines, -1);
-
-        if ((rc == 0) && (func(line, data) < 0))
-          rc = -2;
-        off = 0;
-      }
-
-      mutt_mem_realloc(&line, off + sizeof(buf));
-    }
-    FREE(&line);
+    rc = nntp_read_lines(mdata->adata, msg ? &progress : NULL, func, data);
     func(NULL, data);
+
+    /* if the connection was lost, reconnect and start again */
+    if (rc != -1)
+      break;
   }
   return rc;
 }
@@ -1053,6 +1095,24 @@ static int fetch_tempfile(char *line, void *data)
   return 0;
 }
 
+/**
+ * fetch_buffer - Append a line to a Buffer
+ * @param line Text to append
+ * @param data Buffer
+ * @retval 0 Always
+ */
+static int fetch_buffer(char *line, void *data)
+{
+  struct Buffer *buf = data;
+
+  if (line)
+  {
+    mutt_buffer_addstr(buf, line);
+    mutt_buffer_addch(buf, '\n');
+  }
+  return 0;
+}
+
 /**
  * fetch_numbers - Parse article number
  * @param line Article number
@@ -1119,9 +1179,7 @@ static int parse_overview_line(char *line, void *data)
   }
 
   /* convert overview line to header */
-  FILE *fp = mutt_file_mkstemp();
-  if (!fp)
-    return -1;
+  struct Buffer *hdr = mutt_buffer_pool_get();
 
   header = mdata->adata->overview_fmt;
   while (field)
@@ -1130,24 +1188,17 @@ static int parse_overview_line(char *line, void *data)
 
     if (*header)
     {
-      if (!strstr(header, ":full") && (fputs(header, fp) == EOF))
-      {
-        mutt_file_fclose(&fp);
-        return -1;
-      }
+      if (!strstr(header, ":full"))
+        mutt_buffer_addstr(hdr, header);
       header = strchr(header, '\0') + 1;
     }
 
     field = strchr(field, '\t');
     if (field)
       *field++ = '\0';
-    if ((fputs(b, fp) == EOF) || (fputc('\n', fp) == EOF))
-    {
-      mutt_file_fclose(&fp);
-      return -1;
-    }
+    mutt_buffer_addstr(hdr, b);
+    mutt_buffer_addch(hdr, '\n');
   }
-  rewind(fp);
 
   /* allocate memory for headers */
   if (m->msg_count >= m->email_max)
@@ -1156,10 +1207,10 @@ static int parse_overview_line(char *line, void *data)
   /* parse header */
   m->emails[m->msg_count] = mutt_email_new();
   e = m->emails[m->msg_count];
-  e->env = mutt_rfc822_read_header(fp, e, false, false);
+  e->env = mutt_rfc822_read_header_mem(mutt_b2s(hdr), mutt_buffer_len(hdr), e, false, false);
   e->env->newsgroups = mutt_str_strdup(mdata->group);
   e->received = e->date_sent;
-  mutt_file_fclose(&fp);
+  mutt_buffer_pool_release(&hdr);
 
 #ifdef USE_HCACHE
   if (fc->hc)
@@ -1168,14 +1219,19 @@ static int parse_overview_line(char *line, void *data)
 
     /* try to replace with header from cache */
     snprintf(buf, sizeof(buf), "%u", anum);
+    struct Email *e_cached = NULL;
     void *hdata = mutt_hcache_fetch(fc->hc, buf, strlen(buf));
     if (hdata)
+    {
+      e_cached = mutt_hcache_restore(hdata);
+      mutt_hcache_free(fc->hc, &hdata);
+    }
+    if (e_cached)
     {
       mutt_debug(LL_DEBUG2, "mutt_hcache_fetch %s\n", buf);
       mutt_email_free(&e);
-      e = mutt_hcache_restore(hdata);
+      e = e_cached;
       m->emails[m->msg_count] = e;
-      mutt_hcache_free(fc->hc, &hdata);
       e->edata = NULL;
       e->read = false;
       e->old = false;
@@ -1192,12 +1248,9 @@ static int parse_overview_line(char *line, void *data)
       }
     }
 
-    /* not cached yet, store header */
+    /* not cached yet, store header once the overview is complete */
     else
-    {
-      mutt_debug(LL_DEBUG2, "mutt_hcache_store %s\n", buf);
-      mutt_hcache_store(fc->hc, buf, strlen(buf), e, 0);
-    }
+      fc->messages[anum - fc->first] = 2;
   }
 #endif
 
@@ -1230,6 +1283,169 @@ static int parse_overview_line(char *line, void *data)
   return 0;
 }
 
+/**
+ * nntp_add_email - Set up a newly fetched article
+ * @param m       Mailbox
+ * @param e       Email, already in the Mailbox
+ * @param anum    Article number
+ * @param restore Restore message listed as deleted
+ */
+static void nntp_add_email(struct Mailbox *m, struct Email *e, anum_t anum, bool restore)
+{
+  struct NntpMboxData *mdata = m->mdata;
+
+  e->read = false;
+  e->old = false;
+  e->deleted = false;
+  e->edata = nntp_edata_new();
+  e->free_edata = nntp_edata_free;
+  nntp_edata_get(e)->article_num = anum;
+  if (restore)
+    e->changed = true;
+  else
+  {
+    nntp_article_status(m, e, NULL, anum);
+    if (!e->read)
+      nntp_parse_xref(m, e);
+  }
+  if (anum > mdata->last_loaded)
+    mdata->last_loaded = anum;
+}
+
+/**
+ * nntp_fetch_heads - Fetch articles' headers, using pipelined HEAD commands
+ * @param m     Mailbox
+ * @param fc    Fetch context
+ * @param heads Articles to fetch
+ * @param num   Number of articles
+ * @retval  0 Success
+ * @retval -1 Failure
+ *
+ * Up to #NNTP_HEAD_WINDOW commands are sent before waiting for a reply.
+ *
+ * Each article already has an empty Email in the Mailbox.  If the article
+ * can't be fetched, its Email is freed and its slot set to NULL.
+ */
+static int nntp_fetch_heads(struct Mailbox *m, struct FetchCtx *fc,
+                            struct HeadRequest *heads, int num)
+{
+  struct NntpMboxData *mdata = m->mdata;
+  struct NntpAccountData *adata = mdata->adata;
+  struct Buffer *cmd = mutt_buffer_pool_get();
+  struct Buffer *hdr = mutt_buffer_pool_get();
+  char buf[1024];
+  int sent = 0;
+  int i = 0;
+  int rc = 0;
+
+  /* reconnect, if necessary */
+  if (adata->status != NNTP_OK)
+  {
+    buf[0] = '\0';
+    if (nntp_query(mdata, buf, sizeof(buf)) < 0)
+      rc = -1;
+  }
+
+  if (!m->quiet)
+  {
+    mutt_progress_init(&fc->progress, _("Fetching message headers..."),
+                       MUTT_PROGRESS_MSG, C_ReadInc, num);
+  }
+
+  while ((rc == 0) || (i < sent))
+  {
+    bool lost = false;
+
+    /* top up the window when it's half empty */
+    if ((rc == 0) && (sent - i <= NNTP_HEAD_WINDOW / 2) && (sent < num))
+    {
+      mutt_buffer_reset(cmd);
+      while ((sent < num) && (sent - i < NNTP_HEAD_WINDOW))
+        mutt_buffer_add_printf(cmd, "HEAD %u\r\n", heads[sent++].anum);
+      if (mutt_socket_send(adata->conn, mutt_b2s(cmd)) < 0)
+        lost = true;
+    }
+    if (!lost && (i >= sent))
+      break;
+
+    if (!lost && !m->quiet)
+      mutt_progress_update(&fc->progress, i + 1, -1);
+
+    if (!lost && (mutt_socket_readln(buf, sizeof(buf), adata->conn) < 0))
+      lost = true;
+
+    if (!lost && (buf[0] == '2'))
+    {
+      mutt_buffer_reset(hdr);
+      if (nntp_read_lines(adata, NULL, fetch_buffer, hdr) < 0)
+        lost = true;
+    }
+
+    if (lost)
+    {
+      adata->status = NNTP_NONE;
+      /* after an error, the remaining replies don't matter */
+      if (rc != 0)
+        break;
+
+      /* reconnect, reselect the group and ask again for the articles whose
+       * replies haven't been read */
+      buf[0] = '\0';
+      if (nntp_query(mdata, buf, sizeof(buf)) < 0)
+      {
+        rc = -1;
+        break;
+      }
+      sent = i;
+      continue;
+    }
+
+    struct Email **ep = &m->emails[heads[i].index];
+    const anum_t anum = heads[i].anum;
+    i++;
+
+    if (buf[0] == '2')
+    {
+      /* after an error, the remaining replies are read, but discarded */
+      if (rc == 0)
+      {
+        (*ep)->env = mutt_rfc822_read_header_mem(mutt_b2s(hdr), mutt_buffer_len(hdr),
+                                                 *ep, false, false);
+        (*ep)->received = (*ep)->date_sent;
+        nntp_add_email(m, *ep, anum, fc->restore);
+        continue;
+      }
+    }
+
+    mutt_email_free(ep);
+
+    /* no such article */
+    if (mutt_str_startswith(buf, "423", CASE_MATCH))
+    {
+      if (mdata->bcache)
+      {
+        snprintf(buf, sizeof(buf), "%u", anum);
+        mutt_debug(LL_DEBUG2, "#3 mutt_bcache_del %s\n", buf);
+        mutt_bcache_del(mdata->bcache, buf);
+      }
+    }
+    /* invalid response */
+    else if (rc == 0)
+    {
+      mutt_error("HEAD: %s", buf);
+      rc = -1;
+    }
+  }
+
+  /* free the Emails of the articles we didn't get to */
+  for (; i < num; i++)
+    mutt_email_free(&m->emails[heads[i].index]);
+
+  mutt_buffer_pool_release(&cmd);
+  mutt_buffer_pool_release(&hdr);
+  return rc;
+}
+
 /**
  * nntp_fetch_headers - Fetch headers
  * @param m       Mailbox
@@ -1248,6 +1464,9 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
   struct NntpMboxData *mdata = m->mdata;
   struct FetchCtx fc;
   struct Email *e = NULL;
+  struct HeadRequest *heads = NULL;
+  int num_heads = 0;
+  int max_heads = 0;
   char buf[8192];
   int rc = 0;
   anum_t current;
@@ -1292,6 +1511,9 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
     }
     if (rc == 0)
     {
+#ifdef USE_HCACHE
+      mutt_hcache_begin(fc.hc);
+#endif
       for (current = first; current <= last && rc == 0; current++)
       {
         if (fc.messages[current - first])
@@ -1312,6 +1534,9 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
         }
 #endif
       }
+#ifdef USE_HCACHE
+      mutt_hcache_commit(fc.hc);
+#endif
     }
   }
   else
@@ -1348,16 +1573,15 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
     void *hdata = mutt_hcache_fetch(fc.hc, buf, strlen(buf));
     if (hdata)
     {
+      struct Email cached = { 0 };
+
       mutt_debug(LL_DEBUG2, "mutt_hcache_fetch %s\n", buf);
-      e = mutt_hcache_restore(hdata);
-      m->emails[m->msg_count] = e;
-      mutt_hcache_free(fc.hc, &hdata);
-      e->edata = NULL;
+      mutt_hcache_restore_flags(hdata, &cached);
 
       /* skip header marked as deleted in cache */
-      if (e->deleted && !restore)
+      if (cached.deleted && !restore)
       {
-        mutt_email_free(&e);
+        mutt_hcache_free(fc.hc, &hdata);
         if (mdata->bcache)
         {
           mutt_debug(LL_DEBUG2, "#2 mutt_bcache_del %s\n", buf);
@@ -1366,6 +1590,16 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
         continue;
       }
 
+      e = mutt_hcache_restore(hdata);
+      mutt_hcache_free(fc.hc, &hdata);
+    }
+    else
+      e = NULL;
+
+    if (e)
+    {
+      m->emails[m->msg_count] = e;
+      e->edata = NULL;
       e->read = false;
       e->old = false;
     }
@@ -1386,70 +1620,50 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
         continue;
     }
 
-    /* fetch header from server */
+    /* fetch header from server, later */
     else
     {
-      FILE *fp = mutt_file_mkstemp();
-      if (!fp)
-      {
-        mutt_perror(_("Can't create temporary file"));
-        rc = -1;
-        break;
-      }
-
-      snprintf(buf, sizeof(buf), "HEAD %u\r\n", current);
-      rc = nntp_fetch_lines(mdata, buf, sizeof(buf), NULL, fetch_tempfile, fp);
-      if (rc)
+      if (num_heads >= max_heads)
       {
-        mutt_file_fclose(&fp);
-        if (rc < 0)
-          break;
-
-        /* invalid response */
-        if (!mutt_str_startswith(buf, "423", CASE_MATCH))
-        {
-          mutt_error("HEAD: %s", buf);
-          break;
-        }
-
-        /* no such article */
-        if (mdata->bcache)
-        {
-          snprintf(buf, sizeof(buf), "%u", current);
-          mutt_debug(LL_DEBUG2, "#3 mutt_bcache_del %s\n", buf);
-          mutt_bcache_del(mdata->bcache, buf);
-        }
-        rc = 0;
-        continue;
+        max_heads = MAX(64, 2 * max_heads);
+        mutt_mem_realloc(&heads, max_heads * sizeof(struct HeadRequest));
       }
+      heads[num_heads].anum = current;
+      heads[num_heads].index = m->msg_count;
+      num_heads++;
 
-      /* parse header */
-      m->emails[m->msg_count] = mutt_email_new();
-      e = m->emails[m->msg_count];
-      e->env = mutt_rfc822_read_header(fp, e, false, false);
-      e->received = e->date_sent;
-      mutt_file_fclose(&fp);
+      e = mutt_email_new();
+      m->emails[m->msg_count] = e;
+      e->index = m->msg_count++;
+      first_over = current + 1;
+      continue;
     }
 
     /* save header in context */
     e->index = m->msg_count++;
-    e->read = false;
-    e->old = false;
-    e->deleted = false;
-    e->edata = nntp_edata_new();
-    e->free_edata = nntp_edata_free;
-    nntp_edata_get(e)->article_num = current;
-    if (restore)
-      e->changed = true;
-    else
+    nntp_add_email(m, e, current, restore);
+    first_over = current + 1;
+  }
+
+  if (num_heads > 0)
+  {
+    if (nntp_fetch_heads(m, &fc, heads, num_heads) < 0)
+      rc = -1;
+
+    /* close the gaps left by articles that don't exist */
+    int j = heads[0].index;
+    for (int i = j; i < m->msg_count; i++)
     {
-      nntp_article_status(m, e, NULL, nntp_edata_get(e)->article_num);
-      if (!e->read)
-        nntp_parse_xref(m, e);
+      if (!m->emails[i])
+        continue;
+      m->emails[j] = m->emails[i];
+      m->emails[j]->index = j;
+      j++;
     }
-    if (current > mdata->last_loaded)
-      mdata->last_loaded = current;
-    first_over = current + 1;
+    for (int i = j; i < m->msg_count; i++)
+      m->emails[i] = NULL;
+    m->msg_count = j;
+    FREE(&heads);
   }
 
   if (!C_NntpListgroup || !mdata->adata->hasLISTGROUP)
@@ -1459,12 +1673,33 @@ static int nntp_fetch_headers(struct Mailbox *m, void *hc, anum_t first, anum_t
   if ((current <= last) && (rc == 0) && !mdata->deleted)
   {
     char *cmd = mdata->adata->hasOVER ? "OVER" : "XOVER";
+#ifdef USE_HCACHE
+    const int over_first = m->msg_count;
+#endif
     snprintf(buf, sizeof(buf), "%s %u-%u\r\n", cmd, current, last);
     rc = nntp_fetch_lines(mdata, buf, sizeof(buf), NULL, parse_overview_line, &fc);
     if (rc > 0)
     {
       mutt_error("%s: %s", cmd, buf);
     }
+
+#ifdef USE_HCACHE
+    /* store the new headers in one batch, not while waiting for the server */
+    if (fc.hc && (over_first < m->msg_count))
+    {
+      mutt_hcache_begin(fc.hc);
+      for (int i = over_first; i < m->msg_count; i++)
+      {
+        anum_t anum = nntp_edata_get(m->emails[i])->article_num;
+        if (fc.messages[anum - first] != 2)
+          continue;
+        snprintf(buf, sizeof(buf), "%u", anum);
+        mutt_debug(LL_DEBUG2, "mutt_hcache_store %s\n", buf);
+        mutt_hcache_store(fc.hc, buf, strlen(buf), m->emails[i], 0);
+      }
+      mutt_hcache_commit(fc.hc);
+    }
+#endif
   }
 
   FREE(&fc.messages);
@@ -1610,18 +1845,15 @@ static int check_mailbox(struct Mailbox *m)
         hdata = mutt_hcache_fetch(hc, buf, strlen(buf));
         if (hdata)
         {
-          bool deleted;
+          struct Email cached = { 0 };
 
           mutt_debug(LL_DEBUG2, "#1 mutt_hcache_fetch %s\n", buf);
-          e = mutt_hcache_restore(hdata);
+          mutt_hcache_restore_flags(hdata, &cached);
           mutt_hcache_free(hc, &hdata);
-          e->edata = NULL;
-          deleted = e->deleted;
-          flagged = e->flagged;
-          mutt_email_free(&e);
+          flagged = cached.flagged;
 
           /* header marked as deleted, removing from context */
-          if (deleted)
+          if (cached.deleted)
           {
             mutt_set_flag(m, m->emails[i], MUTT_TAG, false);
             mutt_email_free(&m->emails[i]);
@@ -1656,17 +1888,13 @@ static int check_mailbox(struct Mailbox *m)
       hdata = mutt_hcache_fetch(hc, buf, strlen(buf));
       if (hdata)
       {
-        mutt_debug(LL_DEBUG2, "#2 mutt_hcache_fetch %s\n", buf);
-        if (m->msg_count >= m->email_max)
-          mx_alloc_memory(m);
+        struct Email cached = { 0 };
 
-        e = mutt_hcache_restore(hdata);
-        m->emails[m->msg_count] = e;
-        mutt_hcache_free(hc, &hdata);
-        e->edata = NULL;
-        if (e->deleted)
+        mutt_debug(LL_DEBUG2, "#2 mutt_hcache_fetch %s\n", buf);
+        mutt_hcache_restore_flags(hdata, &cached);
+        if (cached.deleted)
         {
-          mutt_email_free(&e);
+          mutt_hcache_free(hc, &hdata);
           if (mdata->bcache)
           {
             mutt_debug(LL_DEBUG2, "mutt_bcache_del %s\n", buf);
@@ -1675,6 +1903,16 @@ static int check_mailbox(struct Mailbox *m)
           continue;
         }
 
+        if (m->msg_count >= m->email_max)
+          mx_alloc_memory(m);
+
+        e = mutt_hcache_restore(hdata);
+        mutt_hcache_free(hc, &hdata);
+        if (!e)
+          continue;
+        m->emails[m->msg_count] = e;
+        e->edata = NULL;
+
         m->msg_count++;
         e->read = false;
         e->old = false;
@@ -2678,6 +2916,14 @@ static int nntp_mbox_close(struct Mailbox *m)
   if (!mdata->adata || !mdata->adata->groups_hash || !mdata->group)
     return 0;
 
+  /* fold the journal into .newsrc, so other newsreaders see it */
+  struct NntpAccountData *adata = mdata->adata;
+  if ((adata->journal_size != 0) && (nntp_newsrc_parse(adata) >= 0))
+  {
+    nntp_newsrc_compact(adata);
+    nntp_newsrc_close(adata);
+  }
+
   tmp_mdata = mutt_hash_find(mdata->adata->groups_hash, mdata->group);
   if (!tmp_mdata || (tmp_mdata != mdata))
     nntp_mdata_free((void **) &mdata);
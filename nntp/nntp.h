@@ -90,6 +90,9 @@ struct NntpAccountData
   bool newsrc_modified    : 1;
   FILE *fp_newsrc;
   char *newsrc_file;
+  char *newsrc_text;     ///< Contents of .newsrc, as last read or written
+  size_t newsrc_textlen; ///< Length of newsrc_text
+  off_t journal_size;    ///< Size of the .newsrc journal, as last read or written
   char *authenticators;
   char *overview_fmt;
   off_t size;
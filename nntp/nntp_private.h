@@ -55,7 +55,9 @@ void nntp_delete_group_cache(struct NntpMboxData *mdata);
 struct NntpEmailData *nntp_edata_get(struct Email *e);
 void nntp_group_unread_stat(struct NntpMboxData *mdata);
 void nntp_hash_destructor_t(int type, void *obj, intptr_t data);
+void nntp_hashelem_free(int type, void *obj, intptr_t data);
 void nntp_mdata_free(void **ptr);
+int  nntp_newsrc_compact(struct NntpAccountData *adata);
 void nntp_newsrc_gen_entries(struct Mailbox *m);
 int  nntp_open_connection(struct NntpAccountData *adata);
 void nntp_article_status(struct Mailbox *m, struct Email *e, char *group, anum_t anum);
@@ -76,6 +76,7 @@ const int NmUriProtocolLen = sizeof(NmUriProtocol) - 1;
 int C_NmDbLimit;       ///< Config: (notmuch) Default limit for Notmuch queries
 char *C_NmDefaultUri;  ///< Config: (notmuch) Path to the Notmuch database
 char *C_NmExcludeTags; ///< Config: (notmuch) Exclude messages with these tags
+int C_NmOpenBatch;     ///< Config: (notmuch) Number of results to read per batch
 int C_NmOpenTimeout;   ///< Config: (notmuch) Database timeout
 char *C_NmQueryType; ///< Config: (notmuch) Default query type: 'threads' or 'messages'
 int C_NmQueryWindowCurrentPosition; ///< Config: (notmuch) Position of current search window
@@ -938,8 +939,10 @@ static void append_message(header_cache_t *h, struct Mailbox *m,
   if (from_cache)
   {
     e = mutt_hcache_restore(from_cache);
+    mutt_hcache_free(h, &from_cache);
   }
-  else
+  const bool cached = e;
+  if (!cached)
 #endif
   {
     if (access(path, F_OK) == 0)
@@ -972,11 +975,7 @@ static void append_message(header_cache_t *h, struct Mailbox *m,
 
 #ifdef USE_HCACHE
 
-  if (from_cache)
-  {
-    mutt_hcache_free(h, &from_cache);
-  }
-  else
+  if (!cached)
   {
     mutt_hcache_store(h, newpath ? newpath : path,
                       mutt_str_strlen(newpath ? newpath : path), e, 0);
@@ -1097,40 +1096,59 @@ static notmuch_messages_t *get_messages(notmuch_query_t *query)
  * @param m     Mailbox
  * @param q     Notmuch query
  * @param dedup De-duplicate the results
- * @retval true  Success
- * @retval false Failure
+ * @param batch Maximum number of new messages to read, 0 for all
+ * @retval  1 A batch was read, there may be more results
+ * @retval  0 All the results were read
+ * @retval -1 Failure, or interrupted
+ *
+ * When reading in batches, the date of the oldest result so far is kept, so
+ * that the next batch can carry on from there.
  */
-static bool read_mesgs_query(struct Mailbox *m, notmuch_query_t *q, bool dedup)
+static int read_mesgs_query(struct Mailbox *m, notmuch_query_t *q, bool dedup,
+                            int batch)
 {
   struct NmMboxData *mdata = nm_mdata_get(m);
   if (!mdata)
-    return false;
+    return -1;
 
   int limit = get_limit(mdata);
 
   notmuch_messages_t *msgs = get_messages(q);
 
   if (!msgs)
-    return false;
+    return -1;
 
   header_cache_t *h = nm_hcache_open(m);
 
+  int rc = 0;
+  int num = 0;
   for (; notmuch_messages_valid(msgs) && ((limit == 0) || (m->msg_count < limit));
        notmuch_messages_move_to_next(msgs))
   {
+    if ((batch != 0) && (num >= batch))
+    {
+      rc = 1;
+      break;
+    }
     if (SigInt == 1)
     {
       nm_hcache_close(h);
       SigInt = 0;
-      return false;
+      return -1;
     }
     notmuch_message_t *nm = notmuch_messages_get(msgs);
+    const int count = m->msg_count;
     append_message(h, m, q, nm, dedup);
+    if (m->msg_count > count)
+      num++;
+    if (batch != 0)
+      mdata->stream_until =
+          MIN(mdata->stream_until, notmuch_message_get_date(nm));
     notmuch_message_destroy(nm);
   }
 
   nm_hcache_close(h);
-  return true;
+  return rc;
 }
 
 /**
@@ -1167,37 +1185,85 @@ static notmuch_threads_t *get_threads(notmuch_query_t *query)
  * @param q     Query type
  * @param dedup Should the results be de-duped?
  * @param limit Maximum number of results
- * @retval true  Success
- * @retval false Failure
+ * @param batch Maximum number of new threads to read, 0 for all
+ * @retval  1 A batch was read, there may be more results
+ * @retval  0 All the results were read
+ * @retval -1 Failure, or interrupted
+ *
+ * When reading in batches, the date of the oldest result so far is kept, so
+ * that the next batch can carry on from there.  A thread's newest message is
+ * never older than the one that placed it in the results.
  */
-static bool read_threads_query(struct Mailbox *m, notmuch_query_t *q, bool dedup, int limit)
+static int read_threads_query(struct Mailbox *m, notmuch_query_t *q, bool dedup,
+                              int limit, int batch)
 {
   struct NmMboxData *mdata = nm_mdata_get(m);
   if (!mdata)
-    return false;
+    return -1;
 
   notmuch_threads_t *threads = get_threads(q);
   if (!threads)
-    return false;
+    return -1;
 
   header_cache_t *h = nm_hcache_open(m);
 
+  int rc = 0;
+  int num = 0;
   for (; notmuch_threads_valid(threads) && ((limit == 0) || (m->msg_count < limit));
        notmuch_threads_move_to_next(threads))
   {
+    if ((batch != 0) && (num >= batch))
+    {
+      rc = 1;
+      break;
+    }
     if (SigInt == 1)
     {
       nm_hcache_close(h);
       SigInt = 0;
-      return false;
+      return -1;
     }
     notmuch_thread_t *thread = notmuch_threads_get(threads);
+    const int count = m->msg_count;
     append_thread(h, m, q, thread, dedup);
+    if (m->msg_count > count)
+      num++;
+    if (batch != 0)
+      mdata->stream_until =
+          MIN(mdata->stream_until, notmuch_thread_get_newest_date(thread));
     notmuch_thread_destroy(thread);
   }
 
   nm_hcache_close(h);
-  return true;
+  return rc;
+}
+
+/**
+ * read_query - Read the results of a query
+ * @param m     Mailbox
+ * @param q     Notmuch query
+ * @param dedup De-duplicate the results
+ * @param batch Maximum number of new results to read, 0 for all
+ * @retval  1 A batch was read, there may be more results
+ * @retval  0 All the results were read
+ * @retval -1 Failure, or interrupted
+ */
+static int read_query(struct Mailbox *m, notmuch_query_t *q, bool dedup,
+                      int batch)
+{
+  struct NmMboxData *mdata = nm_mdata_get(m);
+  if (!mdata)
+    return -1;
+
+  switch (mdata->query_type)
+  {
+    case NM_QUERY_TYPE_MESGS:
+      return read_mesgs_query(m, q, dedup, batch);
+    case NM_QUERY_TYPE_THREADS:
+      return read_threads_query(m, q, dedup, get_limit(mdata), batch);
+  }
+
+  return -1;
 }
 
 /**
@@ -1682,7 +1748,7 @@ int nm_read_entire_thread(struct Mailbox *m, struct Email *e)
   apply_exclude_tags(q);
   notmuch_query_set_sort(q, NOTMUCH_SORT_NEWEST_FIRST);
 
-  read_threads_query(m, q, true, 0);
+  read_threads_query(m, q, true, 0, 0);
   m->mtime.tv_sec = time(NULL);
   m->mtime.tv_nsec = 0;
   rc = 0;
@@ -1825,6 +1891,81 @@ void nm_query_window_backward(void)
   mutt_debug(LL_DEBUG2, "(%d)\n", C_NmQueryWindowCurrentPosition);
 }
 
+/**
+ * nm_mbox_is_loading - Are the results of the query still being read?
+ * @param m Mailbox
+ * @retval true More results will be read by nm_mbox_read_batch()
+ *
+ * @sa $nm_open_batch
+ */
+bool nm_mbox_is_loading(struct Mailbox *m)
+{
+  struct NmMboxData *mdata = nm_mdata_get(m);
+  return mdata && mdata->streaming;
+}
+
+/**
+ * nm_mbox_read_batch - Read the next batch of a partially read query
+ * @param m Mailbox
+ * @retval -1 Error
+ * @retval  0 No new messages
+ * @retval #MUTT_NEW_MAIL More messages were read
+ *
+ * Called by the index, while the user is idle, until nm_mbox_is_loading() is
+ * false.  The query carries on from the date of the oldest result read so far.
+ * Results with that same date are read again and de-duplicated, so nothing is
+ * lost even if the database changed in between.
+ *
+ * @sa $nm_open_batch
+ */
+int nm_mbox_read_batch(struct Mailbox *m)
+{
+  struct NmMboxData *mdata = nm_mdata_get(m);
+  if (!mdata || !mdata->streaming)
+    return -1;
+
+  int rc = 0;
+  int more = -1;
+  int oldcount = m->msg_count;
+
+  notmuch_database_t *db = nm_db_get(m, false);
+  const char *str = get_query_string(mdata, true);
+  if (db && str)
+  {
+    struct Buffer *buf = mutt_buffer_pool_get();
+    nm_query_until(buf, str, mdata->stream_until);
+    notmuch_query_t *q = notmuch_query_create(db, mutt_b2s(buf));
+    if (q)
+    {
+      mutt_debug(LL_DEBUG2, "nm: reading batch (%s)\n", mutt_b2s(buf));
+      apply_exclude_tags(q);
+      notmuch_query_set_sort(q, NOTMUCH_SORT_NEWEST_FIRST);
+      mdata->noprogress = true;
+      more = read_query(m, q, true, C_NmOpenBatch);
+      notmuch_query_destroy(q);
+    }
+    mutt_buffer_pool_release(&buf);
+  }
+
+  nm_db_release(m);
+
+  /* On error, or user interrupt, keep what we've got */
+  mdata->streaming = (more == 1);
+  if (more < 0)
+    rc = -1;
+
+  mutt_debug(LL_DEBUG1, "nm: read batch [until=%lld, count=%d, more=%d]\n",
+             (long long) mdata->stream_until, m->msg_count, mdata->streaming);
+
+  if (m->msg_count > oldcount)
+  {
+    mutt_mailbox_changed(m, MBN_INVALID);
+    rc = MUTT_NEW_MAIL;
+  }
+
+  return rc;
+}
+
 /**
  * nm_message_is_still_queried - Is a message still visible in the query?
  * @param m Mailbox
@@ -2197,23 +2338,23 @@ static int nm_mbox_open(struct Mailbox *m)
     mx_alloc_memory(m);
   }
 
+  /* Only read the first batch now, the rest is read by nm_mbox_read_batch() */
+  mdata->stream_until = TIME_T_MAX;
+  mdata->streaming = false;
+  if ((C_NmOpenBatch != 0) && (mdata->oldmsgcount > C_NmOpenBatch))
+    mdata->oldmsgcount = C_NmOpenBatch;
+
   int rc = -1;
 
   notmuch_query_t *q = get_query(m, false);
   if (q)
   {
     rc = 0;
-    switch (mdata->query_type)
-    {
-      case NM_QUERY_TYPE_MESGS:
-        if (!read_mesgs_query(m, q, false))
-          rc = -2;
-        break;
-      case NM_QUERY_TYPE_THREADS:
-        if (!read_threads_query(m, q, false, get_limit(mdata)))
-          rc = -2;
-        break;
-    }
+    int more = read_query(m, q, false, C_NmOpenBatch);
+    if (more < 0)
+      rc = -2;
+    else
+      mdata->streaming = (more == 1);
     notmuch_query_destroy(q);
   }
 
@@ -2244,8 +2385,16 @@ static int nm_mbox_check(struct Mailbox *m, int *index_hint)
     return -1;
 
   struct NmMboxData *mdata = nm_mdata_get(m);
+  if (!mdata)
+    return -1;
+
+  /* The index reads the rest of the query with nm_mbox_read_batch().
+   * Changes to the database are picked up once that's done. */
+  if (mdata->streaming)
+    return 0;
+
   time_t mtime = 0;
-  if (!mdata || (nm_db_get_mtime(m, &mtime) != 0))
+  if (nm_db_get_mtime(m, &mtime) != 0)
     return -1;
 
   int new_flags = 0;
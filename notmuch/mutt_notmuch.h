@@ -47,6 +47,7 @@ struct stat;
 extern int   C_NmDbLimit;
 extern char *C_NmDefaultUri;
 extern char *C_NmExcludeTags;
+extern int   C_NmOpenBatch;
 extern int   C_NmOpenTimeout;
 extern char *C_NmQueryType;
 extern int   C_NmQueryWindowCurrentPosition;
@@ -64,6 +65,8 @@ int   nm_get_all_tags            (struct Mailbox *m, char **tag_list, int *tag_c
 char *nm_email_get_folder        (struct Email *e);
 void  nm_db_longrun_done            (struct Mailbox *m);
 void  nm_db_longrun_init            (struct Mailbox *m, bool writable);
+bool  nm_mbox_is_loading         (struct Mailbox *m);
+int   nm_mbox_read_batch         (struct Mailbox *m);
 bool  nm_message_is_still_queried(struct Mailbox *m, struct Email *e);
 void  nm_parse_type_from_query   (struct NmMboxData *mdata, char *buf);
 int   nm_path_probe              (const char *path, const struct stat *st);
@@ -41,8 +41,9 @@
    (LIBNOTMUCH_MAJOR_VERSION == (major) &&                                        \
     LIBNOTMUCH_MINOR_VERSION == (minor) && LIBNOTMUCH_MICRO_VERSION >= (micro)))
 
-const int NmUriProtocolLen;
+extern const int NmUriProtocolLen;
 
+struct Buffer;
 struct Mailbox;
 
 /**
@@ -79,9 +80,11 @@ struct NmMboxData
   struct Progress progress; /**< A progress bar */
   int oldmsgcount;
   int ignmsgcount; /**< Ignored messages */
+  time_t stream_until; /**< Date of the oldest query result read so far */
 
   bool noprogress : 1;     /**< Don't show the progress bar */
   bool progress_ready : 1; /**< A progress bar has been initialised */
+  bool streaming : 1;      /**< More query results are still to be read */
 };
 
 /**
@@ -117,4 +120,6 @@ void                  nm_mdata_free(void **ptr);
 struct NmMboxData *   nm_mdata_get (struct Mailbox *m);
 struct NmMboxData *   nm_mdata_new (const char *uri);
 
+void nm_query_until(struct Buffer *buf, const char *query, time_t until);
+
 #endif /* MUTT_NOTMUCH_NOTMUCH_PRIVATE_H */
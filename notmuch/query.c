@@ -0,0 +1,45 @@
+/**
+ * @file
+ * Notmuch query strings
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page nm_query Notmuch query strings
+ *
+ * Notmuch query strings
+ */
+
+#include "config.h"
+#include <time.h>
+#include "notmuch_private.h"
+#include "mutt/mutt.h"
+
+/**
+ * nm_query_until - Restrict a query to results no newer than a date
+ * @param buf   Buffer for the result
+ * @param query Notmuch query
+ * @param until Latest date to match
+ *
+ * The date range is inclusive, so results dated exactly `until` match again.
+ */
+void nm_query_until(struct Buffer *buf, const char *query, time_t until)
+{
+  if (!buf || !query)
+    return;
+
+  mutt_buffer_printf(buf, "(%s) and date:..@%lld", query, (long long) until);
+}
@@ -202,6 +202,28 @@ static struct PatternHead *SearchPattern = NULL; /**< current search pattern */
 static char LastSearch[256] = { 0 };      /**< last pattern searched for */
 static char LastSearchExpn[1024] = { 0 }; /**< expanded version of LastSearch */
 
+/**
+ * is_plain_string - Does a regex only match itself?
+ * @param s Regex to check
+ * @retval true The regex is lower-case ASCII, with no special characters
+ *
+ * Matching such a regex is the same as a case-insensitive substring search,
+ * which an IMAP server can do.
+ */
+static bool is_plain_string(const char *s)
+{
+  for (; *s; s++)
+  {
+    if (!isascii((unsigned char) *s) || isupper((unsigned char) *s) ||
+        strchr("\\^$.[]|()*+?{}", *s))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /**
  * eat_regex - Parse a regex - Implements ::pattern_eat_t
  */
@@ -249,6 +271,9 @@ static bool eat_regex(struct Pattern *pat, int flags, struct Buffer *s, struct B
       FREE(&pat->p.regex);
       return false;
     }
+    /* Still matched locally as a regex, but the IMAP server can search for it */
+    if (is_plain_string(buf.data))
+      pat->plain = mutt_str_strdup(buf.data);
     FREE(&buf.data);
   }
 
@@ -1357,6 +1382,8 @@ void mutt_pattern_free(struct PatternHead **pat)
       FREE(&np->p.regex);
     }
 
+    FREE(&np->plain);
+    FREE(&np->server_uids);
     mutt_pattern_free(&np->child);
     FREE(&np);
 
@@ -2005,6 +2032,16 @@ static int is_pattern_cache_set(int cache_entry)
 int mutt_pattern_exec(struct Pattern *pat, PatternExecFlags flags,
                       struct Mailbox *m, struct Email *e, struct PatternCache *cache)
 {
+#ifdef USE_IMAP
+  /* IMAP search may have evaluated this part of the pattern on the server */
+  if (pat->server && m && (m->magic == MUTT_IMAP))
+  {
+    const int rc = imap_search_match(pat, e);
+    if (rc >= 0)
+      return rc;
+  }
+#endif
+
   switch (pat->op)
   {
     case MUTT_PAT_AND:
@@ -2058,22 +2095,14 @@ int mutt_pattern_exec(struct Pattern *pat, PatternExecFlags flags,
        * This is also the case when message scoring.  */
       if (!m)
         return 0;
-#ifdef USE_IMAP
-      /* IMAP search sets e->matched at search compile time */
-      if ((m->magic == MUTT_IMAP) && pat->stringmatch)
-        return e->matched;
-#endif
       return pat->not^msg_search(m, pat, e->msgno);
     case MUTT_PAT_SERVERSEARCH:
 #ifdef USE_IMAP
       if (!m)
         return 0;
+      /* Only the server can evaluate this, see imap_search() */
       if (m->magic == MUTT_IMAP)
-      {
-        if (pat->stringmatch)
-          return e->matched;
         return 0;
-      }
       mutt_error(_("error: server custom search only supported with IMAP"));
       return 0;
 #else
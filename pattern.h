@@ -57,6 +57,11 @@ struct Pattern
   bool ismulti : 1; /**< multiple case (only for I pattern now) */
   int min;
   int max;
+  bool server : 1;   ///< The server has evaluated this part, see server_uids
+  char *plain;               ///< Text that the regex is equivalent to, for IMAP search
+  unsigned int *server_uids; ///< UIDs of the messages the server matched, sorted
+  size_t server_num;         ///< Number of server_uids
+  unsigned int server_uid_max; ///< Highest UID covered by the server's search
   SLIST_ENTRY(Pattern) entries;
   struct PatternHead *child; /**< arguments to logical op */
   union {
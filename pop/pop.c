@@ -74,6 +74,8 @@ bool C_PopLast;  ///< Config: (pop) Use the 'LAST' command to fetch new mail
 #define HC_FNAME "neomutt" /* filename for hcache as POP lacks paths */
 #define HC_FEXT "hcache"   /* extension for hcache as POP lacks paths */
 
+#define POP_FETCH_BATCH 64 /* number of headers fetched in one pop_pipeline() */
+
 /**
  * cache_id - Make a message-cache-compatible id
  * @param id POP message id
@@ -166,97 +168,154 @@ static int fetch_message(char *line, void *data)
 }
 
 /**
- * pop_read_header - Read header
- * @param adata POP Account data
- * @param e     Email
+ * fetch_list - Parse the reply to a LIST command - Implements ::pop_fetch_t
+ * @param line Status line
+ * @param data Size of the message
+ * @retval 0 Always
+ */
+static int fetch_list(char *line, void *data)
+{
+  size_t *length = data;
+  int index = 0;
+
+  sscanf(line, "+OK %d %zu", &index, length);
+  return 0;
+}
+
+/**
+ * fetch_buffer - Append a line to a Buffer - Implements ::pop_fetch_t
+ * @param line String to add
+ * @param data Buffer
+ * @retval 0 Always
+ */
+static int fetch_buffer(char *line, void *data)
+{
+  struct Buffer *buf = data;
+
+  mutt_buffer_addstr(buf, line);
+  mutt_buffer_addch(buf, '\n');
+  return 0;
+}
+
+/**
+ * pop_read_headers - Read the headers of several emails
+ * @param adata  POP Account data
+ * @param emails Emails to read
+ * @param num    Number of Emails
  * @retval  0 Success
  * @retval -1 Connection lost
  * @retval -2 Invalid command or execution error
- * @retval -3 Error writing to tempfile
+ *
+ * The LIST and TOP commands for all the Emails go through pop_pipeline(), so
+ * a server supporting PIPELINING doesn't cost two round trips per email.
+ * The headers are parsed straight from memory.
  */
-static int pop_read_header(struct PopAccountData *adata, struct Email *e)
+static int pop_read_headers(struct PopAccountData *adata, struct Email **emails, int num)
 {
-  FILE *fp = mutt_file_mkstemp();
-  if (!fp)
+  struct PopCommand *cmds = mutt_mem_calloc(num * 2, sizeof(struct PopCommand));
+  size_t *lengths = mutt_mem_calloc(num, sizeof(size_t));
+  struct Buffer *hdrs = mutt_mem_calloc(num, sizeof(struct Buffer));
+  int rc = 0;
+
+  for (int i = 0; i < num; i++)
   {
-    mutt_perror(_("Can't create temporary file"));
-    return -3;
+    struct PopCommand *list = &cmds[2 * i];
+    snprintf(list->cmd, sizeof(list->cmd), "LIST %d\r\n", emails[i]->refno);
+    list->callback = fetch_list;
+    list->data = &lengths[i];
+
+    struct PopCommand *top = &cmds[2 * i + 1];
+    snprintf(top->cmd, sizeof(top->cmd), "TOP %d 0\r\n", emails[i]->refno);
+    top->multiline = true;
+    top->callback = fetch_buffer;
+    top->data = &hdrs[i];
   }
 
-  int index = 0;
-  size_t length = 0;
-  char buf[1024];
-
-  snprintf(buf, sizeof(buf), "LIST %d\r\n", e->refno);
-  int rc = pop_query(adata, buf, sizeof(buf));
-  if (rc == 0)
+  if (pop_pipeline(adata, cmds, num * 2, NULL) == -1)
   {
-    sscanf(buf, "+OK %d %zu", &index, &length);
+    rc = -1;
+    goto done;
+  }
 
-    snprintf(buf, sizeof(buf), "TOP %d 0\r\n", e->refno);
-    rc = pop_fetch_data(adata, buf, NULL, fetch_message, fp);
+  for (int i = 0; (rc == 0) && (i < num); i++)
+  {
+    struct Email *e = emails[i];
 
-    if (adata->cmd_top == 2)
+    rc = cmds[2 * i].rc;
+    if (rc == 0)
     {
-      if (rc == 0)
+      rc = cmds[2 * i + 1].rc;
+
+      if (adata->cmd_top == 2)
       {
-        adata->cmd_top = 1;
+        if (rc == 0)
+        {
+          adata->cmd_top = 1;
 
-        mutt_debug(LL_DEBUG1, "set TOP capability\n");
-      }
+          mutt_debug(LL_DEBUG1, "set TOP capability\n");
+        }
 
-      if (rc == -2)
-      {
-        adata->cmd_top = 0;
+        if (rc == -2)
+        {
+          adata->cmd_top = 0;
 
-        mutt_debug(LL_DEBUG1, "unset TOP capability\n");
-        snprintf(adata->err_msg, sizeof(adata->err_msg), "%s",
-                 _("Command TOP is not supported by server"));
+          mutt_debug(LL_DEBUG1, "unset TOP capability\n");
+          snprintf(adata->err_msg, sizeof(adata->err_msg), "%s",
+                   _("Command TOP is not supported by server"));
+        }
       }
     }
-  }
 
-  switch (rc)
-  {
-    case 0:
+    if (rc == 0)
     {
-      rewind(fp);
-      e->env = mutt_rfc822_read_header(fp, e, false, false);
-      e->content->length = length - e->content->offset + 1;
-      rewind(fp);
-      while (!feof(fp))
-      {
-        e->content->length--;
-        fgets(buf, sizeof(buf), fp);
-      }
-      break;
+      /* An empty reply leaves the Buffer unallocated, but still gives an
+       * Envelope */
+      struct Buffer *buf = &hdrs[i];
+      const char *hdr = mutt_b2s(buf);
+      const size_t hdrlen = mutt_buffer_len(buf);
+      e->env = mutt_rfc822_read_header_mem(hdr, hdrlen, e, false, false);
+
+      /* The size from LIST counts CRLF line endings, we store LF */
+      size_t lines = 0;
+      for (const char *nl = hdr; (nl = memchr(nl, '\n', hdrlen - (nl - hdr))); nl++)
+        lines++;
+      e->content->length = lengths[i] - e->content->offset - lines;
     }
-    case -2:
+    else if (rc == -2)
     {
       mutt_error("%s", adata->err_msg);
-      break;
-    }
-    case -3:
-    {
-      mutt_error(_("Can't write header to temporary file"));
-      break;
     }
   }
 
-  mutt_file_fclose(&fp);
+done:
+  for (int i = 0; i < num; i++)
+    FREE(&hdrs[i].data);
+  FREE(&hdrs);
+  FREE(&lengths);
+  FREE(&cmds);
   return rc;
 }
 
+/**
+ * struct UidlData - Data for fetch_uidl()
+ */
+struct UidlData
+{
+  struct Mailbox *mailbox; ///< Mailbox
+  struct Hash *uids;       ///< Emails keyed by UID
+};
+
 /**
  * fetch_uidl - parse UIDL - Implements ::pop_fetch_t
  * @param line String to parse
- * @param data Mailbox
+ * @param data UidlData
  * @retval  0 Success
  * @retval -1 Failure
  */
 static int fetch_uidl(char *line, void *data)
 {
-  struct Mailbox *m = data;
+  struct UidlData *ud = data;
+  struct Mailbox *m = ud->mailbox;
   struct PopAccountData *adata = pop_adata_get(m);
   char *endp = NULL;
 
@@ -272,47 +331,40 @@ static int fetch_uidl(char *line, void *data)
   if (strlen(line) == 0)
     return -1;
 
-  int i;
-  for (i = 0; i < m->msg_count; i++)
-  {
-    struct PopEmailData *edata = m->emails[i]->edata;
-    if (mutt_str_strcmp(line, edata->uid) == 0)
-      break;
-  }
-
-  if (i == m->msg_count)
+  struct Email *e = mutt_hash_find(ud->uids, line);
+  if (!e)
   {
     mutt_debug(LL_DEBUG1, "new header %d %s\n", index, line);
 
-    if (i >= m->email_max)
+    if (m->msg_count >= m->email_max)
       mx_alloc_memory(m);
 
-    m->msg_count++;
-    m->emails[i] = mutt_email_new();
+    e = mutt_email_new();
+    m->emails[m->msg_count++] = e;
 
-    m->emails[i]->edata = pop_edata_new(line);
-    m->emails[i]->free_edata = pop_edata_free;
+    struct PopEmailData *edata = pop_edata_new(line);
+    e->edata = edata;
+    e->free_edata = pop_edata_free;
+    mutt_hash_insert(ud->uids, edata->uid, e);
   }
-  else if (m->emails[i]->index != index - 1)
+  else if (e->index != index - 1)
     adata->clear_cache = true;
 
-  m->emails[i]->refno = index;
-  m->emails[i]->index = index - 1;
+  e->refno = index;
+  e->index = index - 1;
 
   return 0;
 }
 
 /**
  * msg_cache_check - Check the Body Cache for an ID - Implements ::bcache_list_t
+ *
+ * @note data is a Hash of the UIDs of the mailbox
  */
 static int msg_cache_check(const char *id, struct BodyCache *bcache, void *data)
 {
-  struct Mailbox *m = data;
-  if (!m)
-    return -1;
-
-  struct PopAccountData *adata = pop_adata_get(m);
-  if (!adata)
+  struct Hash *uids = data;
+  if (!uids)
     return -1;
 
 #ifdef USE_HCACHE
@@ -321,19 +373,26 @@ static int msg_cache_check(const char *id, struct BodyCache *bcache, void *data)
     return 0;
 #endif
 
-  for (int i = 0; i < m->msg_count; i++)
-  {
-    struct PopEmailData *edata = m->emails[i]->edata;
-    /* if the id we get is known for a header: done (i.e. keep in cache) */
-    if (edata->uid && (mutt_str_strcmp(edata->uid, id) == 0))
-      return 0;
-  }
+  /* if the id we get is known for a header: done (i.e. keep in cache) */
+  if (mutt_hash_find(uids, id))
+    return 0;
 
   /* message not found in context -> remove it from cache
    * return the result of bcache, so we stop upon its first error */
   return mutt_bcache_del(bcache, cache_id(id));
 }
 
+/**
+ * msg_cache_collect - Note an ID in the Body Cache - Implements ::bcache_list_t
+ *
+ * @note data is a Hash to add the ID to
+ */
+static int msg_cache_collect(const char *id, struct BodyCache *bcache, void *data)
+{
+  mutt_hash_insert(data, id, bcache);
+  return 0;
+}
+
 #ifdef USE_HCACHE
 /**
  * pop_hcache_namer - Create a header cache filename for a POP mailbox - Implements ::hcache_namer_t
@@ -370,7 +429,6 @@ static header_cache_t *pop_hcache_open(struct PopAccountData *adata, const char
  * @retval  0 Success
  * @retval -1 Connection lost
  * @retval -2 Invalid command or execution error
- * @retval -3 Error writing to tempfile
  */
 static int pop_fetch_headers(struct Mailbox *m)
 {
@@ -397,11 +455,16 @@ static int pop_fetch_headers(struct Mailbox *m)
     mx_alloc_memory(m);
   }
 
+  struct UidlData ud = { m, mutt_hash_new(MAX(m->msg_count, 128), MUTT_HASH_NO_FLAGS) };
   for (int i = 0; i < m->msg_count; i++)
+  {
+    struct PopEmailData *edata = m->emails[i]->edata;
     m->emails[i]->refno = -1;
+    mutt_hash_insert(ud.uids, edata->uid, m->emails[i]);
+  }
 
   const int old_count = m->msg_count;
-  int rc = pop_fetch_data(adata, "UIDL\r\n", NULL, fetch_uidl, m);
+  int rc = pop_fetch_data(adata, "UIDL\r\n", NULL, fetch_uidl, &ud);
   const int new_count = m->msg_count;
   m->msg_count = old_count;
 
@@ -424,12 +487,6 @@ static int pop_fetch_headers(struct Mailbox *m)
     }
   }
 
-  if (!m->quiet)
-  {
-    mutt_progress_init(&progress, _("Fetching message headers..."),
-                       MUTT_PROGRESS_MSG, C_ReadInc, new_count - old_count);
-  }
-
   if (rc == 0)
   {
     int i, deleted;
@@ -449,15 +506,28 @@ static int pop_fetch_headers(struct Mailbox *m)
           deleted);
     }
 
-    bool hcached = false;
+    /* Reconcile the new messages with the caches first,
+     * so only the headers that are really missing get fetched */
+    const int num_new = new_count - old_count;
+    struct Email **fetch = mutt_mem_calloc(MAX(num_new, 1), sizeof(struct Email *));
+    bool *cached = mutt_mem_calloc(MAX(num_new, 1), sizeof(bool));
+    int num_fetch = 0;
+
+    struct Hash *bcached = mutt_hash_new(MAX(new_count, 128), MUTT_HASH_STRDUP_KEYS);
+    mutt_bcache_list(adata->bcache, msg_cache_collect, bcached);
+
     for (i = old_count; i < new_count; i++)
     {
-      if (!m->quiet)
-        mutt_progress_update(&progress, i + 1 - old_count, -1);
-      struct PopEmailData *edata = m->emails[i]->edata;
 #ifdef USE_HCACHE
+      struct PopEmailData *edata = m->emails[i]->edata;
       void *data = mutt_hcache_fetch(hc, edata->uid, strlen(edata->uid));
+      struct Email *e = NULL;
       if (data)
+      {
+        e = mutt_hcache_restore((unsigned char *) data);
+        mutt_hcache_free(hc, &data);
+      }
+      if (e)
       {
         /* Detach the private data */
         m->emails[i]->edata = NULL;
@@ -471,8 +541,6 @@ static int pop_fetch_headers(struct Mailbox *m)
          *   data freed separately elsewhere
          *   (the old e->data should point inside a malloc'd block from
          *   hcache so there shouldn't be a memleak here) */
-        struct Email *e = mutt_hcache_restore((unsigned char *) data);
-        mutt_hcache_free(hc, &data);
         mutt_email_free(&m->emails[i]);
         m->emails[i] = e;
         m->emails[i]->refno = refno;
@@ -481,18 +549,44 @@ static int pop_fetch_headers(struct Mailbox *m)
         /* Reattach the private data */
         m->emails[i]->edata = edata;
         m->emails[i]->free_edata = pop_edata_free;
-        rc = 0;
-        hcached = true;
+        cached[i - old_count] = true;
+        continue;
       }
-      else
 #endif
-          if ((rc = pop_read_header(adata, m->emails[i])) < 0)
-        break;
+      fetch[num_fetch++] = m->emails[i];
+    }
+
+    mutt_debug(LL_DEBUG1, "%d new messages, %d in header cache, %d headers to fetch\n",
+               num_new, num_new - num_fetch, num_fetch);
+
+    /* The missing headers are fetched in batches */
+    if (!m->quiet)
+    {
+      mutt_progress_init(&progress, _("Fetching message headers..."),
+                         MUTT_PROGRESS_MSG, C_ReadInc, num_fetch);
+    }
+    for (int j = 0; (rc == 0) && (j < num_fetch); j += POP_FETCH_BATCH)
+    {
+      const int num = MIN(num_fetch - j, POP_FETCH_BATCH);
+      rc = pop_read_headers(adata, fetch + j, num);
+      if (!m->quiet)
+        mutt_progress_update(&progress, j + num, -1);
+    }
+
+    /* The cache is only written once all the headers have arrived */
+#ifdef USE_HCACHE
+    mutt_hcache_begin(hc);
+#endif
+
+    bool hcached = false;
+    for (i = old_count; (rc == 0) && (i < new_count); i++)
+    {
+      struct PopEmailData *edata = m->emails[i]->edata;
+      if (cached[i - old_count])
+        hcached = true;
 #ifdef USE_HCACHE
       else
-      {
         mutt_hcache_store(hc, edata->uid, strlen(edata->uid), m->emails[i], 0);
-      }
 #endif
 
       /* faked support for flags works like this:
@@ -505,25 +599,32 @@ static int pop_fetch_headers(struct Mailbox *m)
        * - if 'hcached' is false, we don't have the message in our hcache:
        *        - if we also have a body: read
        *        - if we don't have a body: new */
-      const bool bcached =
-          (mutt_bcache_exists(adata->bcache, cache_id(edata->uid)) == 0);
+      const bool bcache = mutt_hash_find(bcached, cache_id(edata->uid));
       m->emails[i]->old = false;
       m->emails[i]->read = false;
       if (hcached)
       {
-        if (bcached)
+        if (bcache)
           m->emails[i]->read = true;
         else if (C_MarkOld)
           m->emails[i]->old = true;
       }
       else
       {
-        if (bcached)
+        if (bcache)
           m->emails[i]->read = true;
       }
 
       m->msg_count++;
     }
+
+#ifdef USE_HCACHE
+    mutt_hcache_commit(hc);
+#endif
+
+    mutt_hash_free(&bcached);
+    FREE(&cached);
+    FREE(&fetch);
   }
 
 #ifdef USE_HCACHE
@@ -534,6 +635,7 @@ static int pop_fetch_headers(struct Mailbox *m)
   {
     for (int i = m->msg_count; i < new_count; i++)
       mutt_email_free(&m->emails[i]);
+    mutt_hash_free(&ud.uids);
     return rc;
   }
 
@@ -541,8 +643,9 @@ static int pop_fetch_headers(struct Mailbox *m)
    * clean up cache, i.e. wipe messages deleted outside
    * the availability of our cache */
   if (C_MessageCacheClean)
-    mutt_bcache_list(adata->bcache, msg_cache_check, m);
+    mutt_bcache_list(adata->bcache, msg_cache_check, ud.uids);
 
+  mutt_hash_free(&ud.uids);
   mutt_clear_error();
   return new_count - old_count;
 }
@@ -965,32 +1068,41 @@ static int pop_mbox_sync(struct Mailbox *m, int *index_hint)
     hc = pop_hcache_open(adata, mutt_b2s(m->pathbuf));
 #endif
 
-    for (i = 0, j = 0, rc = 0; (rc == 0) && (i < m->msg_count); i++)
+    struct PopCommand *cmds = mutt_mem_calloc(MAX(num_deleted, 1), sizeof(struct PopCommand));
+    for (i = 0, j = 0; i < m->msg_count; i++)
     {
-      struct PopEmailData *edata = m->emails[i]->edata;
       if (m->emails[i]->deleted && (m->emails[i]->refno != -1))
       {
-        j++;
-        if (!m->quiet)
-          mutt_progress_update(&progress, j, -1);
-        snprintf(buf, sizeof(buf), "DELE %d\r\n", m->emails[i]->refno);
-        rc = pop_query(adata, buf, sizeof(buf));
-        if (rc == 0)
-        {
-          mutt_bcache_del(adata->bcache, cache_id(edata->uid));
+        snprintf(cmds[j].cmd, sizeof(cmds[j].cmd), "DELE %d\r\n", m->emails[i]->refno);
+        cmds[j++].data = m->emails[i];
+      }
+    }
+
+    rc = pop_pipeline(adata, cmds, j, m->quiet ? NULL : &progress);
+
+    for (i = 0; i < j; i++)
+    {
+      if (cmds[i].rc == 0)
+      {
+        struct PopEmailData *edata = ((struct Email *) cmds[i].data)->edata;
+        mutt_bcache_del(adata->bcache, cache_id(edata->uid));
 #ifdef USE_HCACHE
-          mutt_hcache_delete(hc, edata->uid, strlen(edata->uid));
+        mutt_hcache_delete(hc, edata->uid, strlen(edata->uid));
 #endif
-        }
       }
+    }
+    FREE(&cmds);
 
 #ifdef USE_HCACHE
+    for (i = 0; i < m->msg_count; i++)
+    {
+      struct PopEmailData *edata = m->emails[i]->edata;
       if (m->emails[i]->changed)
       {
         mutt_hcache_store(hc, edata->uid, strlen(edata->uid), m->emails[i], 0);
       }
-#endif
     }
+#endif
 
 #ifdef USE_HCACHE
     mutt_hcache_close(hc);
@@ -148,6 +148,9 @@ static int fetch_capa(char *line, void *data)
   else if (mutt_str_startswith(line, "TOP", CASE_IGNORE))
     adata->cmd_top = 1;
 
+  else if (mutt_str_startswith(line, "PIPELINING", CASE_IGNORE))
+    adata->cmd_pipelining = true;
+
   return 0;
 }
 
@@ -201,6 +204,7 @@ static int pop_capabilities(struct PopAccountData *adata, int mode)
     adata->cmd_uidl = 0;
     adata->cmd_top = 0;
     adata->resp_codes = false;
+    adata->cmd_pipelining = false;
     adata->expire = true;
     adata->login_delay = 0;
     FREE(&adata->auth_list);
@@ -434,6 +438,28 @@ void pop_logout(struct Mailbox *m)
   adata->status = POP_DISCONNECTED;
 }
 
+/**
+ * pop_read_status - Read the status line of a server response
+ * @param adata  POP Account data
+ * @param buf    Buffer for the response
+ * @param buflen Buffer length
+ * @retval  0 Successful
+ * @retval -1 Connection lost
+ * @retval -2 Negative response
+ */
+static int pop_read_status(struct PopAccountData *adata, char *buf, size_t buflen)
+{
+  if (mutt_socket_readln_d(buf, buflen, adata->conn, MUTT_SOCK_LOG_FULL) < 0)
+  {
+    adata->status = POP_DISCONNECTED;
+    return -1;
+  }
+  if (mutt_str_startswith(buf, "+OK", CASE_MATCH))
+    return 0;
+
+  return -2;
+}
+
 /**
  * pop_query_d - Send data from buffer and receive answer to the same buffer
  * @param adata  POP Account data
@@ -462,44 +488,32 @@ int pop_query_d(struct PopAccountData *adata, char *buf, size_t buflen, char *ms
     *c = '\0';
   snprintf(adata->err_msg, sizeof(adata->err_msg), "%s: ", buf);
 
-  if (mutt_socket_readln_d(buf, buflen, adata->conn, MUTT_SOCK_LOG_FULL) < 0)
-  {
-    adata->status = POP_DISCONNECTED;
-    return -1;
-  }
-  if (mutt_str_startswith(buf, "+OK", CASE_MATCH))
-    return 0;
-
-  pop_error(adata, buf);
-  return -2;
+  int rc = pop_read_status(adata, buf, buflen);
+  if (rc == -2)
+    pop_error(adata, buf);
+  return rc;
 }
 
 /**
- * pop_fetch_data - Read Headers with callback function
+ * pop_read_data - Read the lines of a multi-line response
  * @param adata    POP Account data
- * @param query    POP query to send to server
  * @param progress Progress bar
- * @param callback Function called for each header read
+ * @param callback Function called for each line read
  * @param data     Data to pass to the callback
  * @retval  0 Successful
  * @retval -1 Connection lost
- * @retval -2 Invalid command or execution error
  * @retval -3 Error in callback(*line, *data)
  *
- * This function calls  callback(*line, *data)  for each received line,
- * callback(NULL, *data)  if  rewind(*data)  needs, exits when fail or done.
+ * The whole response is always read, even if the callback fails, so that the
+ * next response can be read.
  */
-int pop_fetch_data(struct PopAccountData *adata, const char *query,
-                   struct Progress *progress, pop_fetch_t callback, void *data)
+static int pop_read_data(struct PopAccountData *adata, struct Progress *progress,
+                         pop_fetch_t callback, void *data)
 {
   char buf[1024];
   long pos = 0;
   size_t lenbuf = 0;
-
-  mutt_str_strfcpy(buf, query, sizeof(buf));
-  int rc = pop_query(adata, buf, sizeof(buf));
-  if (rc < 0)
-    return rc;
+  int rc = 0;
 
   char *inbuf = mutt_mem_malloc(sizeof(buf));
 
@@ -546,6 +560,129 @@ int pop_fetch_data(struct PopAccountData *adata, const char *query,
   return rc;
 }
 
+/**
+ * pop_fetch_data - Read Headers with callback function
+ * @param adata    POP Account data
+ * @param query    POP query to send to server
+ * @param progress Progress bar
+ * @param callback Function called for each header read
+ * @param data     Data to pass to the callback
+ * @retval  0 Successful
+ * @retval -1 Connection lost
+ * @retval -2 Invalid command or execution error
+ * @retval -3 Error in callback(*line, *data)
+ *
+ * This function calls  callback(*line, *data)  for each received line,
+ * callback(NULL, *data)  if  rewind(*data)  needs, exits when fail or done.
+ */
+int pop_fetch_data(struct PopAccountData *adata, const char *query,
+                   struct Progress *progress, pop_fetch_t callback, void *data)
+{
+  char buf[1024];
+
+  mutt_str_strfcpy(buf, query, sizeof(buf));
+  int rc = pop_query(adata, buf, sizeof(buf));
+  if (rc < 0)
+    return rc;
+
+  return pop_read_data(adata, progress, callback, data);
+}
+
+/**
+ * pop_pipeline - Send a list of commands, pipelining them if possible
+ * @param adata    POP Account data
+ * @param cmds     Commands to send
+ * @param num      Number of commands
+ * @param progress Progress bar, updated with the number of replies read
+ * @retval  0 Successful
+ * @retval -1 Connection lost
+ * @retval -2 At least one command failed
+ *
+ * If the server supports PIPELINING (RFC2449), up to #POP_PIPELINE_WINDOW
+ * commands are sent before their replies are read, otherwise the commands are
+ * sent one at a time.  Each reply is handled as it arrives and its result is
+ * stored in PopCommand::rc.
+ *
+ * Once the server has rejected a command, no more commands are sent.  Its
+ * error is kept in PopAccountData::err_msg and the commands that weren't sent
+ * are left with a result of -2.
+ */
+int pop_pipeline(struct PopAccountData *adata, struct PopCommand *cmds, int num,
+                 struct Progress *progress)
+{
+  if (adata->status != POP_CONNECTED)
+    return -1;
+
+  const int window = adata->cmd_pipelining ? POP_PIPELINE_WINDOW : 1;
+  struct Buffer *out = mutt_buffer_pool_get();
+  char buf[1024];
+  int sent = 0;
+  int rc = 0;
+
+  for (int i = 0; i < num; i++)
+    cmds[i].rc = -2;
+
+  for (int i = 0; i < sent || ((rc == 0) && (i < num)); i++)
+  {
+    /* Top up the window when it's half empty, sending each batch at once */
+    if ((rc == 0) && (sent < num) && (sent - i <= window / 2))
+    {
+      mutt_buffer_reset(out);
+      for (; (sent < num) && (sent - i < window); sent++)
+        mutt_buffer_addstr(out, cmds[sent].cmd);
+      if (mutt_socket_send_d(adata->conn, mutt_b2s(out), MUTT_SOCK_LOG_FULL) < 0)
+      {
+        adata->status = POP_DISCONNECTED;
+        rc = -1;
+        break;
+      }
+    }
+
+    struct PopCommand *pc = &cmds[i];
+    if (rc == 0)
+    {
+      mutt_str_strfcpy(adata->err_msg, pc->cmd, sizeof(adata->err_msg));
+      char *c = strpbrk(adata->err_msg, " \r\n");
+      if (c)
+        *c = '\0';
+      mutt_str_strcat(adata->err_msg, sizeof(adata->err_msg), ": ");
+    }
+
+    pc->rc = pop_read_status(adata, buf, sizeof(buf));
+    if (pc->rc == -1)
+    {
+      rc = -1;
+      break;
+    }
+
+    if (pc->rc == -2)
+    {
+      if (rc == 0)
+        pop_error(adata, buf);
+      rc = -2;
+    }
+    else if (pc->multiline)
+    {
+      pc->rc = pop_read_data(adata, NULL, pc->callback, pc->data);
+      if (pc->rc == -1)
+      {
+        rc = -1;
+        break;
+      }
+    }
+    else if (pc->callback && (pc->callback(buf, pc->data) < 0))
+    {
+      pc->rc = -3;
+    }
+
+    if (progress)
+      mutt_progress_update(progress, i + 1, -1);
+  }
+
+  mutt_buffer_pool_release(&out);
+  return rc;
+}
+
 /**
  * check_uidl - find message with this UIDL and set refno - Implements ::pop_fetch_t
  * @param line String containing UIDL
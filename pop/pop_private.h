@@ -40,6 +40,9 @@ struct Progress;
 /* maximal length of the server response (RFC1939) */
 #define POP_CMD_RESPONSE 512
 
+/* maximal number of commands in flight with PIPELINING (RFC2449) */
+#define POP_PIPELINE_WINDOW 32
+
 /**
  * enum PopStatus - POP server responses
  */
@@ -86,6 +89,7 @@ struct PopAccountData
   unsigned int cmd_uidl : 2; /**< optional command UIDL */
   unsigned int cmd_top : 2;  /**< optional command TOP */
   bool resp_codes : 1;       /**< server supports extended response codes */
+  bool cmd_pipelining : 1;   /**< server supports PIPELINING */
   bool expire : 1;           /**< expire is greater than 0 */
   bool clear_cache : 1;
   size_t size;
@@ -131,6 +135,18 @@ void pop_apop_timestamp(struct PopAccountData *adata, char *buf);
  */
 typedef int (*pop_fetch_t)(char *str, void *data);
 
+/**
+ * struct PopCommand - A command to be sent by pop_pipeline()
+ */
+struct PopCommand
+{
+  char cmd[64];         ///< Command to send, including the CRLF
+  bool multiline;       ///< Successful reply is followed by lines of data
+  pop_fetch_t callback; ///< Called with each line of data, or the status line of a single-line reply
+  void *data;           ///< Data to pass to the callback
+  int rc;               ///< Result, as pop_fetch_data()
+};
+
 /* pop_lib.c */
 #define pop_query(adata, buf, buflen) pop_query_d(adata, buf, buflen, NULL)
 int pop_parse_path(const char *path, struct ConnAccount *acct);
@@ -139,6 +155,8 @@ int pop_open_connection(struct PopAccountData *adata);
 int pop_query_d(struct PopAccountData *adata, char *buf, size_t buflen, char *msg);
 int pop_fetch_data(struct PopAccountData *adata, const char *query,
                    struct Progress *progress, pop_fetch_t callback, void *data);
+int pop_pipeline(struct PopAccountData *adata, struct PopCommand *cmds, int num,
+                 struct Progress *progress);
 int pop_reconnect(struct Mailbox *m);
 void pop_logout(struct Mailbox *m);
 struct PopAccountData *pop_adata_get(struct Mailbox *m);
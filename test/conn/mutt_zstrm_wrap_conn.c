@@ -0,0 +1,225 @@
+/**
+ * @file
+ * Test code for mutt_zstrm_wrap_conn()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include <stdbool.h>
+#include <string.h>
+#include "mutt/mutt.h"
+#include "conn/conn.h"
+
+#ifdef HAVE_ZLIB
+/**
+ * struct Loopback - Fake socket that reads back what was written
+ */
+struct Loopback
+{
+  char *data;   ///< Bytes written, not yet read
+  size_t len;   ///< Number of bytes in data
+  size_t alloc; ///< Size of the data buffer
+  bool closed;  ///< conn_close() has been called
+};
+
+static int loop_open(struct Connection *conn)
+{
+  return 0;
+}
+
+static int loop_read(struct Connection *conn, char *buf, size_t count)
+{
+  struct Loopback *lb = conn->sockdata;
+  /* give out small pieces to exercise the partial reads */
+  size_t len = MIN(MIN(count, lb->len), 1000);
+  memcpy(buf, lb->data, len);
+  memmove(lb->data, lb->data + len, lb->len - len);
+  lb->len -= len;
+  return len;
+}
+
+static int loop_write(struct Connection *conn, const char *buf, size_t count)
+{
+  struct Loopback *lb = conn->sockdata;
+  if ((lb->len + count) > lb->alloc)
+  {
+    lb->alloc = lb->len + count + 1024;
+    mutt_mem_realloc(&lb->data, lb->alloc);
+  }
+  memcpy(lb->data + lb->len, buf, count);
+  lb->len += count;
+  return count;
+}
+
+static int loop_poll(struct Connection *conn, time_t wait_secs)
+{
+  struct Loopback *lb = conn->sockdata;
+  return lb->len > 0;
+}
+
+static int loop_close(struct Connection *conn)
+{
+  struct Loopback *lb = conn->sockdata;
+  lb->closed = true;
+  return 0;
+}
+
+static void loop_init(struct Connection *conn, struct Loopback *lb)
+{
+  memset(conn, 0, sizeof(*conn));
+  memset(lb, 0, sizeof(*lb));
+  conn->sockdata = lb;
+  conn->conn_open = loop_open;
+  conn->conn_read = loop_read;
+  conn->conn_write = loop_write;
+  conn->conn_poll = loop_poll;
+  conn->conn_close = loop_close;
+}
+#endif
+
+void test_mutt_zstrm_wrap_conn(void)
+{
+  // int mutt_zstrm_wrap_conn(struct Connection *conn);
+
+#ifdef HAVE_ZLIB
+  {
+    TEST_CHECK(mutt_zstrm_wrap_conn(NULL) == -1);
+  }
+
+  {
+    struct Connection conn;
+    struct Loopback lb;
+    loop_init(&conn, &lb);
+
+    TEST_CHECK(mutt_zstrm_wrap_conn(&conn) == 0);
+    TEST_CHECK(conn.sockdata != &lb);
+    TEST_CHECK(conn.conn_read != loop_read);
+    TEST_CHECK(conn.conn_write != loop_write);
+
+    static const char msg[] = "a001 NOOP\r\n";
+    TEST_CHECK(conn.conn_write(&conn, msg, sizeof(msg) - 1) == sizeof(msg) - 1);
+    TEST_CHECK(lb.len > 0);
+    TEST_CHECK(conn.conn_poll(&conn, 0) == 1);
+
+    char buf[64] = { 0 };
+    TEST_CHECK(conn.conn_read(&conn, buf, sizeof(buf)) == sizeof(msg) - 1);
+    TEST_CHECK(mutt_str_strcmp(buf, msg) == 0);
+    TEST_MSG("Expected: %s", msg);
+    TEST_MSG("Actual  : %s", buf);
+
+    /* closing removes the compression layer and closes the socket */
+    TEST_CHECK(conn.conn_close(&conn) == 0);
+    TEST_CHECK(lb.closed);
+    TEST_CHECK(conn.sockdata == &lb);
+    TEST_CHECK(conn.conn_open == loop_open);
+    TEST_CHECK(conn.conn_read == loop_read);
+    TEST_CHECK(conn.conn_write == loop_write);
+    TEST_CHECK(conn.conn_poll == loop_poll);
+    TEST_CHECK(conn.conn_close == loop_close);
+    FREE(&lb.data);
+  }
+
+  {
+    struct Connection conn;
+    struct Loopback lb;
+    loop_init(&conn, &lb);
+    TEST_CHECK(mutt_zstrm_wrap_conn(&conn) == 0);
+
+    /* ~200KB, written in odd sized pieces and read back in small ones */
+    const size_t total = 200000;
+    char *src = mutt_mem_malloc(total);
+    unsigned int seed = 1;
+    for (size_t i = 0; i < total; i++)
+    {
+      seed = (seed * 1103515245) + 12345;
+      src[i] = ((seed >> 16) % 7 == 0) ? '\n' : 'a' + ((seed >> 16) % 26);
+    }
+
+    for (size_t done = 0; done < total;)
+    {
+      size_t len = MIN(total - done, 4093);
+      TEST_CHECK(conn.conn_write(&conn, src + done, len) == (int) len);
+      done += len;
+    }
+    TEST_CHECK(lb.len < total);
+
+    char *dst = mutt_mem_calloc(1, total);
+    size_t got = 0;
+    while (got < total)
+    {
+      int rc = conn.conn_read(&conn, dst + got, MIN(total - got, 333));
+      if (!TEST_CHECK(rc > 0))
+        break;
+      got += rc;
+    }
+    TEST_CHECK(got == total);
+    TEST_CHECK(memcmp(src, dst, total) == 0);
+
+    /* nothing left: the stream reports end of data */
+    TEST_CHECK(conn.conn_read(&conn, dst, 10) == 0);
+
+    TEST_CHECK(conn.conn_close(&conn) == 0);
+    TEST_CHECK(lb.closed);
+    FREE(&src);
+    FREE(&dst);
+    FREE(&lb.data);
+  }
+
+  {
+    /* compressed data that's already in the receive buffer isn't lost */
+    struct Connection zconn;
+    struct Loopback zlb;
+    loop_init(&zconn, &zlb);
+    TEST_CHECK(mutt_zstrm_wrap_conn(&zconn) == 0);
+    static const char msg[] = "* 1 EXISTS\r\na002 OK done\r\n";
+    TEST_CHECK(zconn.conn_write(&zconn, msg, sizeof(msg) - 1) == sizeof(msg) - 1);
+
+    struct Connection *conn = mutt_mem_calloc(1, sizeof(struct Connection) + 64);
+    struct Loopback lb;
+    loop_init(conn, &lb);
+    conn->inbuflen = 64;
+    const size_t head = zlb.len / 2;
+    memcpy(conn->inbuf, zlb.data, head);
+    conn->available = head;
+    loop_write(conn, zlb.data + head, zlb.len - head);
+
+    TEST_CHECK(mutt_zstrm_wrap_conn(conn) == 0);
+    TEST_CHECK((conn->bufpos == 0) && (conn->available == 0));
+    TEST_CHECK(conn->conn_poll(conn, 0) == 1);
+
+    char buf[64] = { 0 };
+    size_t got = 0;
+    while (got < (sizeof(msg) - 1))
+    {
+      int rc = conn->conn_read(conn, buf + got, sizeof(buf) - 1 - got);
+      if (!TEST_CHECK(rc > 0))
+        break;
+      got += rc;
+    }
+    TEST_CHECK(mutt_str_strcmp(buf, msg) == 0);
+    TEST_MSG("Expected: %s", msg);
+    TEST_MSG("Actual  : %s", buf);
+
+    TEST_CHECK(conn->conn_close(conn) == 0);
+    TEST_CHECK(zconn.conn_close(&zconn) == 0);
+    FREE(&conn);
+    FREE(&lb.data);
+    FREE(&zlb.data);
+  }
+#endif
+}
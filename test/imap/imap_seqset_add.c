@@ -0,0 +1,100 @@
+/**
+ * @file
+ * Test code for imap_seqset_add()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include <limits.h>
+#include <stdbool.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "imap/imap_private.h"
+
+
+static void check_seqset(const unsigned int *nums, size_t count, const char *expected)
+{
+  struct Buffer *buf = mutt_buffer_new();
+  struct SeqsetBuilder sb = { .buf = buf };
+
+  for (size_t i = 0; i < count; i++)
+    imap_seqset_add(&sb, nums[i]);
+  imap_seqset_finish(&sb);
+
+  TEST_CHECK(mutt_str_strcmp(mutt_b2s(buf), expected) == 0);
+  TEST_MSG("Expected: %s", expected);
+  TEST_MSG("Actual  : %s", mutt_b2s(buf));
+
+  mutt_buffer_free(&buf);
+}
+
+void test_imap_seqset_add(void)
+{
+  // void imap_seqset_add(struct SeqsetBuilder *sb, unsigned int num);
+
+  {
+    check_seqset(NULL, 0, "");
+  }
+
+  {
+    static const unsigned int nums[] = { 5 };
+    check_seqset(nums, mutt_array_size(nums), "5");
+  }
+
+  {
+    static const unsigned int nums[] = { 1, 2, 3, 4, 5 };
+    check_seqset(nums, mutt_array_size(nums), "1:5");
+  }
+
+  {
+    static const unsigned int nums[] = { 1, 2, 3, 5, 7, 8, 10 };
+    check_seqset(nums, mutt_array_size(nums), "1:3,5,7:8,10");
+  }
+
+  {
+    /* only ascending runs are merged */
+    static const unsigned int nums[] = { 3, 2, 1, 2, 2 };
+    check_seqset(nums, mutt_array_size(nums), "3,2,1:2,2");
+  }
+
+  {
+    /* a run can't wrap around */
+    static const unsigned int nums[] = { UINT_MAX - 1, UINT_MAX, 0, 1 };
+    check_seqset(nums, mutt_array_size(nums), "4294967294:4294967295,0:1");
+  }
+
+  {
+    /* finishing twice doesn't repeat the last run */
+    struct Buffer *buf = mutt_buffer_new();
+    struct SeqsetBuilder sb = { .buf = buf };
+    imap_seqset_add(&sb, 7);
+    imap_seqset_add(&sb, 8);
+    imap_seqset_finish(&sb);
+    imap_seqset_finish(&sb);
+    TEST_CHECK(mutt_str_strcmp(mutt_b2s(buf), "7:8") == 0);
+    TEST_MSG("Actual  : %s", mutt_b2s(buf));
+
+    /* the builder can be reused */
+    mutt_buffer_reset(buf);
+    imap_seqset_add(&sb, 9);
+    imap_seqset_finish(&sb);
+    TEST_CHECK(mutt_str_strcmp(mutt_b2s(buf), "9") == 0);
+    TEST_MSG("Actual  : %s", mutt_b2s(buf));
+    mutt_buffer_free(&buf);
+  }
+}
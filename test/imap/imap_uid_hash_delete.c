@@ -0,0 +1,118 @@
+/**
+ * @file
+ * Test code for imap_uid_hash_delete()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include <limits.h>
+#include <stdbool.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "imap/imap_private.h"
+
+
+void test_imap_uid_hash_delete(void)
+{
+  // void imap_uid_hash_delete(struct ImapUidHash *uh, unsigned int uid, const struct Email *e);
+
+  struct Email e1 = { 0 };
+  struct Email e2 = { 0 };
+
+  {
+    imap_uid_hash_delete(NULL, 1, &e1);
+    TEST_CHECK_(1, "imap_uid_hash_delete(NULL, 1, &e1)");
+  }
+
+  {
+    struct ImapUidHash *uh = imap_uid_hash_new(0);
+    TEST_CHECK(imap_uid_hash_insert(uh, 10, &e1));
+
+    /* missing UIDs are ignored */
+    imap_uid_hash_delete(uh, 0, NULL);
+    imap_uid_hash_delete(uh, 11, NULL);
+    TEST_CHECK(uh->count == 1);
+
+    /* the UID belongs to another Email */
+    imap_uid_hash_delete(uh, 10, &e2);
+    TEST_CHECK(uh->count == 1);
+    TEST_CHECK(imap_uid_hash_find(uh, 10) == &e1);
+
+    imap_uid_hash_delete(uh, 10, &e1);
+    TEST_CHECK(uh->count == 0);
+    TEST_CHECK(imap_uid_hash_find(uh, 10) == NULL);
+
+    /* the UID can be reused */
+    TEST_CHECK(imap_uid_hash_insert(uh, 10, &e2));
+    imap_uid_hash_delete(uh, 10, NULL);
+    TEST_CHECK(uh->count == 0);
+    imap_uid_hash_free(&uh);
+  }
+
+  {
+    /* Delete each entry of a crowded table in turn.  The entries after it
+     * must still be found, whether or not they were moved back. */
+    const unsigned int num = 24;
+    struct Email emails[24] = { { 0 } };
+
+    for (unsigned int del = 0; del < num; del++)
+    {
+      struct ImapUidHash *uh = imap_uid_hash_new(0);
+      for (unsigned int i = 0; i < num; i++)
+        TEST_CHECK(imap_uid_hash_insert(uh, (i + 1) * 32, &emails[i]));
+      TEST_CHECK(uh->mask == 31);
+
+      imap_uid_hash_delete(uh, (del + 1) * 32, &emails[del]);
+      TEST_CHECK(uh->count == num - 1);
+
+      for (unsigned int i = 0; i < num; i++)
+      {
+        struct Email *expected = (i == del) ? NULL : &emails[i];
+        if (!TEST_CHECK(imap_uid_hash_find(uh, (i + 1) * 32) == expected))
+          TEST_MSG("Deleted UID %u, lost UID %u", (del + 1) * 32, (i + 1) * 32);
+      }
+      imap_uid_hash_free(&uh);
+    }
+  }
+
+  {
+    /* delete half of a large table, in a scattered order */
+    const unsigned int num = 4096;
+    struct Email *emails = mutt_mem_calloc(num, sizeof(struct Email));
+    struct ImapUidHash *uh = imap_uid_hash_new(num);
+    for (unsigned int i = 0; i < num; i++)
+      TEST_CHECK(imap_uid_hash_insert(uh, i + 1, &emails[i]));
+
+    for (unsigned int i = 0; i < num; i++)
+    {
+      const unsigned int j = (i * 2731) % num; // 2731 is coprime with 4096
+      if (j % 2)
+        imap_uid_hash_delete(uh, j + 1, &emails[j]);
+    }
+    TEST_CHECK(uh->count == num / 2);
+
+    for (unsigned int i = 0; i < num; i++)
+    {
+      struct Email *expected = (i % 2) ? NULL : &emails[i];
+      if (!TEST_CHECK(imap_uid_hash_find(uh, i + 1) == expected))
+        TEST_MSG("UID %u", i + 1);
+    }
+    imap_uid_hash_free(&uh);
+    FREE(&emails);
+  }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file
+ * Test code for imap_uid_hash_find()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include <limits.h>
+#include <stdbool.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "imap/imap_private.h"
+
+
+void test_imap_uid_hash_find(void)
+{
+  // struct Email *imap_uid_hash_find(const struct ImapUidHash *uh, unsigned int uid);
+
+  struct Email e1 = { 0 };
+  struct Email e2 = { 0 };
+
+  {
+    TEST_CHECK(imap_uid_hash_find(NULL, 1) == NULL);
+  }
+
+  {
+    struct ImapUidHash *uh = imap_uid_hash_new(100);
+    TEST_CHECK(imap_uid_hash_find(uh, 0) == NULL);
+    TEST_CHECK(imap_uid_hash_find(uh, 1) == NULL);
+
+    TEST_CHECK(imap_uid_hash_insert(uh, 1, &e1));
+    TEST_CHECK(imap_uid_hash_insert(uh, UINT_MAX, &e2));
+    TEST_CHECK(imap_uid_hash_find(uh, 1) == &e1);
+    TEST_CHECK(imap_uid_hash_find(uh, UINT_MAX) == &e2);
+    TEST_CHECK(imap_uid_hash_find(uh, 2) == NULL);
+    TEST_CHECK(imap_uid_hash_find(uh, 0) == NULL);
+    imap_uid_hash_free(&uh);
+  }
+
+  {
+    /* a full table, so some UIDs have to be found by probing */
+    struct ImapUidHash *uh = imap_uid_hash_new(0);
+    const unsigned int slots = uh->mask + 1;
+    const unsigned int num = slots * 3 / 4;
+    struct Email *emails = mutt_mem_calloc(num, sizeof(struct Email));
+    for (unsigned int i = 0; i < num; i++)
+      TEST_CHECK(imap_uid_hash_insert(uh, (i + 1) * 3, &emails[i]));
+    TEST_CHECK(uh->mask + 1 == slots);
+
+    for (unsigned int i = 0; i < num; i++)
+    {
+      TEST_CHECK(imap_uid_hash_find(uh, (i + 1) * 3) == &emails[i]);
+      TEST_CHECK(imap_uid_hash_find(uh, ((i + 1) * 3) + 1) == NULL);
+    }
+    imap_uid_hash_free(&uh);
+    FREE(&emails);
+  }
+}
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * Test code for imap_uid_hash_insert()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include <limits.h>
+#include <stdbool.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "imap/imap_private.h"
+
+
+void test_imap_uid_hash_insert(void)
+{
+  // bool imap_uid_hash_insert(struct ImapUidHash *uh, unsigned int uid, struct Email *e);
+
+  struct Email e1 = { 0 };
+  struct Email e2 = { 0 };
+
+  {
+    TEST_CHECK(!imap_uid_hash_insert(NULL, 1, &e1));
+  }
+
+  {
+    struct ImapUidHash *uh = imap_uid_hash_new(0);
+    TEST_CHECK(!imap_uid_hash_insert(uh, 0, &e1));
+    TEST_CHECK(uh->count == 0);
+
+    TEST_CHECK(imap_uid_hash_insert(uh, 42, &e1));
+    TEST_CHECK(uh->count == 1);
+
+    /* a UID can only be added once */
+    TEST_CHECK(!imap_uid_hash_insert(uh, 42, &e2));
+    TEST_CHECK(uh->count == 1);
+    TEST_CHECK(imap_uid_hash_find(uh, 42) == &e1);
+    imap_uid_hash_free(&uh);
+    TEST_CHECK(uh == NULL);
+  }
+
+  {
+    /* the table grows, keeping every entry */
+    const unsigned int num = 5000;
+    struct Email *emails = mutt_mem_calloc(num, sizeof(struct Email));
+    struct ImapUidHash *uh = imap_uid_hash_new(10);
+    const unsigned int slots = uh->mask + 1;
+
+    for (unsigned int i = 0; i < num; i++)
+    {
+      /* sparse UIDs, as after expunges */
+      if (!TEST_CHECK(imap_uid_hash_insert(uh, (i * 7) + 1, &emails[i])))
+        TEST_MSG("Failed to insert UID %u", (i * 7) + 1);
+    }
+
+    TEST_CHECK(uh->count == num);
+    TEST_CHECK((uh->mask + 1) > slots);
+    TEST_CHECK(((uh->count * 4ULL) <= ((uh->mask + 1) * 3ULL)));
+
+    for (unsigned int i = 0; i < num; i++)
+    {
+      if (!TEST_CHECK(imap_uid_hash_find(uh, (i * 7) + 1) == &emails[i]))
+        TEST_MSG("UID %u not found", (i * 7) + 1);
+    }
+
+    imap_uid_hash_free(&uh);
+    FREE(&emails);
+  }
+}
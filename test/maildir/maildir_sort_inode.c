@@ -0,0 +1,63 @@
+/**
+ * @file
+ * Test code for maildir_sort_inode()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include <sys/types.h>
+#include "mutt/mutt.h"
+#include "maildir/maildir_private.h"
+
+void test_maildir_sort_inode(void)
+{
+  // struct Maildir *maildir_sort_inode(struct Maildir *list);
+
+  {
+    TEST_CHECK(!maildir_sort_inode(NULL));
+  }
+
+  {
+    struct Maildir md = { 0 };
+    TEST_CHECK(maildir_sort_inode(&md) == &md);
+  }
+
+  {
+    /* Inodes more than 2^31 apart, and duplicates, which keep their order */
+    static const ino_t inodes[] = { 300, 5, (ino_t) 1 << 40, 70000, 5, 0, 256 };
+    static const int order[] = { 5, 1, 4, 6, 0, 3, 2 };
+    struct Maildir md[mutt_array_size(inodes)] = { { 0 } };
+    for (size_t i = 0; i < mutt_array_size(inodes); i++)
+    {
+      md[i].inode = inodes[i];
+      if (i > 0)
+        md[i - 1].next = &md[i];
+    }
+
+    struct Maildir *list = maildir_sort_inode(&md[0]);
+    for (size_t i = 0; i < mutt_array_size(order); i++)
+    {
+      TEST_CHECK(list == &md[order[i]]);
+      TEST_MSG("Position %zu: expected md[%d]", i, order[i]);
+      if (!list)
+        break;
+      list = list->next;
+    }
+    TEST_CHECK(!list);
+  }
+}
@@ -0,0 +1,59 @@
+/**
+ * @file
+ * Test code for maildir_sort_path()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "maildir/maildir_private.h"
+
+void test_maildir_sort_path(void)
+{
+  // struct Maildir *maildir_sort_path(struct Maildir *list);
+
+  {
+    TEST_CHECK(!maildir_sort_path(NULL));
+  }
+
+  {
+    static const char *paths[] = { "cur/3", "cur/10", "new/1", "cur/1" };
+    static const int order[] = { 3, 1, 0, 2 };
+    struct Email e[mutt_array_size(paths)] = { { 0 } };
+    struct Maildir md[mutt_array_size(paths)] = { { 0 } };
+    for (size_t i = 0; i < mutt_array_size(paths); i++)
+    {
+      e[i].path = (char *) paths[i];
+      md[i].email = &e[i];
+      if (i > 0)
+        md[i - 1].next = &md[i];
+    }
+
+    struct Maildir *list = maildir_sort_path(&md[0]);
+    for (size_t i = 0; i < mutt_array_size(order); i++)
+    {
+      TEST_CHECK(list == &md[order[i]]);
+      TEST_MSG("Position %zu: expected md[%d]", i, order[i]);
+      if (!list)
+        break;
+      list = list->next;
+    }
+    TEST_CHECK(!list);
+  }
+}
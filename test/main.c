@@ -120,6 +120,7 @@
   NEOMUTT_TEST_ITEM(config_sort)                                               \
   NEOMUTT_TEST_ITEM(config_string)                                             \
   NEOMUTT_TEST_ITEM(config_dump)                                               \
+  NEOMUTT_TEST_ITEM(test_mutt_zstrm_wrap_conn)                                 \
   NEOMUTT_TEST_ITEM(test_mutt_date_add_timeout)                                \
   NEOMUTT_TEST_ITEM(test_mutt_date_check_month)                                \
   NEOMUTT_TEST_ITEM(test_mutt_date_gmtime)                                     \
@@ -227,6 +228,10 @@
   NEOMUTT_TEST_ITEM(test_mutt_idna_local_to_intl)                              \
   NEOMUTT_TEST_ITEM(test_mutt_idna_print_version)                              \
   NEOMUTT_TEST_ITEM(test_mutt_idna_to_ascii_lz)                                \
+  NEOMUTT_TEST_ITEM(test_imap_seqset_add)                                      \
+  NEOMUTT_TEST_ITEM(test_imap_uid_hash_delete)                                 \
+  NEOMUTT_TEST_ITEM(test_imap_uid_hash_find)                                   \
+  NEOMUTT_TEST_ITEM(test_imap_uid_hash_insert)                                 \
   NEOMUTT_TEST_ITEM(test_mutt_list_clear)                                      \
   NEOMUTT_TEST_ITEM(test_mutt_list_compare)                                    \
   NEOMUTT_TEST_ITEM(test_mutt_list_find)                                       \
@@ -251,6 +256,8 @@
   NEOMUTT_TEST_ITEM(test_log_queue_flush)                                      \
   NEOMUTT_TEST_ITEM(test_log_queue_save)                                       \
   NEOMUTT_TEST_ITEM(test_log_queue_set_max_size)                               \
+  NEOMUTT_TEST_ITEM(test_maildir_sort_inode)                                   \
+  NEOMUTT_TEST_ITEM(test_maildir_sort_path)                                    \
   NEOMUTT_TEST_ITEM(test_mutt_map_get_name)                                    \
   NEOMUTT_TEST_ITEM(test_mutt_map_get_value)                                   \
   NEOMUTT_TEST_ITEM(test_mutt_mb_charlen)                                      \
@@ -276,6 +283,7 @@
   NEOMUTT_TEST_ITEM(test_mutt_mem_free)                                        \
   NEOMUTT_TEST_ITEM(test_mutt_mem_malloc)                                      \
   NEOMUTT_TEST_ITEM(test_mutt_mem_realloc)                                     \
+  NEOMUTT_TEST_ITEM(test_nm_query_until)                                       \
   NEOMUTT_TEST_ITEM(test_mutt_param_cmp_strict)                                \
   NEOMUTT_TEST_ITEM(test_mutt_param_delete)                                    \
   NEOMUTT_TEST_ITEM(test_mutt_param_free)                                      \
@@ -297,6 +305,7 @@
   NEOMUTT_TEST_ITEM(test_mutt_rfc822_parse_line)                               \
   NEOMUTT_TEST_ITEM(test_mutt_rfc822_parse_message)                            \
   NEOMUTT_TEST_ITEM(test_mutt_rfc822_read_header)                              \
+  NEOMUTT_TEST_ITEM(test_mutt_rfc822_read_header_mem)                          \
   NEOMUTT_TEST_ITEM(test_mutt_rfc822_read_line)                                \
   NEOMUTT_TEST_ITEM(test_mutt_path_abbr_folder)                                \
   NEOMUTT_TEST_ITEM(test_mutt_path_basename)                                   \
@@ -0,0 +1,61 @@
+/**
+ * @file
+ * Test code for nm_query_until()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include "mutt/mutt.h"
+#ifdef USE_NOTMUCH
+#include "notmuch/notmuch_private.h"
+#endif
+
+void test_nm_query_until(void)
+{
+  // void nm_query_until(struct Buffer *buf, const char *query, time_t until);
+
+#ifdef USE_NOTMUCH
+  {
+    struct Buffer *buf = mutt_buffer_new();
+    nm_query_until(NULL, "tag:inbox", 0);
+    nm_query_until(buf, NULL, 0);
+    TEST_CHECK(mutt_buffer_is_empty(buf));
+    mutt_buffer_free(&buf);
+  }
+
+  {
+    struct Buffer *buf = mutt_buffer_new();
+    nm_query_until(buf, "tag:inbox", 1546300800);
+    TEST_CHECK(mutt_str_strcmp(mutt_b2s(buf),
+                               "(tag:inbox) and date:..@1546300800") == 0);
+    TEST_MSG("Actual: %s", mutt_b2s(buf));
+    mutt_buffer_free(&buf);
+  }
+
+  {
+    // An "or" in the query must not swallow the date range
+    struct Buffer *buf = mutt_buffer_new();
+    mutt_buffer_strcpy(buf, "junk");
+    nm_query_until(buf, "tag:a or tag:b", 42);
+    TEST_CHECK(mutt_str_strcmp(mutt_b2s(buf),
+                               "(tag:a or tag:b) and date:..@42") == 0);
+    TEST_MSG("Actual: %s", mutt_b2s(buf));
+    mutt_buffer_free(&buf);
+  }
+#endif
+}
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * Test code for mutt_rfc822_read_header_mem()
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_NO_MAIN
+#include "acutest.h"
+#include "config.h"
+#include "mutt/mutt.h"
+#include "address/lib.h"
+#include "email/lib.h"
+
+void test_mutt_rfc822_read_header_mem(void)
+{
+  // struct Envelope *mutt_rfc822_read_header_mem(const char *data, size_t len, struct Email *e, bool user_hdrs, bool weed);
+
+  {
+    struct Email email = { 0 };
+    TEST_CHECK(!mutt_rfc822_read_header_mem(NULL, 10, &email, false, false));
+  }
+
+  {
+    struct Envelope *env = NULL;
+    TEST_CHECK((env = mutt_rfc822_read_header_mem(NULL, 0, NULL, false, false)) != NULL);
+    mutt_env_free(&env);
+  }
+
+  {
+    struct Envelope *env = NULL;
+    TEST_CHECK((env = mutt_rfc822_read_header_mem("", 0, NULL, false, false)) != NULL);
+    mutt_env_free(&env);
+  }
+
+  {
+    static const char hdrs[] = "Subject: apple\n"
+                               "  banana\n"
+                               "Message-ID: <1234@example.com>\n"
+                               "\n"
+                               "body\n";
+    struct Email *e = mutt_email_new();
+    struct Envelope *env = NULL;
+    TEST_CHECK((env = mutt_rfc822_read_header_mem(hdrs, sizeof(hdrs) - 1, e, false, false)) != NULL);
+    TEST_CHECK(mutt_str_strcmp(env->subject, "apple banana") == 0);
+    TEST_CHECK(mutt_str_strcmp(env->message_id, "<1234@example.com>") == 0);
+    TEST_CHECK(e->content->offset == (sizeof(hdrs) - 1 - 5));
+    mutt_env_free(&env);
+    mutt_email_free(&e);
+  }
+
+  {
+    // A line that isn't a header ends the header, and isn't consumed
+    static const char hdrs[] = "Subject: apple\n"
+                               "not a header\n";
+    struct Email *e = mutt_email_new();
+    struct Envelope *env = NULL;
+    TEST_CHECK((env = mutt_rfc822_read_header_mem(hdrs, sizeof(hdrs) - 1, e, false, false)) != NULL);
+    TEST_CHECK(mutt_str_strcmp(env->subject, "apple") == 0);
+    TEST_CHECK(e->content->offset == 15);
+    mutt_env_free(&env);
+    mutt_email_free(&e);
+  }
+}
@@ -300,6 +300,50 @@ void test_mutt_pattern_comp(void)
     mutt_pattern_free(&pat);
   }
 
+  { /* a plain lower-case regex is kept as a regex, but remembers its text */
+    char *s = "~s foobar";
+
+    mutt_buffer_reset(err);
+    struct PatternHead *pat = mutt_pattern_comp(s, 0, err);
+
+    if (!TEST_CHECK(pat != NULL))
+    {
+      TEST_MSG("Expected: pat != NULL");
+      TEST_MSG("Actual  : pat == NULL");
+    }
+
+    if (!TEST_CHECK(pat && !SLIST_FIRST(pat)->stringmatch &&
+                    (mutt_str_strcmp(SLIST_FIRST(pat)->plain, "foobar") == 0)))
+    {
+      TEST_MSG("Expected: stringmatch == 0, plain == foobar");
+      TEST_MSG("Actual  : stringmatch == %d, plain == %s",
+               pat ? SLIST_FIRST(pat)->stringmatch : 0, pat ? SLIST_FIRST(pat)->plain : "");
+    }
+
+    mutt_pattern_free(&pat);
+  }
+
+  { /* a real regex is not */
+    char *s = "~s foo.bar";
+
+    mutt_buffer_reset(err);
+    struct PatternHead *pat = mutt_pattern_comp(s, 0, err);
+
+    if (!TEST_CHECK(pat != NULL))
+    {
+      TEST_MSG("Expected: pat != NULL");
+      TEST_MSG("Actual  : pat == NULL");
+    }
+
+    if (!TEST_CHECK(pat && !SLIST_FIRST(pat)->stringmatch && !SLIST_FIRST(pat)->plain))
+    {
+      TEST_MSG("Expected: stringmatch == 0, plain == NULL");
+      TEST_MSG("Actual  : stringmatch == %d", pat ? SLIST_FIRST(pat)->stringmatch : 0);
+    }
+
+    mutt_pattern_free(&pat);
+  }
+
   {
     char *s = "! =s foobar";
 
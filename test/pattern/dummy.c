@@ -52,6 +52,11 @@ int imap_search(struct Mailbox *m, const struct Pattern *pat)
   return -1;
 }
 
+int imap_search_match(const struct Pattern *pat, struct Email *e)
+{
+  return -1;
+}
+
 bool mutt_addr_is_user(struct Address *addr)
 {
   return g_addr_is_user;
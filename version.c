@@ -261,6 +261,11 @@ static struct CompileOptions comp_opts[] = {
 #else
   { "pgp", 0 },
 #endif
+#ifdef USE_PTHREADS
+  { "pthreads", 1 },
+#else
+  { "pthreads", 0 },
+#endif
 #ifdef USE_SASL
   { "sasl", 1 },
 #else